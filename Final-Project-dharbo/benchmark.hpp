@@ -0,0 +1,206 @@
+#ifndef _benchmark_hpp_
+#define _benchmark_hpp_
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "book.hpp"
+
+// Shared scaffolding for the multi-threaded and storage benchmark drivers. The
+// original single-threaded harness lives in generate_csv.cpp; these helpers
+// cover what it has no need for: spawning threads behind a common start line
+// and summarizing per-operation latencies.
+namespace benchmark {
+
+// Preferred clock
+using Clock = std::chrono::steady_clock;
+
+// Reads every Book from "stream" and shuffles them, mirroring how SampleData
+// is built in generate_csv.cpp.
+inline std::vector<Book> load_books(std::istream& stream) {
+  std::vector<Book> books{std::istream_iterator<Book>(stream),
+                          std::istream_iterator<Book>()};
+  books.shrink_to_fit();
+  std::shuffle(books.begin(), books.end(),
+               std::default_random_engine(std::random_device{}()));
+  return books;
+}
+
+// Returns the "index"-th book of a synthetic catalog of any size: a unique
+// 13-digit ISBN, with the title, author, and price of a book from "seed".
+inline Book synthetic_book(const std::vector<Book>& seed, std::size_t index) {
+  const Book& model = seed[index % seed.size()];
+  char isbn[16];
+  std::snprintf(isbn, sizeof isbn, "%013zu", index);
+  return Book(model.title(), model.author(), isbn, model.price());
+}
+
+// Writes synthetic books to "path" in the database format until the file is at
+// least "bytes" long, a few hundred kilobytes at a time: the i-th book written
+// is synthetic_book(seed, index_of(i)). Returns the number of books written.
+template <class IndexOf>
+inline std::size_t write_synthetic_database(const std::string& path,
+                                            const std::vector<Book>& seed,
+                                            std::size_t bytes, IndexOf index_of) {
+  // Book's operator<< ends each record with std::endl, so records are
+  // formatted into a memory buffer first rather than flushing the file per
+  // book.
+  std::ofstream file(path, std::ios::binary);
+  std::size_t written = 0;
+  std::size_t count = 0;
+  while (written < bytes) {
+    std::ostringstream buffer;
+    for (std::size_t i = 0; i < 4096; ++i) {
+      buffer << synthetic_book(seed, index_of(count++));
+    }
+    const std::string text = buffer.str();
+    file.write(text.data(), text.size());
+    written += text.size();
+  }
+  return count;
+}
+
+// As above, writing the synthetic books in order, each ISBN once.
+inline std::size_t write_synthetic_database(const std::string& path,
+                                            const std::vector<Book>& seed,
+                                            std::size_t bytes) {
+  return write_synthetic_database(path, seed, bytes,
+                                  [](std::size_t i) { return i; });
+}
+
+// Returns the thread counts to sweep: powers of two up to "max_threads", plus
+// "max_threads" itself when it is not a power of two.
+inline std::vector<std::size_t> thread_counts(std::size_t max_threads) {
+  std::vector<std::size_t> counts;
+  for (std::size_t count = 1; count < max_threads; count *= 2) {
+    counts.push_back(count);
+  }
+  counts.push_back(std::max<std::size_t>(max_threads, 1));
+  return counts;
+}
+
+// The default upper bound of a thread sweep: every hardware thread, but never
+// fewer than 4 so contention still shows up on small machines.
+inline std::size_t default_max_threads() {
+  return std::max<std::size_t>(std::thread::hardware_concurrency(), 4);
+}
+
+// Runs "work(thread_index)" on "thread_count" threads that are released
+// together once all of them have started, and returns the wall clock time from
+// the release until the last thread finishes.
+template <class Work>
+Clock::duration run_threads(std::size_t thread_count, Work work) {
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::size_t waiting = 0;
+  bool released = false;
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+  for (std::size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back([&, i] {
+      {
+        std::unique_lock lock(mutex);
+        ++waiting;
+        ready.notify_all();
+        ready.wait(lock, [&] { return released; });
+      }
+      work(i);
+    });
+  }
+
+  Clock::time_point start_time;
+  {
+    std::unique_lock lock(mutex);
+    ready.wait(lock, [&] { return waiting == thread_count; });
+    released = true;
+    start_time = Clock::now();
+  }
+  ready.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return Clock::now() - start_time;
+}
+
+// Returns the half-open range [begin, end) of "total" items owned by thread
+// "index" out of "count" threads.
+inline std::pair<std::size_t, std::size_t> slice(std::size_t total,
+                                                 std::size_t index,
+                                                 std::size_t count) {
+  return {total * index / count, total * (index + 1) / count};
+}
+
+// Mean and tail of a set of latency samples, in nanoseconds.
+struct LatencySummary {
+  double mean = 0.0;
+  long long p50 = 0;
+  long long p99 = 0;
+  long long max = 0;
+};
+
+inline LatencySummary summarize(std::vector<Clock::duration>& samples) {
+  LatencySummary summary;
+  if (samples.empty()) {
+    return summary;
+  }
+  std::sort(samples.begin(), samples.end());
+  auto ns = [](Clock::duration d) {
+    return static_cast<long long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+  };
+  long double total = 0;
+  for (auto sample : samples) {
+    total += ns(sample);
+  }
+  summary.mean = static_cast<double>(total / samples.size());
+  summary.p50 = ns(samples[samples.size() / 2]);
+  summary.p99 = ns(samples[samples.size() * 99 / 100]);
+  summary.max = ns(samples.back());
+  return summary;
+}
+
+// Converts "operations" completed in "elapsed" into operations per second.
+inline double per_second(std::size_t operations, Clock::duration elapsed) {
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  return seconds > 0.0 ? operations / seconds : 0.0;
+}
+
+// How long a run of operations took in all, and the latency of each one.
+struct Timing {
+  Clock::duration elapsed;
+  LatencySummary latency;
+};
+
+// Runs "operation(i)" for i in [0, count), timing each call.
+inline Timing time_operations(std::size_t count,
+                              const std::function<void(std::size_t)>& operation) {
+  std::vector<Clock::duration> latencies;
+  latencies.reserve(count);
+  const auto start_time = Clock::now();
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto operation_start = Clock::now();
+    operation(i);
+    latencies.push_back(Clock::now() - operation_start);
+  }
+  const auto elapsed = Clock::now() - start_time;
+  return Timing{elapsed, summarize(latencies)};
+}
+
+}  // namespace benchmark
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef _bloom_filter_hpp_
+#define _bloom_filter_hpp_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// A Bloom filter over strings: a bit array that answers "definitely absent"
+// or "possibly present". Each key sets "hash_count" bits chosen by double
+// hashing (bit i is h1 + i * h2) from one 64-bit FNV-1a hash, so adding or
+// testing a key reads the key once.
+//
+// With 10 bits per key and 7 hashes about 1% of absent keys test positive.
+//
+// The bits can be copied out with bytes() and checked in place with
+// may_contain(bytes, key), so a filter stored in a file needs no decoding.
+class BloomFilter {
+ public:
+  static constexpr std::size_t DEFAULT_BITS_PER_KEY = 10;
+
+  // A filter sized for "expected_keys" keys.
+  explicit BloomFilter(std::size_t expected_keys,
+                       std::size_t bits_per_key = DEFAULT_BITS_PER_KEY)
+      : hash_count_(hash_count_for(bits_per_key)),
+        bits_(std::max<std::size_t>(8, (expected_keys * bits_per_key + 7) / 8 * 8) / 8) {}
+
+  void add(std::string_view key) {
+    const std::size_t bit_count = bits_.size() * 8;
+    std::uint64_t h1, h2;
+    hash(key, h1, h2);
+    for (std::size_t i = 0; i < hash_count_; ++i, h1 += h2) {
+      const std::size_t bit = h1 % bit_count;
+      bits_[bit / 8] |= static_cast<unsigned char>(1u << (bit % 8));
+    }
+  }
+
+  bool may_contain(std::string_view key) const {
+    return may_contain(bits_.data(), bits_.size(), hash_count_, key);
+  }
+
+  // Tests "key" against filter bits stored elsewhere.
+  static bool may_contain(const unsigned char* bits, std::size_t byte_count,
+                          std::size_t hash_count, std::string_view key) {
+    if (byte_count == 0) {
+      return true;
+    }
+    const std::size_t bit_count = byte_count * 8;
+    std::uint64_t h1, h2;
+    hash(key, h1, h2);
+    for (std::size_t i = 0; i < hash_count; ++i, h1 += h2) {
+      const std::size_t bit = h1 % bit_count;
+      if ((bits[bit / 8] & (1u << (bit % 8))) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const std::vector<unsigned char>& bytes() const { return bits_; }
+  std::size_t hash_count() const { return hash_count_; }
+
+ private:
+  // k = ln 2 * bits per key minimizes false positives.
+  static std::size_t hash_count_for(std::size_t bits_per_key) {
+    return std::clamp<std::size_t>(static_cast<std::size_t>(std::lround(bits_per_key * 0.69)), 1, 30);
+  }
+
+  static void hash(std::string_view key, std::uint64_t& h1, std::uint64_t& h2) {
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (unsigned char c : key) {
+      hash = (hash ^ c) * 0x100000001b3;
+    }
+    h1 = hash;
+    h2 = (hash >> 33) | (hash << 31) | 1;           // odd, so successive bits differ
+  }
+
+  std::size_t hash_count_;
+  std::vector<unsigned char> bits_;
+};
+
+#endif
@@ -11,15 +11,19 @@
 // Constructors, Assignments, and Destructor
 //
 
-Book::Book(const std::string& title,
-           const std::string& author,
-           const std::string& isbn, 
-           double price) : title_(title), author_(author), isbn_(isbn), price_(price) {}
+Book::Book(std::string title,
+           std::string author,
+           std::string isbn, 
+           double price) : title_(std::move(title)), author_(std::move(author)), isbn_(std::move(isbn)), price_(price) {}
 
 Book::Book(const Book& other) = default;
 
+Book::Book(Book&& other) noexcept = default;
+
 Book& Book::operator=(const Book& rhs) = default;
 
+Book& Book::operator=(Book&& rhs) noexcept = default;
+
 // Destructor
 Book::~Book() noexcept = default;
 
@@ -19,14 +19,18 @@ class Book {
   // Constructors, Assignments, and Destructor
   //
 
-  Book(const std::string& title = {},
-       const std::string& author = {},
-       const std::string& isbn = {},
+  // The strings are taken by value so callers handing over temporaries (such
+  // as the fast loaders) have them moved in rather than copied.
+  Book(std::string title = {},
+       std::string author = {},
+       std::string isbn = {},
        const double price = 0.0);
 
   Book& operator=(const Book& rhs);
+  Book& operator=(Book&& rhs) noexcept;
 
   Book(const Book& other);
+  Book(Book&& other) noexcept;
 
   ~Book() noexcept;
 
@@ -0,0 +1,170 @@
+#include "book_loader.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "book.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+//
+// Conversions
+//
+
+std::string unescape_book_field(std::string_view field) {
+  std::string result;
+  result.reserve(field.size());
+  for (std::size_t i = 0; i < field.size(); ++i) {
+    // A backslash keeps whatever character follows it.
+    if (field[i] == '\\' && i + 1 < field.size()) {
+      ++i;
+    }
+    result.push_back(field[i]);
+  }
+  return result;
+}
+
+Book to_book(const RawBookRecord& record) {
+  if (record.escaped) {
+    return Book(unescape_book_field(record.title),
+                unescape_book_field(record.author),
+                unescape_book_field(record.isbn), record.price);
+  }
+  return Book(std::string(record.title), std::string(record.author),
+              std::string(record.isbn), record.price);
+}
+
+//
+// Loaders
+//
+
+std::vector<Book> parse_books(std::string_view text) {
+  std::vector<Book> books;
+  // Records are a little under 100 bytes each; overshooting the reservation
+  // is cheaper than growing the vector repeatedly.
+  books.reserve(text.size() / 64 + 1);
+  for_each_book_record(text.data(), text.data() + text.size(),
+                       [&](const RawBookRecord& record) {
+                         books.push_back(to_book(record));
+                       });
+  books.shrink_to_fit();
+  return books;
+}
+
+std::vector<Book> load_books_mapped(const std::string& path) {
+  MappedFile file(path);
+  file.advise_sequential();
+  return parse_books(file.view());
+}
+
+namespace {
+
+// Inputs smaller than this are parsed on the calling thread; splitting them
+// costs more than it saves.
+constexpr std::size_t MIN_PARALLEL_BYTES = 1 << 20;
+
+// The records one worker parsed out of its chunk.
+struct ParsedChunk {
+  std::vector<Book> books;
+  const char* first = nullptr;                        // where the first record starts
+  const char* stop = nullptr;                         // where the next record would start
+  bool reached_limit = false;                         // false if a malformed record stopped it
+};
+
+// Parses the records that start in [begin, limit). The last one may run past
+// "limit" up to "end".
+ParsedChunk parse_chunk(const char* begin, const char* limit, const char* end) {
+  ParsedChunk chunk;
+  chunk.books.reserve((limit - begin) / 64 + 1);
+  const char* cursor = skip_book_space(begin, end);
+  chunk.first = cursor;
+  RawBookRecord record;
+  while (cursor < limit) {
+    const char* next = parse_book_record(cursor, end, record);
+    if (next == nullptr) {
+      chunk.stop = cursor;
+      return chunk;
+    }
+    chunk.books.push_back(to_book(record));
+    cursor = skip_book_space(next, end);
+  }
+  chunk.stop = cursor;
+  chunk.reached_limit = true;
+  return chunk;
+}
+
+}  // namespace
+
+std::vector<Book> parse_books_parallel(std::string_view text,
+                                       std::size_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  if (thread_count == 1 || text.size() < MIN_PARALLEL_BYTES) {
+    return parse_books(text);
+  }
+
+  // Cut just after the first newline at or past each even share of the text.
+  // A few chunks per thread smooths out uneven record lengths.
+  const char* begin = text.data();
+  const char* end = begin + text.size();
+  const std::size_t chunk_count = thread_count * 4;
+  std::vector<const char*> cuts{begin};
+  for (std::size_t i = 1; i < chunk_count; ++i) {
+    const char* cut = std::find(begin + text.size() * i / chunk_count, end, '\n');
+    if (cut != end && cut + 1 > cuts.back()) {
+      cuts.push_back(cut + 1);
+    }
+  }
+  cuts.push_back(end);
+
+  std::vector<std::future<ParsedChunk>> pending;
+  {
+    ThreadPool pool(thread_count);
+    for (std::size_t i = 0; i + 1 < cuts.size(); ++i) {
+      pending.push_back(pool.submit(
+          [=] { return parse_chunk(cuts[i], cuts[i + 1], end); }));
+    }
+  }
+
+  // Join the chunks in file order, checking that each one starts exactly where
+  // the one before it stopped.
+  std::vector<ParsedChunk> chunks;
+  std::size_t total = 0;
+  for (auto& future : pending) {
+    chunks.push_back(future.get());
+    total += chunks.back().books.size();
+  }
+
+  std::vector<Book> books;
+  books.reserve(total);
+  const char* expected = skip_book_space(begin, end);
+  for (ParsedChunk& chunk : chunks) {
+    if (chunk.first != expected) {
+      // Misaligned cut: fall back to a sequential parse of the remainder.
+      std::vector<Book> rest =
+          parse_books(std::string_view(expected, end - expected));
+      std::move(rest.begin(), rest.end(), std::back_inserter(books));
+      break;
+    }
+    std::move(chunk.books.begin(), chunk.books.end(), std::back_inserter(books));
+    if (!chunk.reached_limit) {
+      break;                                          // malformed record
+    }
+    expected = chunk.stop;
+  }
+  return books;
+}
+
+std::vector<Book> load_books_parallel(const std::string& path,
+                                      std::size_t thread_count) {
+  MappedFile file(path);
+  file.advise_sequential();
+  return parse_books_parallel(file.view(), thread_count);
+}
@@ -0,0 +1,180 @@
+#ifndef _book_loader_hpp_
+#define _book_loader_hpp_
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "book.hpp"
+
+// Fast readers for the text database format written by operator<<(Book):
+//
+//   "isbn", "title", "author", price
+//
+// operator>>(std::istream&, Book&) reads this through std::quoted one character
+// at a time and allocates a string per field. The functions here scan the
+// bytes in place instead: a record is first parsed into a RawBookRecord whose
+// fields are views into the input, and only turned into an owning Book when
+// the caller asks for one.
+//
+// The accepted syntax matches operator>> on well-formed input: whitespace is
+// skipped before every field and delimiter, a quoted field may contain commas
+// and backslash escapes (\" and \\), and an unquoted field runs to the next
+// whitespace. Like std::istream_iterator<Book>, parsing stops quietly at the
+// first record that does not fit the format.
+
+// One record as it appears in the input. The string fields view the bytes
+// between the quotes and still contain any backslash escapes.
+struct RawBookRecord {
+  std::string_view isbn;
+  std::string_view title;
+  std::string_view author;
+  double price = 0.0;
+
+  // True if any of the string fields contains a backslash escape, in which
+  // case the views must be unescaped before use.
+  bool escaped = false;
+};
+
+//
+// Record Parsing
+//
+
+inline bool is_book_space(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' ||
+         c == '\f';
+}
+
+inline const char* skip_book_space(const char* cursor, const char* end) {
+  while (cursor != end && is_book_space(*cursor)) {
+    ++cursor;
+  }
+  return cursor;
+}
+
+// Parses one field the way std::quoted extraction does. Returns the position
+// after the field, or nullptr if no field could be read.
+inline const char* parse_book_field(const char* cursor, const char* end,
+                                    std::string_view& field, bool& escaped) {
+  cursor = skip_book_space(cursor, end);
+  if (cursor == end) {
+    return nullptr;
+  }
+
+  if (*cursor != '"') {
+    // Unquoted: a plain whitespace-delimited word.
+    const char* first = cursor;
+    while (cursor != end && !is_book_space(*cursor)) {
+      ++cursor;
+    }
+    field = std::string_view(first, cursor - first);
+    return cursor;
+  }
+
+  const char* first = ++cursor;
+  while (cursor != end && *cursor != '"') {
+    if (*cursor == '\\') {
+      escaped = true;
+      if (++cursor == end) {
+        return nullptr;
+      }
+    }
+    ++cursor;
+  }
+  if (cursor == end) {
+    return nullptr;                                   // unterminated quote
+  }
+  field = std::string_view(first, cursor - first);
+  return cursor + 1;
+}
+
+// Skips whitespace and a single comma. Returns nullptr if the next
+// non-whitespace character is not a comma.
+inline const char* parse_book_delimiter(const char* cursor, const char* end) {
+  cursor = skip_book_space(cursor, end);
+  return (cursor != end && *cursor == ',') ? cursor + 1 : nullptr;
+}
+
+inline const char* parse_book_price(const char* cursor, const char* end,
+                                    double& price) {
+  cursor = skip_book_space(cursor, end);
+  if (cursor != end && *cursor == '+') {
+    ++cursor;                                         // from_chars rejects '+'
+  }
+  // from_chars also reads "inf" and "nan", which operator>> does not.
+  auto [next, error] = std::from_chars(cursor, end, price);
+  return error == std::errc() && std::isfinite(price) ? next : nullptr;
+}
+
+// Parses the record starting at "cursor" into "record". Returns the position
+// after the record, or nullptr if no complete record starts there.
+inline const char* parse_book_record(const char* cursor, const char* end,
+                                     RawBookRecord& record) {
+  record.escaped = false;
+  if ((cursor = parse_book_field(cursor, end, record.isbn, record.escaped)) &&
+      (cursor = parse_book_delimiter(cursor, end)) &&
+      (cursor = parse_book_field(cursor, end, record.title, record.escaped)) &&
+      (cursor = parse_book_delimiter(cursor, end)) &&
+      (cursor = parse_book_field(cursor, end, record.author, record.escaped)) &&
+      (cursor = parse_book_delimiter(cursor, end))) {
+    return parse_book_price(cursor, end, record.price);
+  }
+  return nullptr;
+}
+
+// Calls "visitor(record)" for every record in [begin, end). Returns the
+// position where parsing stopped, which is "end" (give or take trailing
+// whitespace) when the whole input was well formed.
+template <class Visitor>
+const char* for_each_book_record(const char* begin, const char* end,
+                                 Visitor visitor) {
+  RawBookRecord record;
+  const char* cursor = begin;
+  while (const char* next = parse_book_record(cursor, end, record)) {
+    visitor(static_cast<const RawBookRecord&>(record));
+    cursor = next;
+  }
+  return cursor;
+}
+
+//
+// Conversions
+//
+
+// Removes std::quoted's backslash escapes from a field.
+std::string unescape_book_field(std::string_view field);
+
+// Copies a parsed record into an owning Book.
+Book to_book(const RawBookRecord& record);
+
+//
+// Loaders
+//
+
+// Parses every record in "text" into Books.
+std::vector<Book> parse_books(std::string_view text);
+
+// Memory-maps the database file at "path" and parses it without going through
+// iostreams. Throws std::system_error if the file cannot be mapped.
+std::vector<Book> load_books_mapped(const std::string& path);
+
+// Parses every record in "text" into Books using "thread_count" threads (one
+// per hardware thread when 0). The text is cut into chunks just after a
+// newline, each chunk is parsed on a worker, and the results are joined in
+// file order. A newline inside a quoted field could make a cut land mid
+// record; that is detected where neighbouring chunks fail to line up, and the
+// rest of the text is then parsed sequentially, so the result always equals
+// parse_books(text).
+std::vector<Book> parse_books_parallel(std::string_view text,
+                                       std::size_t thread_count = 0);
+
+// Memory-maps the database file at "path" and parses it in parallel. Throws
+// std::system_error if the file cannot be mapped.
+std::vector<Book> load_books_parallel(const std::string& path,
+                                      std::size_t thread_count = 0);
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef _book_loader_test_hpp_
+#define _book_loader_test_hpp_
+
+#include "book_loader.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+#include "mapped_file.hpp"
+
+// Reads "text" the way SampleData does, through operator>>.
+inline std::vector<Book> books_from_stream(const std::string& text) {
+  std::istringstream stream(text);
+  return std::vector<Book>{std::istream_iterator<Book>(stream),
+                           std::istream_iterator<Book>()};
+}
+
+TEST_CASE("ParseBooksMatchesExtractionOperator") {
+  SUBCASE("PlainRecords") {
+    const std::string text =
+        "\"9993023736\", \"The Armenian genocide (1st edition)\", "
+        "\"N. O. Oganesi\xcd\xa1" "an\", 13.81\n"
+        "\"9991530169\", \"Underwater Bahamas (1st edition)\", \"Bob Friel\", "
+        "22.35\n";
+    CHECK_EQ(parse_books(text), books_from_stream(text));
+    CHECK_EQ(parse_books(text).size(), 2);
+  }
+
+  SUBCASE("CommasEscapesAndSpacing") {
+    const std::string text =
+        "  \"1\",\"Title, with commas\",\"Au\\\"thor\\\\\",1.5\n"
+        "\"2\"  ,  \"x\"\t,\"y\",  +2e1";
+    const std::vector<Book> books = parse_books(text);
+    CHECK_EQ(books, books_from_stream(text));
+    REQUIRE_EQ(books.size(), 2);
+    CHECK_EQ(books[0].title(), "Title, with commas");
+    CHECK_EQ(books[0].author(), "Au\"thor\\");
+    CHECK_EQ(books[1].price(), 20.0);
+  }
+
+  SUBCASE("UnquotedFields") {
+    const std::string text = "isbn , title , author , 3\n";
+    CHECK_EQ(parse_books(text), books_from_stream(text));
+  }
+
+  SUBCASE("StopsAtMalformedRecord") {
+    const std::string text =
+        "\"1\", \"a\", \"b\", 1.0\n"
+        "\"2\", \"unterminated, \"c\", 2.0\n"
+        "\"3\", \"a\", \"b\", 3.0\n";
+    CHECK_EQ(parse_books(text).size(), 1);
+    CHECK_EQ(parse_books(text)[0], books_from_stream(text)[0]);
+  }
+
+  SUBCASE("StopsAtNonFinitePrice") {
+    for (const char* price : {"inf", "-INF", "infinity", "nan", "+nan(1)"}) {
+      const std::string text = "\"1\", \"a\", \"b\", 1.0\n\"2\", \"a\", \"b\", " + std::string(price) + "\n";
+      CHECK_EQ(parse_books(text), books_from_stream(text));
+      CHECK_EQ(parse_books(text).size(), 1);
+    }
+  }
+
+  SUBCASE("EmptyInput") {
+    CHECK(parse_books("").empty());
+    CHECK(parse_books(" \n\n").empty());
+  }
+}
+
+// Builds a database text big enough for parse_books_parallel to split.
+inline std::string large_database_text(const std::string& title) {
+  std::ostringstream stream;
+  for (int i = 0; stream.tellp() < (3 << 20); ++i) {
+    stream << Book(title + std::to_string(i), "author", std::to_string(i), i);
+  }
+  return stream.str();
+}
+
+TEST_CASE("ParseBooksParallelMatchesSequential") {
+  SUBCASE("SplitsOnRecordBoundaries") {
+    const std::string text = large_database_text("title, with a comma ");
+    const std::vector<Book> books = parse_books(text);
+    CHECK_GT(books.size(), 10000);
+    CHECK_EQ(parse_books_parallel(text, 4), books);
+    CHECK_EQ(parse_books_parallel(text, 1), books);
+  }
+
+  SUBCASE("NewlinesInsideQuotedFields") {
+    // Every cut lands inside a title, so the chunks never line up.
+    const std::string text = large_database_text("title\n\n\n\n\n\n\n\n");
+    CHECK_EQ(parse_books_parallel(text, 4), parse_books(text));
+  }
+
+  SUBCASE("StopsAtMalformedRecord") {
+    std::string text = large_database_text("title ");
+    text.insert(text.size() / 2, "\"unterminated, 1.0\n");
+    const std::vector<Book> books = parse_books(text);
+    CHECK_LT(books.size(), parse_books(large_database_text("title ")).size());
+    CHECK_EQ(parse_books_parallel(text, 4), books);
+  }
+
+  SUBCASE("SmallInput") {
+    const std::string text = "\"1\", \"a\", \"b\", 1.0\n";
+    CHECK_EQ(parse_books_parallel(text, 4), parse_books(text));
+    CHECK(parse_books_parallel("", 4).empty());
+  }
+}
+
+TEST_CASE("LoadBooksMapped") {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "book_loader_test.dat";
+  const std::vector<Book> books = {
+      Book("title", "author", "isbn", 123.45),
+      Book("other, title", "other \"author\"", "other-isbn", 543.21)};
+  {
+    std::ofstream file(path);
+    for (const Book& book : books) file << book;
+  }
+
+  CHECK_EQ(load_books_mapped(path.string()), books);
+  CHECK_EQ(load_books_parallel(path.string(), 2), books);
+  CHECK_EQ(MappedFile(path.string()).size(),
+           std::filesystem::file_size(path));
+  std::filesystem::remove(path);
+
+  CHECK_THROWS_AS(load_books_mapped(path.string()), std::system_error);
+  CHECK_THROWS_AS(load_books_parallel(path.string()), std::system_error);
+}
+
+#endif
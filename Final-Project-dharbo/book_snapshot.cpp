@@ -0,0 +1,221 @@
+#include "book_snapshot.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "book.hpp"
+#include "book_loader.hpp"
+#include "mapped_file.hpp"
+
+namespace {
+
+constexpr std::uint64_t SECTION_ALIGNMENT = 64;
+
+std::uint64_t align(std::uint64_t offset) {
+  return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+// Writes bytes and pads the file out to the next section boundary.
+class SectionWriter {
+ public:
+  explicit SectionWriter(const std::string& path)
+      : path_(path), file_(path, std::ios::binary | std::ios::trunc) {
+    check();
+  }
+
+  std::uint64_t offset() const { return offset_; }
+
+  void write(const void* data, std::size_t size) {
+    file_.write(static_cast<const char*>(data), size);
+    offset_ += size;
+    check();
+  }
+
+  void pad() {
+    static const char zeros[SECTION_ALIGNMENT] = {};
+    write(zeros, align(offset_) - offset_);
+  }
+
+  void rewrite_header(const SnapshotHeader& header) {
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header), sizeof header);
+    file_.flush();
+    check();
+  }
+
+ private:
+  void check() {
+    if (!file_) {
+      throw std::system_error(errno, std::generic_category(), "write " + path_);
+    }
+  }
+
+  std::string path_;
+  std::ofstream file_;
+  std::uint64_t offset_ = 0;
+};
+
+// Writes one string column as its offsets followed by its heap. Returns the
+// section offsets of both.
+template<class Field>
+std::pair<std::uint64_t, std::uint64_t> write_strings(SectionWriter& out,
+                                                      const std::vector<Book>& books,
+                                                      Field field) {
+  const std::uint64_t offsets_at = out.offset();
+  std::uint64_t position = 0;
+  out.write(&position, sizeof position);
+  for (const Book& book : books) {
+    position += field(book).size();
+    out.write(&position, sizeof position);
+  }
+  out.pad();
+
+  const std::uint64_t heap_at = out.offset();
+  for (const Book& book : books) {
+    const std::string& text = field(book);
+    out.write(text.data(), text.size());
+  }
+  out.pad();
+  return {offsets_at, heap_at};
+}
+
+[[noreturn]] void reject(const std::string& path, const std::string& reason) {
+  throw std::runtime_error(path + " is not a usable book snapshot: " + reason);
+}
+
+}  // namespace
+
+//
+// Writing
+//
+
+void write_book_snapshot(const std::string& path, const std::vector<Book>& books) {
+  SnapshotHeader header{};
+  std::memcpy(header.magic, SnapshotHeader::MAGIC, sizeof header.magic);
+  header.version = SnapshotHeader::VERSION;
+  header.byte_order = SnapshotHeader::BYTE_ORDER_MARK;
+  header.count = books.size();
+  // The widest ISBN decides the column width, rounded up to 8 bytes.
+  std::size_t widest = 0;
+  for (const Book& book : books) widest = std::max(widest, book.isbn().size());
+  header.isbn_width = (widest + 7) / 8 * 8;
+
+  SectionWriter out(path);
+  out.write(&header, sizeof header);                  // placeholder until the offsets are known
+  out.pad();
+
+  header.isbn_column = out.offset();
+  std::vector<char> isbn(header.isbn_width);
+  for (const Book& book : books) {
+    std::fill(isbn.begin(), isbn.end(), '\0');
+    std::copy(book.isbn().begin(), book.isbn().end(), isbn.begin());
+    out.write(isbn.data(), isbn.size());
+  }
+  out.pad();
+
+  header.price_column = out.offset();
+  for (const Book& book : books) {
+    const double price = book.price();
+    out.write(&price, sizeof price);
+  }
+  out.pad();
+
+  std::tie(header.title_offsets, header.title_heap) =
+      write_strings(out, books, [](const Book& book) -> const std::string& { return book.title(); });
+  std::tie(header.author_offsets, header.author_heap) =
+      write_strings(out, books, [](const Book& book) -> const std::string& { return book.author(); });
+
+  header.file_size = out.offset();
+  out.rewrite_header(header);
+}
+
+std::size_t convert_to_book_snapshot(const std::string& database_path,
+                                     const std::string& snapshot_path) {
+  const std::vector<Book> books = load_books_mapped(database_path);
+  write_book_snapshot(snapshot_path, books);
+  return books.size();
+}
+
+//
+// Reading
+//
+
+BookSnapshot::BookSnapshot(const std::string& path) : file_(path) {
+  SnapshotHeader header;
+  if (file_.size() < sizeof header) {
+    reject(path, "too short for a header");
+  }
+  std::memcpy(&header, file_.data(), sizeof header);
+  if (std::memcmp(header.magic, SnapshotHeader::MAGIC, sizeof header.magic) != 0) {
+    reject(path, "bad magic number");
+  }
+  if (header.version != SnapshotHeader::VERSION) {
+    reject(path, "unsupported version " + std::to_string(header.version));
+  }
+  if (header.byte_order != SnapshotHeader::BYTE_ORDER_MARK) {
+    reject(path, "written with a different byte order");
+  }
+  if (header.file_size != file_.size()) {
+    reject(path, "truncated");
+  }
+
+  // Every section must lie inside the file, and every string must lie inside
+  // its heap, before any record is handed out.
+  const std::uint64_t count = header.count;
+  if (count > header.file_size || header.isbn_width > header.file_size) {
+    reject(path, "record count out of bounds");
+  }
+  // Whether "items" items of "width" bytes fit at "offset". Dividing the
+  // room rather than multiplying the size keeps a corrupted count or width
+  // from wrapping around.
+  auto fits = [&](std::uint64_t offset, std::uint64_t items, std::uint64_t width) {
+    return offset % SECTION_ALIGNMENT == 0 && offset <= header.file_size &&
+           (width == 0 || items <= (header.file_size - offset) / width);
+  };
+  if (!fits(header.isbn_column, count, header.isbn_width) ||
+      !fits(header.price_column, count, sizeof(double)) ||
+      !fits(header.title_offsets, count + 1, sizeof(std::uint64_t)) ||
+      !fits(header.author_offsets, count + 1, sizeof(std::uint64_t))) {
+    reject(path, "section out of bounds");
+  }
+
+  const char* base = file_.data();
+  count_ = count;
+  isbn_width_ = header.isbn_width;
+  isbns_ = base + header.isbn_column;
+  prices_ = reinterpret_cast<const double*>(base + header.price_column);
+  title_offsets_ = reinterpret_cast<const std::uint64_t*>(base + header.title_offsets);
+  title_heap_ = base + header.title_heap;
+  author_offsets_ = reinterpret_cast<const std::uint64_t*>(base + header.author_offsets);
+  author_heap_ = base + header.author_heap;
+
+  // Offsets are non-decreasing, so checking the last one bounds them all.
+  auto heap_fits = [&](const std::uint64_t* offsets, std::uint64_t heap) {
+    for (std::uint64_t i = 0; i < count; ++i) {
+      if (offsets[i] > offsets[i + 1]) return false;
+    }
+    return offsets[0] == 0 && fits(heap, offsets[count], 1);
+  };
+  if (!heap_fits(title_offsets_, header.title_heap) ||
+      !heap_fits(author_offsets_, header.author_heap)) {
+    reject(path, "string heap out of bounds");
+  }
+}
+
+std::vector<Book> BookSnapshot::books() const {
+  std::vector<Book> result;
+  result.reserve(count_);
+  for (std::size_t i = 0; i < count_; ++i) {
+    result.push_back(book(i));
+  }
+  return result;
+}
@@ -0,0 +1,130 @@
+#ifndef _book_snapshot_hpp_
+#define _book_snapshot_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "book.hpp"
+#include "book_loader.hpp"
+#include "book_view.hpp"
+#include "mapped_file.hpp"
+
+// A binary snapshot of a Book collection, laid out so that a memory mapping
+// of the file can be read in place with no parsing at startup.
+//
+// Layout (native byte order, every section starting on a 64-byte boundary):
+//
+//   SnapshotHeader
+//   isbn column     count * isbn_width bytes, each ISBN padded with '\0'
+//   price column    count doubles
+//   title offsets   count + 1 uint64_t; title i is heap[offset[i], offset[i+1])
+//   title heap      the titles back to back, unescaped, not terminated
+//   author offsets  as for titles
+//   author heap
+//
+// The header records a format version; readers reject files whose magic,
+// version, byte order, or section bounds do not check out.
+
+struct SnapshotHeader {
+  static constexpr char MAGIC[8] = {'B', 'O', 'O', 'K', 'S', 'N', 'A', 'P'};
+  static constexpr std::uint32_t VERSION = 1;
+  static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint64_t count;
+  std::uint64_t isbn_width;
+  std::uint64_t isbn_column;                          // offsets of each section from the file start
+  std::uint64_t price_column;
+  std::uint64_t title_offsets;
+  std::uint64_t title_heap;
+  std::uint64_t author_offsets;
+  std::uint64_t author_heap;
+  std::uint64_t file_size;
+};
+
+// Writes "books" to "path" as a snapshot. Throws std::system_error if the file
+// cannot be written.
+void write_book_snapshot(const std::string& path, const std::vector<Book>& books);
+
+// Reads a text database at "database_path" and writes it as a snapshot at
+// "snapshot_path". Returns the number of books converted.
+std::size_t convert_to_book_snapshot(const std::string& database_path,
+                                     const std::string& snapshot_path);
+
+// A read-only, memory-mapped snapshot. Opening one maps the file and checks
+// the header; records are read straight out of the mapping on demand.
+//
+// Usage:
+//
+//   BookSnapshot snapshot("database-large.snap");
+//   std::string_view title = snapshot.title(0);    // no copy
+//   Book book = snapshot.book(0);                    // owning copy
+class BookSnapshot {
+ public:
+  // Throws std::system_error if the file cannot be mapped, and
+  // std::runtime_error if it is not a valid snapshot.
+  explicit BookSnapshot(const std::string& path);
+
+  std::size_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+
+  //
+  // Fields of record "index", viewing the mapping
+  //
+
+  std::string_view isbn(std::size_t index) const {
+    const char* first = isbns_ + index * isbn_width_;
+    std::size_t length = 0;
+    while (length < isbn_width_ && first[length] != '\0') ++length;
+    return {first, length};
+  }
+
+  std::string_view title(std::size_t index) const {
+    return {title_heap_ + title_offsets_[index],
+            static_cast<std::size_t>(title_offsets_[index + 1] - title_offsets_[index])};
+  }
+
+  std::string_view author(std::size_t index) const {
+    return {author_heap_ + author_offsets_[index],
+            static_cast<std::size_t>(author_offsets_[index + 1] - author_offsets_[index])};
+  }
+
+  double price(std::size_t index) const { return prices_[index]; }
+
+  // The whole record as views into the mapping. Snapshot strings are stored
+  // unescaped, so the record is never "escaped".
+  RawBookRecord record(std::size_t index) const {
+    return {isbn(index), title(index), author(index), price(index), false};
+  }
+
+  // The record as a BookView of the mapping, valid while the snapshot is open.
+  BookView view(std::size_t index) const {
+    return BookView(title(index), author(index), isbn(index), price(index));
+  }
+
+  //
+  // Owning copies
+  //
+
+  Book book(std::size_t index) const { return to_book(record(index)); }
+
+  std::vector<Book> books() const;
+
+ private:
+  MappedFile file_;
+  std::size_t count_ = 0;
+  std::size_t isbn_width_ = 0;
+  const char* isbns_ = nullptr;
+  const double* prices_ = nullptr;
+  const std::uint64_t* title_offsets_ = nullptr;
+  const char* title_heap_ = nullptr;
+  const std::uint64_t* author_offsets_ = nullptr;
+  const char* author_heap_ = nullptr;
+};
+
+#endif
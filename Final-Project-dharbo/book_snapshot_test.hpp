@@ -0,0 +1,110 @@
+#ifndef _book_snapshot_test_hpp_
+#define _book_snapshot_test_hpp_
+
+#include "book_snapshot.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("BookSnapshot") {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "book_snapshot_test.snap";
+  const std::vector<Book> books = {
+      Book("title", "author", "isbn", 123.45),
+      Book("other, title", "other \"author\"\\", "0123456789012", 543.21),
+      Book("", "", "", 0.0),
+      Book(std::string(300, 't'), "a", "1", -1.5)};
+
+  SUBCASE("RoundTrip") {
+    write_book_snapshot(path.string(), books);
+    const BookSnapshot snapshot(path.string());
+    REQUIRE_EQ(snapshot.size(), books.size());
+    CHECK_EQ(snapshot.books(), books);
+    CHECK_EQ(snapshot.isbn(1), "0123456789012");
+    CHECK_EQ(snapshot.title(1), "other, title");
+    CHECK_EQ(snapshot.author(1), "other \"author\"\\");
+    CHECK_EQ(snapshot.price(1), 543.21);
+    CHECK_EQ(snapshot.book(3), books[3]);
+    CHECK_FALSE(snapshot.record(0).escaped);
+    CHECK_EQ(std::filesystem::file_size(path) % 64, 0);
+  }
+
+  SUBCASE("EmptyCollection") {
+    write_book_snapshot(path.string(), {});
+    const BookSnapshot snapshot(path.string());
+    CHECK(snapshot.empty());
+    CHECK(snapshot.books().empty());
+  }
+
+  SUBCASE("ConvertsTextDatabase") {
+    const std::filesystem::path text =
+        std::filesystem::temp_directory_path() / "book_snapshot_test.dat";
+    {
+      std::ofstream file(text);
+      for (const Book& book : books) file << book;
+    }
+    CHECK_EQ(convert_to_book_snapshot(text.string(), path.string()), books.size());
+    CHECK_EQ(BookSnapshot(path.string()).books(), books);
+    std::filesystem::remove(text);
+  }
+
+  SUBCASE("RejectsDamagedFiles") {
+    write_book_snapshot(path.string(), books);
+    const auto size = std::filesystem::file_size(path);
+
+    std::filesystem::resize_file(path, size - 64);
+    CHECK_THROWS_AS(BookSnapshot(path.string()), std::runtime_error);
+
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file << books[0];
+    }
+    CHECK_THROWS_AS(BookSnapshot(path.string()), std::runtime_error);
+
+    write_book_snapshot(path.string(), books);
+    {
+      std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+      const std::uint32_t version = SnapshotHeader::VERSION + 1;
+      file.seekp(8);
+      file.write(reinterpret_cast<const char*>(&version), sizeof version);
+    }
+    CHECK_THROWS_AS(BookSnapshot(path.string()), std::runtime_error);
+  }
+
+  SUBCASE("RejectsCorruptedHeader") {
+    // Overwrites the header field at "offset" of a fresh snapshot.
+    auto corrupt = [&](std::size_t offset, std::uint64_t value) {
+      write_book_snapshot(path.string(), books);
+      std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(offset);
+      file.write(reinterpret_cast<const char*>(&value), sizeof value);
+    };
+    const std::uint64_t size = [&] {
+      write_book_snapshot(path.string(), books);
+      return std::filesystem::file_size(path);
+    }();
+
+    corrupt(offsetof(SnapshotHeader, isbn_width), size);
+    CHECK_THROWS_AS(BookSnapshot(path.string()), std::runtime_error);
+    corrupt(offsetof(SnapshotHeader, count), size);
+    CHECK_THROWS_AS(BookSnapshot(path.string()), std::runtime_error);
+    corrupt(offsetof(SnapshotHeader, count), UINT64_MAX);
+    CHECK_THROWS_AS(BookSnapshot(path.string()), std::runtime_error);
+    corrupt(offsetof(SnapshotHeader, isbn_column), size + 64);
+    CHECK_THROWS_AS(BookSnapshot(path.string()), std::runtime_error);
+  }
+
+  std::filesystem::remove(path);
+  CHECK_THROWS_AS(BookSnapshot(path.string()), std::system_error);
+}
+
+#endif
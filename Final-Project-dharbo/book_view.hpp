@@ -0,0 +1,175 @@
+#ifndef _book_view_hpp_
+#define _book_view_hpp_
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "book.hpp"
+
+// A non-owning Book: the ISBN, title, and author are string_views into storage
+// that someone else keeps alive (a BookArena, a memory-mapped snapshot, or the
+// Books themselves), and only the price is held by value.
+//
+// A Book owns three std::strings, and most titles are too long for the small
+// string optimization, so copying a Book into a container costs up to three
+// heap allocations. Copying a BookView costs none.
+//
+// BookView has the same accessors and comparisons as Book, so the container
+// functors in operations.hpp work with either.
+class BookView {
+ public:
+  //
+  // Constructors
+  //
+
+  BookView() = default;
+
+  BookView(std::string_view title, std::string_view author,
+           std::string_view isbn, double price = 0.0)
+      : isbn_(isbn), title_(title), author_(author), price_(price) {}
+
+  // Views the strings of "book", which must outlive the view.
+  explicit BookView(const Book& book)
+      : BookView(book.title(), book.author(), book.isbn(), book.price()) {}
+
+  //
+  // Accessors
+  //
+
+  std::string_view isbn() const { return isbn_; }
+  std::string_view title() const { return title_; }
+  std::string_view author() const { return author_; }
+  double price() const { return price_; }
+
+  // Copies the viewed strings into an owning Book.
+  Book to_book() const {
+    return Book(std::string(title_), std::string(author_), std::string(isbn_),
+                price_);
+  }
+
+  //
+  // Relational Operators (same ordering as Book's)
+  //
+
+  bool operator==(const BookView& rhs) const noexcept {
+    return title_ == rhs.title_ && author_ == rhs.author_ &&
+           isbn_ == rhs.isbn_ && price_ == rhs.price_;
+  }
+  bool operator!=(const BookView& rhs) const noexcept { return !(*this == rhs); }
+
+  bool operator<(const BookView& rhs) const noexcept {
+    if (isbn_ != rhs.isbn_) return isbn_ < rhs.isbn_;
+    if (author_ != rhs.author_) return author_ < rhs.author_;
+    if (title_ != rhs.title_) return title_ < rhs.title_;
+    return price_ < rhs.price_;
+  }
+  bool operator<=(const BookView& rhs) const noexcept { return !(rhs < *this); }
+  bool operator>(const BookView& rhs) const noexcept { return rhs < *this; }
+  bool operator>=(const BookView& rhs) const noexcept { return !(*this < rhs); }
+
+ private:
+  std::string_view isbn_;
+  std::string_view title_;
+  std::string_view author_;
+  double price_ = 0.0;
+};
+
+// Writes the view in the same format as operator<<(Book).
+inline std::ostream& operator<<(std::ostream& stream, const BookView& book) {
+  return stream << std::quoted(book.isbn()) << "," << std::quoted(book.title())
+                << "," << std::quoted(book.author()) << "," << book.price()
+                << std::endl;
+}
+
+// The type a record's ISBN is stored as when the record is used as a map
+// value: std::string for Book, std::string_view for BookView.
+template <class Record>
+using isbn_key_t = std::decay_t<decltype(std::declval<const Record&>().isbn())>;
+
+// Append-only storage for the strings behind BookViews. Strings are copied
+// into large blocks, so a whole catalog costs a handful of allocations, and a
+// string never moves once stored: views stay valid until the arena is
+// destroyed.
+class BookArena {
+ public:
+  static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+  BookArena() = default;
+  BookArena(const BookArena&) = delete;
+  BookArena& operator=(const BookArena&) = delete;
+  BookArena(BookArena&&) noexcept = default;
+  BookArena& operator=(BookArena&&) noexcept = default;
+
+  // Copies "text" into the arena and returns a view of the copy.
+  std::string_view store_string(std::string_view text) {
+    if (text.size() > remaining_) {
+      const std::size_t size = std::max(BLOCK_SIZE, text.size());
+      blocks_.push_back(std::make_unique<char[]>(size));
+      next_ = blocks_.back().get();
+      remaining_ = size;
+      bytes_reserved_ += size;
+    }
+    char* copy = next_;
+    std::copy(text.begin(), text.end(), copy);
+    next_ += text.size();
+    remaining_ -= text.size();
+    return {copy, text.size()};
+  }
+
+  // Copies the strings of "book" into the arena and returns a view of them.
+  BookView store(const Book& book) {
+    const std::string_view isbn = store_string(book.isbn());
+    const std::string_view title = store_string(book.title());
+    const std::string_view author = store_string(book.author());
+    return BookView(title, author, isbn, book.price());
+  }
+
+  // Bytes of string storage allocated so far.
+  std::size_t bytes_reserved() const { return bytes_reserved_; }
+
+  std::size_t block_count() const { return blocks_.size(); }
+
+ private:
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* next_ = nullptr;
+  std::size_t remaining_ = 0;
+  std::size_t bytes_reserved_ = 0;
+};
+
+// Copies "books" into "arena" and returns views of them, in the same order.
+inline std::vector<BookView> store_books(BookArena& arena,
+                                         const std::vector<Book>& books) {
+  std::vector<BookView> views;
+  views.reserve(books.size());
+  for (const Book& book : books) {
+    views.push_back(arena.store(book));
+  }
+  return views;
+}
+
+// Returns the bytes "text" has allocated on the heap: none while it fits in
+// the string object itself (the small string optimization), otherwise its
+// capacity plus the terminator.
+inline std::size_t heap_bytes(const std::string& text) {
+  const char* data = text.data();
+  const char* object = reinterpret_cast<const char*>(&text);
+  const bool inline_storage = data >= object && data < object + sizeof text;
+  return inline_storage ? 0 : text.capacity() + 1;
+}
+
+// Returns the bytes one Book occupies, counting the heap storage of its
+// strings.
+inline std::size_t footprint(const Book& book) {
+  return sizeof(Book) + heap_bytes(book.isbn()) + heap_bytes(book.title()) +
+         heap_bytes(book.author());
+}
+
+#endif
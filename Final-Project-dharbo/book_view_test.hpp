@@ -0,0 +1,117 @@
+#ifndef _book_view_test_hpp_
+#define _book_view_test_hpp_
+
+#include "book_view.hpp"
+
+#include <cstddef>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+#include "operations.hpp"
+
+TEST_CASE("BookView") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+
+  SUBCASE("ViewsBook") {
+    const BookView view(book);
+    CHECK_EQ(view.isbn(), "isbn");
+    CHECK_EQ(view.title(), "title");
+    CHECK_EQ(view.author(), "author");
+    CHECK_EQ(view.price(), 123.45);
+    CHECK_EQ(view.isbn().data(), book.isbn().data());
+    CHECK_EQ(view.to_book(), book);
+  }
+
+  SUBCASE("OrdersLikeBook") {
+    CHECK_EQ(BookView(book) < BookView(other_book), book < other_book);
+    CHECK_EQ(BookView(other_book) < BookView(book), other_book < book);
+    CHECK_EQ(BookView(book), BookView(Book(book)));
+    CHECK_NE(BookView(book), BookView(Book(book).price(1.0)));
+  }
+
+  SUBCASE("WritesLikeBook") {
+    const Book quoted = Book("a, \"b\"", "c\\d", "1", 2.5);
+    std::ostringstream expected, actual;
+    expected << quoted;
+    actual << BookView(quoted);
+    CHECK_EQ(actual.str(), expected.str());
+  }
+}
+
+TEST_CASE("BookArena") {
+  BookArena arena;
+
+  SUBCASE("StoresCopies") {
+    std::string text = "title";
+    const std::string_view stored = arena.store_string(text);
+    text = "changed";
+    CHECK_EQ(stored, "title");
+    CHECK_NE(stored.data(), text.data());
+  }
+
+  SUBCASE("ViewsSurviveNewBlocks") {
+    std::vector<Book> books;
+    for (std::size_t i = 0; i < 2000; ++i) {
+      books.push_back(Book(std::string(100, 't') + std::to_string(i), "author",
+                           std::to_string(i), static_cast<double>(i)));
+    }
+    const std::vector<BookView> views = store_books(arena, books);
+    CHECK_GT(arena.block_count(), 1);
+    REQUIRE_EQ(views.size(), books.size());
+    for (std::size_t i = 0; i < books.size(); ++i) {
+      CHECK_EQ(views[i].to_book(), books[i]);
+    }
+  }
+
+  SUBCASE("OversizedString") {
+    const std::string text(BookArena::BLOCK_SIZE * 2, 'x');
+    CHECK_EQ(arena.store_string(text), text);
+    CHECK_GE(arena.bytes_reserved(), text.size());
+  }
+}
+
+TEST_CASE("OperationsOnBookViews") {
+  BookArena arena;
+  const BookView view = arena.store(Book("title", "author", "isbn", 123.45));
+  const BookView other_view =
+      arena.store(Book("other-title", "other-author", "other-isbn", 543.21));
+
+  SUBCASE("Vector") {
+    std::vector<BookView> vector;
+    insert_at_back_of_vector{vector}(view);
+    insert_at_front_of_vector{vector}(other_view);
+    CHECK_EQ(vector, std::vector<BookView>{other_view, view});
+    CHECK_EQ(search_within_vector{vector, "isbn"}(view), &vector[1]);
+    remove_from_front_of_vector{vector}(view);
+    CHECK_EQ(vector, std::vector<BookView>{view});
+  }
+
+  SUBCASE("Bst") {
+    std::map<std::string_view, BookView> bst;
+    insert_into_bst{bst}(view);
+    insert_into_bst{bst}(other_view);
+    CHECK_EQ(bst.size(), 2);
+    CHECK_EQ(search_within_bst{bst, "isbn"}(view), &bst.at("isbn"));
+    remove_from_bst{bst}(view);
+    CHECK_EQ(search_within_bst{bst, "isbn"}(view), nullptr);
+  }
+
+  SUBCASE("HashTable") {
+    std::unordered_map<std::string_view, BookView> hash_table;
+    const std::vector<BookView> views = {view, other_view};
+    bulk_insert_into_hash_table{hash_table}(views.begin(), views.end());
+    CHECK_EQ(hash_table.size(), 2);
+    CHECK_EQ(search_within_hash_table{hash_table, "other-isbn"}(view),
+             &hash_table.at("other-isbn"));
+  }
+}
+
+#endif
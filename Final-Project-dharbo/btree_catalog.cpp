@@ -0,0 +1,456 @@
+#include "btree_catalog.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "book.hpp"
+#include "buffer_pool.hpp"
+
+namespace {
+
+//
+// File Header (page 0)
+//
+
+struct TreeHeader {
+  static constexpr char MAGIC[8] = {'B', 'O', 'O', 'K', 'T', 'R', 'E', 'E'};
+  static constexpr std::uint32_t VERSION = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t page_size;
+  std::uint32_t root;
+  std::uint32_t height;
+  std::uint64_t record_count;
+};
+
+//
+// Nodes
+//
+
+enum NodeKind : std::uint16_t { LEAF = 1, INNER = 2 };
+
+// Offsets of the node header fields, all native byte order.
+constexpr std::size_t KIND_AT = 0;                    // uint16_t NodeKind
+constexpr std::size_t COUNT_AT = 2;                   // uint16_t cells in the node
+constexpr std::size_t CELL_START_AT = 4;              // uint16_t offset of the lowest cell
+constexpr std::size_t GARBAGE_AT = 6;                 // uint16_t bytes of erased cells
+constexpr std::size_t LINK_AT = 8;                    // uint32_t next leaf, or leftmost child
+constexpr std::size_t SLOTS_AT = 16;
+
+constexpr std::size_t LEAF_CELL_HEADER = 16;
+constexpr std::size_t INNER_CELL_HEADER = 8;
+
+template <class T>
+T load(const char* at) {
+  T value;
+  std::memcpy(&value, at, sizeof value);
+  return value;
+}
+
+template <class T>
+void store(char* at, T value) {
+  std::memcpy(at, &value, sizeof value);
+}
+
+// Read access to a node in a page buffer.
+class NodeView {
+ public:
+  explicit NodeView(const char* page) : page_(page) {}
+
+  bool leaf() const { return load<std::uint16_t>(page_ + KIND_AT) == LEAF; }
+  std::size_t count() const { return load<std::uint16_t>(page_ + COUNT_AT); }
+  std::size_t cell_start() const { return load<std::uint16_t>(page_ + CELL_START_AT); }
+  std::size_t garbage() const { return load<std::uint16_t>(page_ + GARBAGE_AT); }
+  PageId link() const { return load<std::uint32_t>(page_ + LINK_AT); }
+
+  std::size_t free_space() const { return cell_start() - SLOTS_AT - 2 * count(); }
+
+  const char* cell(std::size_t i) const {
+    return page_ + load<std::uint16_t>(page_ + SLOTS_AT + 2 * i);
+  }
+
+  std::size_t cell_size(std::size_t i) const {
+    const char* at = cell(i);
+    if (leaf()) {
+      return LEAF_CELL_HEADER + load<std::uint16_t>(at) + load<std::uint16_t>(at + 2) +
+             load<std::uint16_t>(at + 4);
+    }
+    return INNER_CELL_HEADER + load<std::uint16_t>(at);
+  }
+
+  std::string_view key(std::size_t i) const {
+    const char* at = cell(i);
+    return {at + (leaf() ? LEAF_CELL_HEADER : INNER_CELL_HEADER), load<std::uint16_t>(at)};
+  }
+
+  PageId child(std::size_t i) const { return load<std::uint32_t>(cell(i) + 4); }
+
+  Book book(std::size_t i) const {
+    const char* at = cell(i);
+    const std::size_t isbn_size = load<std::uint16_t>(at);
+    const std::size_t title_size = load<std::uint16_t>(at + 2);
+    const std::size_t author_size = load<std::uint16_t>(at + 4);
+    const char* isbn = at + LEAF_CELL_HEADER;
+    const char* title = isbn + isbn_size;
+    const char* author = title + title_size;
+    return Book(std::string(title, title_size), std::string(author, author_size),
+                std::string(isbn, isbn_size), load<double>(at + 8));
+  }
+
+  // The first cell whose key is not less than "key".
+  std::size_t lower_bound(std::string_view key) const {
+    std::size_t low = 0, high = count();
+    while (low < high) {
+      const std::size_t middle = (low + high) / 2;
+      if (this->key(middle) < key) low = middle + 1; else high = middle;
+    }
+    return low;
+  }
+
+  // The first cell whose key is greater than "key".
+  std::size_t upper_bound(std::string_view key) const {
+    std::size_t low = 0, high = count();
+    while (low < high) {
+      const std::size_t middle = (low + high) / 2;
+      if (key < this->key(middle)) high = middle; else low = middle + 1;
+    }
+    return low;
+  }
+
+  // The child of an inner node whose subtree holds "key".
+  PageId child_for(std::string_view key) const {
+    const std::size_t i = upper_bound(key);
+    return i == 0 ? link() : child(i - 1);
+  }
+
+  // Copies of every cell, in key order.
+  std::vector<std::string> cells() const {
+    std::vector<std::string> result;
+    result.reserve(count());
+    for (std::size_t i = 0; i < count(); ++i) {
+      result.emplace_back(cell(i), cell_size(i));
+    }
+    return result;
+  }
+
+ private:
+  const char* page_;
+};
+
+std::string leaf_cell(const Book& book) {
+  std::string cell(LEAF_CELL_HEADER, '\0');
+  store<std::uint16_t>(&cell[0], static_cast<std::uint16_t>(book.isbn().size()));
+  store<std::uint16_t>(&cell[2], static_cast<std::uint16_t>(book.title().size()));
+  store<std::uint16_t>(&cell[4], static_cast<std::uint16_t>(book.author().size()));
+  store<double>(&cell[8], book.price());
+  return cell + book.isbn() + book.title() + book.author();
+}
+
+std::string inner_cell(std::string_view key, PageId child) {
+  std::string cell(INNER_CELL_HEADER, '\0');
+  store<std::uint16_t>(&cell[0], static_cast<std::uint16_t>(key.size()));
+  store<std::uint32_t>(&cell[4], child);
+  return cell.append(key);
+}
+
+// The key of a cell copied out of a node of kind "kind".
+std::string_view cell_key(const std::string& cell, NodeKind kind) {
+  return std::string_view(cell).substr(kind == LEAF ? LEAF_CELL_HEADER : INNER_CELL_HEADER,
+                                       load<std::uint16_t>(cell.data()));
+}
+
+// Replaces the contents of "page" with a node holding "cells" in order.
+void rebuild(char* page, NodeKind kind, PageId link,
+             std::vector<std::string>::const_iterator first,
+             std::vector<std::string>::const_iterator last) {
+  std::memset(page, 0, PAGE_SIZE);
+  store<std::uint16_t>(page + KIND_AT, kind);
+  store<std::uint16_t>(page + COUNT_AT, static_cast<std::uint16_t>(last - first));
+  store<std::uint32_t>(page + LINK_AT, link);
+  std::size_t cell_start = PAGE_SIZE;
+  for (std::size_t i = 0; first != last; ++first, ++i) {
+    cell_start -= first->size();
+    std::memcpy(page + cell_start, first->data(), first->size());
+    store<std::uint16_t>(page + SLOTS_AT + 2 * i, static_cast<std::uint16_t>(cell_start));
+  }
+  store<std::uint16_t>(page + CELL_START_AT, static_cast<std::uint16_t>(cell_start));
+}
+
+void rebuild(char* page, NodeKind kind, PageId link, const std::vector<std::string>& cells) {
+  rebuild(page, kind, link, cells.begin(), cells.end());
+}
+
+// Inserts "cell" as cell "index" of the node in "page", compacting the node
+// first if only the erased cells' space would make room. Returns false if
+// the cell does not fit.
+bool insert_cell(char* page, std::size_t index, const std::string& cell) {
+  NodeView node(page);
+  const std::size_t needed = cell.size() + 2;
+  if (node.free_space() < needed) {
+    if (node.free_space() + node.garbage() < needed) {
+      return false;
+    }
+    rebuild(page, node.leaf() ? LEAF : INNER, node.link(), node.cells());
+  }
+
+  const std::size_t count = node.count();
+  const std::size_t cell_start = node.cell_start() - cell.size();
+  std::memcpy(page + cell_start, cell.data(), cell.size());
+  char* slots = page + SLOTS_AT;
+  std::memmove(slots + 2 * (index + 1), slots + 2 * index, 2 * (count - index));
+  store<std::uint16_t>(slots + 2 * index, static_cast<std::uint16_t>(cell_start));
+  store<std::uint16_t>(page + COUNT_AT, static_cast<std::uint16_t>(count + 1));
+  store<std::uint16_t>(page + CELL_START_AT, static_cast<std::uint16_t>(cell_start));
+  return true;
+}
+
+void remove_cell(char* page, std::size_t index) {
+  NodeView node(page);
+  const std::size_t count = node.count();
+  store<std::uint16_t>(page + GARBAGE_AT, static_cast<std::uint16_t>(node.garbage() + node.cell_size(index)));
+  char* slots = page + SLOTS_AT;
+  std::memmove(slots + 2 * index, slots + 2 * (index + 1), 2 * (count - index - 1));
+  store<std::uint16_t>(page + COUNT_AT, static_cast<std::uint16_t>(count - 1));
+}
+
+// The number of cells to keep on the left of a split: enough to hold about
+// half the bytes, leaving at least "right_minimum" cells on the right.
+std::size_t split_point(const std::vector<std::string>& cells, std::size_t right_minimum) {
+  std::size_t total = 0;
+  for (const std::string& cell : cells) total += cell.size() + 2;
+  std::size_t left = 0, bytes = 0;
+  while (left + right_minimum < cells.size() && bytes < total / 2) {
+    bytes += cells[left++].size() + 2;
+  }
+  return std::max<std::size_t>(left, 1);
+}
+
+[[noreturn]] void reject(const std::string& path, const std::string& reason) {
+  throw std::runtime_error(path + " is not a usable B+tree catalog: " + reason);
+}
+
+}  // namespace
+
+//
+// Constructor and Destructor
+//
+
+BTreeCatalog::BTreeCatalog(const std::string& path, std::size_t pool_pages)
+    : file_(path), pool_(file_, pool_pages) {
+  if (file_.page_count() == 0) {
+    BufferPool::PageRef header = pool_.create();
+    BufferPool::PageRef root = pool_.create();
+    rebuild(root.mutable_data(), LEAF, 0, {});
+    root_ = root.id();
+    height_ = 1;
+    header.release();
+    write_header();
+    return;
+  }
+
+  const BufferPool::PageRef page = pool_.fetch(0);
+  TreeHeader header;
+  std::memcpy(&header, page.data(), sizeof header);
+  if (std::memcmp(header.magic, TreeHeader::MAGIC, sizeof header.magic) != 0) {
+    reject(path, "bad magic number");
+  }
+  if (header.version != TreeHeader::VERSION || header.page_size != PAGE_SIZE) {
+    reject(path, "unsupported version or page size");
+  }
+  if (header.root == 0 || header.root >= file_.page_count() || header.height == 0) {
+    reject(path, "root page out of bounds");
+  }
+  root_ = header.root;
+  height_ = header.height;
+  record_count_ = header.record_count;
+}
+
+BTreeCatalog::~BTreeCatalog() noexcept {
+  try {
+    write_header();
+  } catch (...) {
+  }
+}
+
+void BTreeCatalog::write_header() {
+  TreeHeader header{};
+  std::memcpy(header.magic, TreeHeader::MAGIC, sizeof header.magic);
+  header.version = TreeHeader::VERSION;
+  header.page_size = PAGE_SIZE;
+  header.root = root_;
+  header.height = static_cast<std::uint32_t>(height_);
+  header.record_count = record_count_;
+  BufferPool::PageRef page = pool_.fetch(0);
+  std::memcpy(page.mutable_data(), &header, sizeof header);
+}
+
+//
+// Modifiers
+//
+
+void BTreeCatalog::insert(const Book& book) {
+  if (LEAF_CELL_HEADER + book.isbn().size() + book.title().size() + book.author().size() >
+      MAX_CELL_SIZE) {
+    throw std::length_error("book " + book.isbn() + " is too large for a B+tree page");
+  }
+
+  bool added = false;
+  const std::optional<Split> split = insert_into(root_, book, added);
+  if (split) {
+    // The root split: grow the tree by one level.
+    BufferPool::PageRef root = pool_.create();
+    const std::vector<std::string> cells{inner_cell(split->separator, split->right)};
+    rebuild(root.mutable_data(), INNER, root_, cells);
+    root_ = root.id();
+    ++height_;
+  }
+  if (added) {
+    ++record_count_;
+  }
+}
+
+std::optional<BTreeCatalog::Split> BTreeCatalog::insert_into(PageId page, const Book& book,
+                                                              bool& added) {
+  BufferPool::PageRef ref = pool_.fetch(page);
+  std::string cell;
+  std::size_t index;
+  NodeKind kind;
+  {
+    const NodeView node(ref.data());
+    if (node.leaf()) {
+      kind = LEAF;
+      index = node.lower_bound(book.isbn());
+      added = index == node.count() || node.key(index) != book.isbn();
+      if (!added) {
+        remove_cell(ref.mutable_data(), index);
+      }
+      cell = leaf_cell(book);
+    } else {
+      // Unpin this node while the child works, so that only a few pages are
+      // ever pinned at once however tall the tree is.
+      kind = INNER;
+      const PageId child = node.child_for(book.isbn());
+      ref.release();
+      std::optional<Split> split = insert_into(child, book, added);
+      if (!split) {
+        return std::nullopt;
+      }
+      ref = pool_.fetch(page);
+      index = NodeView(ref.data()).upper_bound(split->separator);
+      cell = inner_cell(split->separator, split->right);
+    }
+  }
+
+  if (insert_cell(ref.mutable_data(), index, cell)) {
+    return std::nullopt;
+  }
+
+  // No room: split this node in two by bytes.
+  const NodeView node(ref.data());
+  std::vector<std::string> cells = node.cells();
+  cells.insert(cells.begin() + index, cell);
+  BufferPool::PageRef right = pool_.create();
+  Split split;
+  split.right = right.id();
+
+  if (kind == LEAF) {
+    const std::size_t left = split_point(cells, 1);
+    split.separator = std::string(cell_key(cells[left], LEAF));
+    rebuild(right.mutable_data(), LEAF, node.link(), cells.begin() + left, cells.end());
+    rebuild(ref.mutable_data(), LEAF, split.right, cells.begin(), cells.begin() + left);
+  } else {
+    // The middle key moves up; its child becomes the right node's leftmost.
+    const std::size_t middle = split_point(cells, 2);
+    split.separator = std::string(cell_key(cells[middle], INNER));
+    const PageId leftmost = load<std::uint32_t>(cells[middle].data() + 4);
+    const PageId link = node.link();
+    rebuild(right.mutable_data(), INNER, leftmost, cells.begin() + middle + 1, cells.end());
+    rebuild(ref.mutable_data(), INNER, link, cells.begin(), cells.begin() + middle);
+  }
+  return split;
+}
+
+bool BTreeCatalog::erase(std::string_view isbn) {
+  BufferPool::PageRef ref = pool_.fetch(find_leaf(isbn));
+  const NodeView node(ref.data());
+  const std::size_t index = node.lower_bound(isbn);
+  if (index == node.count() || node.key(index) != isbn) {
+    return false;
+  }
+  remove_cell(ref.mutable_data(), index);
+  --record_count_;
+  return true;
+}
+
+void BTreeCatalog::flush() {
+  write_header();
+  pool_.flush();
+  file_.sync();
+}
+
+//
+// Queries
+//
+
+PageId BTreeCatalog::find_leaf(std::string_view isbn) const {
+  PageId page = root_;
+  for (;;) {
+    const BufferPool::PageRef ref = pool_.fetch(page);
+    const NodeView node(ref.data());
+    if (node.leaf()) {
+      return page;
+    }
+    page = node.child_for(isbn);
+  }
+}
+
+std::optional<Book> BTreeCatalog::find(std::string_view isbn) const {
+  const BufferPool::PageRef ref = pool_.fetch(find_leaf(isbn));
+  const NodeView node(ref.data());
+  const std::size_t index = node.lower_bound(isbn);
+  if (index == node.count() || node.key(index) != isbn) {
+    return std::nullopt;
+  }
+  return node.book(index);
+}
+
+void BTreeCatalog::for_each_in_range(std::string_view first, std::string_view last,
+                                     const std::function<void(const Book&)>& visit) const {
+  scan(first, last, visit);
+}
+
+void BTreeCatalog::for_each_from(std::string_view first,
+                                 const std::function<void(const Book&)>& visit) const {
+  scan(first, std::nullopt, visit);
+}
+
+// Visits [first, last), or everything from "first" on without "last".
+void BTreeCatalog::scan(std::string_view first, std::optional<std::string_view> last,
+                        const std::function<void(const Book&)>& visit) const {
+  PageId page = find_leaf(first);
+  BufferPool::PageRef ref = pool_.fetch(page);
+  std::size_t index = NodeView(ref.data()).lower_bound(first);
+  for (;;) {
+    const NodeView node(ref.data());
+    for (; index < node.count(); ++index) {
+      if (last && node.key(index) >= *last) {
+        return;
+      }
+      visit(node.book(index));
+    }
+    if (node.link() == 0) {
+      return;
+    }
+    ref = pool_.fetch(node.link());
+    index = 0;
+  }
+}
@@ -0,0 +1,157 @@
+#ifndef _btree_catalog_hpp_
+#define _btree_catalog_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "book.hpp"
+#include "buffer_pool.hpp"
+
+// A catalog of Books kept in a file as a B+tree keyed by ISBN, for catalogs
+// too large to hold in memory. Only the pages in the buffer pool are in
+// memory; everything else is read from the file when a lookup reaches it.
+//
+// File layout: page 0 holds the header (magic number, version, root page,
+// record count, height); every other page is a node. Nodes are slotted
+// pages: a small header, an array of 2-byte cell offsets sorted by key
+// growing from the front, and the cells themselves packed from the back.
+//
+//   leaf cell   isbn length, title length, author length (2 bytes each),
+//               2 bytes padding, price (8 bytes), then the three strings
+//   inner cell  key length (2 bytes), 2 bytes padding, child page (4 bytes),
+//               then the key; the child holds keys >= this key, and the
+//               node header's link holds the child for keys below the first
+//
+// Leaves are chained left to right through their header link for range
+// scans. A node that runs out of room splits in half by bytes and passes the
+// first key of the new right node up to its parent. Erasing only removes the
+// cell: nodes are not merged, and the space is reused by later inserts into
+// the same node.
+//
+// Usage:
+//
+//   BTreeCatalog catalog("catalog.btree", 1024);   // cache up to 1024 pages (4 MB)
+//   catalog.insert(book);
+//   std::optional<Book> found = catalog.find(book.isbn());
+//   catalog.for_each_in_range("0000", "1000", [](const Book& book) { ... });
+//
+// Not thread-safe.
+class BTreeCatalog {
+ public:
+  // The largest record a leaf cell can hold (ISBN, title, and author bytes
+  // plus 16), so that any node can take at least four cells.
+  static constexpr std::size_t MAX_CELL_SIZE = 1000;
+
+  static constexpr std::size_t DEFAULT_POOL_PAGES = 1024;
+
+  // Opens the catalog in "path", creating an empty one if the file is empty
+  // or missing, with a buffer pool of "pool_pages" pages. Throws
+  // std::system_error on I/O errors and std::runtime_error if the file is not
+  // a catalog.
+  explicit BTreeCatalog(const std::string& path,
+                        std::size_t pool_pages = DEFAULT_POOL_PAGES);
+
+  BTreeCatalog(const BTreeCatalog&) = delete;
+  BTreeCatalog& operator=(const BTreeCatalog&) = delete;
+
+  // Writes the header and every dirty page back to the file.
+  ~BTreeCatalog() noexcept;
+
+  //
+  // Modifiers
+  //
+
+  // Inserts "book", replacing any book with the same ISBN. Throws
+  // std::length_error if the record is larger than MAX_CELL_SIZE.
+  void insert(const Book& book);
+
+  // Removes the book with ISBN "isbn". Returns false if there is none.
+  bool erase(std::string_view isbn);
+
+  // Writes the header and every dirty page to the file and syncs it.
+  void flush();
+
+  //
+  // Queries
+  //
+
+  std::optional<Book> find(std::string_view isbn) const;
+
+  // Calls "visit(book)" for every book with an ISBN in [first, last), in ISBN
+  // order.
+  void for_each_in_range(std::string_view first, std::string_view last,
+                         const std::function<void(const Book&)>& visit) const;
+
+  // Calls "visit(book)" for every book with an ISBN of at least "first", in
+  // ISBN order.
+  void for_each_from(std::string_view first, const std::function<void(const Book&)>& visit) const;
+
+  std::size_t size() const { return record_count_; }
+  bool empty() const { return record_count_ == 0; }
+
+  // Levels of nodes from the root to the leaves.
+  std::size_t height() const { return height_; }
+
+  std::size_t page_count() const { return file_.page_count(); }
+
+  const BufferPool& pool() const { return pool_; }
+  BufferPool& pool() { return pool_; }
+
+ private:
+  // What a node passes up to its parent after splitting.
+  struct Split {
+    std::string separator;
+    PageId right = 0;
+  };
+
+  std::optional<Split> insert_into(PageId page, const Book& book, bool& added);
+  PageId find_leaf(std::string_view isbn) const;
+  void scan(std::string_view first, std::optional<std::string_view> last,
+            const std::function<void(const Book&)>& visit) const;
+  void write_header();
+
+  PageFile file_;
+  mutable BufferPool pool_;
+  PageId root_ = 0;
+  std::size_t record_count_ = 0;
+  std::size_t height_ = 0;
+};
+
+//
+// B+TREE OPERATIONS
+//
+
+struct insert_into_btree {
+  // Function takes a constant Book as a parameter, inserts that book indexed by
+  // the book's ISBN into an on-disk B+tree, and returns nothing.
+  void operator()(const Book& book) { my_btree.insert(book); }
+
+  BTreeCatalog& my_btree;
+};
+
+struct remove_from_btree {
+  // Function takes a constant Book as a parameter, finds and removes from the
+  // on-disk B+tree the book with a matching ISBN (if any), and returns nothing.
+  // If no Book matches the ISBN, the method does nothing.
+  void operator()(const Book& book) { my_btree.erase(book.isbn()); }
+
+  BTreeCatalog& my_btree;
+};
+
+struct search_within_btree {
+  // Function takes no parameters, searches an on-disk B+tree for a book with an
+  // ISBN matching the target ISBN, and returns a copy of that book if such a
+  // book is found, an empty optional otherwise.
+  std::optional<Book> operator()(const Book& unused) {
+    return my_btree.find(target_isbn);
+  }
+
+  const BTreeCatalog& my_btree;
+  const std::string target_isbn;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef _btree_catalog_test_hpp_
+#define _btree_catalog_test_hpp_
+
+#include "btree_catalog.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "buffer_pool.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("BufferPool") {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "buffer_pool_test.pages";
+  std::filesystem::remove(path);
+
+  {
+    PageFile file(path.string());
+    BufferPool pool(file, BufferPool::MIN_CAPACITY);
+    for (std::size_t i = 0; i < 3 * pool.capacity(); ++i) {
+      BufferPool::PageRef page = pool.create();
+      std::memset(page.mutable_data(), static_cast<int>(i), PAGE_SIZE);
+    }
+    CHECK_EQ(file.page_count(), 3 * pool.capacity());
+    CHECK_GT(pool.evictions(), 0);
+
+    // Evicted pages were written back and read in again intact.
+    for (PageId i = 0; i < file.page_count(); ++i) {
+      CHECK_EQ(pool.fetch(i).data()[PAGE_SIZE - 1], static_cast<char>(i));
+    }
+    CHECK_GT(pool.misses(), 0);
+
+    std::vector<BufferPool::PageRef> pinned;
+    for (PageId i = 0; i < pool.capacity(); ++i) pinned.push_back(pool.fetch(i));
+    CHECK_THROWS_AS(pool.fetch(static_cast<PageId>(pool.capacity())), std::runtime_error);
+  }
+
+  {
+    PageFile file(path.string());
+    BufferPool pool(file, BufferPool::MIN_CAPACITY);
+    CHECK_EQ(file.page_count(), 3 * pool.capacity());
+    CHECK_EQ(pool.fetch(5).data()[0], 5);
+  }
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("BTreeCatalog") {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "btree_catalog_test.btree";
+  std::filesystem::remove(path);
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+
+  SUBCASE("InsertFindErase") {
+    BTreeCatalog catalog(path.string());
+    CHECK(catalog.empty());
+    insert_into_btree{catalog}(book);
+    insert_into_btree{catalog}(other_book);
+    CHECK_EQ(catalog.size(), 2);
+    CHECK_EQ(search_within_btree{catalog, book.isbn()}(Book{}), book);
+
+    insert_into_btree{catalog}(Book(book).price(1.0));
+    CHECK_EQ(catalog.size(), 2);
+    CHECK_EQ(catalog.find(book.isbn())->price(), 1.0);
+
+    remove_from_btree{catalog}(book);
+    CHECK_EQ(catalog.size(), 1);
+    CHECK_EQ(search_within_btree{catalog, book.isbn()}(Book{}), std::nullopt);
+    CHECK_FALSE(catalog.erase(book.isbn()));
+    CHECK_EQ(catalog.find(other_book.isbn()), other_book);
+  }
+
+  SUBCASE("MatchesStdMapUnderPaging") {
+    std::map<std::string, Book> expected;
+    std::default_random_engine random(131);
+    std::uniform_int_distribution<int> title_length(0, 200);
+    {
+      // A pool far smaller than the tree, so pages are evicted constantly.
+      BTreeCatalog catalog(path.string(), BufferPool::MIN_CAPACITY);
+      for (std::size_t i = 0; i < 20000; ++i) {
+        const std::string isbn = std::to_string(random() % 15000);
+        const Book next(std::string(title_length(random), 't'), "author", isbn,
+                        static_cast<double>(i));
+        if (random() % 4 == 0) {
+          CHECK_EQ(catalog.erase(isbn), expected.erase(isbn) == 1);
+        } else {
+          catalog.insert(next);
+          expected[isbn] = next;
+        }
+      }
+      CHECK_EQ(catalog.size(), expected.size());
+      CHECK_GT(catalog.height(), 2);
+      CHECK_GT(catalog.pool().evictions(), 0);
+    }
+
+    // Reopened from the file.
+    BTreeCatalog catalog(path.string(), 64);
+    REQUIRE_EQ(catalog.size(), expected.size());
+    for (const auto& [isbn, expected_book] : expected) {
+      CHECK_EQ(catalog.find(isbn), expected_book);
+    }
+    CHECK_EQ(catalog.find("15000"), std::nullopt);
+
+    std::vector<Book> scanned;
+    catalog.for_each_in_range("2", "3", [&](const Book& found) { scanned.push_back(found); });
+    std::vector<Book> expected_range;
+    for (auto it = expected.lower_bound("2"); it != expected.lower_bound("3"); ++it) {
+      expected_range.push_back(it->second);
+    }
+    CHECK_EQ(scanned, expected_range);
+
+    std::size_t everything = 0;
+    catalog.for_each_in_range("", "\xff", [&](const Book&) { ++everything; });
+    CHECK_EQ(everything, expected.size());
+  }
+
+  SUBCASE("RejectsBadInput") {
+    {
+      BTreeCatalog catalog(path.string());
+      CHECK_THROWS_AS(catalog.insert(Book(std::string(BTreeCatalog::MAX_CELL_SIZE, 't'), "", "1")),
+                      std::length_error);
+      CHECK(catalog.empty());
+    }
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file << std::string(PAGE_SIZE, 'x');
+    }
+    CHECK_THROWS_AS(BTreeCatalog(path.string()), std::runtime_error);
+  }
+
+  std::filesystem::remove(path);
+}
+
+#endif
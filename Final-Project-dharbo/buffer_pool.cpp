@@ -0,0 +1,176 @@
+#include "buffer_pool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//
+// PageFile
+//
+
+PageFile::PageFile(const std::string& path) : path_(path) {
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "open " + path);
+  }
+  struct stat status;
+  if (::fstat(fd_, &status) != 0) {
+    const int error = errno;
+    ::close(fd_);
+    throw std::system_error(error, std::generic_category(), "stat " + path);
+  }
+  page_count_ = static_cast<std::size_t>(status.st_size) / PAGE_SIZE;
+}
+
+PageFile::PageFile(PageFile&& other) noexcept
+    : path_(std::move(other.path_)),
+      fd_(std::exchange(other.fd_, -1)),
+      page_count_(std::exchange(other.page_count_, 0)) {}
+
+PageFile& PageFile::operator=(PageFile&& other) noexcept {
+  if (this != &other) {
+    PageFile discarded(std::move(*this));
+    path_ = std::move(other.path_);
+    fd_ = std::exchange(other.fd_, -1);
+    page_count_ = std::exchange(other.page_count_, 0);
+  }
+  return *this;
+}
+
+PageFile::~PageFile() noexcept {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+void PageFile::read(PageId page, char* buffer) const {
+  std::size_t done = 0;
+  while (done < PAGE_SIZE) {
+    const ssize_t count = ::pread(fd_, buffer + done, PAGE_SIZE - done,
+                                  static_cast<off_t>(page) * PAGE_SIZE + done);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      throw std::system_error(errno, std::generic_category(), "read " + path_);
+    }
+    if (count == 0) {
+      // Allocated but never written: reads as zeros.
+      std::memset(buffer + done, 0, PAGE_SIZE - done);
+      return;
+    }
+    done += count;
+  }
+}
+
+void PageFile::write(PageId page, const char* buffer) {
+  std::size_t done = 0;
+  while (done < PAGE_SIZE) {
+    const ssize_t count = ::pwrite(fd_, buffer + done, PAGE_SIZE - done,
+                                   static_cast<off_t>(page) * PAGE_SIZE + done);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      throw std::system_error(errno, std::generic_category(), "write " + path_);
+    }
+    done += count;
+  }
+}
+
+void PageFile::sync() {
+  if (::fsync(fd_) != 0) {
+    throw std::system_error(errno, std::generic_category(), "fsync " + path_);
+  }
+}
+
+//
+// BufferPool
+//
+
+BufferPool::BufferPool(PageFile& file, std::size_t capacity)
+    : file_(file),
+      frames_(std::max(capacity, MIN_CAPACITY)),
+      memory_(new char[frames_.size() * PAGE_SIZE]) {
+  page_table_.reserve(frames_.size());
+}
+
+BufferPool::~BufferPool() noexcept {
+  try {
+    flush();
+  } catch (...) {
+  }
+}
+
+BufferPool::PageRef BufferPool::fetch(PageId page) {
+  const auto cached = page_table_.find(page);
+  if (cached != page_table_.end()) {
+    Frame& frame = frames_[cached->second];
+    ++frame.pins;
+    frame.referenced = true;
+    ++hits_;
+    return PageRef(this, cached->second);
+  }
+
+  const std::size_t frame = evict();
+  file_.read(page, frame_data(frame));
+  frames_[frame] = Frame{page, 1, true, false};
+  page_table_.emplace(page, frame);
+  ++misses_;
+  return PageRef(this, frame);
+}
+
+BufferPool::PageRef BufferPool::create() {
+  const std::size_t frame = evict();
+  const PageId page = file_.allocate();
+  std::memset(frame_data(frame), 0, PAGE_SIZE);
+  frames_[frame] = Frame{page, 1, true, true};
+  page_table_.emplace(page, frame);
+  return PageRef(this, frame);
+}
+
+void BufferPool::flush() {
+  for (std::size_t frame = 0; frame < frames_.size(); ++frame) {
+    write_back(frame);
+  }
+}
+
+std::size_t BufferPool::evict() {
+  // Two full sweeps clear every reference bit, so a third finding nothing
+  // means every frame is pinned.
+  for (std::size_t step = 0; step < 3 * frames_.size(); ++step) {
+    const std::size_t frame = hand_;
+    hand_ = (hand_ + 1) % frames_.size();
+    Frame& candidate = frames_[frame];
+    if (candidate.page == NO_PAGE) {
+      return frame;
+    }
+    if (candidate.pins > 0) {
+      continue;
+    }
+    if (candidate.referenced) {
+      candidate.referenced = false;
+      continue;
+    }
+    write_back(frame);
+    page_table_.erase(candidate.page);
+    candidate = Frame{};
+    ++evictions_;
+    return frame;
+  }
+  throw std::runtime_error("buffer pool exhausted: all " + std::to_string(frames_.size()) +
+                           " pages are pinned");
+}
+
+void BufferPool::write_back(std::size_t frame) {
+  Frame& candidate = frames_[frame];
+  if (candidate.page != NO_PAGE && candidate.dirty) {
+    file_.write(candidate.page, frame_data(frame));
+    candidate.dirty = false;
+    ++writes_;
+  }
+}
@@ -0,0 +1,171 @@
+#ifndef _buffer_pool_hpp_
+#define _buffer_pool_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Fixed-size pages of a file, and a bounded cache of them in memory.
+//
+// Page-oriented structures (the B+tree catalog) read and write whole pages
+// through a BufferPool, which keeps at most "capacity" pages in memory and
+// evicts with the clock algorithm: every cached page has a reference bit that
+// is set when it is used, and a hand sweeps the frames, clearing set bits and
+// evicting the first page whose bit is already clear. Dirty pages are written
+// back when they are evicted or flushed.
+//
+// POSIX only (pread/pwrite). Not thread-safe.
+
+constexpr std::size_t PAGE_SIZE = 4096;
+
+using PageId = std::uint32_t;
+
+// A file read and written a page at a time. Throws std::system_error on I/O
+// errors.
+class PageFile {
+ public:
+  // Opens "path", creating an empty file if there is none.
+  explicit PageFile(const std::string& path);
+
+  PageFile(const PageFile&) = delete;
+  PageFile& operator=(const PageFile&) = delete;
+  PageFile(PageFile&& other) noexcept;
+  PageFile& operator=(PageFile&& other) noexcept;
+
+  ~PageFile() noexcept;
+
+  // Pages in the file, counting those allocated but not yet written.
+  std::size_t page_count() const { return page_count_; }
+
+  void read(PageId page, char* buffer) const;
+  void write(PageId page, const char* buffer);
+
+  // Reserves a new page at the end of the file and returns its id.
+  PageId allocate() { return static_cast<PageId>(page_count_++); }
+
+  // Forces written pages to the disk.
+  void sync();
+
+ private:
+  std::string path_;
+  int fd_ = -1;
+  std::size_t page_count_ = 0;
+};
+
+class BufferPool {
+ public:
+  // The fewest frames a pool may have; a B+tree operation pins up to three
+  // pages at once.
+  static constexpr std::size_t MIN_CAPACITY = 8;
+
+  // Caches up to "capacity" pages of "file" (at least MIN_CAPACITY), which
+  // must outlive the pool.
+  BufferPool(PageFile& file, std::size_t capacity);
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  // Writes back dirty pages. Errors are swallowed here; call flush() to see
+  // them.
+  ~BufferPool() noexcept;
+
+  // A pinned page: it stays in memory, at the same address, until the last
+  // PageRef to it is destroyed.
+  class PageRef {
+   public:
+    PageRef() = default;
+    PageRef(const PageRef&) = delete;
+    PageRef& operator=(const PageRef&) = delete;
+    PageRef(PageRef&& other) noexcept
+        : pool_(std::exchange(other.pool_, nullptr)), frame_(other.frame_) {}
+    PageRef& operator=(PageRef&& other) noexcept {
+      if (this != &other) {
+        release();
+        pool_ = std::exchange(other.pool_, nullptr);
+        frame_ = other.frame_;
+      }
+      return *this;
+    }
+    ~PageRef() { release(); }
+
+    PageId id() const { return pool_->frames_[frame_].page; }
+    const char* data() const { return pool_->frame_data(frame_); }
+
+    // Writable bytes of the page; the page is written back before it leaves
+    // the pool.
+    char* mutable_data() {
+      pool_->frames_[frame_].dirty = true;
+      return pool_->frame_data(frame_);
+    }
+
+    // Unpins the page early.
+    void release() {
+      if (pool_ != nullptr) {
+        --pool_->frames_[frame_].pins;
+        pool_ = nullptr;
+      }
+    }
+
+   private:
+    friend class BufferPool;
+    PageRef(BufferPool* pool, std::size_t frame) : pool_(pool), frame_(frame) {}
+
+    BufferPool* pool_ = nullptr;
+    std::size_t frame_ = 0;
+  };
+
+  // Pins page "page", reading it from the file unless it is cached. Throws
+  // std::runtime_error if every frame is pinned.
+  PageRef fetch(PageId page);
+
+  // Allocates a new page in the file and pins it, zero filled and dirty.
+  PageRef create();
+
+  // Writes every dirty page back to the file.
+  void flush();
+
+  std::size_t capacity() const { return frames_.size(); }
+
+  //
+  // Statistics
+  //
+
+  std::size_t hits() const { return hits_; }
+  std::size_t misses() const { return misses_; }                    // pages read from the file
+  std::size_t evictions() const { return evictions_; }
+  std::size_t writes() const { return writes_; }                    // pages written to the file
+  void reset_statistics() { hits_ = misses_ = evictions_ = writes_ = 0; }
+
+ private:
+  static constexpr PageId NO_PAGE = ~PageId{0};
+
+  struct Frame {
+    PageId page = NO_PAGE;
+    std::size_t pins = 0;
+    bool referenced = false;
+    bool dirty = false;
+  };
+
+  char* frame_data(std::size_t frame) { return memory_.get() + frame * PAGE_SIZE; }
+
+  // Picks a frame to reuse and writes back the page in it, if any.
+  std::size_t evict();
+  void write_back(std::size_t frame);
+
+  PageFile& file_;
+  std::vector<Frame> frames_;
+  std::unique_ptr<char[]> memory_;
+  std::unordered_map<PageId, std::size_t> page_table_;              // cached page to its frame
+  std::size_t hand_ = 0;
+
+  std::size_t hits_ = 0;
+  std::size_t misses_ = 0;
+  std::size_t evictions_ = 0;
+  std::size_t writes_ = 0;
+};
+
+#endif
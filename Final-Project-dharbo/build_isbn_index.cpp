@@ -0,0 +1,33 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "isbn_index.hpp"
+#include "timer.hpp"
+
+// Writes the ISBN index sidecar for a text database or a snapshot, so that
+// IsbnIndex can look books up without building a hash table at startup.
+//
+// Usage:  build_isbn_index <database> [index]
+//
+// The index defaults to the database path plus ".idx". Rebuild it whenever
+// the database changes; IsbnIndex refuses an index whose database has changed
+// size.
+int main(int argc, char* argv[]) {
+  if (argc != 2 && argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <database> [index]\n";
+    return EXIT_FAILURE;
+  }
+
+  try {
+    const std::string database = argv[1];
+    const std::string index = argc == 3 ? argv[2] : isbn_index_path(database);
+    Utilities::Timer timer{"Timer:  index built in ", std::clog};
+    const std::size_t count = write_isbn_index(database, index);
+    std::clog << "Indexed " << count << " ISBNs of " << database << " in " << index << '\n';
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
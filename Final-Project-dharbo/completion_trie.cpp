@@ -0,0 +1,264 @@
+#include "completion_trie.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// A distinct string, with the prices of every book that has it, sorted.
+struct Entry {
+  Completion completion;
+  std::vector<double> prices;
+};
+
+}  // namespace
+
+struct CompletionTrie::Node {
+  std::string label;                                  // the bytes on the edge from the parent
+  std::vector<std::unique_ptr<Node>> children;        // by the first byte of their labels
+  std::unique_ptr<Entry> entry;                       // if a string ends here
+  std::vector<const Entry*> top;                      // the best of the subtree, best first
+};
+
+namespace {
+
+using Node = CompletionTrie::Node;
+
+// The child of "node" whose label starts with "byte", or end().
+template <class TrieNode>
+auto find_child(TrieNode& node, char byte) {
+  auto child = std::lower_bound(node.children.begin(), node.children.end(), byte,
+                                [](const std::unique_ptr<Node>& c, char b) { return c->label[0] < b; });
+  return child != node.children.end() && (*child)->label[0] == byte ? child : node.children.end();
+}
+
+// Every entry of the subtree at "node".
+void collect(const Node& node, std::vector<const Entry*>& out) {
+  if (node.entry) out.push_back(node.entry.get());
+  for (const auto& child : node.children) collect(*child, out);
+}
+
+std::size_t count_nodes(const Node& node) {
+  std::size_t count = 1;
+  for (const auto& child : node.children) count += count_nodes(*child);
+  return count;
+}
+
+std::size_t node_bytes(const Node& node) {
+  std::size_t bytes = sizeof(Node) + node.label.capacity() + node.children.capacity() * sizeof(node.children[0]) +
+                      node.top.capacity() * sizeof(node.top[0]);
+  if (node.entry) {
+    bytes += sizeof(Entry) + node.entry->completion.key.capacity() + node.entry->completion.text.capacity() +
+             node.entry->prices.capacity() * sizeof(double);
+  }
+  for (const auto& child : node.children) bytes += node_bytes(*child);
+  return bytes;
+}
+
+}  // namespace
+
+//
+// Constructors, Assignments, and Destructor
+//
+
+CompletionTrie::CompletionTrie(TextField field, CompletionRank rank, std::size_t cache_size)
+    : field_(field), rank_(rank), cache_size_(std::max<std::size_t>(cache_size, 1)), root_(std::make_unique<Node>()) {}
+
+CompletionTrie::~CompletionTrie() noexcept = default;
+CompletionTrie::CompletionTrie(CompletionTrie&&) noexcept = default;
+CompletionTrie& CompletionTrie::operator=(CompletionTrie&&) noexcept = default;
+
+//
+// Modifiers
+//
+
+void CompletionTrie::insert(std::string_view text, double price) {
+  const std::string key = completion_key(text);
+  if (key.empty()) {
+    return;
+  }
+
+  // Walk down, splitting the edge where the key leaves it.
+  std::vector<Node*> path{root_.get()};
+  for (std::size_t i = 0; i < key.size();) {
+    Node& node = *path.back();
+    auto child = find_child(node, key[i]);
+    if (child == node.children.end()) {
+      auto leaf = std::make_unique<Node>();
+      leaf->label = key.substr(i);
+      auto position = std::lower_bound(node.children.begin(), node.children.end(), key[i],
+                                       [](const std::unique_ptr<Node>& c, char b) { return c->label[0] < b; });
+      path.push_back(node.children.insert(position, std::move(leaf))->get());
+      break;
+    }
+    const std::string& label = (*child)->label;
+    const std::size_t common =
+        std::mismatch(label.begin(), label.end(), key.begin() + i, key.end()).first - label.begin();
+    if (common < label.size()) {
+      auto middle = std::make_unique<Node>();
+      middle->label = label.substr(0, common);
+      middle->top = (*child)->top;                    // the same strings below it
+      (*child)->label.erase(0, common);
+      middle->children.push_back(std::move(*child));
+      *child = std::move(middle);
+    }
+    path.push_back(child->get());
+    i += common;
+  }
+
+  Node& node = *path.back();
+  if (!node.entry) {
+    node.entry = std::make_unique<Entry>();
+    node.entry->completion.key = key;
+    node.entry->completion.text = std::string(text);
+    ++strings_;
+  }
+  Entry& entry = *node.entry;
+  entry.prices.insert(std::upper_bound(entry.prices.begin(), entry.prices.end(), price), price);
+  entry.completion.books = entry.prices.size();
+  entry.completion.price = entry.prices.back();
+  ++books_;
+
+  // The entry only got better: move it up in each cache, from the bottom,
+  // until one is full of better entries.
+  auto better = [&](const Entry* lhs, const Entry* rhs) { return ranks_before(lhs->completion, rhs->completion, rank_); };
+  for (auto at = path.rbegin(); at != path.rend(); ++at) {
+    std::vector<const Entry*>& top = (*at)->top;
+    top.erase(std::remove(top.begin(), top.end(), &entry), top.end());
+    top.insert(std::upper_bound(top.begin(), top.end(), &entry, better), &entry);
+    if (top.size() > cache_size_) {
+      const bool turned_away = top.back() == &entry;
+      top.pop_back();
+      if (turned_away) break;
+    }
+  }
+}
+
+bool CompletionTrie::remove(std::string_view text, double price) {
+  const std::string key = completion_key(text);
+  if (key.empty()) {
+    return false;
+  }
+  std::vector<Node*> path{root_.get()};
+  for (std::size_t i = 0; i < key.size();) {
+    auto child = find_child(*path.back(), key[i]);
+    if (child == path.back()->children.end() || key.compare(i, (*child)->label.size(), (*child)->label) != 0) {
+      return false;
+    }
+    i += (*child)->label.size();
+    path.push_back(child->get());
+  }
+  Node& node = *path.back();
+  if (!node.entry) {
+    return false;
+  }
+  Entry* entry = node.entry.get();
+  const auto found = std::lower_bound(entry->prices.begin(), entry->prices.end(), price);
+  if (found == entry->prices.end() || *found != price) {
+    return false;
+  }
+  entry->prices.erase(found);
+  --books_;
+
+  // Out of the trie, but alive until no cache points at it.
+  std::unique_ptr<Entry> removed;
+  if (entry->prices.empty()) {
+    removed = std::move(node.entry);
+    --strings_;
+  } else {
+    entry->completion.books = entry->prices.size();
+    entry->completion.price = entry->prices.back();
+  }
+
+  // The entry only got worse: rebuild each cache that held it from the
+  // caches below, from the bottom. A cache without it has none above.
+  auto better = [&](const Entry* lhs, const Entry* rhs) { return ranks_before(lhs->completion, rhs->completion, rank_); };
+  for (auto at = path.rbegin(); at != path.rend(); ++at) {
+    Node& cached = **at;
+    if (std::find(cached.top.begin(), cached.top.end(), entry) == cached.top.end()) break;
+    cached.top.clear();
+    if (cached.entry) cached.top.push_back(cached.entry.get());
+    for (const auto& child : cached.children) cached.top.insert(cached.top.end(), child->top.begin(), child->top.end());
+    const std::size_t kept = std::min(cache_size_, cached.top.size());
+    std::partial_sort(cached.top.begin(), cached.top.begin() + kept, cached.top.end(), better);
+    cached.top.resize(kept);
+  }
+
+  // Keep the trie compressed: drop a node left with nothing below it, then
+  // merge a node left with one child and no string into that child.
+  if (removed) {
+    for (std::size_t depth = path.size() - 1; depth > 0; --depth) {
+      Node& at = *path[depth];
+      Node& parent = *path[depth - 1];
+      if (at.entry || !at.children.empty()) {
+        if (!at.entry && at.children.size() == 1) {
+          std::unique_ptr<Node> child = std::move(at.children.front());
+          at.label += child->label;
+          at.children = std::move(child->children);
+          at.entry = std::move(child->entry);
+          at.top = std::move(child->top);
+        }
+        break;
+      }
+      parent.children.erase(find_child(parent, at.label[0]));
+    }
+  }
+  return true;
+}
+
+void CompletionTrie::clear() {
+  root_ = std::make_unique<Node>();
+  strings_ = 0;
+  books_ = 0;
+}
+
+//
+// Queries
+//
+
+std::vector<Completion> CompletionTrie::complete(std::string_view prefix, std::size_t count) const {
+  const std::string key = completion_key(prefix);
+  const Node* node = root_.get();
+  for (std::size_t i = 0; i < key.size();) {
+    auto child = find_child(*node, key[i]);
+    if (child == node->children.end()) {
+      return {};
+    }
+    const std::string& label = (*child)->label;
+    const std::size_t length = std::min(label.size(), key.size() - i);
+    if (key.compare(i, length, label, 0, length) != 0) {
+      return {};
+    }
+    node = child->get();
+    i += length;
+  }
+
+  std::vector<const Entry*> best;
+  if (count <= cache_size_) {
+    best.assign(node->top.begin(), node->top.begin() + std::min(count, node->top.size()));
+  } else {
+    collect(*node, best);
+    const std::size_t kept = std::min(count, best.size());
+    std::partial_sort(best.begin(), best.begin() + kept, best.end(), [&](const Entry* lhs, const Entry* rhs) {
+      return ranks_before(lhs->completion, rhs->completion, rank_);
+    });
+    best.resize(kept);
+  }
+  std::vector<Completion> completions;
+  completions.reserve(best.size());
+  for (const Entry* entry : best) completions.push_back(entry->completion);
+  return completions;
+}
+
+std::size_t CompletionTrie::nodes() const {
+  return count_nodes(*root_);
+}
+
+std::size_t CompletionTrie::memory_bytes() const {
+  return node_bytes(*root_);
+}
@@ -0,0 +1,191 @@
+#ifndef _completion_trie_hpp_
+#define _completion_trie_hpp_
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "book.hpp"
+#include "trigram_index.hpp"
+
+// Autocomplete over books' authors or titles: the best few completions of
+// what has been typed so far, in time that depends on the prefix rather than
+// on how many strings start with it.
+//
+// The strings are normalized as the trigram index normalizes them
+// (normalize_text()), so "olafur" completes to "Ólafur Jóhann Sigurðsson",
+// and stored in a radix (Patricia) trie over their UTF-8 bytes: each edge is
+// labelled with a run of bytes rather than one, so a node branches or ends a
+// string, and a trie of n strings has fewer than 2n nodes.
+//
+// Each node caches the best "cache_size" completions in its subtree, ranked
+// by the number of books sharing the string (popularity) or by the highest
+// price among them. Completing a prefix walks down its bytes and copies the
+// cache of the node it ends in. An insert offers its string to the caches on
+// its path, stopping at the first that turns it away, since a node's cache
+// is at least as selective as any below it; a remove rebuilds the caches
+// that held the string from their children's.
+//
+// Usage:
+//
+//   CompletionTrie authors(TextField::Author, CompletionRank::Popularity);
+//   for (const Book& book : books) authors.insert(book);
+//   for (const Completion& completion : authors.complete("tol", 5)) std::cout << completion.text << '\n';
+
+// What a completion is ranked by.
+enum class CompletionRank { Popularity, Price };
+
+// A distinct normalized string and the books that have it.
+struct Completion {
+  std::string key;                                    // normalized
+  std::string text;                                   // as the first of its books spells it
+  std::size_t books = 0;
+  double price = 0.0;                                 // the highest of its books'
+};
+
+// The key a string is completed and ranked by.
+inline std::string completion_key(std::string_view text) { return to_utf8(normalize_text(text)); }
+
+// Whether "lhs" ranks ahead of "rhs"; ties go to the lesser key, so that the
+// order is total.
+inline bool ranks_before(const Completion& lhs, const Completion& rhs, CompletionRank rank) {
+  if (rank == CompletionRank::Popularity && lhs.books != rhs.books) return lhs.books > rhs.books;
+  if (lhs.price != rhs.price) return lhs.price > rhs.price;
+  if (lhs.books != rhs.books) return lhs.books > rhs.books;
+  return lhs.key < rhs.key;
+}
+
+class CompletionTrie {
+ public:
+  // Completes the "field" of books, caching the "cache_size" best
+  // completions by "rank" at each node.
+  CompletionTrie(TextField field, CompletionRank rank, std::size_t cache_size = 10);
+  ~CompletionTrie() noexcept;
+
+  CompletionTrie(const CompletionTrie&) = delete;
+  CompletionTrie& operator=(const CompletionTrie&) = delete;
+  CompletionTrie(CompletionTrie&&) noexcept;
+  CompletionTrie& operator=(CompletionTrie&&) noexcept;
+
+  //
+  // Modifiers
+  //
+
+  // Adds a book's field, at its price. A string with no letters or digits is
+  // not completed.
+  template <class Record>
+  void insert(const Record& book) { insert(field_ == TextField::Title ? book.title() : book.author(), book.price()); }
+  void insert(std::string_view text, double price);
+
+  // Removes one book added with this field and price. Returns false if there
+  // is none.
+  template <class Record>
+  bool remove(const Record& book) { return remove(field_ == TextField::Title ? book.title() : book.author(), book.price()); }
+  bool remove(std::string_view text, double price);
+
+  void clear();
+
+  //
+  // Queries
+  //
+
+  // The best "count" completions of "prefix", best first. Up to the cache
+  // size they are copied from one node; more walk the prefix's subtree.
+  std::vector<Completion> complete(std::string_view prefix, std::size_t count) const;
+
+  // Distinct strings, and the books that have them.
+  std::size_t size() const { return strings_; }
+  std::size_t books() const { return books_; }
+  bool empty() const { return strings_ == 0; }
+
+  std::size_t nodes() const;
+  std::size_t cache_size() const { return cache_size_; }
+
+  // Bytes held by the nodes, their caches, and the completions.
+  std::size_t memory_bytes() const;
+
+  // A trie node, defined in completion_trie.cpp.
+  struct Node;
+
+ private:
+  TextField field_;
+  CompletionRank rank_;
+  std::size_t cache_size_;
+  std::unique_ptr<Node> root_;
+  std::size_t strings_ = 0;
+  std::size_t books_ = 0;
+};
+
+//
+// COMPLETION TRIE OPERATIONS
+//
+
+struct insert_into_completion_trie {
+  // Function takes a constant Book as a parameter, adds that book's field to
+  // a completion trie, and returns nothing.
+  void operator()(const Book& book) { my_trie.insert(book); }
+
+  CompletionTrie& my_trie;
+};
+
+struct remove_from_completion_trie {
+  // Function takes a constant Book as a parameter, removes that book's field
+  // from a completion trie (if present), and returns nothing.
+  void operator()(const Book& book) { my_trie.remove(book); }
+
+  CompletionTrie& my_trie;
+};
+
+struct complete_within_completion_trie {
+  // Function takes no parameters, finds the best completions of the target
+  // prefix in a completion trie, and returns them.
+  std::vector<Completion> operator()(const Book& unused) { return my_trie.complete(target_prefix, count); }
+
+  const CompletionTrie& my_trie;
+  const std::string target_prefix;
+  const std::size_t count;
+};
+
+struct complete_within_map {
+  // Function takes no parameters, scans a BST (std::map) of completions by
+  // key for those starting with the target prefix, and returns the best.
+  std::vector<Completion> operator()(const Book& unused) {
+    const std::string prefix = completion_key(target_prefix);
+    std::vector<Completion> found;
+    for (auto iter = my_map.lower_bound(prefix);
+         iter != my_map.end() && iter->first.compare(0, prefix.size(), prefix) == 0; ++iter) {
+      found.push_back(iter->second);
+    }
+    auto better = [&](const Completion& lhs, const Completion& rhs) { return ranks_before(lhs, rhs, rank); };
+    const std::size_t kept = std::min(count, found.size());
+    std::partial_sort(found.begin(), found.begin() + kept, found.end(), better);
+    found.resize(kept);
+    return found;
+  }
+
+  const std::map<std::string, Completion>& my_map;
+  const std::string target_prefix;
+  const std::size_t count;
+  const CompletionRank rank;
+};
+
+// Adds a book's field to a BST of completions by key, as complete_within_map
+// expects.
+template <class Record>
+void add_completion(std::map<std::string, Completion>& map, const Record& book, TextField field) {
+  const std::string_view text = field == TextField::Title ? book.title() : book.author();
+  std::string key = completion_key(text);
+  if (key.empty()) return;
+  Completion& completion = map[key];
+  if (completion.books++ == 0) {
+    completion.key = std::move(key);
+    completion.text = std::string(text);
+  }
+  completion.price = std::max(completion.price, static_cast<double>(book.price()));
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef _completion_trie_test_hpp_
+#define _completion_trie_test_hpp_
+
+#include "completion_trie.hpp"
+
+#include <cstddef>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+namespace completion_trie_test {
+
+// The texts of "completions", in order.
+inline std::vector<std::string> texts(const std::vector<Completion>& completions) {
+  std::vector<std::string> found;
+  for (const Completion& completion : completions) found.push_back(completion.text);
+  return found;
+}
+
+}  // namespace completion_trie_test
+
+TEST_CASE("CompletionTrie") {
+  using completion_trie_test::texts;
+  using Texts = std::vector<std::string>;
+
+  CompletionTrie authors(TextField::Author, CompletionRank::Popularity, 3);
+  for (const Book& book : {Book("Kvæði", "Ólafur Jóhann Sigurðsson", "1", 10.0),
+                           Book("Vorkaldi", "Ólafur Jóhann Sigurðsson", "2", 12.0),
+                           Book("Sögur", "Olaf Olsen", "3", 30.0),
+                           Book("Odes", "Oliver Goldsmith", "4", 20.0),
+                           Book("Malta language question", "Geoffrey Hull", "5", 62.06),
+                           Book("Moments", "Olaf", "6", 5.0)}) {
+    insert_into_completion_trie{authors}(book);
+  }
+
+  SUBCASE("RanksByPopularityThenPrice") {
+    CHECK_EQ(authors.size(), 5);
+    CHECK_EQ(authors.books(), 6);
+    CHECK_EQ(texts(authors.complete("ol", 3)), Texts{"Ólafur Jóhann Sigurðsson", "Olaf Olsen", "Oliver Goldsmith"});
+    CHECK_EQ(texts(authors.complete("OLAF", 10)), Texts{"Ólafur Jóhann Sigurðsson", "Olaf Olsen", "Olaf"});
+    CHECK_EQ(texts(authors.complete("olaf ", 1)), Texts{"Ólafur Jóhann Sigurðsson"});
+    CHECK_EQ(texts(authors.complete("olaf o", 3)), Texts{"Olaf Olsen"});
+    CHECK_EQ(texts(authors.complete("g", 3)), Texts{"Geoffrey Hull"});
+    CHECK(authors.complete("x", 3).empty());
+    CHECK(authors.complete("olx", 3).empty());
+    CHECK_EQ(authors.complete("", 10).size(), 5);
+    const std::vector<Completion> best = complete_within_completion_trie{authors, "o", 1}(Book());
+    REQUIRE_EQ(best.size(), 1);
+    CHECK_EQ(best[0].books, 2);
+    CHECK_EQ(best[0].price, 12.0);
+    CHECK_EQ(best[0].key, "olafur johann sigurdsson");
+  }
+
+  SUBCASE("RemoveReranksAndCompresses") {
+    const std::size_t nodes = authors.nodes();
+    CHECK(authors.remove(Book("Vorkaldi", "Ólafur Jóhann Sigurðsson", "2", 12.0)));
+    CHECK_FALSE(authors.remove(Book("Vorkaldi", "Ólafur Jóhann Sigurðsson", "2", 12.0)));
+    CHECK_FALSE(authors.remove("Nobody", 1.0));
+    CHECK_EQ(texts(authors.complete("ol", 3)), Texts{"Olaf Olsen", "Oliver Goldsmith", "Ólafur Jóhann Sigurðsson"});
+    remove_from_completion_trie{authors}(Book("Odes", "Oliver Goldsmith", "4", 20.0));
+    CHECK_EQ(texts(authors.complete("ol", 3)), Texts{"Olaf Olsen", "Ólafur Jóhann Sigurðsson", "Olaf"});
+    CHECK_LT(authors.nodes(), nodes);
+    CHECK_EQ(authors.size(), 4);
+  }
+
+  SUBCASE("Clear") {
+    authors.clear();
+    CHECK(authors.empty());
+    CHECK_EQ(authors.nodes(), 1);
+    CHECK(authors.complete("o", 3).empty());
+  }
+}
+
+TEST_CASE("CompletionTrieMatchesAMapScan") {
+  // Titles over a few letters, so that they share long prefixes, with
+  // repeated titles and prices.
+  std::default_random_engine random(48);
+  std::uniform_int_distribution<int> letter('a', 'd');
+  std::uniform_int_distribution<std::size_t> length(1, 8);
+  std::uniform_int_distribution<int> cents(100, 120);
+  std::vector<Book> books;
+  for (std::size_t i = 0; i < 3000; ++i) {
+    std::string title;
+    for (std::size_t n = length(random); n > 0; --n) title += static_cast<char>(letter(random));
+    books.emplace_back(title, "Author", std::to_string(i), cents(random) / 100.0);
+  }
+
+  for (CompletionRank rank : {CompletionRank::Popularity, CompletionRank::Price}) {
+    CompletionTrie trie(TextField::Title, rank, 4);
+    for (const Book& book : books) trie.insert(book);
+    // Remove a third of the books, so that removals reshape the trie.
+    std::map<std::string, Completion> map;
+    for (std::size_t i = 0; i < books.size(); ++i) {
+      if (i % 3 == 0) {
+        CHECK(trie.remove(books[i]));
+      } else {
+        add_completion(map, books[i], TextField::Title);
+      }
+    }
+    CHECK_EQ(trie.size(), map.size());
+
+    for (const std::string prefix : {"", "a", "b", "ab", "dca", "abcd", "cccccc", "dddddddd", "e"}) {
+      for (std::size_t count : {1, 4, 9}) {
+        const std::vector<Completion> expected = complete_within_map{map, prefix, count, rank}(books[0]);
+        const std::vector<Completion> found = trie.complete(prefix, count);
+        CHECK_EQ(completion_trie_test::texts(found), completion_trie_test::texts(expected));
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,359 @@
+#include "compressed_catalog.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "book_view.hpp"
+
+namespace {
+
+//
+// Codec
+//
+
+constexpr std::size_t MIN_MATCH = 4;
+constexpr std::size_t MAX_OFFSET = 0xFFFF;
+constexpr int HASH_BITS = 14;
+
+// The part of a dictionary that back references can reach.
+std::string_view reachable(std::string_view dictionary) {
+  return dictionary.size() > MAX_OFFSET ? dictionary.substr(dictionary.size() - MAX_OFFSET) : dictionary;
+}
+
+std::uint32_t hash4(const char* at) {
+  std::uint32_t value;
+  std::memcpy(&value, at, sizeof value);
+  return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void append_length(std::string& out, std::size_t length) {
+  for (; length >= 255; length -= 255) out.push_back(static_cast<char>(255));
+  out.push_back(static_cast<char>(length));
+}
+
+// A sequence is a token (literal count in the high nibble, match length
+// minus MIN_MATCH in the low one, 15 meaning more bytes follow), the
+// literals, then a 2-byte offset and the rest of the match length. The last
+// sequence has literals only.
+void append_sequence(std::string& out, std::string_view literals, std::size_t offset, std::size_t match) {
+  const std::size_t extra = match > 0 ? match - MIN_MATCH : 0;
+  out.push_back(static_cast<char>((std::min<std::size_t>(literals.size(), 15) << 4) |
+                                  std::min<std::size_t>(extra, 15)));
+  if (literals.size() >= 15) append_length(out, literals.size() - 15);
+  out.append(literals);
+  if (match > 0) {
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (extra >= 15) append_length(out, extra - 15);
+  }
+}
+
+//
+// Records
+//
+
+// A record in a block: ISBN, title, and author each as a varint length and
+// the bytes, then the price. A price with an exact number of cents is a
+// varint of cents * 2; any other is a varint 1 and the 8-byte double.
+void append_varint(std::string& out, std::uint64_t value) {
+  for (; value >= 0x80; value >>= 7) out.push_back(static_cast<char>(value | 0x80));
+  out.push_back(static_cast<char>(value));
+}
+
+std::uint64_t read_varint(const char*& cursor, const char* end) {
+  std::uint64_t value = 0;
+  for (int shift = 0; cursor < end && shift < 64; shift += 7) {
+    const auto byte = static_cast<unsigned char>(*cursor++);
+    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) return value;
+  }
+  throw std::runtime_error("damaged compressed catalog block");
+}
+
+void append_record(std::string& out, const Book& book) {
+  for (const std::string* field : {&book.isbn(), &book.title(), &book.author()}) {
+    append_varint(out, field->size());
+    out.append(*field);
+  }
+  const double price = book.price();
+  const double cents = std::round(price * 100.0);
+  if (cents >= 0.0 && cents < 1e15 && cents / 100.0 == price) {
+    append_varint(out, static_cast<std::uint64_t>(cents) * 2);
+  } else {
+    append_varint(out, 1);
+    out.append(reinterpret_cast<const char*>(&price), sizeof price);
+  }
+}
+
+struct Record {
+  std::string_view isbn;
+  std::string_view title;
+  std::string_view author;
+  double price;
+};
+
+const char* read_record(const char* cursor, const char* end, Record& record) {
+  for (std::string_view* field : {&record.isbn, &record.title, &record.author}) {
+    const std::uint64_t size = read_varint(cursor, end);
+    if (static_cast<std::uint64_t>(end - cursor) < size) {
+      throw std::runtime_error("damaged compressed catalog block");
+    }
+    *field = std::string_view(cursor, size);
+    cursor += size;
+  }
+  const std::uint64_t price = read_varint(cursor, end);
+  if (price == 1) {
+    if (end - cursor < static_cast<std::ptrdiff_t>(sizeof(double))) {
+      throw std::runtime_error("damaged compressed catalog block");
+    }
+    std::memcpy(&record.price, cursor, sizeof(double));
+    cursor += sizeof(double);
+  } else {
+    record.price = static_cast<double>(price / 2) / 100.0;
+  }
+  return cursor;
+}
+
+}  // namespace
+
+std::string lz_compress(std::string_view dictionary, std::string_view input) {
+  dictionary = reachable(dictionary);
+  std::string window;
+  window.reserve(dictionary.size() + input.size());
+  window.append(dictionary).append(input);
+  const std::size_t start = dictionary.size();
+
+  // The last position seen with each hash of 4 bytes; one candidate each.
+  std::vector<std::int32_t> last(std::size_t(1) << HASH_BITS, -1);
+  for (std::size_t p = 0; p + MIN_MATCH <= start; ++p) last[hash4(&window[p])] = static_cast<std::int32_t>(p);
+
+  std::string out;
+  std::size_t anchor = start;
+  std::size_t p = start;
+  while (p + MIN_MATCH <= window.size()) {
+    const std::uint32_t hash = hash4(&window[p]);
+    const std::int32_t candidate = last[hash];
+    last[hash] = static_cast<std::int32_t>(p);
+    if (candidate < 0 || p - candidate > MAX_OFFSET ||
+        std::memcmp(&window[candidate], &window[p], MIN_MATCH) != 0) {
+      ++p;
+      continue;
+    }
+    std::size_t length = MIN_MATCH;
+    while (p + length < window.size() && window[candidate + length] == window[p + length]) ++length;
+    append_sequence(out, std::string_view(window).substr(anchor, p - anchor), p - candidate, length);
+    for (std::size_t q = p + 1; q < p + length && q + MIN_MATCH <= window.size(); ++q) {
+      last[hash4(&window[q])] = static_cast<std::int32_t>(q);
+    }
+    p += length;
+    anchor = p;
+  }
+  append_sequence(out, std::string_view(window).substr(anchor), 0, 0);
+  return out;
+}
+
+std::string lz_decompress(std::string_view dictionary, std::string_view compressed, std::size_t raw_size) {
+  dictionary = reachable(dictionary);
+  auto damaged = [] { return std::runtime_error("damaged compressed data"); };
+  auto read_length = [&](std::size_t& at) {
+    std::size_t length = 0;
+    for (;;) {
+      if (at >= compressed.size()) throw damaged();
+      const auto byte = static_cast<unsigned char>(compressed[at++]);
+      length += byte;
+      if (byte != 255) return length;
+    }
+  };
+
+  // Copies run 8 bytes at a time and may overshoot into this slack.
+  constexpr std::size_t SLACK = 16;
+  std::string out(raw_size + SLACK, '\0');
+  char* const output = out.data();
+  auto copy8 = [](char* to, const char* from, std::size_t size) {
+    for (char* end = to + size; to < end; to += 8, from += 8) std::memcpy(to, from, 8);
+  };
+  std::size_t written = 0;
+  std::size_t at = 0;
+  while (at < compressed.size()) {
+    const auto token = static_cast<unsigned char>(compressed[at++]);
+    std::size_t literals = token >> 4;
+    if (literals == 15) literals += read_length(at);
+    if (compressed.size() - at < literals || raw_size - written < literals) throw damaged();
+    if (compressed.size() - at >= literals + 8) {
+      copy8(output + written, compressed.data() + at, literals);
+    } else {
+      std::memcpy(output + written, compressed.data() + at, literals);
+    }
+    written += literals;
+    at += literals;
+    if (at == compressed.size()) break;
+
+    if (compressed.size() - at < 2) throw damaged();
+    const std::size_t offset = static_cast<unsigned char>(compressed[at]) |
+                               static_cast<std::size_t>(static_cast<unsigned char>(compressed[at + 1])) << 8;
+    at += 2;
+    std::size_t match = (token & 15) + MIN_MATCH;
+    if ((token & 15) == 15) match += read_length(at);
+    if (offset == 0 || offset > written + dictionary.size() || raw_size - written < match) {
+      throw damaged();
+    }
+    // A match may start in the dictionary and run on into the output.
+    if (offset > written) {
+      const std::size_t from_dictionary = std::min(match, offset - written);
+      std::memcpy(output + written, dictionary.data() + dictionary.size() - (offset - written), from_dictionary);
+      written += from_dictionary;
+      match -= from_dictionary;
+    }
+    if (offset >= 8) {
+      // Each 8-byte step reads only bytes already written.
+      copy8(output + written, output + written - offset, match);
+      written += match;
+    } else {
+      // A short repeating pattern, copied byte by byte.
+      for (; match > 0; --match, ++written) output[written] = output[written - offset];
+    }
+  }
+  out.resize(written);
+  if (written != raw_size) throw damaged();
+  return out;
+}
+
+//
+// Constructor
+//
+
+CompressedCatalog::CompressedCatalog(const std::vector<Book>& books, std::size_t block_bytes,
+                                     std::size_t cache_blocks)
+    : cache_blocks_(cache_blocks) {
+  // Sorted by ISBN; of equal ISBNs, the last one given wins.
+  std::vector<const Book*> sorted;
+  sorted.reserve(books.size());
+  for (const Book& book : books) sorted.push_back(&book);
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const Book* a, const Book* b) { return a->isbn() < b->isbn(); });
+  std::vector<const Book*> unique;
+  unique.reserve(sorted.size());
+  for (std::size_t i = 0; i < sorted.size(); ++i) {
+    if (i + 1 == sorted.size() || sorted[i + 1]->isbn() != sorted[i]->isbn()) unique.push_back(sorted[i]);
+  }
+  size_ = unique.size();
+
+  // The dictionary: records sampled evenly across the catalog.
+  const std::size_t stride = std::max<std::size_t>(1, unique.size() / (DICTIONARY_BYTES / 64));
+  for (std::size_t i = 0; i < unique.size() && dictionary_.size() < DICTIONARY_BYTES; i += stride) {
+    append_record(dictionary_, *unique[i]);
+  }
+  dictionary_.shrink_to_fit();
+
+  std::string raw;
+  auto finish_block = [&] {
+    const std::string compressed = lz_compress(dictionary_, raw);
+    blocks_.push_back(Block{data_.size(), static_cast<std::uint32_t>(compressed.size()),
+                            static_cast<std::uint32_t>(raw.size())});
+    data_ += compressed;
+    raw_bytes_ += raw.size();
+    raw.clear();
+  };
+  for (const Book* book : unique) {
+    if (raw.empty()) first_isbns_.push_back(book->isbn());
+    append_record(raw, *book);
+    if (raw.size() >= block_bytes) finish_block();
+  }
+  if (!raw.empty()) finish_block();
+  data_.shrink_to_fit();
+  blocks_.shrink_to_fit();
+  first_isbns_.shrink_to_fit();
+}
+
+//
+// Queries
+//
+
+std::optional<Book> CompressedCatalog::find(std::string_view isbn) const {
+  // The last block starting at or before "isbn" is the only one that can
+  // hold it.
+  auto after = std::upper_bound(first_isbns_.begin(), first_isbns_.end(), isbn,
+                                [](std::string_view key, const std::string& first) { return key < first; });
+  if (after == first_isbns_.begin()) {
+    return std::nullopt;
+  }
+  const Decoded raw = block(static_cast<std::size_t>(after - first_isbns_.begin()) - 1);
+
+  Record record;
+  const char* end = raw->data() + raw->size();
+  for (const char* cursor = raw->data(); cursor < end;) {
+    cursor = read_record(cursor, end, record);
+    if (record.isbn == isbn) {
+      return Book(std::string(record.title), std::string(record.author), std::string(record.isbn),
+                  record.price);
+    }
+    if (isbn < record.isbn) {
+      break;
+    }
+  }
+  return std::nullopt;
+}
+
+CompressedCatalog::Decoded CompressedCatalog::block(std::size_t number) const {
+  {
+    std::lock_guard lock(cache_mutex_);
+    if (auto found = cached_.find(number); found != cached_.end()) {
+      recent_.splice(recent_.begin(), recent_, found->second);
+      ++hits_;
+      return found->second->second;
+    }
+    ++misses_;
+  }
+
+  const Block& block = blocks_[number];
+  auto decoded = std::make_shared<const std::string>(
+      lz_decompress(dictionary_, std::string_view(data_).substr(block.offset, block.compressed_size),
+                    block.raw_size));
+  if (cache_blocks_ > 0) {
+    std::lock_guard lock(cache_mutex_);
+    if (cached_.count(number) == 0) {
+      recent_.emplace_front(number, decoded);
+      cached_[number] = recent_.begin();
+      if (recent_.size() > cache_blocks_) {
+        cached_.erase(recent_.back().first);
+        recent_.pop_back();
+      }
+    }
+  }
+  return decoded;
+}
+
+//
+// Memory and Statistics
+//
+
+std::size_t CompressedCatalog::memory_bytes() const {
+  std::size_t bytes = sizeof(*this) + dictionary_.capacity() + data_.capacity() +
+                      blocks_.capacity() * sizeof(Block) + first_isbns_.capacity() * sizeof(std::string);
+  for (const std::string& isbn : first_isbns_) bytes += heap_bytes(isbn);
+  if (!blocks_.empty()) {
+    bytes += std::min(cache_blocks_, blocks_.size()) * (raw_bytes_ / blocks_.size());
+  }
+  return bytes;
+}
+
+std::size_t CompressedCatalog::cache_hits() const {
+  std::lock_guard lock(cache_mutex_);
+  return hits_;
+}
+
+std::size_t CompressedCatalog::cache_misses() const {
+  std::lock_guard lock(cache_mutex_);
+  return misses_;
+}
+
+void CompressedCatalog::reset_statistics() {
+  std::lock_guard lock(cache_mutex_);
+  hits_ = misses_ = 0;
+}
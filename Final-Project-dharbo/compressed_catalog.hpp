@@ -0,0 +1,135 @@
+#ifndef _compressed_catalog_hpp_
+#define _compressed_catalog_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "book.hpp"
+
+// A read-only catalog that keeps its Books compressed in memory, for when RAM
+// rather than lookup time is the constraint.
+//
+// The books are sorted by ISBN and packed into blocks of about
+// "block_bytes" bytes, each compressed on its own with lz_compress() below.
+// The codec is primed with a dictionary sampled from the whole catalog, so
+// even a small block finds matches for text that repeats across blocks, such
+// as " (1st edition)" and common author names. The first ISBN of every block
+// stays uncompressed in a sorted index, so a lookup binary searches the index,
+// decompresses one block, and scans it.
+//
+// Recently decompressed blocks are kept in a small least-recently-used cache.
+// find() is safe to call from many threads.
+//
+// Usage:
+//
+//   CompressedCatalog catalog(books);
+//   std::optional<Book> found = catalog.find(isbn);
+
+// Compresses "input" with an LZ77 codec: a sequence of literal runs and
+// back references of at least 4 bytes into the last 64 KiB of "dictionary"
+// followed by the input. Returns the compressed bytes.
+std::string lz_compress(std::string_view dictionary, std::string_view input);
+
+// Reverses lz_compress() given the same dictionary. Throws
+// std::runtime_error if "compressed" is damaged.
+std::string lz_decompress(std::string_view dictionary, std::string_view compressed,
+                          std::size_t raw_size);
+
+class CompressedCatalog {
+ public:
+  static constexpr std::size_t DEFAULT_BLOCK_BYTES = 4096;
+  static constexpr std::size_t DEFAULT_CACHE_BLOCKS = 64;
+  static constexpr std::size_t DICTIONARY_BYTES = 16 << 10;
+
+  // Compresses "books". If an ISBN appears more than once, the last book
+  // with it wins, as inserting every book into a hash table would. A cache of
+  // 0 blocks decompresses a block on every lookup.
+  explicit CompressedCatalog(const std::vector<Book>& books,
+                             std::size_t block_bytes = DEFAULT_BLOCK_BYTES,
+                             std::size_t cache_blocks = DEFAULT_CACHE_BLOCKS);
+
+  CompressedCatalog(const CompressedCatalog&) = delete;
+  CompressedCatalog& operator=(const CompressedCatalog&) = delete;
+
+  //
+  // Queries
+  //
+
+  std::optional<Book> find(std::string_view isbn) const;
+  bool contains(std::string_view isbn) const { return find(isbn).has_value(); }
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  std::size_t block_count() const { return blocks_.size(); }
+
+  //
+  // Memory
+  //
+
+  // Bytes of the books before and after compression.
+  std::size_t raw_bytes() const { return raw_bytes_; }
+  std::size_t compressed_bytes() const { return data_.size(); }
+
+  // Everything the catalog holds: compressed blocks, index, dictionary, and
+  // a full cache.
+  std::size_t memory_bytes() const;
+
+  //
+  // Cache Statistics
+  //
+
+  std::size_t cache_hits() const;
+  std::size_t cache_misses() const;
+  void reset_statistics();
+
+ private:
+  struct Block {
+    std::uint64_t offset;                             // into data_
+    std::uint32_t compressed_size;
+    std::uint32_t raw_size;
+  };
+  using Decoded = std::shared_ptr<const std::string>;
+
+  Decoded block(std::size_t number) const;
+
+  std::string dictionary_;
+  std::string data_;
+  std::vector<Block> blocks_;
+  std::vector<std::string> first_isbns_;              // of each block, sorted
+  std::size_t size_ = 0;
+  std::size_t raw_bytes_ = 0;
+
+  // The cache: most recently used first, and where each block is in it.
+  const std::size_t cache_blocks_;
+  mutable std::mutex cache_mutex_;
+  mutable std::list<std::pair<std::size_t, Decoded>> recent_;
+  mutable std::unordered_map<std::size_t, std::list<std::pair<std::size_t, Decoded>>::iterator> cached_;
+  mutable std::size_t hits_ = 0;
+  mutable std::size_t misses_ = 0;
+};
+
+//
+// COMPRESSED CATALOG OPERATIONS
+//
+
+struct search_within_compressed_catalog {
+  // Function takes no parameters, searches a compressed catalog for a book with
+  // an ISBN matching the target ISBN, and returns a copy of that book if such a
+  // book is found, an empty optional otherwise.
+  std::optional<Book> operator()(const Book& unused) {
+    return my_catalog.find(target_isbn);
+  }
+
+  const CompressedCatalog& my_catalog;
+  const std::string target_isbn;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef _compressed_catalog_test_hpp_
+#define _compressed_catalog_test_hpp_
+
+#include "compressed_catalog.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("LzCodec") {
+  const std::string dictionary = "Introduction to Algorithms (1st edition)";
+  std::default_random_engine random(40);
+  std::string noise(5000, '\0');
+  for (char& c : noise) c = static_cast<char>(random());
+  std::string repetitive;
+  for (int i = 0; i < 300; ++i) repetitive += "Book " + std::to_string(i % 7) + " (1st edition), ";
+
+  for (const std::string& input : {std::string(), std::string("abc"), std::string(1000, 'x'), noise,
+                                   repetitive, dictionary + " and more " + dictionary}) {
+    for (const std::string& primer : {std::string(), dictionary, noise}) {
+      const std::string compressed = lz_compress(primer, input);
+      CHECK_EQ(lz_decompress(primer, compressed, input.size()), input);
+    }
+  }
+  CHECK_LT(lz_compress("", repetitive).size(), repetitive.size() / 10);
+  CHECK_LT(lz_compress(dictionary, dictionary).size(), 8);
+
+  const std::string compressed = lz_compress("", repetitive);
+  CHECK_THROWS_AS(lz_decompress("", compressed, repetitive.size() + 1), std::runtime_error);
+  CHECK_THROWS_AS(lz_decompress("", compressed.substr(0, compressed.size() / 2), repetitive.size()),
+                  std::runtime_error);
+}
+
+TEST_CASE("CompressedCatalog") {
+  std::vector<Book> books;
+  for (int i = 0; i < 5000; ++i) {
+    books.emplace_back("Title " + std::to_string(i % 300) + " (1st edition)", "Author " + std::to_string(i % 40),
+                       std::to_string(1000000 + i * 7), (i % 1000) / 4.0);
+  }
+  books.emplace_back("Odd price", "Author", "1000007", 1.0 / 3.0);    // replaces book 1
+  books.emplace_back(std::string(300, 'z'), "", "0", 0.0);
+
+  for (std::size_t cache_blocks : {0, 2, 1000}) {
+    CompressedCatalog catalog(books, 512, cache_blocks);
+    CHECK_EQ(catalog.size(), 5001);
+    CHECK_GT(catalog.block_count(), 10);
+    CHECK_LT(catalog.compressed_bytes(), catalog.raw_bytes() / 2);
+
+    for (std::size_t i = 0; i < books.size(); ++i) {
+      if (i == 1) continue;
+      CHECK_EQ(search_within_compressed_catalog{catalog, books[i].isbn()}(Book{}), books[i]);
+    }
+    CHECK_EQ(catalog.find("1000007")->price(), 1.0 / 3.0);
+    CHECK_EQ(catalog.find("1000008"), std::nullopt);
+    CHECK_EQ(catalog.find(""), std::nullopt);
+    CHECK_FALSE(catalog.contains("9"));
+    if (cache_blocks == 1000) {
+      CHECK_GT(catalog.cache_hits(), catalog.cache_misses());
+    }
+  }
+
+  SUBCASE("ConcurrentReaders") {
+    CompressedCatalog catalog(books, 512, 4);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+      readers.emplace_back([&catalog, &books, t] {
+        for (std::size_t i = t; i < 4000; i += 4) CHECK_EQ(catalog.find(books[i + 2].isbn()), books[i + 2]);
+      });
+    }
+    for (auto& reader : readers) reader.join();
+  }
+
+  CompressedCatalog empty(std::vector<Book>{});
+  CHECK(empty.empty());
+  CHECK_EQ(empty.find("1"), std::nullopt);
+}
+
+#endif
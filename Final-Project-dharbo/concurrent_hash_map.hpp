@@ -0,0 +1,190 @@
+#ifndef _concurrent_hash_map_hpp_
+#define _concurrent_hash_map_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "book.hpp"
+
+// A hash table that may be shared by many threads at once. The keys are split
+// across a fixed number of shards, and each shard is an ordinary
+// std::unordered_map guarded by its own reader/writer lock. Lookups only take
+// the shard's lock in shared mode, so readers never block each other, and
+// writers only block the threads that happen to hash into the same shard.
+//
+// Values are copied out of the table rather than handed back by pointer, since
+// a pointer into a shard is no longer safe once the shard's lock is released.
+template <class Key, class Value, class Hash = std::hash<Key>>
+class ConcurrentHashMap {
+ public:
+  // Creates a table with at least "shard_count" shards. The count is rounded up
+  // to a power of two so a shard can be picked with a shift instead of a modulo.
+  explicit ConcurrentHashMap(std::size_t shard_count = 64)
+      : shard_bits_(bits_for(shard_count)),
+        shards_(std::make_unique<Shard[]>(std::size_t{1} << shard_bits_)) {}
+
+  ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+  ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+  // Inserts "value" under "key", replacing any existing value. Returns true if
+  // the key was not already present.
+  bool insert_or_assign(const Key& key, const Value& value) {
+    Shard& shard = shard_for(key);
+    std::unique_lock lock(shard.mutex);
+    return shard.map.insert_or_assign(key, value).second;
+  }
+
+  // Removes the value stored under "key", if any. Returns true if a value was
+  // removed.
+  bool erase(const Key& key) {
+    Shard& shard = shard_for(key);
+    std::unique_lock lock(shard.mutex);
+    return shard.map.erase(key) != 0;
+  }
+
+  // Returns a copy of the value stored under "key", or an empty optional.
+  std::optional<Value> find(const Key& key) const {
+    const Shard& shard = shard_for(key);
+    std::shared_lock lock(shard.mutex);
+    auto iter = shard.map.find(key);
+    if (iter == shard.map.end()) {
+      return std::nullopt;
+    }
+    return iter->second;
+  }
+
+  // Calls "visitor" with the value stored under "key" while the shard is held
+  // in shared mode, avoiding the copy made by find(). Returns false if the key
+  // is not present. The visitor must not call back into this table.
+  template <class Visitor>
+  bool visit(const Key& key, Visitor visitor) const {
+    const Shard& shard = shard_for(key);
+    std::shared_lock lock(shard.mutex);
+    auto iter = shard.map.find(key);
+    if (iter == shard.map.end()) {
+      return false;
+    }
+    visitor(iter->second);
+    return true;
+  }
+
+  bool contains(const Key& key) const {
+    return visit(key, [](const Value&) {});
+  }
+
+  // Returns the number of stored values. Each shard is counted under its own
+  // lock, so the total is only exact when no writers are running.
+  std::size_t size() const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < shard_count(); ++i) {
+      std::shared_lock lock(shards_[i].mutex);
+      total += shards_[i].map.size();
+    }
+    return total;
+  }
+
+  // Pre-sizes every shard for "count" values spread evenly across the shards.
+  void reserve(std::size_t count) {
+    const std::size_t per_shard = count / shard_count() + 1;
+    for (std::size_t i = 0; i < shard_count(); ++i) {
+      std::unique_lock lock(shards_[i].mutex);
+      shards_[i].map.reserve(per_shard);
+    }
+  }
+
+  void clear() {
+    for (std::size_t i = 0; i < shard_count(); ++i) {
+      std::unique_lock lock(shards_[i].mutex);
+      shards_[i].map.clear();
+    }
+  }
+
+  std::size_t shard_count() const { return std::size_t{1} << shard_bits_; }
+
+ private:
+  // Each shard sits on its own cache line so that locking one shard does not
+  // invalidate the line holding a neighbouring shard's lock.
+  struct alignas(64) Shard {
+    mutable std::shared_mutex mutex;
+    std::unordered_map<Key, Value, Hash> map;
+  };
+
+  static unsigned bits_for(std::size_t shard_count) {
+    unsigned bits = 0;
+    while ((std::size_t{1} << bits) < shard_count) {
+      ++bits;
+    }
+    return bits;
+  }
+
+  // The shard is chosen from the high bits of a multiplicative mix of the hash.
+  // std::unordered_map buckets on the low bits, so the two choices stay
+  // independent and a shard's buckets are still evenly used.
+  std::size_t shard_index(const Key& key) const {
+    if (shard_bits_ == 0) {
+      return 0;
+    }
+    const std::uint64_t mixed =
+        static_cast<std::uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<std::size_t>(mixed >> (64 - shard_bits_));
+  }
+
+  Shard& shard_for(const Key& key) { return shards_[shard_index(key)]; }
+  const Shard& shard_for(const Key& key) const {
+    return shards_[shard_index(key)];
+  }
+
+  unsigned shard_bits_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+using ConcurrentBookTable = ConcurrentHashMap<std::string, Book>;
+
+//
+// CONCURRENT HASH TABLE OPERATIONS
+//
+
+struct insert_into_concurrent_hash_table {
+  // Function takes a constant Book as a parameter, inserts that book indexed by
+  // the book's ISBN into a concurrent hash table, and returns nothing. Safe to
+  // call from many threads at once.
+  void operator()(const Book& book) {
+    my_hash_table.insert_or_assign(book.isbn(), book);
+  }
+
+  ConcurrentBookTable& my_hash_table;
+};
+
+struct remove_from_concurrent_hash_table {
+  // Function takes a constant Book as a parameter, removes the book with a
+  // matching ISBN (if any) from a concurrent hash table, and returns nothing.
+  // Safe to call from many threads at once.
+  void operator()(const Book& book) {
+    my_hash_table.erase(book.isbn());
+  }
+
+  ConcurrentBookTable& my_hash_table;
+};
+
+struct search_within_concurrent_hash_table {
+  // Function takes no parameters, searches a concurrent hash table for a book
+  // with an ISBN matching the target ISBN, and returns a copy of that book if
+  // such a book is found, an empty optional otherwise. Safe to call from many
+  // threads at once.
+  std::optional<Book> operator()(const Book& unused) {
+    return my_hash_table.find(target_isbn);
+  }
+
+  const ConcurrentBookTable& my_hash_table;
+  const std::string target_isbn;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef _concurrent_hash_map_test_hpp_
+#define _concurrent_hash_map_test_hpp_
+
+#include "concurrent_hash_map.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("InsertIntoConcurrentHashTable") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+  ConcurrentBookTable hash_table(4);
+
+  SUBCASE("EmptyHashTable") {
+    insert_into_concurrent_hash_table{hash_table}(book);
+    CHECK_EQ(hash_table.size(), 1);
+    CHECK_EQ(hash_table.find(book.isbn()), book);
+  }
+
+  SUBCASE("ReplacesExisting") {
+    insert_into_concurrent_hash_table{hash_table}(other_book);
+    insert_into_concurrent_hash_table{hash_table}(book);
+    insert_into_concurrent_hash_table{hash_table}(
+        Book(book).price(1.0));
+    CHECK_EQ(hash_table.size(), 2);
+    CHECK_EQ(hash_table.find(book.isbn())->price(), 1.0);
+    CHECK_EQ(hash_table.find(other_book.isbn()), other_book);
+  }
+}
+
+TEST_CASE("RemoveFromConcurrentHashTable") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+  ConcurrentBookTable hash_table(4);
+
+  SUBCASE("EmptyHashTable") {
+    remove_from_concurrent_hash_table{hash_table}(book);
+    CHECK_EQ(hash_table.size(), 0);
+  }
+
+  SUBCASE("NonEmptyHashTable") {
+    hash_table.insert_or_assign(book.isbn(), book);
+    hash_table.insert_or_assign(other_book.isbn(), other_book);
+    remove_from_concurrent_hash_table{hash_table}(book);
+    CHECK_EQ(hash_table.size(), 1);
+    CHECK_FALSE(hash_table.contains(book.isbn()));
+    CHECK_EQ(hash_table.find(other_book.isbn()), other_book);
+  }
+}
+
+TEST_CASE("SearchWithinConcurrentHashTable") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+  ConcurrentBookTable hash_table(4);
+  hash_table.insert_or_assign(other_book.isbn(), other_book);
+
+  SUBCASE("ItemNotFound") {
+    CHECK_EQ(search_within_concurrent_hash_table{hash_table, book.isbn()}(book),
+             std::nullopt);
+  }
+
+  SUBCASE("ItemFound") {
+    hash_table.insert_or_assign(book.isbn(), book);
+    CHECK_EQ(search_within_concurrent_hash_table{hash_table, book.isbn()}(book),
+             book);
+  }
+}
+
+TEST_CASE("ConcurrentHashTableManyThreads") {
+  constexpr std::size_t THREADS = 4;
+  constexpr std::size_t BOOKS_PER_THREAD = 500;
+  ConcurrentBookTable hash_table(8);
+
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&hash_table, t] {
+      for (std::size_t i = 0; i < BOOKS_PER_THREAD; ++i) {
+        const std::string isbn = std::to_string(t * BOOKS_PER_THREAD + i);
+        hash_table.insert_or_assign(isbn, Book("title", "author", isbn, 1.0));
+        hash_table.find(isbn);
+        if (i % 2 == 0) {
+          hash_table.erase(isbn);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  CHECK_EQ(hash_table.size(), THREADS * BOOKS_PER_THREAD / 2);
+  CHECK(hash_table.contains("1"));
+  CHECK_FALSE(hash_table.contains("0"));
+}
+
+#endif
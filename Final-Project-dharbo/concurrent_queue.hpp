@@ -0,0 +1,289 @@
+#ifndef _concurrent_queue_hpp_
+#define _concurrent_queue_hpp_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "book.hpp"
+#include "epoch_reclamation.hpp"
+
+// A bounded multi-producer, multi-consumer queue over a ring buffer. Each cell
+// carries a sequence number that tells producers and consumers whose turn it is
+// to use the cell, so a push or pop claims a cell with a single compare-and-swap
+// on the shared tail or head position and never takes a lock.
+//
+// The capacity is fixed at construction and rounded up to a power of two.
+template <class T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(std::size_t capacity = 1024)
+      : mask_(round_up(capacity) - 1),
+        cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  ~BoundedQueue() {
+    T discarded;
+    while (try_pop(discarded)) {
+    }
+  }
+
+  // Appends "value" at the back of the queue. Returns false if the queue is
+  // full.
+  bool try_push(T value) {
+    std::size_t position = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[position & mask_];
+      const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+      if (difference == 0) {
+        // The cell is free for this lap; try to claim it.
+        if (tail_.compare_exchange_weak(position, position + 1,
+                                        std::memory_order_relaxed)) {
+          new (&cell.storage) T(std::move(value));
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // The cell still holds a value from the previous lap.
+        return false;
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Removes the value at the front of the queue into "value". Returns false if
+  // the queue is empty.
+  bool try_pop(T& value) {
+    std::size_t position = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[position & mask_];
+      const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto difference =
+          static_cast<std::ptrdiff_t>(sequence - (position + 1));
+      if (difference == 0) {
+        if (head_.compare_exchange_weak(position, position + 1,
+                                        std::memory_order_relaxed)) {
+          T* stored = std::launder(reinterpret_cast<T*>(&cell.storage));
+          value = std::move(*stored);
+          stored->~T();
+          cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  // Returns true if the queue held no values at the moment of the call.
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+  };
+
+  static std::size_t round_up(std::size_t capacity) {
+    std::size_t rounded = 2;
+    while (rounded < capacity) {
+      rounded *= 2;
+    }
+    return rounded;
+  }
+
+  const std::size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+
+  // Producers and consumers hammer different ends, so keep them on separate
+  // cache lines.
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  alignas(64) std::atomic<std::size_t> head_{0};
+};
+
+// An unbounded multi-producer, multi-consumer queue after Michael and Scott's
+// non-blocking linked-list queue. The list always starts with a dummy node;
+// popping a value advances the head onto the node holding it, which then
+// becomes the new dummy. Unlinked nodes are retired through an EpochDomain so a
+// thread still reading a node is never left with a dangling pointer.
+template <class T>
+class UnboundedQueue {
+ public:
+  UnboundedQueue() {
+    Node* dummy = new Node;
+    head_.store(dummy, std::memory_order_relaxed);
+    tail_.store(dummy, std::memory_order_relaxed);
+  }
+
+  UnboundedQueue(const UnboundedQueue&) = delete;
+  UnboundedQueue& operator=(const UnboundedQueue&) = delete;
+
+  ~UnboundedQueue() {
+    for (Node* node = head_.load(); node != nullptr;) {
+      Node* next = node->next.load();
+      delete node;
+      node = next;
+    }
+  }
+
+  // Appends "value" at the back of the queue.
+  void push(T value) {
+    Node* node = new Node;
+    node->value.emplace(std::move(value));
+    EpochDomain::Guard guard = domain_.pin();
+    for (;;) {
+      Node* tail = tail_.load(std::memory_order_acquire);
+      Node* next = tail->next.load(std::memory_order_acquire);
+      if (tail != tail_.load(std::memory_order_acquire)) {
+        continue;
+      }
+      if (next == nullptr) {
+        if (tail->next.compare_exchange_weak(next, node,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+          tail_.compare_exchange_strong(tail, node, std::memory_order_release,
+                                        std::memory_order_relaxed);
+          return;
+        }
+      } else {
+        // Another producer linked a node but has not swung the tail yet; help
+        // it along.
+        tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                    std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Removes and returns the value at the front of the queue, or an empty
+  // optional if the queue is empty.
+  std::optional<T> try_pop() {
+    EpochDomain::Guard guard = domain_.pin();
+    for (;;) {
+      Node* head = head_.load(std::memory_order_acquire);
+      Node* tail = tail_.load(std::memory_order_acquire);
+      Node* next = head->next.load(std::memory_order_acquire);
+      if (head != head_.load(std::memory_order_acquire)) {
+        continue;
+      }
+      if (next == nullptr) {
+        return std::nullopt;
+      }
+      if (head == tail) {
+        tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                    std::memory_order_relaxed);
+        continue;
+      }
+      if (head_.compare_exchange_weak(head, next, std::memory_order_acq_rel,
+                                      std::memory_order_relaxed)) {
+        // Only the thread that won the exchange touches "next->value", and
+        // "next" cannot be retired before this thread unpins.
+        std::optional<T> value = std::move(next->value);
+        next->value.reset();
+        domain_.retire(head);
+        return value;
+      }
+    }
+  }
+
+  // Returns true if the queue held no values at the moment of the call.
+  bool empty() const {
+    EpochDomain::Guard guard = domain_.pin();
+    return head_.load(std::memory_order_acquire)
+               ->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+ private:
+  struct Node {
+    std::optional<T> value;
+    std::atomic<Node*> next{nullptr};
+  };
+
+  alignas(64) std::atomic<Node*> head_;
+  alignas(64) std::atomic<Node*> tail_;
+  mutable EpochDomain domain_;
+};
+
+using BoundedBookQueue = BoundedQueue<Book>;
+using UnboundedBookQueue = UnboundedQueue<Book>;
+
+//
+// CONCURRENT QUEUE OPERATIONS
+//
+
+struct insert_at_back_of_bounded_queue {
+  // Function takes a constant Book as a parameter, inserts that book at the
+  // back of a bounded lock-free queue, and returns nothing. Safe to call from
+  // many threads at once.
+  void operator()(const Book& book) {
+    // If the queue is full, throw exception.
+    if (!my_queue.try_push(book)) {
+      throw std::out_of_range("Cannot insert into full data structure.");
+    }
+  }
+
+  BoundedBookQueue& my_queue;
+};
+
+struct remove_from_front_of_bounded_queue {
+  // Function takes no parameters, removes the book at the front of a bounded
+  // lock-free queue, and returns that book. Safe to call from many threads at
+  // once.
+  Book operator()(const Book& unused) {
+    Book book;
+    // If the queue is empty, throw exception.
+    if (!my_queue.try_pop(book)) {
+      throw std::out_of_range("Cannot remove from empty data structure.");
+    }
+    return book;
+  }
+
+  BoundedBookQueue& my_queue;
+};
+
+struct insert_at_back_of_unbounded_queue {
+  // Function takes a constant Book as a parameter, inserts that book at the
+  // back of an unbounded lock-free queue, and returns nothing. Safe to call
+  // from many threads at once.
+  void operator()(const Book& book) {
+    my_queue.push(book);
+  }
+
+  UnboundedBookQueue& my_queue;
+};
+
+struct remove_from_front_of_unbounded_queue {
+  // Function takes no parameters, removes the book at the front of an
+  // unbounded lock-free queue, and returns that book. Safe to call from many
+  // threads at once.
+  Book operator()(const Book& unused) {
+    std::optional<Book> book = my_queue.try_pop();
+    // If the queue is empty, throw exception.
+    if (!book) {
+      throw std::out_of_range("Cannot remove from empty data structure.");
+    }
+    return std::move(*book);
+  }
+
+  UnboundedBookQueue& my_queue;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef _concurrent_queue_test_hpp_
+#define _concurrent_queue_test_hpp_
+
+#include "concurrent_queue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("BoundedQueueOrderAndCapacity") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+  BoundedBookQueue queue(2);
+
+  SUBCASE("EmptyQueue") {
+    CHECK(queue.empty());
+    CHECK_THROWS_AS(remove_from_front_of_bounded_queue{queue}(book),
+                    std::out_of_range);
+  }
+
+  SUBCASE("FirstInFirstOut") {
+    insert_at_back_of_bounded_queue{queue}(book);
+    insert_at_back_of_bounded_queue{queue}(other_book);
+    CHECK_EQ(remove_from_front_of_bounded_queue{queue}(book), book);
+    CHECK_EQ(remove_from_front_of_bounded_queue{queue}(book), other_book);
+    CHECK(queue.empty());
+  }
+
+  SUBCASE("FullQueue") {
+    insert_at_back_of_bounded_queue{queue}(book);
+    insert_at_back_of_bounded_queue{queue}(book);
+    CHECK_THROWS_AS(insert_at_back_of_bounded_queue{queue}(book),
+                    std::out_of_range);
+  }
+}
+
+TEST_CASE("UnboundedQueueOrder") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+  UnboundedBookQueue queue;
+
+  SUBCASE("EmptyQueue") {
+    CHECK(queue.empty());
+    CHECK_THROWS_AS(remove_from_front_of_unbounded_queue{queue}(book),
+                    std::out_of_range);
+  }
+
+  SUBCASE("FirstInFirstOut") {
+    insert_at_back_of_unbounded_queue{queue}(book);
+    insert_at_back_of_unbounded_queue{queue}(other_book);
+    CHECK_EQ(remove_from_front_of_unbounded_queue{queue}(book), book);
+    CHECK_EQ(remove_from_front_of_unbounded_queue{queue}(book), other_book);
+    CHECK(queue.empty());
+  }
+}
+
+// Every value pushed by the producers must be popped exactly once.
+template <class Push, class Pop>
+void check_producers_and_consumers(Push push, Pop pop) {
+  constexpr std::size_t PRODUCERS = 3;
+  constexpr std::size_t CONSUMERS = 3;
+  constexpr std::size_t PER_PRODUCER = 2000;
+
+  std::vector<std::atomic<int>> seen(PRODUCERS * PER_PRODUCER);
+  std::atomic<std::size_t> consumed{0};
+  std::vector<std::thread> threads;
+  for (std::size_t p = 0; p < PRODUCERS; ++p) {
+    threads.emplace_back([&, p] {
+      for (std::size_t i = 0; i < PER_PRODUCER; ++i) {
+        push(p * PER_PRODUCER + i);
+      }
+    });
+  }
+  for (std::size_t c = 0; c < CONSUMERS; ++c) {
+    threads.emplace_back([&] {
+      while (consumed.load() < PRODUCERS * PER_PRODUCER) {
+        std::size_t value;
+        if (pop(value)) {
+          seen[value].fetch_add(1);
+          consumed.fetch_add(1);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::size_t exactly_once = 0;
+  for (auto& count : seen) exactly_once += count.load() == 1;
+  CHECK_EQ(exactly_once, PRODUCERS * PER_PRODUCER);
+}
+
+TEST_CASE("BoundedQueueManyThreads") {
+  BoundedQueue<std::size_t> queue(64);
+  check_producers_and_consumers(
+      [&](std::size_t value) {
+        while (!queue.try_push(value)) std::this_thread::yield();
+      },
+      [&](std::size_t& value) { return queue.try_pop(value); });
+  CHECK(queue.empty());
+}
+
+TEST_CASE("UnboundedQueueManyThreads") {
+  UnboundedQueue<std::size_t> queue;
+  check_producers_and_consumers(
+      [&](std::size_t value) { queue.push(value); },
+      [&](std::size_t& value) {
+        auto popped = queue.try_pop();
+        if (popped) value = *popped;
+        return popped.has_value();
+      });
+  CHECK(queue.empty());
+}
+
+#endif
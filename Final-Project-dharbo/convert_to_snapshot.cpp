@@ -0,0 +1,26 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+#include "book_snapshot.hpp"
+#include "timer.hpp"
+
+// Converts a text database into a binary snapshot that BookSnapshot can map
+// at startup without parsing.
+//
+// Usage:  convert_to_snapshot <database.dat> <database.snap>
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <database.dat> <database.snap>\n";
+    return EXIT_FAILURE;
+  }
+
+  try {
+    Utilities::Timer timer{"Timer:  conversion completed in ", std::clog};
+    const std::size_t count = convert_to_book_snapshot(argv[1], argv[2]);
+    std::clog << "Converted " << count << " books from " << argv[1] << " to " << argv[2] << '\n';
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,157 @@
+#ifndef _durable_catalog_hpp_
+#define _durable_catalog_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "book.hpp"
+#include "wal.hpp"
+
+// An in-memory hash catalog whose mutations survive a restart: every insert,
+// remove, and price update is logged to a WriteAheadLog before it returns,
+// and opening the catalog replays the log.
+//
+// A mutation is queued in the log and applied to the table under the same
+// lock, so the log holds the mutations in the order the table saw them. The
+// writer then waits for its group commit without holding the lock, so
+// concurrent writers share fsyncs. Readers may see a mutation a moment before
+// its writer returns; a crash in that moment can lose it.
+//
+// Usage:
+//
+//   DurableCatalog catalog("catalog.wal");
+//   catalog.insert(book);
+//   catalog.update_price(book.isbn(), 9.99);
+class DurableCatalog {
+ public:
+  // Opens the log at "log_path" and replays it. Throws std::system_error on
+  // I/O errors.
+  explicit DurableCatalog(const std::string& log_path, WalOptions options = {})
+      : log_(log_path, options) {
+    log_.replay([this](const WalRecord& record) { apply(record); });
+  }
+
+  //
+  // Modifiers
+  //
+
+  // Inserts "book", replacing any book with the same ISBN.
+  void insert(const Book& book) {
+    log_.wait_durable(log_and_apply(WalRecord::insert(book)));
+  }
+
+  // Removes the book with ISBN "isbn". Returns false, logging nothing, if
+  // there is none.
+  bool remove(std::string_view isbn) {
+    return commit_if_present(isbn, WalRecord::remove(isbn));
+  }
+
+  // Sets the price of the book with ISBN "isbn". Returns false, logging
+  // nothing, if there is none.
+  bool update_price(std::string_view isbn, double price) {
+    return commit_if_present(isbn, WalRecord::price_update(isbn, price));
+  }
+
+  //
+  // Queries
+  //
+
+  std::optional<Book> find(const std::string& isbn) const {
+    std::shared_lock lock(mutex_);
+    auto iter = books_.find(isbn);
+    if (iter == books_.end()) {
+      return std::nullopt;
+    }
+    return iter->second;
+  }
+
+  std::size_t size() const {
+    std::shared_lock lock(mutex_);
+    return books_.size();
+  }
+
+  const WriteAheadLog& log() const { return log_; }
+
+ private:
+  std::uint64_t log_and_apply(const WalRecord& record) {
+    std::unique_lock lock(mutex_);
+    const std::uint64_t sequence = log_.enqueue(record);
+    apply(record);
+    return sequence;
+  }
+
+  bool commit_if_present(std::string_view isbn, const WalRecord& record) {
+    std::uint64_t sequence;
+    {
+      std::unique_lock lock(mutex_);
+      if (books_.count(std::string(isbn)) == 0) {
+        return false;
+      }
+      sequence = log_.enqueue(record);
+      apply(record);
+    }
+    log_.wait_durable(sequence);
+    return true;
+  }
+
+  void apply(const WalRecord& record) {
+    switch (record.kind) {
+      case WalRecord::Kind::INSERT:
+        books_.insert_or_assign(record.book.isbn(), record.book);
+        break;
+      case WalRecord::Kind::REMOVE:
+        books_.erase(record.book.isbn());
+        break;
+      case WalRecord::Kind::PRICE_UPDATE:
+        if (auto iter = books_.find(record.book.isbn()); iter != books_.end()) {
+          iter->second.price(record.book.price());
+        }
+        break;
+    }
+  }
+
+  WriteAheadLog log_;
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<std::string, Book> books_;
+};
+
+//
+// DURABLE CATALOG OPERATIONS
+//
+
+struct insert_into_durable_catalog {
+  // Function takes a constant Book as a parameter, logs and inserts that book
+  // indexed by the book's ISBN into a durable catalog, and returns nothing once
+  // the insert is committed.
+  void operator()(const Book& book) { my_catalog.insert(book); }
+
+  DurableCatalog& my_catalog;
+};
+
+struct remove_from_durable_catalog {
+  // Function takes a constant Book as a parameter, logs and removes the book
+  // with a matching ISBN (if any) from a durable catalog, and returns nothing.
+  void operator()(const Book& book) { my_catalog.remove(book.isbn()); }
+
+  DurableCatalog& my_catalog;
+};
+
+struct search_within_durable_catalog {
+  // Function takes no parameters, searches a durable catalog for a book with an
+  // ISBN matching the target ISBN, and returns a copy of that book if such a
+  // book is found, an empty optional otherwise.
+  std::optional<Book> operator()(const Book& unused) {
+    return my_catalog.find(target_isbn);
+  }
+
+  const DurableCatalog& my_catalog;
+  const std::string target_isbn;
+};
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef _epoch_reclamation_hpp_
+#define _epoch_reclamation_hpp_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Epoch-based memory reclamation for the lock-free containers.
+//
+// A lock-free container cannot delete a node as soon as it unlinks it, because
+// another thread may have loaded a pointer to that node a moment earlier and
+// still be reading it. Instead, every thread "pins" the domain for the duration
+// of an operation, and unlinked nodes are "retired" rather than deleted. The
+// domain keeps a global epoch counter that can only advance once every pinned
+// thread has observed the current value. A node retired in epoch E is deleted
+// once the global epoch reaches E + 2, at which point no thread that could have
+// seen the node is still pinned.
+//
+// Usage:
+//
+//   EpochDomain domain;
+//   {
+//     EpochDomain::Guard guard = domain.pin();  // protect the operation
+//     Node* node = unlink_something();
+//     domain.retire(node);                      // deleted later, not now
+//   }
+class EpochDomain {
+  struct Retired {
+    void* pointer;
+    void (*deleter)(void*);
+    std::uint64_t epoch;
+  };
+
+  // Per-thread state. Records are linked into the domain on first use and are
+  // never unlinked; a record whose thread exited is simply reused by the next
+  // thread that needs one. Each record takes its own cache line, so that
+  // threads pinning on different cores do not bounce each other's epochs.
+  struct alignas(64) Record {
+    // The epoch this thread observed when it pinned, or 0 while unpinned.
+    std::atomic<std::uint64_t> local_epoch{0};
+    std::atomic<bool> in_use{true};
+    unsigned nesting = 0;
+    std::vector<Retired> limbo;
+    Record* next = nullptr;
+  };
+
+  // Everything a thread may still touch after the EpochDomain object itself
+  // has been destroyed lives here, kept alive by shared ownership between the
+  // domain and each thread's record cache.
+  struct State {
+    ~State() {
+      for (Record* record = records.load(); record != nullptr;) {
+        Record* next = record->next;
+        free_all(record->limbo);
+        delete record;
+        record = next;
+      }
+      free_all(orphans);
+    }
+
+    std::atomic<std::uint64_t> global_epoch{1};
+    std::atomic<Record*> records{nullptr};
+    std::atomic<bool> closed{false};
+
+    // Retired pointers left behind by threads that exited before their epoch
+    // was reached.
+    std::mutex orphans_mutex;
+    std::vector<Retired> orphans;
+  };
+
+ public:
+  // Keeps the calling thread pinned while alive. Guards nest: only the
+  // outermost guard on a thread publishes and clears the thread's epoch.
+  class Guard {
+   public:
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+    Guard(Guard&& other) noexcept : record_(other.record_) {
+      other.record_ = nullptr;
+    }
+    ~Guard() noexcept {
+      if (record_ != nullptr && --record_->nesting == 0) {
+        record_->local_epoch.store(0, std::memory_order_release);
+      }
+    }
+
+   private:
+    friend class EpochDomain;
+    explicit Guard(Record* record) : record_(record) {}
+    Record* record_;
+  };
+
+  EpochDomain() : state_(std::make_shared<State>()) {}
+
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+
+  // Frees every outstanding retired pointer. No thread may be inside an
+  // operation on the domain when it is destroyed.
+  ~EpochDomain() {
+    state_->closed.store(true);
+    for (Record* record = state_->records.load(); record != nullptr;
+         record = record->next) {
+      free_all(record->limbo);
+    }
+    std::lock_guard lock(state_->orphans_mutex);
+    free_all(state_->orphans);
+  }
+
+  // Pins the calling thread until the returned guard is destroyed.
+  Guard pin() {
+    Record* record = local_record();
+    if (record->nesting++ == 0) {
+      // A sequentially consistent exchange makes the published epoch visible
+      // before any shared pointer is read.
+      record->local_epoch.exchange(
+          state_->global_epoch.load(std::memory_order_relaxed),
+          std::memory_order_seq_cst);
+    }
+    return Guard(record);
+  }
+
+  // Schedules "pointer" for deletion once no pinned thread can still reach it.
+  // The pointer must already be unreachable from the shared structure.
+  template <class T>
+  void retire(T* pointer) {
+    retire(pointer, [](void* p) { delete static_cast<T*>(p); });
+  }
+
+  void retire(void* pointer, void (*deleter)(void*)) {
+    Record* record = local_record();
+    record->limbo.push_back(
+        {pointer, deleter,
+         state_->global_epoch.load(std::memory_order_acquire)});
+    if (record->limbo.size() >= COLLECT_THRESHOLD) {
+      collect(*record);
+    }
+  }
+
+  // Attempts to advance the epoch and frees whatever the calling thread has
+  // retired that is now safe to delete.
+  void collect() { collect(*local_record()); }
+
+ private:
+  // Number of pointers a thread retires between attempts to free them.
+  static constexpr std::size_t COLLECT_THRESHOLD = 64;
+
+  static void free_all(std::vector<Retired>& retired) {
+    for (const Retired& entry : retired) {
+      entry.deleter(entry.pointer);
+    }
+    retired.clear();
+  }
+
+  // Frees the entries of "retired" that are at least two epochs old.
+  static void free_expired(std::vector<Retired>& retired, std::uint64_t epoch) {
+    auto expired = std::partition(
+        retired.begin(), retired.end(),
+        [epoch](const Retired& entry) { return entry.epoch + 2 > epoch; });
+    for (auto iter = expired; iter != retired.end(); ++iter) {
+      iter->deleter(iter->pointer);
+    }
+    retired.erase(expired, retired.end());
+  }
+
+  // Advances the global epoch if every pinned thread has observed it.
+  bool try_advance() {
+    std::uint64_t epoch = state_->global_epoch.load(std::memory_order_seq_cst);
+    for (Record* record = state_->records.load(std::memory_order_acquire);
+         record != nullptr; record = record->next) {
+      const std::uint64_t local =
+          record->local_epoch.load(std::memory_order_seq_cst);
+      if (local != 0 && local != epoch) {
+        return false;
+      }
+    }
+    return state_->global_epoch.compare_exchange_strong(
+        epoch, epoch + 1, std::memory_order_acq_rel);
+  }
+
+  void collect(Record& record) {
+    try_advance();
+    const std::uint64_t epoch =
+        state_->global_epoch.load(std::memory_order_acquire);
+    free_expired(record.limbo, epoch);
+
+    std::unique_lock lock(state_->orphans_mutex, std::try_to_lock);
+    if (lock.owns_lock() && !state_->orphans.empty()) {
+      free_expired(state_->orphans, epoch);
+    }
+  }
+
+  // Each thread caches the record it uses for every domain it has touched. On
+  // thread exit the cache hands any pending retirements to the domain and
+  // releases the records for reuse.
+  struct ThreadCache {
+    ~ThreadCache() {
+      for (auto& [state, record] : entries) {
+        if (!state->closed.load()) {
+          std::lock_guard lock(state->orphans_mutex);
+          state->orphans.insert(state->orphans.end(), record->limbo.begin(),
+                                record->limbo.end());
+        }
+        record->limbo.clear();
+        record->in_use.store(false, std::memory_order_release);
+      }
+    }
+
+    std::vector<std::pair<std::shared_ptr<State>, Record*>> entries;
+  };
+
+  Record* local_record() {
+    thread_local ThreadCache cache;
+    for (auto& [state, record] : cache.entries) {
+      if (state == state_) {
+        return record;
+      }
+    }
+
+    // First use of this domain on this thread. Drop cache entries for domains
+    // that no longer exist, then claim a free record or link a new one.
+    cache.entries.erase(
+        std::remove_if(cache.entries.begin(), cache.entries.end(),
+                       [](const auto& entry) {
+                         if (!entry.first->closed.load()) return false;
+                         entry.second->in_use.store(false);
+                         return true;
+                       }),
+        cache.entries.end());
+
+    Record* record = nullptr;
+    for (Record* candidate = state_->records.load(std::memory_order_acquire);
+         candidate != nullptr; candidate = candidate->next) {
+      bool expected = false;
+      if (candidate->in_use.compare_exchange_strong(expected, true)) {
+        record = candidate;
+        break;
+      }
+    }
+    if (record == nullptr) {
+      record = new Record;
+      Record* head = state_->records.load(std::memory_order_relaxed);
+      do {
+        record->next = head;
+      } while (!state_->records.compare_exchange_weak(
+          head, record, std::memory_order_release, std::memory_order_relaxed));
+    }
+    cache.entries.emplace_back(state_, record);
+    return record;
+  }
+
+  std::shared_ptr<State> state_;
+};
+
+#endif
@@ -0,0 +1,406 @@
+#include "external_sort.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "book_loader.hpp"
+#include "book_snapshot.hpp"
+#include "sorted_run.hpp"
+
+namespace {
+
+constexpr std::size_t MAX_FIELD_SIZE = 0xFFFF;        // a run entry's 2-byte lengths
+constexpr std::size_t MAX_RECORD_TEXT = 8 * MAX_FIELD_SIZE;
+constexpr std::size_t MAX_BUFFER = 1 << 20;
+constexpr std::size_t MIN_BUDGET = 64 << 10;
+
+[[noreturn]] void fail(const std::string& what, const std::string& path) {
+  throw std::system_error(errno, std::generic_category(), what + " " + path);
+}
+
+// The run files of one sort, removed when it ends however it ends.
+class TemporaryFiles {
+ public:
+  explicit TemporaryFiles(const std::string& directory)
+      : directory_(directory.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(directory)) {}
+
+  TemporaryFiles(const TemporaryFiles&) = delete;
+  TemporaryFiles& operator=(const TemporaryFiles&) = delete;
+
+  ~TemporaryFiles() noexcept {
+    std::error_code ignored;
+    for (const std::string& path : paths_) std::filesystem::remove(path, ignored);
+  }
+
+  std::string make() {
+    paths_.push_back((directory_ / ("external_sort." + std::to_string(::getpid()) + "." +
+                                    std::to_string(paths_.size()) + ".run")).string());
+    return paths_.back();
+  }
+
+  void remove(const std::string& path) { std::filesystem::remove(path); }
+
+ private:
+  std::filesystem::path directory_;
+  std::vector<std::string> paths_;
+};
+
+// Writes bytes to a file through a buffer of "capacity" bytes.
+class BufferedWriter {
+ public:
+  BufferedWriter(const std::string& path, std::size_t capacity)
+      : path_(path), file_(path, std::ios::binary | std::ios::trunc), capacity_(capacity) {
+    if (!file_) fail("create", path_);
+    buffer_.reserve(capacity_);
+  }
+
+  std::string& buffer() { return buffer_; }
+
+  // Call after appending to buffer().
+  void written() {
+    if (buffer_.size() >= capacity_) flush();
+  }
+
+  std::size_t finish() {
+    flush();
+    file_.close();
+    if (!file_) fail("write", path_);
+    return bytes_;
+  }
+
+ private:
+  void flush() {
+    file_.write(buffer_.data(), buffer_.size());
+    if (!file_) fail("write", path_);
+    bytes_ += buffer_.size();
+    buffer_.clear();
+  }
+
+  std::string path_;
+  std::ofstream file_;
+  std::string buffer_;
+  std::size_t capacity_;
+  std::size_t bytes_ = 0;
+};
+
+// Reads a run file's entries in order through a buffer of about "capacity"
+// bytes.
+class RunReader {
+ public:
+  RunReader(const std::string& path, std::size_t capacity)
+      : path_(path), file_(path, std::ios::binary), capacity_(capacity) {
+    if (!file_) fail("open", path_);
+    advance();
+  }
+
+  bool valid() const { return valid_; }
+  const RunEntry& entry() const { return entry_; }
+
+  // Moves to the next entry; "entry()" and the views it holds change.
+  void advance() {
+    for (;;) {
+      const char* begin = buffer_.data() + position_;
+      if (const char* next = decode_run_entry(begin, buffer_.data() + buffer_.size(), entry_)) {
+        position_ = next - buffer_.data();
+        valid_ = true;
+        return;
+      }
+      if (end_of_file_) {
+        if (position_ != buffer_.size()) throw std::runtime_error(path_ + ": damaged run file");
+        valid_ = false;
+        return;
+      }
+      refill();
+    }
+  }
+
+ private:
+  void refill() {
+    buffer_.erase(0, position_);
+    position_ = 0;
+    const std::size_t kept = buffer_.size();
+    buffer_.resize(kept + capacity_);
+    file_.read(&buffer_[kept], capacity_);
+    buffer_.resize(kept + file_.gcount());
+    if (file_.eof()) {
+      end_of_file_ = true;
+    } else if (!file_) {
+      fail("read", path_);
+    }
+  }
+
+  std::string path_;
+  std::ifstream file_;
+  std::size_t capacity_;
+  std::string buffer_;
+  std::size_t position_ = 0;
+  bool end_of_file_ = false;
+  RunEntry entry_;
+  bool valid_ = false;
+};
+
+// Calls "visit(record)" for every record of the text database or snapshot at
+// "path", reading text a chunk of "chunk" bytes at a time.
+void for_each_input_record(const std::string& path, std::size_t chunk,
+                           const std::function<void(const RawBookRecord&)>& visit) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) fail("open", path);
+  char magic[sizeof SnapshotHeader::MAGIC] = {};
+  file.read(magic, sizeof magic);
+  if (file.gcount() == sizeof magic && std::memcmp(magic, SnapshotHeader::MAGIC, sizeof magic) == 0) {
+    const BookSnapshot snapshot(path);
+    for (std::size_t i = 0; i < snapshot.size(); ++i) visit(snapshot.record(i));
+    return;
+  }
+
+  std::string buffer(magic, file.gcount());
+  file.clear();
+  for (bool end_of_file = false; !end_of_file;) {
+    const std::size_t kept = buffer.size();
+    buffer.resize(kept + chunk);
+    file.read(&buffer[kept], chunk);
+    buffer.resize(kept + file.gcount());
+    end_of_file = file.eof();
+    if (!end_of_file && !file) fail("read", path);
+
+    const char* cursor = buffer.data();
+    const char* end = buffer.data() + buffer.size();
+    RawBookRecord record;
+    for (;;) {
+      const char* next = parse_book_record(cursor, end, record);
+      // A record ending exactly at the end of the chunk may have more price
+      // digits in the next one.
+      if (next == nullptr || (next == end && !end_of_file)) break;
+      visit(record);
+      cursor = next;
+    }
+    // Like for_each_book_record, stop quietly at a record that cannot be
+    // complete, whether the file ends or no record is that long.
+    if (static_cast<std::size_t>(end - cursor) > MAX_RECORD_TEXT && !end_of_file) {
+      if (parse_book_record(cursor, end, record) == nullptr) return;
+    }
+    buffer.erase(0, cursor - buffer.data());
+  }
+}
+
+void append_quoted(std::string& out, std::string_view field) {
+  out.push_back('"');
+  for (char c : field) {
+    if (c == '"' || c == '\\') out.push_back('\\');
+    out.push_back(c);
+  }
+  out.push_back('"');
+}
+
+// operator<<(Book)'s format, but with the shortest price that reads back
+// exactly.
+void append_text_record(std::string& out, const RunEntry& entry) {
+  append_quoted(out, entry.isbn);
+  out.push_back(',');
+  append_quoted(out, entry.title);
+  out.push_back(',');
+  append_quoted(out, entry.author);
+  out.push_back(',');
+  char price[32];
+  const auto result = std::to_chars(price, price + sizeof price, entry.price);
+  out.append(price, result.ptr);
+  out.push_back('\n');
+}
+
+class Sorter {
+ public:
+  Sorter(const ExternalSortOptions& options, ExternalSortStatistics& statistics)
+      : options_(options),
+        statistics_(statistics),
+        files_(options.temporary_directory),
+        buffer_bytes_(std::min(MAX_BUFFER, options.memory_budget / 4)),
+        fan_in_(std::max<std::size_t>(2, options.memory_budget / buffer_bytes_ - 1)) {}
+
+  void sort(const std::string& input_path, const std::string& output_path) {
+    form_runs(input_path);
+
+    // Merge consecutive runs, so run i still holds only records read after
+    // those of run i - 1, until one pass can produce the output.
+    while (runs_.size() > fan_in_) {
+      std::vector<std::string> merged;
+      for (std::size_t first = 0; first < runs_.size(); first += fan_in_) {
+        const std::vector<std::string> group(runs_.begin() + first,
+                                             runs_.begin() + std::min(first + fan_in_, runs_.size()));
+        if (group.size() == 1) {
+          merged.push_back(group.front());
+          continue;
+        }
+        const std::string path = files_.make();
+        BufferedWriter writer(path, buffer_bytes_);
+        merge(group, [&](const RunEntry& entry) {
+          append_run_entry(writer.buffer(), entry);
+          writer.written();
+        });
+        statistics_.bytes_spilled += writer.finish();
+        for (const std::string& input : group) files_.remove(input);
+        merged.push_back(path);
+      }
+      runs_ = std::move(merged);
+      ++statistics_.merge_passes;
+    }
+
+    BufferedWriter output(output_path, buffer_bytes_);
+    merge(runs_, [&](const RunEntry& entry) {
+      append_text_record(output.buffer(), entry);
+      output.written();
+      ++statistics_.records_written;
+    });
+    output.finish();
+    ++statistics_.merge_passes;
+  }
+
+ private:
+  // Where a buffered record is, and its ISBN's length for sorting.
+  struct Key {
+    std::size_t offset;
+    std::size_t isbn_size;
+  };
+
+  void form_runs(const std::string& input_path) {
+    // Half the budget holds records and an eighth their keys; the input chunk
+    // and the run being written take at most a quarter each.
+    records_.reserve(options_.memory_budget / 2);
+    keys_.reserve(options_.memory_budget / 8 / sizeof(Key));
+    std::string title, author;
+    for_each_input_record(input_path, buffer_bytes_, [&](const RawBookRecord& record) {
+      ++statistics_.records_read;
+      RunEntry entry{record.isbn, record.title, record.author, record.price, false};
+      std::string isbn;
+      if (record.escaped) {
+        isbn = unescape_book_field(record.isbn);
+        title = unescape_book_field(record.title);
+        author = unescape_book_field(record.author);
+        entry.isbn = isbn;
+        entry.title = title;
+        entry.author = author;
+      }
+      if (entry.isbn.size() > MAX_FIELD_SIZE || entry.title.size() > MAX_FIELD_SIZE ||
+          entry.author.size() > MAX_FIELD_SIZE) {
+        throw std::length_error("book " + std::string(entry.isbn.substr(0, 32)) + " has a field too long to sort");
+      }
+      const std::size_t size = 15 + entry.isbn.size() + entry.title.size() + entry.author.size();
+      if (!keys_.empty() && (records_.size() + size > records_.capacity() || keys_.size() == keys_.capacity())) {
+        spill();
+      }
+      keys_.push_back(Key{records_.size(), entry.isbn.size()});
+      append_run_entry(records_, entry);
+    });
+    if (!keys_.empty()) {
+      spill();
+    }
+    std::string().swap(records_);
+    std::vector<Key>().swap(keys_);
+  }
+
+  std::string_view isbn(const Key& key) const {
+    return std::string_view(records_.data() + key.offset + 15, key.isbn_size);
+  }
+
+  void spill() {
+    std::stable_sort(keys_.begin(), keys_.end(),
+                     [this](const Key& a, const Key& b) { return isbn(a) < isbn(b); });
+    const std::string path = files_.make();
+    BufferedWriter writer(path, buffer_bytes_);
+    RunEntry entry;
+    for (std::size_t i = 0; i < keys_.size(); ++i) {
+      // Of equal ISBNs, the stable sort left the last one read last.
+      if (options_.deduplicate && i + 1 < keys_.size() && isbn(keys_[i]) == isbn(keys_[i + 1])) {
+        ++statistics_.duplicates_dropped;
+        continue;
+      }
+      const char* begin = records_.data() + keys_[i].offset;
+      const char* end = decode_run_entry(begin, records_.data() + records_.size(), entry);
+      writer.buffer().append(begin, end);
+      writer.written();
+    }
+    statistics_.bytes_spilled += writer.finish();
+    runs_.push_back(path);
+    ++statistics_.runs;
+    records_.clear();
+    keys_.clear();
+  }
+
+  // Merges "inputs" in ISBN order into "sink". Of equal ISBNs the later run's
+  // record comes first, and is the only one kept when deduplicating.
+  template <class Sink>
+  void merge(const std::vector<std::string>& inputs, Sink sink) {
+    if (inputs.empty()) {
+      return;
+    }
+    std::vector<std::optional<RunReader>> readers(inputs.size());
+    for (std::size_t i = 0; i < inputs.size(); ++i) readers[i].emplace(inputs[i], buffer_bytes_);
+    const bool later_first = options_.deduplicate;
+    auto less = [&](std::size_t a, std::size_t b) {
+      if (!readers[a]->valid()) return false;
+      if (!readers[b]->valid()) return true;
+      const int order = readers[a]->entry().isbn.compare(readers[b]->entry().isbn);
+      return order != 0 ? order < 0 : (later_first ? a > b : a < b);
+    };
+
+    LoserTree tree(readers.size());
+    tree.build(less);
+    std::string previous;
+    bool first = true;
+    for (;;) {
+      RunReader& reader = *readers[tree.winner()];
+      if (!reader.valid()) {
+        break;
+      }
+      const RunEntry& entry = reader.entry();
+      if (options_.deduplicate && !first && entry.isbn == previous) {
+        ++statistics_.duplicates_dropped;
+      } else {
+        sink(entry);
+        previous.assign(entry.isbn);
+        first = false;
+      }
+      reader.advance();
+      tree.replay(less);
+    }
+  }
+
+  const ExternalSortOptions& options_;
+  ExternalSortStatistics& statistics_;
+  TemporaryFiles files_;
+  const std::size_t buffer_bytes_;
+  const std::size_t fan_in_;
+  std::string records_;
+  std::vector<Key> keys_;
+  std::vector<std::string> runs_;
+};
+
+}  // namespace
+
+ExternalSortStatistics external_sort_books(const std::string& input_path, const std::string& output_path,
+                                           const ExternalSortOptions& options) {
+  if (options.memory_budget < MIN_BUDGET) {
+    throw std::invalid_argument("external sort needs a memory budget of at least " +
+                                std::to_string(MIN_BUDGET) + " bytes");
+  }
+  const auto start_time = std::chrono::steady_clock::now();
+  ExternalSortStatistics statistics;
+  statistics.bytes_read = std::filesystem::file_size(input_path);
+  Sorter(options, statistics).sort(input_path, output_path);
+  statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  return statistics;
+}
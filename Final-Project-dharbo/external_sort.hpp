@@ -0,0 +1,104 @@
+#ifndef _external_sort_hpp_
+#define _external_sort_hpp_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Sorts a Book database of any size by ISBN within a fixed memory budget, and
+// drops duplicate ISBNs, keeping the last record of each as inserting every
+// book into a hash table would.
+//
+// The sort runs in two phases:
+//
+//   run formation  the input is read a chunk at a time into a buffer of
+//                  encoded records (sorted_run.hpp's entry format) until the
+//                  buffer reaches the budget; the buffer is sorted, deduped,
+//                  and spilled to a temporary run file, so run i holds part i
+//                  of the input in ISBN order
+//   merging        up to "fan in" runs are merged at a time through a loser
+//                  tree, which finds the next smallest ISBN among k runs in
+//                  log2(k) comparisons. Of equal ISBNs the record from the
+//                  latest run wins. Merged runs replace their inputs until
+//                  one pass can merge the rest straight into the output.
+//
+// The input is a text database or a snapshot (recognized by its magic
+// number); the output is a text database in operator<<(Book)'s format, with
+// prices written in full precision.
+//
+// Usage:
+//
+//   ExternalSortOptions options;
+//   options.memory_budget = 256 << 20;
+//   ExternalSortStatistics statistics = external_sort_books("feeds.dat", "sorted.dat", options);
+
+struct ExternalSortOptions {
+  std::size_t memory_budget = 64 << 20;               // bytes of records and buffers held at once
+  std::string temporary_directory;                    // for run files; empty means the system's
+  bool deduplicate = true;
+};
+
+struct ExternalSortStatistics {
+  std::size_t bytes_read = 0;
+  std::size_t records_read = 0;
+  std::size_t records_written = 0;
+  std::size_t duplicates_dropped = 0;
+  std::size_t runs = 0;                               // written by run formation
+  std::size_t merge_passes = 0;                       // including the final one
+  std::size_t bytes_spilled = 0;                      // to run files, over every pass
+  double seconds = 0.0;
+};
+
+// Sorts "input_path" into "output_path". Temporary files are removed even if
+// sorting fails. Throws std::system_error on I/O errors, std::length_error if
+// a field is longer than a run entry can hold, and std::invalid_argument if
+// the memory budget is too small to merge two runs.
+ExternalSortStatistics external_sort_books(const std::string& input_path, const std::string& output_path,
+                                           const ExternalSortOptions& options = {});
+
+// Selects the smallest of "k" sequences repeatedly: a tournament tree whose
+// internal nodes remember the loser of each match, so replacing the winner
+// replays only the log2(k) matches on its path to the root.
+//
+// "less(a, b)" orders sources a and b by their current heads; an exhausted
+// source must compare greater than every other.
+//
+//   LoserTree tree(k);
+//   tree.build(less);
+//   while (!exhausted(tree.winner())) { consume(tree.winner()); advance it; tree.replay(less); }
+class LoserTree {
+ public:
+  explicit LoserTree(std::size_t k) : k_(k), losers_(k, 0) {}
+
+  template <class Less>
+  void build(Less less) {
+    // Winners of each subtree, bottom up: leaves are k .. 2k-1.
+    std::vector<std::size_t> winners(2 * k_);
+    for (std::size_t i = 0; i < k_; ++i) winners[k_ + i] = i;
+    for (std::size_t node = k_ - 1; node > 0; --node) {
+      const std::size_t a = winners[2 * node], b = winners[2 * node + 1];
+      const bool a_wins = !less(b, a);
+      winners[node] = a_wins ? a : b;
+      losers_[node] = a_wins ? b : a;
+    }
+    losers_[0] = k_ > 1 ? winners[1] : 0;
+  }
+
+  std::size_t winner() const { return losers_[0]; }
+
+  // Replays the matches of the winner, whose head has changed.
+  template <class Less>
+  void replay(Less less) {
+    std::size_t winner = losers_[0];
+    for (std::size_t node = (k_ + winner) / 2; node > 0; node /= 2) {
+      if (less(losers_[node], winner)) std::swap(losers_[node], winner);
+    }
+    losers_[0] = winner;
+  }
+
+ private:
+  std::size_t k_;
+  std::vector<std::size_t> losers_;                   // losers_[0] is the overall winner
+};
+
+#endif
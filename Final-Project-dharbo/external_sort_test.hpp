@@ -0,0 +1,132 @@
+#ifndef _external_sort_test_hpp_
+#define _external_sort_test_hpp_
+
+#include "external_sort.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "book_loader.hpp"
+#include "book_snapshot.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("LoserTree") {
+  std::default_random_engine random(41);
+  for (std::size_t k = 1; k <= 9; ++k) {
+    std::vector<std::vector<int>> sources(k);
+    std::vector<int> expected;
+    for (auto& source : sources) {
+      source.resize(random() % 20);
+      for (int& value : source) value = static_cast<int>(random() % 50);
+      std::sort(source.begin(), source.end());
+      expected.insert(expected.end(), source.begin(), source.end());
+    }
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<std::size_t> heads(k, 0);
+    auto less = [&](std::size_t a, std::size_t b) {
+      if (heads[a] == sources[a].size()) return false;
+      if (heads[b] == sources[b].size()) return true;
+      return sources[a][heads[a]] < sources[b][heads[b]];
+    };
+    LoserTree tree(k);
+    tree.build(less);
+    std::vector<int> merged;
+    while (heads[tree.winner()] < sources[tree.winner()].size()) {
+      merged.push_back(sources[tree.winner()][heads[tree.winner()]++]);
+      tree.replay(less);
+    }
+    CHECK_EQ(merged, expected);
+  }
+}
+
+TEST_CASE("ExternalSort") {
+  const std::filesystem::path directory = std::filesystem::temp_directory_path() / "external_sort_test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  const std::string input = (directory / "input.dat").string();
+  const std::string output = (directory / "output.dat").string();
+
+  // Over ten times the smallest budget, each ISBN about three times over, a
+  // few fields needing escapes, and prices that do not print in six digits.
+  std::default_random_engine random(410);
+  std::vector<Book> books;
+  std::map<std::string, Book> expected;
+  for (std::size_t i = 0; i < 15000; ++i) {
+    const std::string isbn = std::to_string(1000000 + random() % 5000);
+    std::string title = "Title " + std::to_string(i) + " (1st edition)";
+    if (i % 97 == 0) title += " \"quoted\" \\ slashed";
+    books.emplace_back(title, "Author " + std::to_string(i % 300), isbn, 1000.0 + i / 7.0);
+    expected.insert_or_assign(isbn, books.back());
+  }
+  {
+    std::ofstream file(input);
+    for (const Book& book : books) file << std::quoted(book.isbn()) << ", " << std::quoted(book.title()) << ", "
+                                        << std::quoted(book.author()) << ", " << std::setprecision(17)
+                                        << book.price() << '\n';
+  }
+  const std::vector<Book> unsorted = load_books_mapped(input);
+  REQUIRE_EQ(unsorted, books);
+
+  ExternalSortOptions options;
+  options.memory_budget = 64 << 10;
+  options.temporary_directory = directory.string();
+  REQUIRE_GT(std::filesystem::file_size(input), 10 * options.memory_budget);
+
+  SUBCASE("SortsAndKeepsLastDuplicate") {
+    const ExternalSortStatistics statistics = external_sort_books(input, output, options);
+    CHECK_EQ(statistics.records_read, books.size());
+    CHECK_EQ(statistics.records_written, expected.size());
+    CHECK_EQ(statistics.duplicates_dropped, books.size() - expected.size());
+    CHECK_GT(statistics.runs, 10);
+    CHECK_GT(statistics.merge_passes, 1);
+
+    std::vector<Book> sorted;
+    for (const auto& [isbn, book] : expected) sorted.push_back(book);
+    CHECK_EQ(load_books_mapped(output), sorted);
+    // Only the input and output are left.
+    CHECK_EQ(std::distance(std::filesystem::directory_iterator(directory), std::filesystem::directory_iterator()), 2);
+  }
+
+  SUBCASE("KeepsDuplicatesInInputOrder") {
+    options.deduplicate = false;
+    external_sort_books(input, output, options);
+    std::vector<Book> sorted = books;
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const Book& a, const Book& b) { return a.isbn() < b.isbn(); });
+    CHECK_EQ(load_books_mapped(output), sorted);
+  }
+
+  SUBCASE("ReadsSnapshots") {
+    const std::string snapshot = (directory / "input.snap").string();
+    write_book_snapshot(snapshot, books);
+    const ExternalSortStatistics statistics = external_sort_books(snapshot, output, options);
+    CHECK_EQ(statistics.records_written, expected.size());
+    CHECK_EQ(load_books_mapped(output).back(), expected.rbegin()->second);
+  }
+
+  SUBCASE("EdgeCases") {
+    { std::ofstream file(input, std::ios::trunc); }
+    CHECK_EQ(external_sort_books(input, output, options).records_written, 0);
+    CHECK_EQ(std::filesystem::file_size(output), 0);
+
+    options.memory_budget = 1000;
+    CHECK_THROWS_AS(external_sort_books(input, output, options), std::invalid_argument);
+    CHECK_THROWS_AS(external_sort_books((directory / "missing").string(), output, ExternalSortOptions{}),
+                    std::filesystem::filesystem_error);
+  }
+
+  std::filesystem::remove_all(directory);
+}
+
+#endif
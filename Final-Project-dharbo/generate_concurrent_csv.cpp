@@ -0,0 +1,600 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "book.hpp"
+#include "book_view.hpp"
+#include "concurrent_hash_map.hpp"
+#include "concurrent_queue.hpp"
+#include "group_by.hpp"
+#include "rcu_catalog.hpp"
+#include "skip_list.hpp"
+#include "timer.hpp"
+
+// Multi-threaded companion to generate_csv.cpp. Reads a book database from
+// standard input and sweeps each concurrent structure from 1 to N threads,
+// writing one comma-separated row per (structure, thread count) to standard
+// output.
+//
+// Usage:  generate_concurrent_csv <mode> [max-threads] < database-large.dat
+//
+// Modes:  hash   sharded hash table against a mutex-wrapped std::unordered_map
+//         queue  lock-free MPMC queues against a mutex-wrapped std::list
+//         skiplist  lock-free skip list against std::map behind a std::shared_mutex
+//         rcu    read-copy-update catalog against a std::shared_mutex hash table,
+//                N reader threads plus one writer
+//         aggregate  partitioned group-by-author (count, sum, and average
+//                price) with string keys and with packed author numbers,
+//                against a serial std::unordered_map, over the database and
+//                over synthetic catalogs of 10 to 1,000,000 authors
+
+namespace {
+
+using benchmark::Clock;
+using Utilities::Timer;
+
+// Number of lookups performed for every insert/remove pair in the mixed
+// read/write workloads.
+constexpr std::size_t SEARCHES_PER_WRITE = 8;
+
+const std::vector<Book> sampleData = benchmark::load_books(std::cin);
+
+void printHeader() {
+  std::cout << "Threads,Structure,Operations,Throughput (ops/s),Scaling,"
+               "Mean latency (ns),p50 latency (ns),p99 latency (ns),"
+               "Slowest thread mean latency (ns),Slowest thread p99 latency (ns)\n";
+}
+
+// Prints the row for a run whose threads each recorded their own latency
+// samples: percentiles over every sample, then the worst mean and the worst
+// p99 of any one thread, which show a thread starved by the others.
+void printRow(std::size_t threads, const std::string& structureName,
+              std::size_t operations, Clock::duration elapsed,
+              double baselineThroughput,
+              std::vector<std::vector<Clock::duration>>& latencies) {
+  std::vector<Clock::duration> merged;
+  double slowestMean = 0.0;
+  long long slowestP99 = 0;
+  for (auto& samples : latencies) {
+    merged.insert(merged.end(), samples.begin(), samples.end());
+    const benchmark::LatencySummary perThread = benchmark::summarize(samples);
+    slowestMean = std::max(slowestMean, perThread.mean);
+    slowestP99 = std::max(slowestP99, perThread.p99);
+  }
+  const double throughput = benchmark::per_second(operations, elapsed);
+  const benchmark::LatencySummary latency = benchmark::summarize(merged);
+  std::cout << threads << ',' << structureName << ',' << operations << ','
+            << static_cast<long long>(throughput) << ','
+            << (baselineThroughput > 0.0 ? throughput / baselineThroughput : 1.0)
+            << ',' << static_cast<long long>(latency.mean) << ',' << latency.p50 << ',' << latency.p99
+            << ',' << static_cast<long long>(slowestMean) << ',' << slowestP99 << '\n';
+}
+
+// Every search of the benchmarks looks for a book of the sample data and
+// half of them stay loaded throughout, so a run that found none of them
+// searched the wrong way.
+void checkHits(const std::string& structureName, const std::vector<std::size_t>& found) {
+  std::size_t hits = 0;
+  for (std::size_t threadHits : found) hits += threadHits;
+  if (hits == 0 && sampleData.size() > 1) std::clog << "  " << structureName << " found no books\n";
+}
+
+//
+// HASH TABLE MODE
+//
+
+// Baseline: the whole table behind one lock, as a program would have to do to
+// share insert_into_hash_table and friends between threads.
+struct MutexHashTable {
+  void insert(const Book& book) {
+    std::lock_guard lock(mutex);
+    table[book.isbn()] = book;
+  }
+  void remove(const Book& book) {
+    std::lock_guard lock(mutex);
+    table.erase(book.isbn());
+  }
+  std::optional<Book> search(const std::string& isbn) {
+    std::lock_guard lock(mutex);
+    auto iter = table.find(isbn);
+    if (iter == table.end()) return std::nullopt;
+    return iter->second;
+  }
+
+  std::mutex mutex;
+  std::unordered_map<std::string, Book> table;
+};
+
+struct ShardedHashTable {
+  void insert(const Book& book) { insert_into_concurrent_hash_table{table}(book); }
+  void remove(const Book& book) { remove_from_concurrent_hash_table{table}(book); }
+  std::optional<Book> search(const std::string& isbn) {
+    return search_within_concurrent_hash_table{table, isbn}(Book{});
+  }
+
+  ConcurrentBookTable table;
+};
+
+// Pre-fills "structure" with the first half of the sample data, then has each
+// thread take a slice of the second half and, for every book in it, insert
+// the book, search for SEARCHES_PER_WRITE random books, and remove the book
+// again. Every operation is timed individually.
+//
+// "Structure" is an adapter with insert(book), remove(book), and search(isbn).
+template <class Structure>
+double measureMixedWorkload(const std::string& structureName, std::size_t threads,
+                        double baselineThroughput) {
+  Structure structure;
+  const std::size_t half = sampleData.size() / 2;
+  for (std::size_t i = 0; i < half; ++i) structure.insert(sampleData[i]);
+
+  std::vector<std::vector<Clock::duration>> latencies(threads);
+  std::vector<std::size_t> found(threads);
+  auto elapsed = benchmark::run_threads(threads, [&](std::size_t index) {
+    auto [begin, end] = benchmark::slice(sampleData.size() - half, index, threads);
+    std::default_random_engine engine(static_cast<unsigned>(index));
+    std::uniform_int_distribution<std::size_t> pick(0, sampleData.size() - 1);
+    auto& samples = latencies[index];
+    samples.reserve((end - begin) * (SEARCHES_PER_WRITE + 2));
+
+    // Counted locally and stored once: the slots of "found" share a cache
+    // line, and writing them in the loop would time false sharing too.
+    std::size_t hits = 0;
+    for (std::size_t i = half + begin; i < half + end; ++i) {
+      auto start_time = Clock::now();
+      structure.insert(sampleData[i]);
+      samples.push_back(Clock::now() - start_time);
+
+      for (std::size_t s = 0; s < SEARCHES_PER_WRITE; ++s) {
+        const std::string& isbn = sampleData[pick(engine)].isbn();
+        start_time = Clock::now();
+        hits += structure.search(isbn).has_value();
+        samples.push_back(Clock::now() - start_time);
+      }
+
+      start_time = Clock::now();
+      structure.remove(sampleData[i]);
+      samples.push_back(Clock::now() - start_time);
+    }
+    found[index] = hits;
+  });
+
+  std::size_t operations = 0;
+  for (const auto& samples : latencies) operations += samples.size();
+  checkHits(structureName, found);
+  printRow(threads, structureName, operations, elapsed, baselineThroughput, latencies);
+  return benchmark::per_second(operations, elapsed);
+}
+
+void runHashMode(std::size_t maxThreads) {
+  Timer timer{"Timer:  Hash Table measurements completed in ", std::clog};
+  double mutexBaseline = 0.0;
+  double shardedBaseline = 0.0;
+  if (maxThreads == 0) maxThreads = benchmark::default_max_threads();
+  for (std::size_t threads : benchmark::thread_counts(maxThreads)) {
+    std::clog << "  measuring hash tables with " << threads << " thread(s)\n";
+    const double mutexThroughput = measureMixedWorkload<MutexHashTable>(
+        "Mutex Hash Table", threads, mutexBaseline);
+    const double shardedThroughput = measureMixedWorkload<ShardedHashTable>(
+        "Sharded Hash Table", threads, shardedBaseline);
+    if (threads == 1) {
+      mutexBaseline = mutexThroughput;
+      shardedBaseline = shardedThroughput;
+    }
+  }
+}
+
+//
+// SKIP LIST MODE
+//
+
+// Baseline: an ordered map shared the conventional way, readers under a shared
+// lock and writers under an exclusive one.
+struct SharedMutexMap {
+  void insert(const Book& book) {
+    std::unique_lock lock(mutex);
+    map[book.isbn()] = book;
+  }
+  void remove(const Book& book) {
+    std::unique_lock lock(mutex);
+    map.erase(book.isbn());
+  }
+  std::optional<Book> search(const std::string& isbn) {
+    std::shared_lock lock(mutex);
+    auto iter = map.find(isbn);
+    if (iter == map.end()) return std::nullopt;
+    return iter->second;
+  }
+
+  std::shared_mutex mutex;
+  std::map<std::string, Book> map;
+};
+
+struct LockFreeSkipList {
+  void insert(const Book& book) { insert_into_skip_list{list}(book); }
+  void remove(const Book& book) { remove_from_skip_list{list}(book); }
+  std::optional<Book> search(const std::string& isbn) {
+    return search_within_skip_list{list, isbn}(Book{});
+  }
+
+  BookSkipList list;
+};
+
+void runSkipListMode(std::size_t maxThreads) {
+  Timer timer{"Timer:  Skip List measurements completed in ", std::clog};
+  if (maxThreads == 0) maxThreads = benchmark::default_max_threads();
+  double mapBaseline = 0.0;
+  double skipListBaseline = 0.0;
+  for (std::size_t threads : benchmark::thread_counts(maxThreads)) {
+    std::clog << "  measuring ordered maps with " << threads << " thread(s)\n";
+    const double mapThroughput = measureMixedWorkload<SharedMutexMap>(
+        "Shared Mutex BST", threads, mapBaseline);
+    const double skipListThroughput = measureMixedWorkload<LockFreeSkipList>(
+        "Skip List", threads, skipListBaseline);
+    if (threads == 1) {
+      mapBaseline = mapThroughput;
+      skipListBaseline = skipListThroughput;
+    }
+  }
+}
+
+//
+// RCU MODE
+//
+
+// Number of lookups each reader thread performs per measurement.
+constexpr std::size_t READS_PER_THREAD = 200'000;
+
+// Only every LATENCY_STRIDE-th read is timed individually, so that reading the
+// clock does not swamp a lookup that takes a few tens of nanoseconds.
+constexpr std::size_t LATENCY_STRIDE = 16;
+
+// Pause between the writer's inserts. The catalog sees about 1000 reads per
+// write in production; an unpaced writer would instead measure how fast the
+// structure absorbs a write storm.
+constexpr auto WRITE_INTERVAL = std::chrono::microseconds(20);
+
+// Baseline: a hash table whose readers take a shared lock. Every lookup still
+// performs an atomic read-modify-write on the lock's cache line.
+struct SharedMutexHashTable {
+  void insert(const Book& book) {
+    std::unique_lock lock(mutex);
+    table[book.isbn()] = book;
+  }
+  bool contains(const std::string& isbn) {
+    std::shared_lock lock(mutex);
+    return table.find(isbn) != table.end();
+  }
+
+  std::shared_mutex mutex;
+  std::unordered_map<std::string, Book> table;
+};
+
+struct RcuHashTable {
+  void insert(const Book& book) { insert_into_rcu_catalog{catalog}(book); }
+  bool contains(const std::string& isbn) {
+    return catalog.visit(isbn, [](const Book&) {});
+  }
+
+  RcuCatalog catalog;
+};
+
+// Loads the first half of the sample data, then runs "readers" threads that
+// look up random books while one writer thread inserts the second half of the
+// sample data, one book every WRITE_INTERVAL, cycling until the readers
+// finish. Only the readers' work counts towards throughput; the writer's
+// insert count is logged.
+template <class Structure>
+double measureReadMostly(const std::string& structureName, std::size_t readers,
+                         double baselineThroughput) {
+  Structure structure;
+  const std::size_t half = sampleData.size() / 2;
+  for (std::size_t i = 0; i < half; ++i) structure.insert(sampleData[i]);
+  if constexpr (std::is_same_v<Structure, RcuHashTable>) structure.catalog.publish();
+
+  std::atomic<std::size_t> readersRunning{readers};
+  std::size_t writes = 0;
+  std::vector<std::vector<Clock::duration>> latencies(readers);
+  std::vector<std::size_t> found(readers);
+
+  auto elapsed = benchmark::run_threads(readers + 1, [&](std::size_t index) {
+    if (index == readers) {
+      for (std::size_t i = 0; readersRunning.load(std::memory_order_relaxed) > 0; ++i, ++writes) {
+        structure.insert(sampleData[half + i % (sampleData.size() - half)]);
+        std::this_thread::sleep_for(WRITE_INTERVAL);
+      }
+      return;
+    }
+    std::default_random_engine engine(static_cast<unsigned>(index));
+    std::uniform_int_distribution<std::size_t> pick(0, sampleData.size() - 1);
+    auto& samples = latencies[index];
+    samples.reserve(READS_PER_THREAD / LATENCY_STRIDE);
+    // Counted locally and stored once, as in measureMixedWorkload().
+    std::size_t hits = 0;
+    for (std::size_t i = 0; i < READS_PER_THREAD; ++i) {
+      const std::string& isbn = sampleData[pick(engine)].isbn();
+      if (i % LATENCY_STRIDE == 0) {
+        auto start_time = Clock::now();
+        hits += structure.contains(isbn);
+        samples.push_back(Clock::now() - start_time);
+      } else {
+        hits += structure.contains(isbn);
+      }
+    }
+    found[index] = hits;
+    readersRunning.fetch_sub(1, std::memory_order_relaxed);
+  });
+
+  std::clog << "    " << structureName << ": writer inserted " << writes << " books\n";
+  checkHits(structureName, found);
+  const std::size_t reads = readers * READS_PER_THREAD;
+  printRow(readers, structureName, reads, elapsed, baselineThroughput, latencies);
+  return benchmark::per_second(reads, elapsed);
+}
+
+void runRcuMode(std::size_t maxThreads) {
+  Timer timer{"Timer:  RCU measurements completed in ", std::clog};
+  if (maxThreads == 0) maxThreads = benchmark::default_max_threads();
+  double lockBaseline = 0.0;
+  double rcuBaseline = 0.0;
+  for (std::size_t readers : benchmark::thread_counts(maxThreads)) {
+    std::clog << "  measuring read-mostly catalogs with " << readers << " reader(s) and 1 writer\n";
+    const double lockThroughput = measureReadMostly<SharedMutexHashTable>(
+        "Shared Mutex Hash Table", readers, lockBaseline);
+    const double rcuThroughput = measureReadMostly<RcuHashTable>(
+        "RCU Catalog", readers, rcuBaseline);
+    if (readers == 1) {
+      lockBaseline = lockThroughput;
+      rcuBaseline = rcuThroughput;
+    }
+  }
+}
+
+//
+// QUEUE MODE
+//
+
+// Number of books pushed through each queue per measurement, regardless of
+// the number of producers and consumers.
+constexpr std::size_t QUEUE_MESSAGES = 200'000;
+
+// The queue payload: a book stamped with the time it was enqueued so the
+// consumer can measure how long it waited in the queue.
+struct Message {
+  Book book;
+  Clock::time_point enqueued;
+};
+
+// Baseline: the work queue as it is written today, std::list push_back and
+// pop_front behind one lock.
+struct MutexListQueue {
+  bool push(Message message) {
+    std::lock_guard lock(mutex);
+    list.push_back(std::move(message));
+    return true;
+  }
+  bool pop(Message& message) {
+    std::lock_guard lock(mutex);
+    if (list.empty()) return false;
+    message = std::move(list.front());
+    list.pop_front();
+    return true;
+  }
+
+  std::mutex mutex;
+  std::list<Message> list;
+};
+
+struct RingQueue {
+  bool push(Message message) { return queue.try_push(std::move(message)); }
+  bool pop(Message& message) { return queue.try_pop(message); }
+
+  BoundedQueue<Message> queue{1024};
+};
+
+struct MichaelScottQueue {
+  bool push(Message message) {
+    queue.push(std::move(message));
+    return true;
+  }
+  bool pop(Message& message) {
+    std::optional<Message> popped = queue.try_pop();
+    if (!popped) return false;
+    message = std::move(*popped);
+    return true;
+  }
+
+  UnboundedQueue<Message> queue;
+};
+
+// Runs "pairs" producers and "pairs" consumers against a fresh queue. The
+// producers split QUEUE_MESSAGES between them, cycling through the sample
+// data; the consumers pop until every message has been seen and record the
+// enqueue-to-dequeue latency of each one.
+template <class Queue>
+double measureQueue(const std::string& structureName, std::size_t pairs,
+                    double baselineThroughput) {
+  Queue queue;
+  std::atomic<std::size_t> consumed{0};
+  std::vector<std::vector<Clock::duration>> latencies(pairs);
+
+  auto elapsed = benchmark::run_threads(2 * pairs, [&](std::size_t index) {
+    if (index < pairs) {
+      auto [begin, end] = benchmark::slice(QUEUE_MESSAGES, index, pairs);
+      for (std::size_t i = begin; i < end; ++i) {
+        Message message{sampleData[i % sampleData.size()], Clock::now()};
+        while (!queue.push(message)) std::this_thread::yield();
+      }
+    } else {
+      auto& samples = latencies[index - pairs];
+      samples.reserve(QUEUE_MESSAGES / pairs + 1);
+      Message message;
+      while (consumed.load(std::memory_order_relaxed) < QUEUE_MESSAGES) {
+        if (queue.pop(message)) {
+          samples.push_back(Clock::now() - message.enqueued);
+          consumed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    }
+  });
+
+  std::size_t operations = 0;
+  for (const auto& samples : latencies) operations += samples.size();
+  printRow(pairs, structureName, operations, elapsed, baselineThroughput, latencies);
+  return benchmark::per_second(operations, elapsed);
+}
+
+void runQueueMode(std::size_t maxThreads) {
+  Timer timer{"Timer:  Queue measurements completed in ", std::clog};
+  if (maxThreads == 0) maxThreads = 16;
+  double listBaseline = 0.0;
+  double ringBaseline = 0.0;
+  double msBaseline = 0.0;
+  for (std::size_t pairs : {1, 2, 4, 8, 16}) {
+    if (pairs > maxThreads) break;
+    std::clog << "  measuring queues with " << pairs << " producer(s) and " << pairs << " consumer(s)\n";
+    const double listThroughput = measureQueue<MutexListQueue>("Mutex List Queue", pairs, listBaseline);
+    const double ringThroughput = measureQueue<RingQueue>("Bounded Ring Queue", pairs, ringBaseline);
+    const double msThroughput = measureQueue<MichaelScottQueue>("Michael-Scott Queue", pairs, msBaseline);
+    if (pairs == 1) {
+      listBaseline = listThroughput;
+      ringBaseline = ringThroughput;
+      msBaseline = msThroughput;
+    }
+  }
+}
+
+//
+// AGGREGATE MODE
+//
+
+// Runs "group()" "runs" times over "books" books and prints the row, with
+// one latency sample per run. Returns the throughput in books per second.
+double measureGrouping(const std::string& structureName, std::size_t threads, std::size_t books, std::size_t runs,
+                       double baselineThroughput, const std::function<std::size_t()>& group) {
+  // Each run is one sample of the calling thread, whatever threads it uses.
+  std::vector<std::vector<Clock::duration>> latencies(1);
+  std::size_t groups = 0;
+  const auto start_time = Clock::now();
+  for (std::size_t run = 0; run < runs; ++run) {
+    const auto run_start = Clock::now();
+    groups += group();
+    latencies[0].push_back(Clock::now() - run_start);
+  }
+  const Clock::duration elapsed = Clock::now() - start_time;
+  if (groups == 0 && books > 0) std::clog << "  " << structureName << " found no groups\n";
+  printRow(threads, structureName, books * runs, elapsed, baselineThroughput, latencies);
+  return benchmark::per_second(books * runs, elapsed);
+}
+
+template <class Record>
+void measureAggregation(const std::string& corpusName, const std::vector<Record>& books, std::size_t maxThreads) {
+  // About ten million books' worth of runs, and at least three.
+  const std::size_t runs = std::clamp<std::size_t>(10'000'000 / std::max<std::size_t>(books.size(), 1), 3, 200);
+  AuthorIds ids;
+  {
+    Timer timer{"  numbered the authors of " + corpusName + " in ", std::clog};
+    ids = number_authors(books);
+  }
+  std::clog << "  " << corpusName << ": " << books.size() << " books by " << ids.authors.size() << " authors\n";
+
+  const Record unused{};
+  measureGrouping("Serial std::unordered_map (" + corpusName + ")", 1, books.size(), runs, 0.0,
+                  [&] { return group_vector_by_author_serially{books}(unused).size(); });
+  double stringBaseline = 0.0;
+  double idBaseline = 0.0;
+  for (std::size_t threads : benchmark::thread_counts(maxThreads)) {
+    const double stringThroughput =
+        measureGrouping("String keys (" + corpusName + ")", threads, books.size(), runs, stringBaseline,
+                        [&] { return group_vector_by_author{books, threads}(unused).size(); });
+    const double idThroughput =
+        measureGrouping("Packed ids (" + corpusName + ")", threads, books.size(), runs, idBaseline,
+                        [&] { return group_vector_by_author_id{books, ids, threads}(unused).size(); });
+    if (threads == 1) {
+      stringBaseline = stringThroughput;
+      idBaseline = idThroughput;
+    }
+  }
+}
+
+void runAggregateMode(std::size_t maxThreads) {
+  Timer timer{"Timer:  Aggregation measurements completed in ", std::clog};
+  if (maxThreads == 0) maxThreads = benchmark::default_max_threads();
+  if (sampleData.empty()) return;
+  measureAggregation("database", sampleData, maxThreads);
+
+  // Synthetic catalogs viewing the database's titles, ISBNs, and prices,
+  // with authors drawn uniformly from a set number of names.
+  constexpr std::size_t SYNTHETIC_BOOKS = 5'000'000;
+  std::default_random_engine random(std::random_device{}());
+  for (std::size_t cardinality : {10, 1'000, 100'000, 1'000'000}) {
+    std::vector<std::string> authors;
+    authors.reserve(cardinality);
+    for (std::size_t i = 0; i < cardinality; ++i) authors.push_back("Synthetic Author " + std::to_string(i));
+    std::uniform_int_distribution<std::size_t> author(0, cardinality - 1);
+    std::vector<BookView> books;
+    books.reserve(SYNTHETIC_BOOKS);
+    for (std::size_t i = 0; i < SYNTHETIC_BOOKS; ++i) {
+      const Book& model = sampleData[i % sampleData.size()];
+      books.emplace_back(model.title(), authors[author(random)], model.isbn(), model.price());
+    }
+    measureAggregation(std::to_string(cardinality) + " authors", books, maxThreads);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const std::map<std::string, std::function<void(std::size_t)>> modes{
+      {"hash", runHashMode},
+      {"queue", runQueueMode},
+      {"skiplist", runSkipListMode},
+      {"rcu", runRcuMode},
+      {"aggregate", runAggregateMode},
+  };
+
+  if (argc < 2 || modes.count(argv[1]) == 0) {
+    std::cerr << "Usage: " << argv[0] << " <mode> [max-threads] < database.dat\n"
+              << "Modes:";
+    for (const auto& [name, run] : modes) std::cerr << ' ' << name;
+    std::cerr << '\n';
+    return EXIT_FAILURE;
+  }
+
+  // 0 lets each mode pick its own sweep.
+  std::size_t maxThreads = 0;
+  if (argc > 2) {
+    try {
+      std::size_t parsed = 0;
+      maxThreads = std::stoul(argv[2], &parsed);
+      if (argv[2][parsed] != '\0') throw std::invalid_argument("trailing characters");
+    } catch (const std::exception& error) {
+      std::cerr << "Invalid max-threads \"" << argv[2] << "\": " << error.what() << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+
+  Timer totalElapsedTime{"Timer:  total elapsed time is ", std::clog};
+  std::clog << "Loaded " << sampleData.size() << " books\n";
+  printHeader();
+  modes.at(argv[1])(maxThreads);
+}
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <chrono>
+#include <filesystem>
 #include <cstddef>
 #include <forward_list>
 #include <iostream>
@@ -9,10 +10,18 @@
 #include <random>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "book.hpp"
+#include "btree_catalog.hpp"
+#include "book_loader.hpp"
+#include "book_view.hpp"
+#include "completion_trie.hpp"
 #include "operations.hpp"
+#include "price_index.hpp"
+#include "secondary_index.hpp"
+#include "skip_list.hpp"
 #include "timer.hpp"
 
 namespace {
@@ -37,7 +46,9 @@ struct Direction {
   template<typename Iter, typename T = typename Iter::value_type>
   struct SampleData : std::vector<T> {
     using std::vector<T>::vector;                                                                         // inherit constructors
-    SampleData(Iter begin, Iter end) : std::vector<T>{begin, end} {
+    SampleData() = default;
+    SampleData(Iter begin, Iter end) : SampleData(std::vector<T>{begin, end}) {}
+    explicit SampleData(std::vector<T> samples) : std::vector<T>{std::move(samples)} {
       this->shrink_to_fit();
       std::shuffle(
           this->begin(),
@@ -48,14 +59,14 @@ struct Direction {
 
   std::ostream & operator<<( std::ostream & stream, const TimeMatrix & matrix );
 
-  template<class Operation>
+  template<class Record = Book, class Operation>
   void measure(
       const std::string& structureName,                            // free text name of data structure being measured
       const std::string& operationDescription,                     // free text name of the operation of the data structure being measured
       Operation operation,                                // operation to be measured, expressed as a Functiod
       Direction::value direction = Direction::Grow);            // indicates to record measurements as the container grows (i.e. inserts) or shrinks (i.e. removes)
 
-  template<class Operation, class Preamble>
+  template<class Record = Book, class Operation, class Preamble>
   void measure(
       const std::string& structureName,                            // free text name of data structure being measured
       const std::string& operationDescription,                     // free text name of the operation of the data structure being measured
@@ -63,275 +74,686 @@ struct Direction {
       Operation operation,                                // operation to be measured, expressed as a Functiod
       Direction::value direction = Direction::Grow);            // indicates to record measurements as the container grows (i.e. inserts) or shrinks (i.e. removes)
 
+  template<class Record = Book, class BulkOperation>
+  void measureBulk(
+      const std::string& structureName,                            // free text name of data structure being measured
+      const std::string& operationDescription,                     // free text name of the operation of the data structure being measured
+      BulkOperation operation,                            // operation to be measured, expressed as a Functiod taking a range of elements
+      Direction::value direction = Direction::Grow);            // indicates to record measurements as the container grows (i.e. inserts) or shrinks (i.e. removes)
+
+  template<class Record>
+  void measureVector( const std::string & structureName );              // every vector operation, on a container of Records
+  template<class Record>
+  void measureDoublyLinkedList( const std::string & structureName );    // every doubly linked list (std::list) operation, on a container of Records
+  template<class Record>
+  void measureSinglyLinkedList( const std::string & structureName );    // every singly linked list (std::forward_list) operation, on a container of Records
+  template<class Record>
+  void measureBinarySearchTree( const std::string & structureName );    // every binary search tree (std::map) operation, on a container of Records
+  void measureBTree( const std::string & structureName );              // every on-disk B+tree operation, on a catalog of Books
+  template<class Record>
+  void measureSkipList( const std::string & structureName );            // every lock-free skip list operation, on a container of Records
+  template<class Record>
+  void measureHashTable( const std::string & structureName );           // every hash table (std::unordered_map) operation, on a container of Records
+  template<class Catalog>
+  void measureIndexedCatalog( const std::string & structureName );      // every operation of an ISBN-keyed container with author and title indexes
+  void measurePriceIndex( const std::string & structureName );          // every price index operation, on an index of Books
+  void measureCompletionTrie( const std::string & structureName );      // every completion trie operation, on a trie of Books' authors
+
   /*********************************************************************************************************************************
   **  Object Definitions
   *********************************************************************************************************************************/
   TimeMatrix runTimes;                                                 // collection of operation time measurements
-  const SampleData sampleData{
-      std::istream_iterator<Book>(std::cin),      // define and initialize from standard input a
-      std::istream_iterator<Book>()
-  };    // collection of data samples
+  constexpr std::size_t SAMPLE_SIZE = 250;                             // Number of operations to perform before reporting timing data
+  SampleData<std::istream_iterator<Book>> sampleData;                  // collection of data samples, filled in by main()
+  BookArena             sampleArena;                                   // string storage behind sampleViews
+  std::vector<BookView> sampleViews;                                   // the same samples, in the same order, as non-owning views
+
+  // The samples a measurement of containers holding "Record"s iterates over
+  template<class Record> const std::vector<Record> & samples();
+  template<> const std::vector<Book>     & samples<Book>    () { return sampleData;  }
+  template<> const std::vector<BookView> & samples<BookView>() { return sampleViews; }
+
+  void reportSampleMemory();                                          // compare the memory held by sampleData and sampleViews
 }    // unnamed, anonymous namespace
 
 
-int main() {
+// Usage:  generate_csv < database.dat
+//         generate_csv database.dat      (memory-mapped and parsed on every hardware thread)
+int main(int argc, char* argv[]) {
+  if (argc > 1) {
+    sampleData = SampleData<std::istream_iterator<Book>>(load_books_parallel(argv[1]));
+  } else {
+    sampleData = SampleData<std::istream_iterator<Book>>(std::istream_iterator<Book>(std::cin),
+                                                         std::istream_iterator<Book>());
+  }
+
+  sampleViews = store_books(sampleArena, sampleData);
+  reportSampleMemory();
+
   Timer totalElapsedTime{"Timer:  total elapsed time is ", std::clog};
 
   //
   // VECTOR MEASUREMENTS
   //
 
+  measureVector<Book>    ( "Vector" );
+  measureVector<BookView>( "Vector (views)" );
+
+  //
+  // DOUBLY LINKED LIST MEASUREMENTS
+  //
+
+  measureDoublyLinkedList<Book>    ( "DLL" );
+  measureDoublyLinkedList<BookView>( "DLL (views)" );
+
+  //
+  // SINGLY LINKED LIST MEASUREMENTS
+  //
+
+  measureSinglyLinkedList<Book>    ( "SLL" );
+  measureSinglyLinkedList<BookView>( "SLL (views)" );
+
+  //
+  // BINARY SEARCH TREE MEASUREMENTS
+  //
+
+  measureBinarySearchTree<Book>    ( "BST" );
+  measureBinarySearchTree<BookView>( "BST (views)" );
+
+  //
+  // B+TREE MEASUREMENTS
+  //
+
+  measureBTree( "B+ Tree" );
+
+  //
+  // SKIP LIST MEASUREMENTS
+  //
+
+  measureSkipList<Book>    ( "Skip List" );
+  measureSkipList<BookView>( "Skip List (views)" );
+
+  //
+  // HASH TABLE MEASUREMENTS
+  //
+
+  measureHashTable<Book>    ( "Hash Table" );
+  measureHashTable<BookView>( "Hash Table (views)" );
+
+  //
+  // SECONDARY INDEX MEASUREMENTS
+  //
+
+  measureIndexedCatalog<HashIndexedCatalog<Book>>   ( "Hash Table (indexed)" );
+  measureIndexedCatalog<OrderedIndexedCatalog<Book>>( "BST (indexed)" );
+
+  //
+  // PRICE INDEX MEASUREMENTS
+  //
+
+  measurePriceIndex( "Price Index" );
+
+  //
+  // COMPLETION TRIE MEASUREMENTS
+  //
+
+  measureCompletionTrie( "Completion Trie" );
+
+  //
+  // REPORT MEASUREMENTS
+  //
+  std::cout << runTimes << '\n';
+
+  std::clog << '\n'
+            << std::string( 80, '-' ) << '\n';
+}
+
+
+
+/*********************************************************************************************************************************
+**  Private definitions
+*********************************************************************************************************************************/
+namespace {
+  template<class Record, class Operation>
+  void measure( const std::string & structureName,                            // free text name of data structure being measured
+                const std::string & operationDescription,                     // free text name of the operation of the data structure being measured
+                Operation           operation,                                // operation to be measured, expressed as a Functiod
+                Direction::value    direction )                               // indicates to record measurements as the container grows (i.e. inserts) or shrinks (i.e. removes)
   {
-    std::clog << "\n\n\nStarting to collect Vector measurements\n";
-    Timer timer{"Timer:  Vector measurements completed in ", std::clog};
+    static auto noop = []( auto & ) {};                                       // A no-operation (do nothing) Functiod. Useful when requesting no setup be done prior to measuring an operation.
+    measure<Record>( structureName, operationDescription, noop, operation, direction );
+  }
+
+  // Template function to measure the elapsed time consumed to perform a container's operation
+  template<class Record, class Operation, class Preamble>
+  void measure( const std::string & structureName,                            // free text name of data structure being measured
+                const std::string & operationDescription,                     // free text name of the operation of the data structure being measured
+                Preamble            preamble,                                 // setup work to occur before operation, expressed as a Functiod defaulted to "do nothing"
+                Operation           operation,                                // operation to be measured, expressed as a Functiod
+                Direction::value    direction )                               // indicates to record measurements as the container grows (i.e. inserts) or shrinks (i.e. removes)
+  {
+    struct progressRAII
+    {
+      progressRAII( const std::string & structureName, const std::string & operationDescription )
+      { std::clog << "  starting " << structureName << "'s " << operationDescription << " operation ... "; }
+
+      ~progressRAII()
+      { std::clog << "finished"; }
+
+      Timer duration{ " in ", std::clog };
+    } progress_raii{structureName, operationDescription};
+
+    std::size_t sampleIndex = (direction == Direction::Grow) ? 0 : samples<Record>().size();
+    for( const auto & element : samples<Record>() )
+    {
+      preamble( element );                                                    // perform any setup work, but don't include this in the measured time
+
+      // ToDo:  help prevent interruptions, perhaps with "critical section" or "Priority Boost"
+      // ToDo:  Remove the function call overhead from the measurement, perhaps with some template or polymorphic std::variant magic
+      auto start_time = Clock::now();
+      operation( element );                                                   // perform the operation and measure the elapsed wall clock time, subject to the OS's task scheduling
+      auto stop_time = Clock::now();
+
+      //if( sampleIndex % SAMPLE_SIZE  ==  0)                                 // uncomment if you want single samples, otherwise it accumulates all the samples over the interval
+      runTimes[( ( sampleIndex / SAMPLE_SIZE ) + 1 ) * SAMPLE_SIZE][structureName][operationDescription] += stop_time - start_time;
+      sampleIndex += direction;
+    }
+  }
+
+  // Template function to measure the elapsed time consumed to perform a container's bulk operation. The sample data is handed to
+  // the operation in chunks that line up with the SAMPLE_SIZE reporting intervals used by measure(), so each interval holds the
+  // time of one bulk call covering exactly the elements that the one-at-a-time measurements spread over SAMPLE_SIZE calls.
+  // Dividing either by SAMPLE_SIZE gives the amortized per-element cost.
+  template<class Record, class BulkOperation>
+  void measureBulk( const std::string & structureName,                        // free text name of data structure being measured
+                    const std::string & operationDescription,                 // free text name of the operation of the data structure being measured
+                    BulkOperation       operation,                            // operation to be measured, expressed as a Functiod taking a range of elements
+                    Direction::value    direction )                           // indicates to record measurements as the container grows (i.e. inserts) or shrinks (i.e. removes)
+  {
+    std::clog << "  starting " << structureName << "'s " << operationDescription << " operation ... ";
+    Timer duration{ "finished in ", std::clog };
+
+    const auto & sampleRecords = samples<Record>();
+    std::size_t sampleIndex = (direction == Direction::Grow) ? 0 : sampleRecords.size();
+    for( auto first = sampleRecords.cbegin(); first != sampleRecords.cend(); )
+    {
+      // The elements measure() would record in the same interval as this one
+      std::size_t count = (direction == Direction::Grow) ? SAMPLE_SIZE - sampleIndex % SAMPLE_SIZE : sampleIndex % SAMPLE_SIZE + 1;
+      count = std::min<std::size_t>( count, sampleRecords.cend() - first );
+
+      auto start_time = Clock::now();
+      operation( first, first + count );                                      // perform the operation on the whole chunk at once
+      auto stop_time = Clock::now();
+
+      runTimes[( ( sampleIndex / SAMPLE_SIZE ) + 1 ) * SAMPLE_SIZE][structureName][operationDescription] += stop_time - start_time;
+      first += count;
+      sampleIndex = (direction == Direction::Grow) ? sampleIndex + count : sampleIndex - count;
+    }
+  }
+
+  // Measures every vector operation on a container holding "Record"s (Book or BookView), reporting under "structureName"
+  template<class Record>
+  void measureVector( const std::string & structureName )
+  {
+    std::clog << "\nStarting to collect " << structureName << " measurements\n";
+    Timer timer{"Timer:  " + structureName + " measurements completed in ", std::clog};
 
     // Insert at the back of a vector
     {
-      std::vector<Book> v;
-      measure("Vector", "Insert at the back", insert_at_back_of_vector{v});
+      std::vector<Record> v;
+      measure<Record>(structureName, "Insert at the back", insert_at_back_of_vector{v});
     }
 
     // Insert at the front of a vector
     {
-      std::vector<Book> v;
-      measure("Vector", "Insert at the front", insert_at_front_of_vector{v});
+      std::vector<Record> v;
+      measure<Record>(structureName, "Insert at the front", insert_at_front_of_vector{v});
     }
 
     // Remove from the back of a vector
     {    
-      std::vector<Book> v{sampleData.cbegin(), sampleData.cend()};
-      measure("Vector", "Remove from the back", remove_from_back_of_vector{v}, Direction::Shrink);
+      std::vector<Record> v{samples<Record>().cbegin(), samples<Record>().cend()};
+      measure<Record>(structureName, "Remove from the back", remove_from_back_of_vector{v}, Direction::Shrink);
     }
 
     // Remove from the front of a vector
     {
-      std::vector<Book> v{sampleData.cbegin(), sampleData.cend()};
-      measure("Vector", "Remove from the front", remove_from_front_of_vector{v}, Direction::Shrink);
+      std::vector<Record> v{samples<Record>().cbegin(), samples<Record>().cend()};
+      measure<Record>(structureName, "Remove from the front", remove_from_front_of_vector{v}, Direction::Shrink);
+    }
+
+    // Insert a batch at the back of a vector
+    {
+      std::vector<Record> v;
+      measureBulk<Record>(structureName, "Bulk insert", bulk_insert_at_back_of_vector{v});
+    }
+
+    // Remove a batch from the back of a vector
+    {
+      std::vector<Record> v{samples<Record>().cbegin(), samples<Record>().cend()};
+      measureBulk<Record>(structureName, "Bulk remove", bulk_remove_from_back_of_vector{v}, Direction::Shrink);
     }
 
     // Search for an element in a vector
     {
-      std::vector<Book> v;
-      v.reserve(sampleData.size());
-      measure(
-          "Vector",
+      std::vector<Record> v;
+      v.reserve(samples<Record>().size());
+      measure<Record>(
+          structureName,
           "Search",
-          [&](const Book& book) { v.push_back(book); },
+          [&](const Record& book) { v.push_back(book); },
           search_within_vector{v, "non-existent"});
     }
-  }
 
+    // Search for every element by an author in a vector
+    {
+      std::vector<Record> v;
+      v.reserve(samples<Record>().size());
+      measure<Record>(
+          structureName,
+          "Search by author",
+          [&](const Record& book) { v.push_back(book); },
+          [&](const Record& book) { return search_within_vector_by_author{v, std::string(book.author())}(book); });
+    }
 
-  //
-  // DOUBLY LINKED LIST MEASUREMENTS 
-  //
+    // Count and sum the prices of the elements between $10 and $20 in a vector
+    {
+      std::vector<Record> v;
+      v.reserve(samples<Record>().size());
+      measure<Record>(
+          structureName,
+          "Price range summary",
+          [&](const Record& book) { v.push_back(book); },
+          summarize_price_range_of_vector{v, 10.0, 20.0});
+    }
+  }
 
+  // Measures every doubly linked list (std::list) operation on a container holding "Record"s (Book or BookView), reporting under "structureName"
+  template<class Record>
+  void measureDoublyLinkedList( const std::string & structureName )
   {
-    std::clog << "\nStarting to collect Doubly Linked List measurements\n";
-    Timer timer{"Timer:  Doubly Linked List measurements completed in ", std::clog};
+    std::clog << "\nStarting to collect " << structureName << " measurements\n";
+    Timer timer{"Timer:  " + structureName + " measurements completed in ", std::clog};
 
     // Insert at the back of a doubly linked list
     {
-      std::list<Book> dll;
-      measure("DLL", "Insert at the back", insert_at_back_of_dll{dll});
+      std::list<Record> dll;
+      measure<Record>(structureName, "Insert at the back", insert_at_back_of_dll{dll});
     }
 
     // Insert at the front of a doubly linked list
     {
-      std::list<Book> dll;
-      measure("DLL", "Insert at the front", insert_at_front_of_dll{dll});
+      std::list<Record> dll;
+      measure<Record>(structureName, "Insert at the front", insert_at_front_of_dll{dll});
     }
 
     // Remove from the back of a doubly linked list
     {
-      std::list<Book> dll{sampleData.cbegin(), sampleData.cend()};
-      measure("DLL", "Remove from the back", remove_from_back_of_dll{dll}, Direction::Shrink);
+      std::list<Record> dll{samples<Record>().cbegin(), samples<Record>().cend()};
+      measure<Record>(structureName, "Remove from the back", remove_from_back_of_dll{dll}, Direction::Shrink);
     }
 
     // Remove from the front of a doubly linked list
     {
-      std::list<Book> dll{sampleData.cbegin(), sampleData.cend()};
-      measure("DLL", "Remove from the front", remove_from_front_of_dll{dll}, Direction::Shrink);
+      std::list<Record> dll{samples<Record>().cbegin(), samples<Record>().cend()};
+      measure<Record>(structureName, "Remove from the front", remove_from_front_of_dll{dll}, Direction::Shrink);
+    }
+
+    // Insert a batch at the back of a doubly linked list
+    {
+      std::list<Record> dll;
+      measureBulk<Record>(structureName, "Bulk insert", bulk_insert_at_back_of_dll{dll});
+    }
+
+    // Remove a batch from the front of a doubly linked list
+    {
+      std::list<Record> dll{samples<Record>().cbegin(), samples<Record>().cend()};
+      measureBulk<Record>(structureName, "Bulk remove", bulk_remove_from_front_of_dll{dll}, Direction::Shrink);
     }
 
     // Search for an element in a doubly linked list
     {
-      std::list<Book> dll;
-      measure(
-          "DLL",
+      std::list<Record> dll;
+      measure<Record>(
+          structureName,
           "Search",
-          [&](const Book& book) { dll.push_back(book); },
+          [&](const Record& book) { dll.push_back(book); },
           search_within_dll{dll, "non-existent"});
     }
   }
 
-  //
-  // SINGLY LINKED LIST MEASUREMENTS
-  //
-
+  // Measures every singly linked list (std::forward_list) operation on a container holding "Record"s (Book or BookView), reporting under "structureName"
+  template<class Record>
+  void measureSinglyLinkedList( const std::string & structureName )
   {
-    std::clog << "\nStarting to collect Singly Linked List measurements\n";
-    Timer timer{"Timer:  Singly Linked List measurements completed in ", std::clog};
+    std::clog << "\nStarting to collect " << structureName << " measurements\n";
+    Timer timer{"Timer:  " + structureName + " measurements completed in ", std::clog};
 
     // Insert at the back of a singly linked list
     {
-      std::forward_list<Book> sll;
-      measure("SLL", "Insert at the back", insert_at_back_of_sll{sll});
+      std::forward_list<Record> sll;
+      measure<Record>(structureName, "Insert at the back", insert_at_back_of_sll{sll});
     }
 
     // Insert at the front of a singly linked list
     {
-      std::forward_list<Book> sll;
-      measure("SLL", "Insert at the front", insert_at_front_of_sll{sll});
+      std::forward_list<Record> sll;
+      measure<Record>(structureName, "Insert at the front", insert_at_front_of_sll{sll});
     }
 
     // Remove from the back of a singly linked list
     {
-      std::forward_list<Book> ssl{sampleData.cbegin(), sampleData.cend()};
-      measure("SLL", "Remove from the back", remove_from_back_of_sll{ssl}, Direction::Shrink);
+      std::forward_list<Record> ssl{samples<Record>().cbegin(), samples<Record>().cend()};
+      measure<Record>(structureName, "Remove from the back", remove_from_back_of_sll{ssl}, Direction::Shrink);
     }
 
     // Remove from the front of a singly linked list
     {
-      std::forward_list<Book> sll{sampleData.cbegin(), sampleData.cend()};
-      measure("SLL", "Remove from the front", remove_from_front_of_sll{sll}, Direction::Shrink);
+      std::forward_list<Record> sll{samples<Record>().cbegin(), samples<Record>().cend()};
+      measure<Record>(structureName, "Remove from the front", remove_from_front_of_sll{sll}, Direction::Shrink);
+    }
+
+    // Insert a batch at the back of a singly linked list
+    {
+      std::forward_list<Record> sll;
+      measureBulk<Record>(structureName, "Bulk insert", bulk_insert_at_back_of_sll{sll});
+    }
+
+    // Remove a batch from the front of a singly linked list
+    {
+      std::forward_list<Record> sll{samples<Record>().cbegin(), samples<Record>().cend()};
+      measureBulk<Record>(structureName, "Bulk remove", bulk_remove_from_front_of_sll{sll}, Direction::Shrink);
     }
 
     // Search for an element in a singly linked list
     {
-      std::forward_list<Book> sll;
-      measure(
-          "SLL",
+      std::forward_list<Record> sll;
+      measure<Record>(
+          structureName,
           "Search",
-          [&](const Book& book) { sll.push_front(book); },
+          [&](const Record& book) { sll.push_front(book); },
           search_within_sll{sll, "non-existent"});
     }
   }
 
-  //
-  // BINARY SEARCH TREE MEASUREMENTS
-
+  // Measures every binary search tree (std::map) operation on a container holding "Record"s (Book or BookView), reporting under "structureName"
+  template<class Record>
+  void measureBinarySearchTree( const std::string & structureName )
   {
-    std::clog << "\nStarting to collect Binary Search Tree measurements\n";
-    Timer timer{"Timer:  Binary Search Tree measurements completed in ", std::clog};
+    std::clog << "\nStarting to collect " << structureName << " measurements\n";
+    Timer timer{"Timer:  " + structureName + " measurements completed in ", std::clog};
+
     
     // Insert into a binary search tree
     {
-      std::map<std::string, Book> map;
-      measure("BST", "Insert", insert_into_bst{map});
+      std::map<isbn_key_t<Record>, Record> map;
+      measure<Record>(structureName, "Insert", insert_into_bst{map});
     }
 
     // Remove from a binary search tree
     {
-      std::map<std::string, Book> map;
-      for (const Book& book : sampleData) map.emplace(book.isbn(), book);
-      measure("BST", "Remove", remove_from_bst{map}, Direction::Shrink);
+      std::map<isbn_key_t<Record>, Record> map;
+      for (const Record& book : samples<Record>()) map.emplace(book.isbn(), book);
+      measure<Record>(structureName, "Remove", remove_from_bst{map}, Direction::Shrink);
+    }
+
+    // Insert a batch into a binary search tree
+    {
+      std::map<isbn_key_t<Record>, Record> map;
+      measureBulk<Record>(structureName, "Bulk insert", bulk_insert_into_bst{map});
+    }
+
+    // Remove a batch from a binary search tree
+    {
+      std::map<isbn_key_t<Record>, Record> map;
+      for (const Record& book : samples<Record>()) map.emplace(book.isbn(), book);
+      measureBulk<Record>(structureName, "Bulk remove", bulk_remove_from_bst{map}, Direction::Shrink);
     }
 
     // Search for an element in a binary search tree
     {
-      std::map<std::string, Book> map;
-      measure(
-          "BST",
+      std::map<isbn_key_t<Record>, Record> map;
+      measure<Record>(
+          structureName,
           "Search",
-          [&](const Book& book) { map.emplace(book.isbn(), book); },
+          [&](const Record& book) { map.emplace(book.isbn(), book); },
           search_within_bst{map, "non-existent"});
     }
   }
 
-  //
-  // HASH TABLE MEASUREMENTS
-  //
+  // Measures every on-disk B+tree operation on a catalog file in the temporary directory, reporting under "structureName"
+  void measureBTree( const std::string & structureName )
+  {
+    std::clog << "\nStarting to collect " << structureName << " measurements\n";
+    Timer timer{"Timer:  " + structureName + " measurements completed in ", std::clog};
+
+    const std::string path = ( std::filesystem::temp_directory_path() / "generate_csv.btree" ).string();
+
+    // Insert into a B+tree
+    {
+      std::filesystem::remove( path );
+      BTreeCatalog btree( path );
+      measure(structureName, "Insert", insert_into_btree{btree});
+    }
 
+    // Remove from a B+tree
+    {
+      std::filesystem::remove( path );
+      BTreeCatalog btree( path );
+      for (const Book& book : sampleData) btree.insert(book);
+      measure(structureName, "Remove", remove_from_btree{btree}, Direction::Shrink);
+    }
+
+    // Search for an element in a B+tree
+    {
+      std::filesystem::remove( path );
+      BTreeCatalog btree( path );
+      measure(
+          structureName,
+          "Search",
+          [&](const Book& book) { btree.insert(book); },
+          search_within_btree{btree, "non-existent"});
+    }
+
+    std::filesystem::remove( path );
+  }
+
+  // Measures every lock-free skip list operation on a container holding "Record"s (Book or BookView), reporting under "structureName"
+  template<class Record>
+  void measureSkipList( const std::string & structureName )
   {
-    std::clog << "\nStarting to collect Hash Table measurements\n";
-    Timer timer{"Timer:  Hash Table measurements completed in ", std::clog};
+    std::clog << "\nStarting to collect " << structureName << " measurements\n";
+    Timer timer{"Timer:  " + structureName + " measurements completed in ", std::clog};
+
+    // Insert into a skip list
+    {
+      SkipList<isbn_key_t<Record>, Record> skip_list;
+      measure<Record>(structureName, "Insert", insert_into_skip_list{skip_list});
+    }
+
+    // Remove from a skip list
+    {
+      SkipList<isbn_key_t<Record>, Record> skip_list;
+      for (const Record& book : samples<Record>()) skip_list.insert_or_assign(book.isbn(), book);
+      measure<Record>(structureName, "Remove", remove_from_skip_list{skip_list}, Direction::Shrink);
+    }
+
+    // Search for an element in a skip list
+    {
+      SkipList<isbn_key_t<Record>, Record> skip_list;
+      measure<Record>(
+          structureName,
+          "Search",
+          [&](const Record& book) { skip_list.insert_or_assign(book.isbn(), book); },
+          search_within_skip_list{skip_list, "non-existent"});
+    }
+  }
+
+  // Measures every hash table (std::unordered_map) operation on a container holding "Record"s (Book or BookView), reporting under "structureName"
+  template<class Record>
+  void measureHashTable( const std::string & structureName )
+  {
+    std::clog << "\nStarting to collect " << structureName << " measurements\n";
+    Timer timer{"Timer:  " + structureName + " measurements completed in ", std::clog};
 
     // Insert into a hash table
     {
-      std::unordered_map<std::string, Book> u_map;
-      measure("Hash Table", "Insert", insert_into_hash_table{u_map});
+      std::unordered_map<isbn_key_t<Record>, Record> u_map;
+      measure<Record>(structureName, "Insert", insert_into_hash_table{u_map});
     }
 
     // Remove from a hash table
     {
-      std::unordered_map<std::string, Book> u_map;
-      for (const Book& book : sampleData) u_map.emplace(book.isbn(), book);
-      measure("Hash Table", "Remove", remove_from_hash_table{u_map}, Direction::Shrink);
+      std::unordered_map<isbn_key_t<Record>, Record> u_map;
+      for (const Record& book : samples<Record>()) u_map.emplace(book.isbn(), book);
+      measure<Record>(structureName, "Remove", remove_from_hash_table{u_map}, Direction::Shrink);
+    }
+
+    // Insert a batch into a hash table
+    {
+      std::unordered_map<isbn_key_t<Record>, Record> u_map;
+      measureBulk<Record>(structureName, "Bulk insert", bulk_insert_into_hash_table{u_map});
+    }
+
+    // Remove a batch from a hash table
+    {
+      std::unordered_map<isbn_key_t<Record>, Record> u_map;
+      for (const Record& book : samples<Record>()) u_map.emplace(book.isbn(), book);
+      measureBulk<Record>(structureName, "Bulk remove", bulk_remove_from_hash_table{u_map}, Direction::Shrink);
     }
 
     // Search for an element in a hash table
     {
-      std::unordered_map<std::string, Book> u_map;
-      measure(
-          "Hash Table",
+      std::unordered_map<isbn_key_t<Record>, Record> u_map;
+      measure<Record>(
+          structureName,
           "Search",
-          [&](const Book& book) { u_map.emplace(book.isbn(), book); },
+          [&](const Record& book) { u_map.emplace(book.isbn(), book); },
           search_within_hash_table{u_map, "non-existent"});
     }
   }
 
-  //
-  // REPORT MEASUREMENTS
-  //
-  std::cout << runTimes << '\n';
-
-  std::clog << '\n'
-            << std::string( 80, '-' ) << '\n';
-}
+  // Measures every operation of an ISBN-keyed container that keeps author and title indexes in sync, reporting under
+  // "structureName". Insert and Remove include the index maintenance, so they compare with the unindexed container's.
+  template<class Catalog>
+  void measureIndexedCatalog( const std::string & structureName )
+  {
+    using Record = typename Catalog::Record;
+    std::clog << "\nStarting to collect " << structureName << " measurements\n";
+    Timer timer{"Timer:  " + structureName + " measurements completed in ", std::clog};
 
+    // Insert into an indexed catalog
+    {
+      Catalog catalog;
+      measure<Record>(structureName, "Insert", insert_into_indexed_catalog<Catalog>{catalog});
+    }
 
+    // Remove from an indexed catalog
+    {
+      Catalog catalog;
+      for (const Record& book : samples<Record>()) catalog.insert(book);
+      measure<Record>(structureName, "Remove", remove_from_indexed_catalog<Catalog>{catalog}, Direction::Shrink);
+    }
 
-/*********************************************************************************************************************************
-**  Private definitions
-*********************************************************************************************************************************/
-namespace {
-  template<class Operation>
-  void measure( const std::string & structureName,                            // free text name of data structure being measured
-                const std::string & operationDescription,                     // free text name of the operation of the data structure being measured
-                Operation           operation,                                // operation to be measured, expressed as a Functiod
-                Direction::value    direction )                               // indicates to record measurements as the container grows (i.e. inserts) or shrinks (i.e. removes)
-  {
-    static auto noop = []( auto & ) {};                                       // A no-operation (do nothing) Functiod. Useful when requesting no setup be done prior to measuring an operation.
-    measure( structureName, operationDescription, noop, operation, direction );
+    // Search for every element by an author in an indexed catalog
+    {
+      Catalog catalog;
+      measure<Record>(
+          structureName,
+          "Search by author",
+          [&](const Record& book) { catalog.insert(book); },
+          [&](const Record& book) {
+            return search_within_indexed_catalog_by_author<Catalog>{catalog, std::string(book.author())}(book);
+          });
+    }
   }
 
-  // Template function to measure the elapsed time consumed to perform a container's operation
-  template<class Operation, class Preamble>
-  void measure( const std::string & structureName,                            // free text name of data structure being measured
-                const std::string & operationDescription,                     // free text name of the operation of the data structure being measured
-                Preamble            preamble,                                 // setup work to occur before operation, expressed as a Functiod defaulted to "do nothing"
-                Operation           operation,                                // operation to be measured, expressed as a Functiod
-                Direction::value    direction )                               // indicates to record measurements as the container grows (i.e. inserts) or shrinks (i.e. removes)
+  // Measures every price index operation on an index of the sample Books, reporting under "structureName". Its
+  // "Price range summary" answers the same question as the vector's full scan.
+  void measurePriceIndex( const std::string & structureName )
   {
-    struct progressRAII
+    std::clog << "\nStarting to collect " << structureName << " measurements\n";
+    Timer timer{"Timer:  " + structureName + " measurements completed in ", std::clog};
+
+    // Insert into a price index
     {
-      progressRAII( const std::string & structureName, const std::string & operationDescription )
-      { std::clog << "  starting " << structureName << "'s " << operationDescription << " operation ... "; }
+      PriceIndex index;
+      measure(structureName, "Insert", insert_into_price_index{index});
+    }
 
-      ~progressRAII()
-      { std::clog << "finished"; }
+    // Remove from a price index
+    {
+      PriceIndex index;
+      for (const Book& book : sampleData) index.insert(book);
+      measure(structureName, "Remove", remove_from_price_index{index}, Direction::Shrink);
+    }
 
-      Timer duration{ " in ", std::clog };
-    } progress_raii{structureName, operationDescription};
+    // Count and sum the prices of the elements between $10 and $20 in a price index
+    {
+      PriceIndex index;
+      measure(
+          structureName,
+          "Price range summary",
+          [&](const Book& book) { index.insert(book); },
+          summarize_price_range_of_price_index{index, 10.0, 20.0});
+    }
+  }
 
-    constexpr std::size_t SAMPLE_SIZE = 250;                                  // Number of operations to perform before reporting timing data
+  // Measures every completion trie operation on a trie of the sample Books' authors, reporting under "structureName". Its
+  // "Complete author prefix" column completes the first 3 characters of each author; the "BST (completions)" column finds the
+  // same completions by scanning a std::map of authors from the prefix on.
+  void measureCompletionTrie( const std::string & structureName )
+  {
+    std::clog << "\nStarting to collect " << structureName << " measurements\n";
+    Timer timer{"Timer:  " + structureName + " measurements completed in ", std::clog};
+
+    auto prefixOf = []( const Book & book ) { return to_utf8( normalize_text( book.author() ).substr( 0, 3 ) ); };
 
-    std::size_t sampleIndex = (direction == Direction::Grow) ? 0 : sampleData.size();
-    for( const auto & element : sampleData )
+    // Insert into a completion trie
     {
-      preamble( element );                                                    // perform any setup work, but don't include this in the measured time
+      CompletionTrie trie( TextField::Author, CompletionRank::Popularity );
+      measure(structureName, "Insert", insert_into_completion_trie{trie});
+    }
 
-      // ToDo:  help prevent interruptions, perhaps with "critical section" or "Priority Boost"
-      // ToDo:  Remove the function call overhead from the measurement, perhaps with some template or polymorphic std::variant magic
-      auto start_time = Clock::now();
-      operation( element );                                                   // perform the operation and measure the elapsed wall clock time, subject to the OS's task scheduling
-      auto stop_time = Clock::now();
+    // Remove from a completion trie
+    {
+      CompletionTrie trie( TextField::Author, CompletionRank::Popularity );
+      for (const Book& book : sampleData) trie.insert(book);
+      measure(structureName, "Remove", remove_from_completion_trie{trie}, Direction::Shrink);
+    }
 
-      //if( sampleIndex % SAMPLE_SIZE  ==  0)                                 // uncomment if you want single samples, otherwise it accumulates all the samples over the interval
-      runTimes[( ( sampleIndex / SAMPLE_SIZE ) + 1 ) * SAMPLE_SIZE][structureName][operationDescription] += stop_time - start_time;
-      sampleIndex += direction;
+    // Complete the first characters of an author in a completion trie
+    {
+      CompletionTrie trie( TextField::Author, CompletionRank::Popularity );
+      std::string prefix;
+      measure(
+          structureName,
+          "Complete author prefix",
+          [&](const Book& book) { trie.insert(book); prefix = prefixOf(book); },
+          [&](const Book& book) { return complete_within_completion_trie{trie, prefix, 10}(book); });
     }
+
+    // Complete the first characters of an author by scanning a map
+    {
+      std::map<std::string, Completion> map;
+      std::string prefix;
+      measure(
+          "BST (completions)",
+          "Complete author prefix",
+          [&](const Book& book) { add_completion(map, book, TextField::Author); prefix = prefixOf(book); },
+          [&](const Book& book) { return complete_within_map{map, prefix, 10, CompletionRank::Popularity}(book); });
+    }
+  }
+
+  void reportSampleMemory()
+  {
+    std::size_t bookBytes = 0;
+    for( const Book & book : sampleData ) bookBytes += footprint( book );
+    const std::size_t viewBytes = sampleViews.size() * sizeof( BookView ) + sampleArena.bytes_reserved();
+
+    std::clog << "Sample data:  " << sampleData.size() << " Books occupy " << bookBytes << " bytes ("
+              << sizeof( Book ) << " per object plus string heap storage); the same BookViews occupy " << viewBytes << " bytes ("
+              << sizeof( BookView ) << " per object plus " << sampleArena.block_count() << " arena blocks)\n";
   }
 
   std::ostream & operator<<( std::ostream & stream, const TimeMatrix & matrix )
@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "book.hpp"
+#include "book_loader.hpp"
+#include "book_snapshot.hpp"
+#include "isbn_index.hpp"
+#include "mapped_file.hpp"
+#include "structural_scanner.hpp"
+#include "timer.hpp"
+
+// Loading and startup companion to generate_csv.cpp. Times each way of turning
+// a database file into a collection of Books and writes one comma-separated
+// row per loader to standard output.
+//
+// Usage:  generate_loader_csv <mode> <database.dat> [mode arguments]
+//
+// Modes:  mmap                 operator>> over an ifstream against the
+//                              memory-mapped parser
+//         simd                 the memory-mapped parser against the two-stage
+//                              structural scanner
+//         snapshot             text loading against opening a binary snapshot
+//                              converted from <database.dat>
+//         index                building a hash table against probing a
+//                              persisted ISBN index, from a cold start and
+//                              for repeated lookups
+//         parallel [megabytes] the chunked parallel parser from 1 thread to
+//                              every hardware thread; with a size, runs
+//                              against a synthetic database of that many
+//                              megabytes built from <database.dat>
+
+namespace {
+
+using benchmark::Clock;
+using Utilities::Timer;
+
+// Each loader runs this many times and the fastest run is reported, so that
+// the first run's page-cache misses do not count against one loader only.
+constexpr std::size_t REPETITIONS = 3;
+
+void printHeader() {
+  std::cout << "Loader,Records,Bytes,Seconds,Throughput (MB/s),Speedup\n";
+}
+
+// Times "load", which returns the number of records it read, and prints its
+// best run with its speedup over a baseline time (if any). "prepare", if
+// given, runs untimed before each repetition. Returns the time in seconds.
+double measureLoad(const std::string& loaderName, const std::string& path,
+                   const std::function<std::size_t(const std::string&)>& load,
+                   double baselineSeconds,
+                   const std::function<void()>& prepare = {}) {
+  std::clog << "  starting " << loaderName << " ... ";
+  Timer timer{"finished in ", std::clog};
+
+  const auto bytes = std::filesystem::file_size(path);
+  Clock::duration best = Clock::duration::max();
+  std::size_t records = 0;
+  for (std::size_t i = 0; i < REPETITIONS; ++i) {
+    if (prepare) prepare();
+    auto start_time = Clock::now();
+    records = load(path);
+    best = std::min(best, Clock::now() - start_time);
+  }
+
+  const double seconds = std::chrono::duration<double>(best).count();
+  const double throughput = bytes / seconds / (1024.0 * 1024.0);
+  std::cout << loaderName << ',' << records << ',' << bytes << ',' << seconds
+            << ',' << throughput << ','
+            << (baselineSeconds > 0.0 ? baselineSeconds / seconds : 1.0)
+            << '\n';
+  return seconds;
+}
+
+// Adapts a function returning the loaded Books to measureLoad().
+template<class Loader>
+std::function<std::size_t(const std::string&)> countBooks(Loader load) {
+  return [load](const std::string& path) { return load(path).size(); };
+}
+
+// The way SampleData is filled today.
+std::vector<Book> loadWithStream(const std::string& path) {
+  std::ifstream file(path);
+  return std::vector<Book>{std::istream_iterator<Book>(file),
+                           std::istream_iterator<Book>()};
+}
+
+//
+// MMAP MODE
+//
+
+void runMmapMode(const std::vector<std::string>& args) {
+  const std::string& path = args[0];
+  const double streamSeconds = measureLoad("istream operator>>", path, countBooks(loadWithStream), 0.0);
+  measureLoad("mmap scanner", path, countBooks(load_books_mapped), streamSeconds);
+}
+
+//
+// SIMD MODE
+//
+
+// Visits every record of the mapped file with "scan" without building Books,
+// so only the scanning itself is timed.
+template<class Scan>
+std::function<std::size_t(const std::string&)> countRecords(Scan scan) {
+  return [scan](const std::string& path) {
+    MappedFile file(path);
+    std::size_t records = 0;
+    scan(file.data(), file.data() + file.size(),
+         [&records](const RawBookRecord&) { ++records; });
+    return records;
+  };
+}
+
+void runSimdMode(const std::vector<std::string>& args) {
+  const std::string& path = args[0];
+  const std::string structural = std::string("structural scanner ") + STRUCTURAL_BACKEND;
+
+  const double scalarSeconds = measureLoad("mmap scanner", path, countBooks(load_books_mapped), 0.0);
+  measureLoad(structural, path, countBooks(load_books_simd), scalarSeconds);
+
+  const double scalarScanSeconds = measureLoad(
+      "mmap scanner (records only)", path,
+      countRecords([](auto first, auto last, auto visit) { for_each_book_record(first, last, visit); }),
+      0.0);
+  measureLoad(
+      structural + " (records only)", path,
+      countRecords([](auto first, auto last, auto visit) { for_each_book_record_indexed(first, last, visit); }),
+      scalarScanSeconds);
+}
+
+//
+// SNAPSHOT MODE
+//
+
+void runSnapshotMode(const std::vector<std::string>& args) {
+  const std::string& path = args[0];
+  const std::string snapshotPath =
+      (std::filesystem::temp_directory_path() / "generate_loader_csv.snap").string();
+  convert_to_book_snapshot(path, snapshotPath);
+
+  const double streamSeconds = measureLoad("istream operator>>", path, countBooks(loadWithStream), 0.0);
+  measureLoad("mmap scanner", path, countBooks(load_books_mapped), streamSeconds);
+
+  // Ready to answer queries: the mapping is checked but no record is touched.
+  measureLoad("snapshot open", snapshotPath,
+              [](const std::string& path) { return BookSnapshot(path).size(); },
+              streamSeconds);
+
+  // Every record read in place, as a caller working with views would.
+  measureLoad("snapshot open and view every record", snapshotPath,
+              [](const std::string& path) {
+                const BookSnapshot snapshot(path);
+                std::size_t bytes = 0;
+                for (std::size_t i = 0; i < snapshot.size(); ++i) {
+                  const RawBookRecord record = snapshot.record(i);
+                  bytes += record.isbn.size() + record.title.size() + record.author.size();
+                }
+                return bytes > 0 ? snapshot.size() : 0;
+              },
+              streamSeconds);
+
+  measureLoad("snapshot to Books", snapshotPath,
+              countBooks([](const std::string& path) { return BookSnapshot(path).books(); }),
+              streamSeconds);
+
+  std::filesystem::remove(snapshotPath);
+}
+
+//
+// INDEX MODE
+//
+
+// Builds the hash table an application keeps today: every Book by ISBN.
+std::unordered_map<std::string, Book> loadHashTable(const std::string& path) {
+  std::unordered_map<std::string, Book> table;
+  for (Book& book : load_books_mapped(path)) {
+    table.insert_or_assign(book.isbn(), std::move(book));
+  }
+  return table;
+}
+
+void runIndexMode(const std::vector<std::string>& args) {
+  const std::string& path = args[0];
+  const auto temporary = std::filesystem::temp_directory_path();
+  const std::string indexPath = (temporary / "generate_loader_csv.dat.idx").string();
+  const std::string snapshotPath = (temporary / "generate_loader_csv.snap").string();
+  const std::string snapshotIndexPath = (temporary / "generate_loader_csv.snap.idx").string();
+
+  measureLoad("isbn index build", path,
+              [&](const std::string& path) { return write_isbn_index(path, indexPath); },
+              0.0);
+  convert_to_book_snapshot(path, snapshotPath);
+  write_isbn_index(snapshotPath, snapshotIndexPath);
+
+  // Lookups of every ISBN in a random order, and the first of them.
+  std::vector<std::string> isbns;
+  for (const auto& [isbn, book] : loadHashTable(path)) isbns.push_back(isbn);
+  std::shuffle(isbns.begin(), isbns.end(), std::default_random_engine(std::random_device{}()));
+  const std::string firstIsbn = isbns.empty() ? std::string() : isbns.front();
+
+  // Cold start: from nothing in memory (as far as the page cache allows) to
+  // the answer of one lookup.
+  auto dropCaches = [&] {
+    for (const auto& file : {path, indexPath, snapshotPath, snapshotIndexPath}) {
+      drop_cached_pages(file);
+    }
+  };
+  const double tableStartSeconds = measureLoad(
+      "cold start: hash table build and first lookup", path,
+      [&](const std::string& path) { return loadHashTable(path).count(firstIsbn); },
+      0.0, dropCaches);
+  measureLoad("cold start: isbn index open and first lookup", path,
+              [&](const std::string& path) {
+                return static_cast<std::size_t>(IsbnIndex(path, indexPath).find(firstIsbn).has_value());
+              },
+              tableStartSeconds, dropCaches);
+  measureLoad("cold start: snapshot isbn index open and first lookup", snapshotPath,
+              [&](const std::string& path) {
+                return static_cast<std::size_t>(IsbnIndex(path, snapshotIndexPath).find(firstIsbn).has_value());
+              },
+              tableStartSeconds, dropCaches);
+
+  // Steady state: everything loaded and cached, each lookup copying out the
+  // Book it finds. Records counts the lookups.
+  const auto table = loadHashTable(path);
+  const IsbnIndex textIndex(path, indexPath);
+  const IsbnIndex snapshotIndex(snapshotPath, snapshotIndexPath);
+  auto lookUpEvery = [&](auto find) {
+    return [&isbns, find](const std::string&) {
+      std::size_t found = 0;
+      for (const std::string& isbn : isbns) found += find(isbn).has_value();
+      return found;
+    };
+  };
+  const double tableLookupSeconds = measureLoad(
+      "steady state: hash table lookups", path,
+      lookUpEvery([&table](const std::string& isbn) {
+        const auto found = table.find(isbn);
+        return found != table.end() ? std::optional<Book>(found->second) : std::nullopt;
+      }),
+      0.0);
+  measureLoad("steady state: isbn index lookups", path,
+              lookUpEvery([&textIndex](const std::string& isbn) { return textIndex.find(isbn); }),
+              tableLookupSeconds);
+  measureLoad("steady state: snapshot isbn index lookups", snapshotPath,
+              lookUpEvery([&snapshotIndex](const std::string& isbn) { return snapshotIndex.find(isbn); }),
+              tableLookupSeconds);
+
+  for (const auto& file : {indexPath, snapshotPath, snapshotIndexPath}) {
+    std::filesystem::remove(file);
+  }
+}
+
+//
+// PARALLEL MODE
+//
+
+void runParallelMode(const std::vector<std::string>& args) {
+  std::string path = args[0];
+  std::filesystem::path synthetic;
+  if (args.size() > 1) {
+    std::ifstream seedFile(path);
+    const std::vector<Book> seed = benchmark::load_books(seedFile);
+    synthetic = std::filesystem::temp_directory_path() / "generate_loader_csv.dat";
+    std::clog << "  writing " << args[1] << " MB synthetic database ... ";
+    Timer timer{"finished in ", std::clog};
+    benchmark::write_synthetic_database(
+        synthetic.string(), seed, std::stoull(args[1]) * 1024 * 1024);
+    path = synthetic.string();
+  }
+
+  const double sequentialSeconds = measureLoad("mmap scanner", path, countBooks(load_books_mapped), 0.0);
+  const std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (std::size_t threads : benchmark::thread_counts(maxThreads)) {
+    measureLoad("parallel scanner (" + std::to_string(threads) + " threads)", path,
+                countBooks([threads](const std::string& path) { return load_books_parallel(path, threads); }),
+                sequentialSeconds);
+  }
+
+  if (!synthetic.empty()) {
+    std::filesystem::remove(synthetic);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const std::map<std::string, std::function<void(const std::vector<std::string>&)>> modes{
+      {"index",    runIndexMode},
+      {"mmap",     runMmapMode},
+      {"parallel", runParallelMode},
+      {"simd",     runSimdMode},
+      {"snapshot", runSnapshotMode},
+  };
+
+  if (argc < 3 || modes.count(argv[1]) == 0) {
+    std::cerr << "Usage: " << argv[0] << " <mode> <database.dat> [mode arguments]\n"
+              << "Modes:";
+    for (const auto& [name, run] : modes) std::cerr << ' ' << name;
+    std::cerr << '\n';
+    return EXIT_FAILURE;
+  }
+
+  Timer totalElapsedTime{"Timer:  total elapsed time is ", std::clog};
+  printHeader();
+  modes.at(argv[1])(std::vector<std::string>(argv + 2, argv + argc));
+}
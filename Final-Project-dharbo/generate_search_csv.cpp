@@ -0,0 +1,467 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "book.hpp"
+#include "book_loader.hpp"
+#include "book_view.hpp"
+#include "completion_trie.hpp"
+#include "query_engine.hpp"
+#include "text_index.hpp"
+#include "trigram_index.hpp"
+#include "timer.hpp"
+
+// Search companion to generate_csv.cpp. Times the indexes that answer
+// questions about titles and authors rather than ISBNs, against scanning
+// every book, and writes one comma-separated row per (corpus, structure,
+// operation) to standard output.
+//
+// Usage:  generate_search_csv <mode> <database.dat> [mode arguments]
+//
+// Modes:  text [books]         keyword searches of 1 to 3 words in a
+//                              TextIndex, with SSE2 and with scalar posting
+//                              list intersection, against a scan of every
+//                              title and author, over <database.dat> and
+//                              over a synthetic catalog of [books] books
+//                              (default 10000000) whose titles and authors
+//                              are those of <database.dat> repeated; then
+//                              removing and re-adding books
+//         trigram              substring searches of 3 to 12 characters
+//                              and fuzzy searches within 1 or 2 edits of
+//                              titles and authors in a TrigramIndex, with
+//                              the number of candidates its trigrams leave
+//                              to verify, against verifying every book and
+//                              against std::string::find over every title
+//         autocomplete [cache size ...]
+//                              build time, memory, and latency of the 10
+//                              best completions of author and title
+//                              prefixes of 1 to 8 characters in a
+//                              CompletionTrie with each cache size (default
+//                              10), ranked by popularity, against scanning a
+//                              std::map of the same strings; then removing
+//                              and re-inserting books
+//         query [runs]         a fixed set of queries on ISBN, title,
+//                              author, and price, each run [runs] times
+//                              (default 1000) through the plan a BookTable
+//                              chooses by cost, against forcing a scan of
+//                              every book
+//
+// Each mode prints its own header row.
+
+namespace {
+
+using benchmark::Clock;
+using benchmark::Timing;
+using benchmark::time_operations;
+using Utilities::Timer;
+
+// Times "search(i)", which returns its number of matches, for i in
+// [0, count) and prints the row.
+void measureSearches(const std::string& corpusName, std::size_t books, const std::string& structureName,
+                     const std::string& operationName, std::size_t count,
+                     const std::function<std::size_t(std::size_t)>& search) {
+  std::size_t matches = 0;
+  const Timing timing = time_operations(count, [&](std::size_t i) { matches += search(i); });
+  std::cout << corpusName << ',' << books << ',' << structureName << ',' << operationName << ',' << count << ','
+            << (count > 0 ? static_cast<double>(matches) / count : 0.0) << ','
+            << static_cast<long long>(benchmark::per_second(count, timing.elapsed)) << ','
+            << static_cast<long long>(timing.latency.mean) << ',' << timing.latency.p50 << ','
+            << timing.latency.p99 << '\n';
+}
+
+// Random books drawn per query wanted before sampling gives up on finding
+// books long enough for the queries.
+constexpr std::size_t SAMPLE_ATTEMPTS_PER_QUERY = 100;
+
+// "count" queries of "words" words each, drawn from the title and author of
+// random books, so that every query matches at least one book. Throws
+// std::runtime_error if too few books have that many words.
+template <class Record>
+std::vector<std::string> sampleQueries(const std::vector<Record>& books, std::size_t words, std::size_t count,
+                                       std::default_random_engine& random) {
+  std::vector<std::string> queries;
+  std::uniform_int_distribution<std::size_t> position(0, books.size() - 1);
+  for (std::size_t attempts = 0; queries.size() < count; ++attempts) {
+    if (attempts == count * SAMPLE_ATTEMPTS_PER_QUERY) {
+      throw std::runtime_error("too few books have " + std::to_string(words) + " words to query");
+    }
+    const Record& book = books[position(random)];
+    std::vector<std::string> tokens = text_tokens(std::string(book.title()) + ' ' + std::string(book.author()));
+    if (tokens.size() < words) continue;
+    std::shuffle(tokens.begin(), tokens.end(), random);
+    std::string query = tokens[0];
+    for (std::size_t i = 1; i < words; ++i) query += ' ' + tokens[i];
+    queries.push_back(query);
+  }
+  return queries;
+}
+
+//
+// TEXT MODE
+//
+
+template <class Record>
+void measureTextCorpus(const std::string& corpusName, const std::vector<Record>& books) {
+  TextIndex index;
+  {
+    std::clog << "  indexing " << books.size() << " books of " << corpusName << " ... ";
+    Timer timer{"finished in ", std::clog};
+    for (const Record& book : books) index.add(book);
+  }
+  std::clog << "  " << index.terms() << " words, " << index.postings() << " postings in "
+            << index.posting_bytes() << " bytes (" << static_cast<double>(index.posting_bytes()) / index.postings()
+            << " bytes per posting, " << TEXT_INDEX_BACKEND << " intersection)\n";
+
+  // A full scan tokenizes every title and author, so it runs about five
+  // million books' worth of queries.
+  const std::size_t fullScans = std::clamp<std::size_t>(5'000'000 / books.size(), 1, 100);
+  std::default_random_engine random(std::random_device{}());
+  for (std::size_t words = 1; words <= 3; ++words) {
+    const std::vector<std::string> queries = sampleQueries(books, words, 1000, random);
+    const std::string operationName = std::to_string(words) + (words == 1 ? " word" : " words");
+    measureSearches(corpusName, books.size(), "Text index", operationName, queries.size(),
+                    [&](std::size_t i) { return index.search(queries[i]).size(); });
+    measureSearches(corpusName, books.size(), "Text index (scalar intersection)", operationName, queries.size(),
+                    [&](std::size_t i) { return index.search<false>(queries[i]).size(); });
+    measureSearches(corpusName, books.size(), "Vector (full scan)", operationName, fullScans,
+                    [&](std::size_t i) { return search_within_vector_by_words{books, queries[i]}(books[0]).size(); });
+  }
+
+  // Remove random books, then add them back.
+  std::vector<const Record*> changed;
+  std::uniform_int_distribution<std::size_t> position(0, books.size() - 1);
+  for (std::size_t i = 0; i < 1000; ++i) changed.push_back(&books[position(random)]);
+  measureSearches(corpusName, books.size(), "Text index", "Remove", changed.size(),
+                  [&](std::size_t i) { return index.remove(changed[i]->isbn()) ? 1 : 0; });
+  measureSearches(corpusName, books.size(), "Text index", "Add", changed.size(),
+                  [&](std::size_t i) { return index.add(*changed[i]) > 0 ? 1 : 0; });
+}
+
+void runTextMode(const std::vector<std::string>& args) {
+  std::cout << "Corpus,Books,Structure,Operation,Operations,Matches per operation,Throughput (ops/s),"
+               "Mean latency (ns),p50 latency (ns),p99 latency (ns)\n";
+  const std::vector<Book> books = load_books_mapped(args[0]);
+  const std::size_t syntheticBooks = args.size() > 1 ? std::stoul(args[1]) : 10'000'000;
+  if (books.empty()) return;
+
+  measureTextCorpus(args[0], books);
+
+  // The synthetic books view the titles and authors of the real ones, with
+  // unique 13-digit ISBNs, so the corpus costs little more than its index.
+  std::vector<char> isbns(syntheticBooks * 13);
+  std::vector<BookView> synthetic;
+  synthetic.reserve(syntheticBooks);
+  for (std::size_t i = 0; i < syntheticBooks; ++i) {
+    char* isbn = &isbns[i * 13];
+    char digits[21];
+    std::snprintf(digits, sizeof digits, "%013zu", i);
+    std::memcpy(isbn, digits, 13);
+    const Book& model = books[i % books.size()];
+    synthetic.emplace_back(model.title(), model.author(), std::string_view(isbn, 13), model.price());
+  }
+  measureTextCorpus("Synthetic", synthetic);
+}
+
+//
+// TRIGRAM MODE
+//
+
+// Times "search(i)", which returns its number of candidates and of matches,
+// for i in [0, count) and prints the row.
+void measureCandidates(const std::string& structureName, const std::string& operationName, std::size_t count,
+                       const std::function<std::pair<std::size_t, std::size_t>(std::size_t)>& search) {
+  std::size_t candidates = 0;
+  std::size_t matches = 0;
+  const Timing timing = time_operations(count, [&](std::size_t i) {
+    const auto [verified, found] = search(i);
+    candidates += verified;
+    matches += found;
+  });
+  std::cout << structureName << ',' << operationName << ',' << count << ','
+            << (count > 0 ? static_cast<double>(candidates) / count : 0.0) << ','
+            << (count > 0 ? static_cast<double>(matches) / count : 0.0) << ','
+            << static_cast<long long>(benchmark::per_second(count, timing.elapsed)) << ','
+            << static_cast<long long>(timing.latency.mean) << ',' << timing.latency.p50 << ','
+            << timing.latency.p99 << '\n';
+}
+
+void runTrigramMode(const std::vector<std::string>& args) {
+  std::cout << "Structure,Operation,Queries,Candidates per query,Matches per query,Throughput (queries/s),"
+               "Mean latency (ns),p50 latency (ns),p99 latency (ns)\n";
+  const std::vector<Book> books = load_books_mapped(args[0]);
+  if (books.empty()) return;
+
+  TrigramIndex index;
+  {
+    std::clog << "  indexing " << books.size() << " books ... ";
+    Timer timer{"finished in ", std::clog};
+    for (const Book& book : books) index.add(book);
+  }
+  std::clog << "  " << index.trigrams() << " trigrams, " << index.postings() << " postings\n";
+
+  // Pieces of "length" code points of random books' normalized fields, with
+  // "edits" random substitutions, insertions, or deletions of letters.
+  std::default_random_engine random(std::random_device{}());
+  std::uniform_int_distribution<std::size_t> position(0, books.size() - 1);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  auto sampleQueries = [&](TextField field, std::size_t length, std::size_t edits) {
+    constexpr std::size_t QUERIES = 1000;
+    std::vector<std::string> queries;
+    for (std::size_t attempts = 0; queries.size() < QUERIES; ++attempts) {
+      if (attempts == QUERIES * SAMPLE_ATTEMPTS_PER_QUERY) {
+        throw std::runtime_error("too few books have " + std::to_string(length) + " letters to query");
+      }
+      const Book& book = books[position(random)];
+      std::u32string text = normalize_text(field == TextField::Title ? book.title() : book.author());
+      if (text.size() < length) continue;
+      text = text.substr(std::uniform_int_distribution<std::size_t>(0, text.size() - length)(random), length);
+      for (std::size_t edit = 0; edit < edits; ++edit) {
+        const std::size_t at = std::uniform_int_distribution<std::size_t>(0, text.size() - 1)(random);
+        switch (edit % 3) {
+          case 0: text[at] = static_cast<char32_t>(letter(random)); break;
+          case 1: text.insert(text.begin() + at, static_cast<char32_t>(letter(random))); break;
+          default: text.erase(text.begin() + at); break;
+        }
+      }
+      queries.push_back(to_utf8(text));
+    }
+    return queries;
+  };
+  auto counts = [](const TrigramSearch& search) { return std::pair{search.candidates, search.matches.size()}; };
+
+  for (std::size_t length : {3, 5, 8, 12}) {
+    const std::vector<std::string> queries = sampleQueries(TextField::Title, length, 0);
+    const std::string operationName = "Title substring of " + std::to_string(length);
+    measureCandidates("Trigram index", operationName, queries.size(),
+                      [&](std::size_t i) { return counts(index.find_substring(queries[i], TextField::Title)); });
+    measureCandidates("Trigram index (verify every book)", operationName, 100, [&](std::size_t i) {
+      return counts(index.find_substring<false>(queries[i], TextField::Title));
+    });
+    measureCandidates("Vector (std::string::find)", operationName, 100, [&](std::size_t i) {
+      return std::pair{books.size(), search_within_vector_by_title_substring{books, queries[i]}(books[0]).size()};
+    });
+  }
+
+  const std::vector<std::tuple<TextField, std::size_t, std::size_t>> fuzzySearches = {
+      {TextField::Author, 8, 1}, {TextField::Author, 12, 1}, {TextField::Author, 12, 2}, {TextField::Title, 12, 1},
+      {TextField::Title, 20, 2}};
+  for (const auto& [field, length, edits] : fuzzySearches) {
+    const std::vector<std::string> queries = sampleQueries(field, length, edits);
+    const std::string operationName = std::string(field == TextField::Title ? "Title" : "Author") + " of " +
+                                      std::to_string(length) + " within " + std::to_string(edits) +
+                                      (edits == 1 ? " edit" : " edits");
+    measureCandidates("Trigram index", operationName, queries.size(),
+                      [&, field = field, edits = edits](std::size_t i) {
+                        return counts(index.find_fuzzy(queries[i], edits, field));
+                      });
+    measureCandidates("Trigram index (verify every book)", operationName, 100,
+                      [&, field = field, edits = edits](std::size_t i) {
+                        return counts(index.find_fuzzy<false>(queries[i], edits, field));
+                      });
+  }
+}
+
+//
+// AUTOCOMPLETE MODE
+//
+
+// Times "operation(i)", which returns its number of completions, for i in
+// [0, count) and prints the row.
+void measureCompletions(const std::string& structureName, TextField field, std::size_t cacheSize, std::size_t memory,
+                        const std::string& operationName, std::size_t count,
+                        const std::function<std::size_t(std::size_t)>& operation) {
+  std::size_t completions = 0;
+  const Timing timing = time_operations(count, [&](std::size_t i) { completions += operation(i); });
+  std::cout << structureName << ',' << (field == TextField::Title ? "Title" : "Author") << ',' << cacheSize << ','
+            << memory << ',' << operationName << ',' << count << ','
+            << (count > 0 ? static_cast<double>(completions) / count : 0.0) << ','
+            << static_cast<long long>(benchmark::per_second(count, timing.elapsed)) << ','
+            << static_cast<long long>(timing.latency.mean) << ',' << timing.latency.p50 << ','
+            << timing.latency.p99 << '\n';
+}
+
+// The bytes of a std::map of completions: its nodes, taken as the pair plus
+// four pointers of tree links and color, and the strings' heap buffers.
+std::size_t mapBytes(const std::map<std::string, Completion>& map) {
+  std::size_t bytes = sizeof map;
+  for (const auto& [key, completion] : map) {
+    bytes += sizeof(std::pair<const std::string, Completion>) + 4 * sizeof(void*);
+    for (const std::string* text : {&key, &completion.key, &completion.text}) {
+      if (text->capacity() > std::string().capacity()) bytes += text->capacity() + 1;
+    }
+  }
+  return bytes;
+}
+
+void runAutocompleteMode(const std::vector<std::string>& args) {
+  std::cout << "Structure,Field,Cache size,Memory (bytes),Operation,Operations,Completions per operation,"
+               "Throughput (ops/s),Mean latency (ns),p50 latency (ns),p99 latency (ns)\n";
+  const std::vector<Book> books = load_books_mapped(args[0]);
+  std::vector<std::size_t> cacheSizes;
+  for (std::size_t i = 1; i < args.size(); ++i) cacheSizes.push_back(std::stoul(args[i]));
+  if (cacheSizes.empty()) cacheSizes = {10};
+  if (books.empty()) return;
+
+  constexpr std::size_t COMPLETIONS = 10;
+  std::default_random_engine random(std::random_device{}());
+  std::uniform_int_distribution<std::size_t> position(0, books.size() - 1);
+  for (TextField field : {TextField::Author, TextField::Title}) {
+    auto text = [&](const Book& book) -> const std::string& {
+      return field == TextField::Title ? book.title() : book.author();
+    };
+
+    // Prefixes of random books' normalized fields, as typed so far.
+    std::map<std::size_t, std::vector<std::string>> prefixes;
+    for (std::size_t length : {1, 2, 3, 5, 8}) {
+      while (prefixes[length].size() < 10000) {
+        const std::u32string normalized = normalize_text(text(books[position(random)]));
+        if (normalized.size() >= length) prefixes[length].push_back(to_utf8(normalized.substr(0, length)));
+      }
+    }
+    std::vector<const Book*> changed;
+    for (std::size_t i = 0; i < 1000; ++i) changed.push_back(&books[position(random)]);
+
+    std::map<std::string, Completion> map;
+    measureCompletions("BST (completions)", field, 0, 0, "Build", books.size(), [&](std::size_t i) {
+      add_completion(map, books[i], field);
+      return 0;
+    });
+    for (const auto& [length, queries] : prefixes) {
+      measureCompletions("BST (completions)", field, 0, mapBytes(map), "Complete prefix of " + std::to_string(length),
+                         queries.size(), [&](std::size_t i) {
+                           return complete_within_map{map, queries[i], COMPLETIONS, CompletionRank::Popularity}(books[0])
+                               .size();
+                         });
+    }
+
+    for (std::size_t cacheSize : cacheSizes) {
+      CompletionTrie trie(field, CompletionRank::Popularity, cacheSize);
+      measureCompletions("Completion trie", field, cacheSize, 0, "Build", books.size(), [&](std::size_t i) {
+        trie.insert(books[i]);
+        return 0;
+      });
+      const std::size_t memory = trie.memory_bytes();
+      std::clog << "  " << trie.size() << " strings in " << trie.nodes() << " nodes, " << memory << " bytes\n";
+      for (const auto& [length, queries] : prefixes) {
+        measureCompletions("Completion trie", field, cacheSize, memory, "Complete prefix of " + std::to_string(length),
+                           queries.size(),
+                           [&](std::size_t i) { return trie.complete(queries[i], COMPLETIONS).size(); });
+      }
+      measureCompletions("Completion trie", field, cacheSize, memory, "Remove", changed.size(),
+                         [&](std::size_t i) { return trie.remove(*changed[i]) ? 1 : 0; });
+      measureCompletions("Completion trie", field, cacheSize, memory, "Insert", changed.size(), [&](std::size_t i) {
+        trie.insert(*changed[i]);
+        return 1;
+      });
+    }
+  }
+}
+
+//
+// QUERY MODE
+//
+
+void runQueryMode(const std::vector<std::string>& args) {
+  std::cout << "Query,Mode,Plan,Estimated rows,Estimated cost,Runs,Matches per run,Throughput (queries/s),"
+               "Mean latency (ns),p50 latency (ns),p99 latency (ns)\n";
+  const std::vector<Book> books = load_books_mapped(args[0]);
+  const std::size_t runs = args.size() > 1 ? std::stoul(args[1]) : 1000;
+  if (books.empty()) return;
+
+  std::unique_ptr<BookTable> table;
+  {
+    std::clog << "  building the table and its indexes over " << books.size() << " books ... ";
+    Timer timer{"finished in ", std::clog};
+    table = std::make_unique<BookTable>(books);
+  }
+
+  // The same queries every run: their values come from books picked with a
+  // fixed seed.
+  std::default_random_engine random(49);
+  std::uniform_int_distribution<std::size_t> position(0, books.size() - 1);
+  const Book& a = books[position(random)];
+  const Book& b = books[position(random)];
+  const Book& c = books[position(random)];
+  std::vector<std::string> isbns;
+  for (const Book& book : books) isbns.push_back(book.isbn());
+  std::sort(isbns.begin(), isbns.end());
+  const std::size_t first = position(random) % (isbns.size() - std::min<std::size_t>(isbns.size(), 100) + 1);
+  const std::size_t last = std::min(first + 100, isbns.size() - 1);
+
+  using Field = QueryField;
+  const std::vector<std::pair<std::string, Predicate>> queries = {
+      {"ISBN equals", Predicate::equals(Field::Isbn, a.isbn())},
+      {"ISBN prefix of 5", Predicate::starts_with(Field::Isbn, a.isbn().substr(0, 5))},
+      {"ISBN range of 100", Predicate::between(Field::Isbn, isbns[first], isbns[last])},
+      {"Author equals", Predicate::equals(Field::Author, b.author())},
+      {"Title equals", Predicate::equals(Field::Title, c.title())},
+      {"Price within 10 cents", Predicate::price_between(a.price(), a.price() + 0.10)},
+      {"Price from $10 to $20", Predicate::price_between(10, 20)},
+      {"Any price", Predicate::price_between(0, 1e9)},
+      {"Author and price", Predicate::equals(Field::Author, b.author()) && Predicate::price_between(10, 50)},
+      {"Two authors or a title", Predicate::equals(Field::Author, a.author()) ||
+                                     Predicate::equals(Field::Author, b.author()) ||
+                                     Predicate::equals(Field::Title, c.title())},
+      {"ISBN prefix and title word",
+       Predicate::starts_with(Field::Isbn, a.isbn().substr(0, 4)) && Predicate::contains(Field::Title, "History")},
+      {"Title word", Predicate::contains(Field::Title, "History")},
+      {"Author or title word", Predicate::equals(Field::Author, b.author()) || Predicate::contains(Field::Title, "History")},
+  };
+
+  for (const auto& [name, query] : queries) {
+    for (PlanMode mode : {PlanMode::CostBased, PlanMode::FullScan}) {
+      const QueryPlan plan = table->plan(query, mode);
+      if (mode == PlanMode::CostBased) std::clog << "  " << name << ":\n" << plan.explain();
+      std::size_t matches = 0;
+      const Timing timing = time_operations(runs, [&](std::size_t) {
+        matches += select_from_book_table{*table, query, mode}(books[0]).size();
+      });
+      std::cout << name << ',' << (mode == PlanMode::CostBased ? "Planned" : "Forced full scan") << ','
+                << QueryPlan::name(plan.op) << ',' << plan.rows << ',' << plan.cost << ',' << runs << ','
+                << (runs > 0 ? static_cast<double>(matches) / runs : 0.0) << ','
+                << static_cast<long long>(benchmark::per_second(runs, timing.elapsed)) << ','
+                << static_cast<long long>(timing.latency.mean) << ',' << timing.latency.p50 << ','
+                << timing.latency.p99 << '\n';
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const std::map<std::string, std::function<void(const std::vector<std::string>&)>> modes{
+      {"text", runTextMode},
+      {"trigram", runTrigramMode},
+      {"autocomplete", runAutocompleteMode},
+      {"query", runQueryMode},
+  };
+
+  if (argc < 3 || modes.count(argv[1]) == 0) {
+    std::cerr << "Usage: " << argv[0] << " <mode> <database.dat> [mode arguments]\n"
+              << "Modes:";
+    for (const auto& [name, run] : modes) std::cerr << ' ' << name;
+    std::cerr << '\n';
+    return EXIT_FAILURE;
+  }
+
+  Timer totalElapsedTime{"Timer:  total elapsed time is ", std::clog};
+  try {
+    modes.at(argv[1])(std::vector<std::string>(argv + 2, argv + argc));
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,789 @@
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "book.hpp"
+#include "book_loader.hpp"
+#include "book_view.hpp"
+#include "btree_catalog.hpp"
+#include "buffer_pool.hpp"
+#include "compressed_catalog.hpp"
+#include "external_sort.hpp"
+#include "lsm_catalog.hpp"
+#include "mapped_file.hpp"
+#include "range_scan.hpp"
+#include "shared_catalog.hpp"
+#include "skip_list.hpp"
+#include "timer.hpp"
+#include "wal.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Storage companion to generate_csv.cpp. Times the on-disk structures, whose
+// cost depends on how much of them is cached in memory, and writes one
+// comma-separated row per (structure, cache size, operation) to standard
+// output.
+//
+// Usage:  generate_storage_csv <mode> <database.dat> [mode arguments]
+//
+// Modes:  btree [percent ...]  lookups and range scans in a B+tree catalog
+//                              built from <database.dat>, with the buffer
+//                              pool capped at each percentage of the tree's
+//                              pages (default 100 50 25 10 5 1), against
+//                              std::map
+//         lsm [updates per book]
+//                              a price feed of random price updates
+//                              (default 10 per book) ingested by an LSM
+//                              catalog, std::map, and std::unordered_map,
+//                              then lookups of present and absent ISBNs
+//         wal [records] [directory]
+//                              write-ahead log commits of insert, remove,
+//                              and price-update records (default 4000 per
+//                              row) to a log in [directory] (default the
+//                              current one, so a real disk rather than a
+//                              temporary file system): one writer at
+//                              growing batch sizes, then concurrent writers
+//                              sharing group commits, with and without
+//                              fsync
+//         compressed [block bytes ...]
+//                              memory per book and lookup latency of a
+//                              CompressedCatalog at each block size (default
+//                              1024 4096 16384) and cache size, against
+//                              std::unordered_map
+//         sort [MiB] [directory]
+//                              an external sort of a synthetic database of
+//                              [MiB] (default 256) in which each ISBN
+//                              appears about twice, written in [directory]
+//                              (default the current one), with memory
+//                              budgets of a tenth, a fortieth, and a
+//                              hundred-and-sixtieth of its size
+//         range [width ...]    ISBN range scans returning each number of
+//                              books (default 1 10 100 1000 10000), and
+//                              prefix scans for prefixes of 2 to 8 digits,
+//                              over std::map, a sorted vector, the skip
+//                              list, and the B+tree, against filtering an
+//                              unsorted vector
+//         shared [processes]   startup time and memory of [processes]
+//                              (default 8) worker processes starting at
+//                              once, each loading its own copy of
+//                              <database.dat> the way SampleData is filled,
+//                              against each attaching one SharedCatalog in
+//                              POSIX shared memory
+//
+// Each mode prints its own header row.
+
+namespace {
+
+using benchmark::Clock;
+using benchmark::Timing;
+using benchmark::time_operations;
+using Utilities::Timer;
+
+// Books visited by each range scan.
+constexpr std::size_t RANGE_SCAN_LENGTH = 100;
+
+// What the buffer pool did during a measurement; all zero for in-memory
+// structures.
+struct PoolActivity {
+  std::size_t pages = 0;
+  double fraction = 1.0;
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+};
+
+// Times "operation(i)" for i in [0, count) and prints the row.
+void measureOperations(const std::string& structureName, const std::string& operationName,
+                       std::size_t count, const std::function<void(std::size_t)>& operation,
+                       const std::function<PoolActivity()>& activity) {
+  const Timing timing = time_operations(count, operation);
+  const PoolActivity pool = activity();
+  const benchmark::LatencySummary& latency = timing.latency;
+  const std::size_t fetches = pool.hits + pool.misses;
+  std::cout << structureName << ',' << pool.pages << ',' << pool.fraction << ','
+            << operationName << ',' << count << ','
+            << static_cast<long long>(benchmark::per_second(count, timing.elapsed)) << ','
+            << static_cast<long long>(latency.mean) << ',' << latency.p50 << ',' << latency.p99 << ','
+            << (fetches > 0 ? static_cast<double>(pool.hits) / fetches : 1.0) << ','
+            << (count > 0 ? static_cast<double>(pool.misses) / count : 0.0) << '\n';
+}
+
+//
+// B+TREE MODE
+//
+
+void runBTreeMode(const std::vector<std::string>& args) {
+  std::cout << "Structure,Pool pages,Pool fraction,Operation,Operations,Throughput (ops/s),"
+               "Mean latency (ns),p50 latency (ns),p99 latency (ns),Hit rate,Page reads per operation\n";
+  const std::vector<Book> books = load_books_mapped(args[0]);
+  std::vector<double> percents;
+  for (std::size_t i = 1; i < args.size(); ++i) percents.push_back(std::stod(args[i]));
+  if (percents.empty()) percents = {100, 50, 25, 10, 5, 1};
+
+  // Lookups in a random order, and range scans starting at random books.
+  std::map<std::string, Book> map;
+  for (const Book& book : books) map.insert_or_assign(book.isbn(), book);
+  std::vector<std::string> isbns;
+  for (const auto& [isbn, book] : map) isbns.push_back(isbn);
+  std::default_random_engine random(std::random_device{}());
+  std::vector<std::string> lookups = isbns;
+  std::shuffle(lookups.begin(), lookups.end(), random);
+  const std::size_t scans = std::max<std::size_t>(isbns.size() / RANGE_SCAN_LENGTH, 1);
+  std::vector<std::string> scanStarts;
+  std::uniform_int_distribution<std::size_t> position(0, isbns.empty() ? 0 : isbns.size() - 1);
+  for (std::size_t i = 0; i < scans && !isbns.empty(); ++i) scanStarts.push_back(isbns[position(random)]);
+  std::vector<std::string> scanEnds;
+  for (const std::string& first : scanStarts) {
+    auto last = map.lower_bound(first);
+    for (std::size_t i = 0; i < RANGE_SCAN_LENGTH && last != map.end(); ++i) ++last;
+    scanEnds.push_back(last == map.end() ? std::string("\xff") : last->first);
+  }
+
+  const std::string path = (std::filesystem::temp_directory_path() / "generate_storage_csv.btree").string();
+  std::filesystem::remove(path);
+  std::size_t pageCount = 0;
+  {
+    std::clog << "  building B+tree of " << books.size() << " books ... ";
+    Timer timer{"finished in ", std::clog};
+    BTreeCatalog catalog(path, 1 << 16);
+    for (const Book& book : books) catalog.insert(book);
+    catalog.flush();
+    pageCount = catalog.page_count();
+    std::clog << pageCount << " pages, height " << catalog.height() << ", ";
+  }
+
+  // Every operation adds the prices it finds to "total", which is logged at
+  // the end, so none of them can be optimized away.
+  double total = 0.0;
+  auto noPool = [] { return PoolActivity{}; };
+  measureOperations("std::map", "Find", lookups.size(),
+                    [&](std::size_t i) {
+                      if (auto found = map.find(lookups[i]); found != map.end()) total += found->second.price();
+                    },
+                    noPool);
+  measureOperations("std::map", "Range scan", scanStarts.size(),
+                    [&](std::size_t i) {
+                      for (auto it = map.lower_bound(scanStarts[i]); it != map.end() && it->first < scanEnds[i]; ++it) {
+                        total += it->second.price();
+                      }
+                    },
+                    noPool);
+
+  for (double percent : percents) {
+    const std::size_t poolPages = std::max<std::size_t>(pageCount * percent / 100.0, BufferPool::MIN_CAPACITY);
+    drop_cached_pages(path);
+    BTreeCatalog catalog(path, poolPages);
+
+    // One untimed pass brings the pool to its steady state for this size.
+    for (const std::string& isbn : lookups) catalog.find(isbn);
+
+    auto activity = [&] {
+      return PoolActivity{catalog.pool().capacity(), static_cast<double>(catalog.pool().capacity()) / pageCount,
+                          catalog.pool().hits(), catalog.pool().misses()};
+    };
+    catalog.pool().reset_statistics();
+    measureOperations("B+ Tree", "Find", lookups.size(),
+                      [&](std::size_t i) {
+                        if (const std::optional<Book> found = catalog.find(lookups[i])) total += found->price();
+                      },
+                      activity);
+    catalog.pool().reset_statistics();
+    measureOperations("B+ Tree", "Range scan", scanStarts.size(),
+                      [&](std::size_t i) {
+                        catalog.for_each_in_range(scanStarts[i], scanEnds[i],
+                                                  [&total](const Book& book) { total += book.price(); });
+                      },
+                      activity);
+  }
+
+  std::clog << "  prices found sum to " << total << '\n';
+  std::filesystem::remove(path);
+}
+
+//
+// LSM MODE
+//
+
+// Read and write amplification of an LSM catalog; zero for in-memory
+// structures.
+struct LsmActivity {
+  double runsRead = 0.0;
+  double writeAmplification = 0.0;
+};
+
+void printLsmRow(const std::string& structureName, const std::string& operationName,
+                 std::size_t count, const Timing& timing, const LsmActivity& lsm) {
+  std::cout << structureName << ',' << operationName << ',' << count << ','
+            << static_cast<long long>(benchmark::per_second(count, timing.elapsed)) << ','
+            << static_cast<long long>(timing.latency.mean) << ',' << timing.latency.p50 << ','
+            << timing.latency.p99 << ',' << lsm.runsRead << ',' << lsm.writeAmplification << '\n';
+}
+
+void runLsmMode(const std::vector<std::string>& args) {
+  std::cout << "Structure,Operation,Operations,Throughput (ops/s),Mean latency (ns),"
+               "p50 latency (ns),p99 latency (ns),Runs read per lookup,Write amplification\n";
+  const std::vector<Book> books = load_books_mapped(args[0]);
+  const std::size_t updatesPerBook = args.size() > 1 ? std::stoul(args[1]) : 10;
+  if (books.empty()) return;
+
+  // The feed: random books at random new prices. Lookups of present books
+  // in a random order, and of ISBNs no book has.
+  std::default_random_engine random(std::random_device{}());
+  std::uniform_int_distribution<std::size_t> which(0, books.size() - 1);
+  std::uniform_real_distribution<double> price(1.0, 200.0);
+  std::vector<Book> feed;
+  feed.reserve(books.size() * updatesPerBook);
+  for (std::size_t i = 0; i < books.size() * updatesPerBook; ++i) {
+    feed.push_back(Book(books[which(random)]).price(price(random)));
+  }
+  std::vector<std::string> present;
+  for (std::size_t i = 0; i < books.size(); ++i) present.push_back(books[which(random)].isbn());
+  std::vector<std::string> absent;
+  for (std::size_t i = 0; i < books.size(); ++i) absent.push_back("absent-" + std::to_string(i));
+
+  auto measureMap = [&](const std::string& name, auto& map) {
+    printLsmRow(name, "Ingest", feed.size(),
+                time_operations(feed.size(), [&](std::size_t i) { map.insert_or_assign(feed[i].isbn(), feed[i]); }),
+                {});
+    printLsmRow(name, "Find", present.size(),
+                time_operations(present.size(), [&](std::size_t i) { map.find(present[i]); }), {});
+    printLsmRow(name, "Find absent", absent.size(),
+                time_operations(absent.size(), [&](std::size_t i) { map.find(absent[i]); }), {});
+  };
+  {
+    std::map<std::string, Book> map;
+    measureMap("std::map", map);
+  }
+  {
+    std::unordered_map<std::string, Book> map;
+    measureMap("std::unordered_map", map);
+  }
+
+  const std::string directory = (std::filesystem::temp_directory_path() / "generate_storage_csv.lsm").string();
+  std::filesystem::remove_all(directory);
+  {
+    LsmCatalog catalog(directory);
+    // The ingest rate includes the stalls the background thread imposes on
+    // writers when flushing or compaction falls behind.
+    const Timing ingest = time_operations(feed.size(), [&](std::size_t i) { catalog.insert(feed[i]); });
+    catalog.flush();
+    catalog.wait_for_compaction();
+    const LsmStatistics written = catalog.statistics();
+    printLsmRow("LSM Tree", "Ingest", feed.size(), ingest, {0.0, written.write_amplification()});
+    std::clog << "  LSM tree levels (runs):";
+    for (std::size_t runs : written.runs_per_level) std::clog << ' ' << runs;
+    std::clog << '\n';
+
+    auto measureLookups = [&](const std::string& operationName, const std::vector<std::string>& isbns) {
+      const LsmStatistics before = catalog.statistics();
+      const Timing timing = time_operations(isbns.size(), [&](std::size_t i) { catalog.find(isbns[i]); });
+      const LsmStatistics after = catalog.statistics();
+      const double runsRead = static_cast<double>((after.runs_probed - before.runs_probed) -
+                                                  (after.runs_filtered - before.runs_filtered)) / isbns.size();
+      printLsmRow("LSM Tree", operationName, isbns.size(), timing, {runsRead, written.write_amplification()});
+    };
+    measureLookups("Find", present);
+    measureLookups("Find absent", absent);
+  }
+  std::filesystem::remove_all(directory);
+}
+
+//
+// WAL MODE
+//
+
+void runWalMode(const std::vector<std::string>& args) {
+  std::cout << "Configuration,Writers,Batch size,Sync interval (us),Records,Throughput (records/s),"
+               "Mean commit latency (ns),p50 commit latency (ns),p99 commit latency (ns),Records per sync\n";
+  const std::vector<Book> books = load_books_mapped(args[0]);
+  const std::size_t recordCount = args.size() > 1 ? std::stoul(args[1]) : 4000;
+  const std::filesystem::path directory = args.size() > 2 ? args[2] : ".";
+  if (books.empty()) return;
+
+  // A mix of the catalog mutations: mostly price updates.
+  std::vector<WalRecord> records;
+  for (std::size_t i = 0; i < recordCount; ++i) {
+    const Book& book = books[i % books.size()];
+    switch (i % 8) {
+      case 0: records.push_back(WalRecord::insert(book)); break;
+      case 1: records.push_back(WalRecord::remove(book.isbn())); break;
+      default: records.push_back(WalRecord::price_update(book.isbn(), book.price() + i % 100)); break;
+    }
+  }
+  const std::string path = (directory / "generate_storage_csv.wal").string();
+
+  auto printRow = [&](const std::string& configuration, std::size_t writers, std::size_t batchSize,
+                      const WalOptions& options, Clock::duration elapsed,
+                      std::vector<Clock::duration>& latencies, std::size_t syncs) {
+    const benchmark::LatencySummary latency = benchmark::summarize(latencies);
+    std::cout << configuration << ',' << writers << ',' << batchSize << ','
+              << options.sync_interval.count() << ',' << records.size() << ','
+              << static_cast<long long>(benchmark::per_second(records.size(), elapsed)) << ','
+              << static_cast<long long>(latency.mean) << ',' << latency.p50 << ',' << latency.p99 << ','
+              << (syncs > 0 ? static_cast<double>(records.size()) / syncs : 0.0) << '\n';
+  };
+
+  // One writer committing "batchSize" records at a time. A commit's latency is
+  // charged to each record in it.
+  auto measureBatches = [&](const std::string& configuration, std::size_t batchSize, const WalOptions& options) {
+    std::filesystem::remove(path);
+    WriteAheadLog log(path, options);
+    std::vector<Clock::duration> latencies;
+    const auto start_time = Clock::now();
+    for (std::size_t first = 0; first < records.size(); first += batchSize) {
+      const std::vector<WalRecord> batch(records.begin() + first,
+                                         records.begin() + std::min(first + batchSize, records.size()));
+      const auto commit_start = Clock::now();
+      log.append_batch(batch);
+      latencies.insert(latencies.end(), batch.size(), Clock::now() - commit_start);
+    }
+    const auto elapsed = Clock::now() - start_time;
+    printRow(configuration, 1, batchSize, options, elapsed, latencies, log.syncs());
+  };
+
+  // "writers" threads each appending their share one record at a time.
+  auto measureWriters = [&](const std::string& configuration, std::size_t writers, const WalOptions& options) {
+    std::filesystem::remove(path);
+    WriteAheadLog log(path, options);
+    std::vector<std::vector<Clock::duration>> perWriter(writers);
+    const auto elapsed = benchmark::run_threads(writers, [&](std::size_t index) {
+      const auto [first, last] = benchmark::slice(records.size(), index, writers);
+      for (std::size_t i = first; i < last; ++i) {
+        const auto commit_start = Clock::now();
+        log.append(records[i]);
+        perWriter[index].push_back(Clock::now() - commit_start);
+      }
+    });
+    std::vector<Clock::duration> latencies;
+    for (const auto& samples : perWriter) latencies.insert(latencies.end(), samples.begin(), samples.end());
+    printRow(configuration, writers, 1, options, elapsed, latencies, log.syncs());
+  };
+
+  WalOptions synced;
+  WalOptions unsynced;
+  unsynced.sync = false;
+  for (std::size_t batchSize : {1, 4, 16, 64, 256, 1024}) {
+    measureBatches("fsync per batch", batchSize, synced);
+  }
+  measureBatches("no fsync", 1, unsynced);
+  for (std::size_t writers : benchmark::thread_counts(benchmark::default_max_threads() * 4)) {
+    measureWriters("group commit", writers, synced);
+  }
+  WalOptions delayed;
+  delayed.sync_interval = std::chrono::microseconds(500);
+  for (std::size_t writers : benchmark::thread_counts(benchmark::default_max_threads() * 4)) {
+    measureWriters("group commit", writers, delayed);
+  }
+  std::filesystem::remove(path);
+}
+
+//
+// COMPRESSED MODE
+//
+
+// Bytes a std::unordered_map<std::string, Book> holding "books" occupies: the
+// Books and their strings, a key string per node, the node's next pointer and
+// cached hash, the allocator's per-node overhead, and the bucket array.
+std::size_t hashTableBytes(const std::unordered_map<std::string, Book>& table) {
+  constexpr std::size_t NODE_OVERHEAD = 2 * sizeof(void*) + 16;
+  std::size_t bytes = table.bucket_count() * sizeof(void*);
+  for (const auto& [isbn, book] : table) {
+    bytes += sizeof(std::string) + heap_bytes(isbn) + footprint(book) + NODE_OVERHEAD;
+  }
+  return bytes;
+}
+
+void runCompressedMode(const std::vector<std::string>& args) {
+  std::cout << "Structure,Block bytes,Cache blocks,Bytes per book,Compression ratio,Operation,Operations,"
+               "Throughput (ops/s),Mean latency (ns),p50 latency (ns),p99 latency (ns),Cache hit rate\n";
+  const std::vector<Book> books = load_books_mapped(args[0]);
+  std::vector<std::size_t> blockSizes;
+  for (std::size_t i = 1; i < args.size(); ++i) blockSizes.push_back(std::stoul(args[i]));
+  if (blockSizes.empty()) blockSizes = {1024, 4096, 16384};
+  if (books.empty()) return;
+
+  // Uniform lookups over the whole catalog, and skewed ones over 1% of it,
+  // which is what the block cache is for.
+  std::default_random_engine random(std::random_device{}());
+  std::uniform_int_distribution<std::size_t> any(0, books.size() - 1);
+  std::uniform_int_distribution<std::size_t> hot(0, std::max<std::size_t>(books.size() / 100, 1) - 1);
+  std::vector<std::string> uniform, skewed;
+  for (std::size_t i = 0; i < books.size(); ++i) {
+    uniform.push_back(books[any(random)].isbn());
+    skewed.push_back(books[hot(random)].isbn());
+  }
+
+  auto printRow = [&](const std::string& structure, std::size_t blockBytes, std::size_t cacheBlocks,
+                      double bytesPerBook, double ratio, const std::string& operation, std::size_t count,
+                      const Timing& timing, double hitRate) {
+    std::cout << structure << ',' << blockBytes << ',' << cacheBlocks << ',' << bytesPerBook << ',' << ratio
+              << ',' << operation << ',' << count << ','
+              << static_cast<long long>(benchmark::per_second(count, timing.elapsed)) << ','
+              << static_cast<long long>(timing.latency.mean) << ',' << timing.latency.p50 << ','
+              << timing.latency.p99 << ',' << hitRate << '\n';
+  };
+
+  {
+    std::unordered_map<std::string, Book> table;
+    for (const Book& book : books) table.insert_or_assign(book.isbn(), book);
+    const double bytesPerBook = static_cast<double>(hashTableBytes(table)) / table.size();
+    for (const auto& [name, isbns] : {std::pair{"Find", &uniform}, std::pair{"Find hot", &skewed}}) {
+      const Timing timing = time_operations(isbns->size(), [&](std::size_t i) { table.find((*isbns)[i])->second.price(); });
+      printRow("std::unordered_map", 0, 0, bytesPerBook, 1.0, name, isbns->size(), timing, 1.0);
+    }
+  }
+
+  for (std::size_t blockBytes : blockSizes) {
+    for (std::size_t cacheBlocks : {std::size_t(0), CompressedCatalog::DEFAULT_CACHE_BLOCKS}) {
+      std::clog << "  compressing " << books.size() << " books in " << blockBytes << "-byte blocks ... ";
+      CompressedCatalog catalog(books, blockBytes, cacheBlocks);
+      std::clog << catalog.block_count() << " blocks\n";
+      const double bytesPerBook = static_cast<double>(catalog.memory_bytes()) / catalog.size();
+      const double ratio = static_cast<double>(catalog.raw_bytes()) / catalog.compressed_bytes();
+      for (const auto& [name, isbns] : {std::pair{"Find", &uniform}, std::pair{"Find hot", &skewed}}) {
+        catalog.reset_statistics();
+        const Timing timing = time_operations(isbns->size(), [&](std::size_t i) { catalog.find((*isbns)[i]); });
+        const double fetches = catalog.cache_hits() + catalog.cache_misses();
+        printRow("Compressed", blockBytes, cacheBlocks, bytesPerBook, ratio, name, isbns->size(), timing,
+                 fetches > 0 ? catalog.cache_hits() / fetches : 0.0);
+      }
+    }
+  }
+}
+
+//
+// SORT MODE
+//
+
+void runSortMode(const std::vector<std::string>& args) {
+  std::cout << "Input bytes,Memory budget (bytes),Records,Records written,Runs,Merge passes,"
+               "Bytes spilled,Seconds,Throughput (MiB/s),Throughput (records/s)\n";
+  const std::vector<Book> seed = load_books_mapped(args[0]);
+  const std::size_t inputBytes = (args.size() > 1 ? std::stoul(args[1]) : 256) << 20;
+  const std::filesystem::path directory = args.size() > 2 ? args[2] : ".";
+  if (seed.empty()) return;
+
+  // Synthetic books whose ISBNs are drawn at random from half as many as
+  // there are records, so the input is unsorted and about half the records
+  // are duplicates to drop.
+  const std::string input = (directory / "generate_storage_csv.unsorted").string();
+  const std::string output = (directory / "generate_storage_csv.sorted").string();
+  {
+    std::clog << "  writing " << (inputBytes >> 20) << " MiB of synthetic books ... ";
+    Timer timer{"finished in ", std::clog};
+    const std::size_t estimate = inputBytes / 90;
+    std::default_random_engine random(std::random_device{}());
+    std::uniform_int_distribution<std::size_t> isbn(0, std::max<std::size_t>(estimate / 2, 1));
+    benchmark::write_synthetic_database(input, seed, inputBytes, [&](std::size_t) { return isbn(random); });
+  }
+
+  for (std::size_t divisor : {10, 40, 160}) {
+    ExternalSortOptions options;
+    options.memory_budget = std::max<std::size_t>(inputBytes / divisor, 64 << 10);
+    options.temporary_directory = directory.string();
+    const ExternalSortStatistics statistics = external_sort_books(input, output, options);
+    std::cout << statistics.bytes_read << ',' << options.memory_budget << ',' << statistics.records_read << ','
+              << statistics.records_written << ',' << statistics.runs << ',' << statistics.merge_passes << ','
+              << statistics.bytes_spilled << ',' << statistics.seconds << ','
+              << statistics.bytes_read / statistics.seconds / (1 << 20) << ','
+              << static_cast<long long>(statistics.records_read / statistics.seconds) << '\n';
+  }
+  std::filesystem::remove(input);
+  std::filesystem::remove(output);
+}
+
+//
+// RANGE MODE
+//
+
+// Times "scan(i)", which returns the number of books it visited, for i in
+// [0, count), and prints the row.
+void measureScans(const std::string& structureName, const std::string& queryName, std::size_t count,
+                  const std::function<std::size_t(std::size_t)>& scan) {
+  std::size_t books = 0;
+  const Timing timing = time_operations(count, [&](std::size_t i) { books += scan(i); });
+  std::cout << structureName << ',' << queryName << ',' << count << ','
+            << (count > 0 ? static_cast<double>(books) / count : 0.0) << ','
+            << static_cast<long long>(benchmark::per_second(books, timing.elapsed)) << ','
+            << static_cast<long long>(timing.latency.mean) << ',' << timing.latency.p50 << ','
+            << timing.latency.p99 << '\n';
+}
+
+void runRangeMode(const std::vector<std::string>& args) {
+  std::cout << "Structure,Query,Queries,Books per query,Throughput (books/s),"
+               "Mean latency (ns),p50 latency (ns),p99 latency (ns)\n";
+  const std::vector<Book> books = load_books_mapped(args[0]);
+  std::vector<std::size_t> widths;
+  for (std::size_t i = 1; i < args.size(); ++i) widths.push_back(std::stoul(args[i]));
+  if (widths.empty()) widths = {1, 10, 100, 1000, 10000};
+
+  std::map<std::string, Book> map;
+  for (const Book& book : books) map.insert_or_assign(book.isbn(), book);
+  std::vector<Book> unsorted;
+  BookSkipList skipList;
+  for (const auto& [isbn, book] : map) {
+    unsorted.push_back(book);
+    skipList.insert_or_assign(isbn, book);
+  }
+  std::vector<Book> sorted = unsorted;
+  sort_by_isbn(sorted);
+  std::default_random_engine random(std::random_device{}());
+  std::shuffle(unsorted.begin(), unsorted.end(), random);
+  if (sorted.empty()) return;
+
+  const std::string path = (std::filesystem::temp_directory_path() / "generate_storage_csv.btree").string();
+  std::filesystem::remove(path);
+  BTreeCatalog btree(path, 1 << 16);
+  {
+    std::clog << "  building B+tree of " << sorted.size() << " books ... ";
+    Timer timer{"finished in ", std::clog};
+    for (const Book& book : sorted) btree.insert(book);
+  }
+
+  // Runs every query of "ranges" against every structure.
+  auto measureAll = [&](const std::string& queryName, const std::vector<IsbnRange>& ranges) {
+    auto sum = [](double& total) { return [&total](const Book& book) { total += book.price(); }; };
+    double total = 0.0;
+    measureScans("std::map", queryName, ranges.size(),
+                 [&](std::size_t i) { return for_each_in_isbn_range(map, ranges[i], sum(total)); });
+    measureScans("Sorted vector", queryName, ranges.size(),
+                 [&](std::size_t i) { return for_each_in_isbn_range(sorted, ranges[i], sum(total)); });
+    measureScans("Skip list", queryName, ranges.size(),
+                 [&](std::size_t i) { return for_each_in_isbn_range(skipList, ranges[i], sum(total)); });
+    measureScans("B+ Tree", queryName, ranges.size(),
+                 [&](std::size_t i) { return for_each_in_isbn_range(btree, ranges[i], sum(total)); });
+    // The unsorted vector sees every book per query, so it runs fewer.
+    const std::size_t fullScans = std::min<std::size_t>(ranges.size(), 100);
+    measureScans("Vector (full scan)", queryName, fullScans, [&](std::size_t i) {
+      std::size_t count = 0;
+      for (const Book& book : unsorted) {
+        if (ranges[i].contains(book.isbn())) {
+          total += book.price();
+          ++count;
+        }
+      }
+      return count;
+    });
+    // Logging the sum keeps the scans from being optimized away.
+    std::clog << "  " << queryName << ": prices found sum to " << total << '\n';
+  };
+
+  // Ranges starting at random books and covering "width" books each, about
+  // a million books' worth of scanning per structure.
+  std::uniform_int_distribution<std::size_t> position(0, sorted.size() - 1);
+  for (std::size_t width : widths) {
+    std::vector<IsbnRange> ranges;
+    const std::size_t queries = std::clamp<std::size_t>((1 << 20) / std::max<std::size_t>(width, 1), 100, 100000);
+    for (std::size_t i = 0; i < queries; ++i) {
+      const std::size_t first = position(random);
+      const std::size_t last = first + width;
+      ranges.push_back(IsbnRange{sorted[first].isbn(),
+                                 last < sorted.size() ? std::optional<std::string>(sorted[last].isbn()) : std::nullopt});
+    }
+    measureAll("Range of " + std::to_string(width), ranges);
+  }
+
+  // Prefixes of random books' ISBNs, so longer prefixes match fewer books,
+  // again up to about a million books per structure.
+  for (std::size_t length = 2; length <= 8; ++length) {
+    std::vector<IsbnRange> ranges;
+    for (std::size_t matched = 0; ranges.size() < 10000 && matched < (1 << 20);) {
+      ranges.push_back(IsbnRange::with_prefix(std::string_view(sorted[position(random)].isbn()).substr(0, length)));
+      matched += for_each_in_isbn_range(sorted, ranges.back(), [](const Book&) {});
+    }
+    measureAll("Prefix of " + std::to_string(length), ranges);
+  }
+
+  std::filesystem::remove(path);
+}
+
+//
+// SHARED MODE
+//
+
+// Memory of the calling process in MiB: resident pages, and its proportional
+// share of them, where a page mapped by n processes counts 1/n.
+struct ResidentMemory {
+  double rss = 0.0;
+  double pss = 0.0;
+};
+
+ResidentMemory residentMemory() {
+  ResidentMemory memory;
+  std::ifstream rollup("/proc/self/smaps_rollup");
+  std::string line;
+  while (std::getline(rollup, line)) {
+    std::istringstream fields(line);
+    std::string field;
+    double kilobytes = 0.0;
+    fields >> field >> kilobytes;
+    if (field == "Rss:") memory.rss = kilobytes / 1024;
+    if (field == "Pss:") memory.pss = kilobytes / 1024;
+  }
+  return memory;
+}
+
+// What each worker process sends back.
+struct WorkerReport {
+  double seconds;                                     // from starting to ready
+  ResidentMemory memory;                              // once ready
+  std::size_t records;
+};
+
+// Forks "processes" workers at once, each running "work" and calling the
+// "ready" function it is given, with the number of records it can answer for,
+// while it still holds everything it loaded. Prints one row for them.
+using Worker = std::function<void(const std::function<void(std::size_t records)>& ready)>;
+
+void runWorkers(const std::string& loaderName, std::size_t processes, const Worker& work) {
+  std::clog << "  starting " << processes << " x " << loaderName << " ... ";
+  Timer timer{"finished in ", std::clog};
+
+  int channel[2];
+  if (::pipe(channel) != 0) throw std::system_error(errno, std::generic_category(), "pipe");
+  for (std::size_t i = 0; i < processes; ++i) {
+    const pid_t child = ::fork();
+    if (child < 0) {
+      const int error = errno;
+      ::close(channel[0]);
+      ::close(channel[1]);
+      while (::wait(nullptr) > 0) {}
+      throw std::system_error(error, std::generic_category(), "fork");
+    }
+    if (child == 0) {
+      ::close(channel[0]);
+      const auto start_time = Clock::now();
+      work([&](std::size_t records) {
+        const WorkerReport report{std::chrono::duration<double>(Clock::now() - start_time).count(),
+                                  residentMemory(), records};
+        // Reports are smaller than PIPE_BUF, so each arrives whole.
+        ::write(channel[1], &report, sizeof report);
+      });
+      ::_exit(0);
+    }
+  }
+  ::close(channel[1]);
+
+  std::vector<WorkerReport> reports;
+  WorkerReport report;
+  while (::read(channel[0], &report, sizeof report) == sizeof report) reports.push_back(report);
+  ::close(channel[0]);
+  while (::wait(nullptr) > 0) {}
+  if (reports.empty()) return;
+
+  double totalSeconds = 0.0, maxSeconds = 0.0, totalRss = 0.0, totalPss = 0.0;
+  for (const WorkerReport& worker : reports) {
+    totalSeconds += worker.seconds;
+    maxSeconds = std::max(maxSeconds, worker.seconds);
+    totalRss += worker.memory.rss;
+    totalPss += worker.memory.pss;
+  }
+  const double count = static_cast<double>(reports.size());
+  std::cout << loaderName << ',' << reports.size() << ',' << reports.front().records << ','
+            << totalSeconds / count * 1000 << ',' << maxSeconds * 1000 << ','
+            << totalRss / count << ',' << totalPss / count << ',' << totalPss << '\n';
+}
+
+void runSharedMode(const std::vector<std::string>& args) {
+  std::cout << "Loader,Processes,Records,Mean ready time (ms),Max ready time (ms),"
+               "Mean RSS (MiB),Mean PSS (MiB),Total PSS (MiB)\n";
+  const std::string& path = args[0];
+  const std::size_t processes = args.size() > 1 ? std::stoul(args[1]) : 8;
+  const std::string name = "/generate_storage_csv." + std::to_string(::getpid());
+
+  // Nothing is loaded in this process, so the workers forked from it start
+  // from as little memory as a freshly started program.
+  {
+    std::clog << "  publishing the shared catalog ... ";
+    Timer timer{"finished in ", std::clog};
+    // std::cerr flushes std::cout, so a child reporting an error would
+    // print the rows buffered before the fork a second time.
+    std::cout.flush();
+    const pid_t child = ::fork();
+    if (child < 0) throw std::system_error(errno, std::generic_category(), "fork");
+    if (child == 0) {
+      try {
+        publish_shared_catalog(name, load_books_mapped(path));
+      } catch (const std::exception& error) {
+        std::cerr << error.what() << '\n';
+        ::_exit(EXIT_FAILURE);
+      }
+      ::_exit(0);
+    }
+    // Without a catalog every attach worker would fail, and its rows go
+    // missing without a word.
+    int status = 0;
+    if (::waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      throw std::runtime_error("could not publish the shared catalog " + name);
+    }
+  }
+
+  runWorkers("SampleData (istream operator>>)", processes, [&](const auto& ready) {
+    std::ifstream file(path);
+    const std::vector<Book> books = benchmark::load_books(file);
+    ready(books.size());
+  });
+  runWorkers("SampleData and std::unordered_map by ISBN", processes, [&](const auto& ready) {
+    std::ifstream file(path);
+    std::unordered_map<std::string, Book> table;
+    for (Book& book : benchmark::load_books(file)) table.insert_or_assign(book.isbn(), std::move(book));
+    ready(table.size());
+  });
+  runWorkers("SharedCatalog attach", processes, [&](const auto& ready) {
+    const SharedCatalog catalog = SharedCatalog::attach(name);
+    ready(catalog.size());
+  });
+  runWorkers("SharedCatalog attach and find every ISBN", processes, [&](const auto& ready) {
+    const SharedCatalog catalog = SharedCatalog::attach(name);
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < catalog.size(); ++i) found += catalog.contains(catalog.record(i).isbn());
+    ready(found);
+  });
+
+  remove_shared_catalog(name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const std::map<std::string, std::function<void(const std::vector<std::string>&)>> modes{
+      {"btree", runBTreeMode},
+      {"lsm", runLsmMode},
+      {"wal", runWalMode},
+      {"compressed", runCompressedMode},
+      {"sort", runSortMode},
+      {"shared", runSharedMode},
+      {"range", runRangeMode},
+  };
+
+  if (argc < 3 || modes.count(argv[1]) == 0) {
+    std::cerr << "Usage: " << argv[0] << " <mode> <database.dat> [mode arguments]\n"
+              << "Modes:";
+    for (const auto& [name, run] : modes) std::cerr << ' ' << name;
+    std::cerr << '\n';
+    return EXIT_FAILURE;
+  }
+
+  Timer totalElapsedTime{"Timer:  total elapsed time is ", std::clog};
+  try {
+    modes.at(argv[1])(std::vector<std::string>(argv + 2, argv + argc));
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
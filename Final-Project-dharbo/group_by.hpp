@@ -0,0 +1,309 @@
+#ifndef _group_by_hpp_
+#define _group_by_hpp_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "book.hpp"
+#include "price_index.hpp"
+#include "thread_pool.hpp"
+
+// Per-author price statistics over a whole catalog (how many books each
+// author has, and their total and average price) computed by a hash
+// aggregation spread over several threads.
+//
+// The aggregation runs in two phases, with no locks and no shared writes:
+//
+//   1. Each thread takes an even slice of the books and sums them into
+//      thread-local tables, one per partition of the keys: the top bits of
+//      a key's hash pick its partition.
+//   2. Each thread takes whole partitions and merges every thread's partial
+//      table for that partition into one. A key's partials are all in the
+//      same partition, so no two threads ever touch the same group.
+//
+// There are several partitions per thread, so that the merges even out
+// when the groups do not. The tables use open addressing with linear
+// probing and keep each key's hash, so a merge never hashes twice.
+//
+// Groups are keyed either by the author string itself, a string_view into
+// the books, or by a packed 32-bit author number from number_authors(),
+// which encodes the catalog's authors once so that every later grouping
+// hashes and compares integers instead of strings.
+//
+// Usage:
+//
+//   GroupedPrices<std::string_view> by_author = group_by_author(books, 8);
+//   if (const PriceSummary* found = by_author.find("Lillian Too")) std::cout << found->average() << '\n';
+//
+//   AuthorIds ids = number_authors(books);
+//   GroupedPrices<std::uint32_t> by_id = group_by_author_id(books, ids, 8);
+
+// The hash a key is grouped by: the standard hash of a string, and a
+// Fibonacci (multiplicative) hash of a number, whose top bits are as mixed
+// as the partitions need.
+inline std::uint64_t group_hash(std::string_view key) { return std::hash<std::string_view>{}(key); }
+inline std::uint64_t group_hash(std::uint32_t key) { return key * 0x9E3779B97F4A7C15ull; }
+
+// An open-addressing hash table of price summaries by key, which only
+// grows.
+template <class Key>
+class AggregateTable {
+ public:
+  // The summary of "key", whose group_hash() is "hash", empty if new.
+  PriceSummary& at(const Key& key, std::uint64_t hash) {
+    if (2 * (size_ + 1) > slots_.size()) grow();
+    Slot& slot = probe(slots_, key, hash);
+    if (!slot.used) {
+      slot = Slot{key, hash, PriceSummary{}, true};
+      ++size_;
+    }
+    return slot.summary;
+  }
+
+  const PriceSummary* find(const Key& key, std::uint64_t hash) const {
+    if (slots_.empty()) return nullptr;
+    const Slot& slot = probe(slots_, key, hash);
+    return slot.used ? &slot.summary : nullptr;
+  }
+
+  // Calls "visit(key, hash, summary)" for each group.
+  template <class Visit>
+  void for_each(Visit visit) const {
+    for (const Slot& slot : slots_) {
+      if (slot.used) visit(slot.key, slot.hash, slot.summary);
+    }
+  }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  struct Slot {
+    Key key{};
+    std::uint64_t hash = 0;
+    PriceSummary summary;
+    bool used = false;
+  };
+
+  // The slot holding "key", or the empty slot it would go in.
+  template <class Slots>
+  static auto& probe(Slots& slots, const Key& key, std::uint64_t hash) {
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+      if (!slots[i].used || (slots[i].hash == hash && slots[i].key == key)) return slots[i];
+    }
+  }
+
+  void grow() {
+    std::vector<Slot> slots(std::max<std::size_t>(16, 2 * slots_.size()));
+    for (Slot& slot : slots_) {
+      if (slot.used) probe(slots, slot.key, slot.hash) = std::move(slot);
+    }
+    slots_ = std::move(slots);
+  }
+
+  std::vector<Slot> slots_;                           // a power of two of them, at most half used
+  std::size_t size_ = 0;
+};
+
+// The groups of a grouping, by key.
+template <class Key>
+class GroupedPrices {
+ public:
+  explicit GroupedPrices(std::vector<AggregateTable<Key>> partitions) : partitions_(std::move(partitions)) {}
+
+  // The summary of the books with "key", or null if there are none.
+  const PriceSummary* find(const Key& key) const {
+    const std::uint64_t hash = group_hash(key);
+    return partitions_[partition_of(hash, partitions_.size())].find(key, hash);
+  }
+
+  // Calls "visit(key, summary)" for each group, in no particular order.
+  template <class Visit>
+  void for_each(Visit visit) const {
+    for (const AggregateTable<Key>& partition : partitions_) {
+      partition.for_each([&](const Key& key, std::uint64_t, const PriceSummary& summary) { visit(key, summary); });
+    }
+  }
+
+  // The number of groups.
+  std::size_t size() const {
+    std::size_t groups = 0;
+    for (const AggregateTable<Key>& partition : partitions_) groups += partition.size();
+    return groups;
+  }
+
+  // The partition a hash belongs to, by its top 16 bits.
+  static std::size_t partition_of(std::uint64_t hash, std::size_t partitions) { return (hash >> 48) % partitions; }
+
+ private:
+  std::vector<AggregateTable<Key>> partitions_;
+};
+
+// Groups "records" records by "key_of(i)" and sums "price_of(i)" for each,
+// on exactly "thread_count" threads. When 0, it picks one per hardware
+// thread, but no more than the records keep busy.
+template <class Key, class KeyOf, class PriceOf>
+GroupedPrices<Key> group_prices(std::size_t records, KeyOf key_of, PriceOf price_of, std::size_t thread_count = 0) {
+  // Below this many records per thread, starting the thread costs more than
+  // it saves.
+  constexpr std::size_t MIN_RECORDS_PER_THREAD = 4096;
+  constexpr std::size_t PARTITIONS_PER_THREAD = 4;
+
+  if (thread_count == 0) {
+    thread_count = std::clamp<std::size_t>(records / MIN_RECORDS_PER_THREAD, 1,
+                                           std::max(1u, std::thread::hardware_concurrency()));
+  }
+  const std::size_t partitions = thread_count == 1 ? 1 : thread_count * PARTITIONS_PER_THREAD;
+
+  auto aggregate = [&](std::size_t begin, std::size_t end) {
+    std::vector<AggregateTable<Key>> tables(partitions);
+    for (std::size_t i = begin; i < end; ++i) {
+      const Key key = key_of(i);
+      const std::uint64_t hash = group_hash(key);
+      PriceSummary& summary = tables[GroupedPrices<Key>::partition_of(hash, partitions)].at(key, hash);
+      ++summary.count;
+      summary.sum += price_of(i);
+    }
+    return tables;
+  };
+  if (thread_count == 1) {
+    return GroupedPrices<Key>(aggregate(0, records));
+  }
+
+  ThreadPool pool(thread_count);
+
+  // Phase 1: thread-local partials, by partition.
+  std::vector<std::future<std::vector<AggregateTable<Key>>>> pending;
+  for (std::size_t thread = 0; thread < thread_count; ++thread) {
+    pending.push_back(pool.submit([&, thread] {
+      const std::size_t begin = records * thread / thread_count;
+      const std::size_t end = records * (thread + 1) / thread_count;
+      return aggregate(begin, end);
+    }));
+  }
+  std::vector<std::vector<AggregateTable<Key>>> partials;
+  for (auto& future : pending) partials.push_back(future.get());
+
+  // Phase 2: each partition's partials merged into the first thread's.
+  std::vector<std::future<void>> merges;
+  for (std::size_t partition = 0; partition < partitions; ++partition) {
+    merges.push_back(pool.submit([&, partition] {
+      AggregateTable<Key>& merged = partials[0][partition];
+      for (std::size_t thread = 1; thread < thread_count; ++thread) {
+        partials[thread][partition].for_each([&](const Key& key, std::uint64_t hash, const PriceSummary& partial) {
+          PriceSummary& summary = merged.at(key, hash);
+          summary.count += partial.count;
+          summary.sum += partial.sum;
+        });
+        partials[thread][partition] = AggregateTable<Key>();
+      }
+    }));
+  }
+  for (auto& future : merges) future.get();
+  return GroupedPrices<Key>(std::move(partials[0]));
+}
+
+// Each book's author, grouped by the author string. The books must outlive
+// the result, whose keys view their authors.
+template <class Record>
+GroupedPrices<std::string_view> group_by_author(const std::vector<Record>& books, std::size_t thread_count = 0) {
+  return group_prices<std::string_view>(
+      books.size(), [&](std::size_t i) { return std::string_view(books[i].author()); },
+      [&](std::size_t i) { return books[i].price(); }, thread_count);
+}
+
+// The authors of a catalog numbered densely in order of first appearance:
+// each book's author number, and each number's author.
+struct AuthorIds {
+  std::vector<std::uint32_t> ids;
+  std::vector<std::string_view> authors;
+};
+
+// Numbers the authors of "books", which must outlive the result.
+template <class Record>
+AuthorIds number_authors(const std::vector<Record>& books) {
+  AuthorIds numbered;
+  std::unordered_map<std::string_view, std::uint32_t> numbers;
+  numbered.ids.reserve(books.size());
+  for (const Record& book : books) {
+    const std::string_view author = book.author();
+    auto [number, added] = numbers.try_emplace(author, static_cast<std::uint32_t>(numbered.authors.size()));
+    if (added) numbered.authors.push_back(author);
+    numbered.ids.push_back(number->second);
+  }
+  return numbered;
+}
+
+// Each book's author, grouped by its number in "ids", which number_authors()
+// made from the same books.
+template <class Record>
+GroupedPrices<std::uint32_t> group_by_author_id(const std::vector<Record>& books, const AuthorIds& ids,
+                                                std::size_t thread_count = 0) {
+  return group_prices<std::uint32_t>(
+      books.size(), [&](std::size_t i) { return ids.ids[i]; }, [&](std::size_t i) { return books[i].price(); },
+      thread_count);
+}
+
+//
+// GROUP BY OPERATIONS
+//
+
+template <class Record = Book>
+struct group_vector_by_author {
+  // Function takes no parameters, groups the books of a vector by author on
+  // the target number of threads, and returns each author's count, sum, and
+  // average price.
+  GroupedPrices<std::string_view> operator()(const Record& unused) { return group_by_author(my_vector, thread_count); }
+
+  const std::vector<Record>& my_vector;
+  const std::size_t thread_count;
+};
+template <class Record>
+group_vector_by_author(const std::vector<Record>&, std::size_t) -> group_vector_by_author<Record>;
+
+template <class Record = Book>
+struct group_vector_by_author_id {
+  // Function takes no parameters, groups the books of a vector by their
+  // authors' numbers on the target number of threads, and returns each
+  // number's count, sum, and average price.
+  GroupedPrices<std::uint32_t> operator()(const Record& unused) {
+    return group_by_author_id(my_vector, my_ids, thread_count);
+  }
+
+  const std::vector<Record>& my_vector;
+  const AuthorIds& my_ids;
+  const std::size_t thread_count;
+};
+template <class Record>
+group_vector_by_author_id(const std::vector<Record>&, const AuthorIds&, std::size_t) -> group_vector_by_author_id<Record>;
+
+template <class Record = Book>
+struct group_vector_by_author_serially {
+  // Function takes no parameters, groups the books of a vector by author
+  // into a std::unordered_map of author copies on one thread, and returns
+  // it.
+  std::unordered_map<std::string, PriceSummary> operator()(const Record& unused) {
+    std::unordered_map<std::string, PriceSummary> groups;
+    for (const Record& book : my_vector) {
+      PriceSummary& summary = groups[std::string(book.author())];
+      ++summary.count;
+      summary.sum += book.price();
+    }
+    return groups;
+  }
+
+  const std::vector<Record>& my_vector;
+};
+template <class Record>
+group_vector_by_author_serially(const std::vector<Record>&) -> group_vector_by_author_serially<Record>;
+
+#endif
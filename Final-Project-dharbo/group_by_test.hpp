@@ -0,0 +1,90 @@
+#ifndef _group_by_test_hpp_
+#define _group_by_test_hpp_
+
+#include "group_by.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "book.hpp"
+#include "book_view.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("GroupBy") {
+  const Book unused;
+
+  SUBCASE("Empty") {
+    const std::vector<Book> books;
+    CHECK_EQ(group_by_author(books, 4).size(), 0);
+    CHECK_EQ(group_by_author(books, 4).find("anyone"), nullptr);
+    const AuthorIds ids = number_authors(books);
+    CHECK_EQ(group_by_author_id(books, ids).size(), 0);
+  }
+
+  SUBCASE("SmallCatalog") {
+    const std::vector<Book> books = {Book("a", "Lillian Too", "1", 21.03), Book("b", "Geoffrey Hull", "2", 62.06),
+                                     Book("c", "Lillian Too", "3", 10.97)};
+    const GroupedPrices<std::string_view> groups = group_vector_by_author{books, 2}(unused);
+    CHECK_EQ(groups.size(), 2);
+    REQUIRE_NE(groups.find("Lillian Too"), nullptr);
+    CHECK_EQ(groups.find("Lillian Too")->count, 2);
+    CHECK_EQ(groups.find("Lillian Too")->average(), doctest::Approx(16.0));
+    CHECK_EQ(groups.find("Nobody"), nullptr);
+
+    const AuthorIds ids = number_authors(books);
+    CHECK_EQ(ids.ids, std::vector<std::uint32_t>{0, 1, 0});
+    CHECK_EQ(ids.authors, std::vector<std::string_view>{"Lillian Too", "Geoffrey Hull"});
+    const GroupedPrices<std::uint32_t> by_id = group_vector_by_author_id{books, ids, 2}(unused);
+    REQUIRE_NE(by_id.find(1), nullptr);
+    CHECK_EQ(by_id.find(1)->sum, doctest::Approx(62.06));
+  }
+
+  SUBCASE("MatchesASerialGroupingOnAnyThreadCount") {
+    // Skewed authors: half the books by 10 authors, the rest spread over
+    // thousands, in views of strings that outlive them.
+    std::default_random_engine random(50);
+    std::uniform_int_distribution<std::size_t> common(0, 9);
+    std::uniform_int_distribution<std::size_t> rare(10, 20000);
+    std::uniform_int_distribution<int> cents(0, 10000);
+    std::vector<std::string> authors;
+    for (std::size_t i = 0; i <= 20000; ++i) authors.push_back("Author " + std::to_string(i));
+    std::vector<BookView> books;
+    for (std::size_t i = 0; i < 60000; ++i) {
+      const std::string& author = authors[i % 2 == 0 ? common(random) : rare(random)];
+      books.emplace_back("title", author, "isbn", cents(random) / 100.0);
+    }
+    const std::unordered_map<std::string, PriceSummary> expected = group_vector_by_author_serially{books}(BookView());
+    const AuthorIds ids = number_authors(books);
+    CHECK_EQ(ids.authors.size(), expected.size());
+
+    for (std::size_t threads : {1, 2, 3, 8}) {
+      const GroupedPrices<std::string_view> groups = group_by_author(books, threads);
+      const GroupedPrices<std::uint32_t> by_id = group_by_author_id(books, ids, threads);
+      CHECK_EQ(groups.size(), expected.size());
+      CHECK_EQ(by_id.size(), expected.size());
+      // Sums may differ in the last bits with the order they were added in.
+      auto differs = [](const PriceSummary& lhs, const PriceSummary& rhs) {
+        return lhs.count != rhs.count || std::abs(lhs.sum - rhs.sum) > 1e-6 * rhs.sum;
+      };
+      std::size_t total = 0;
+      std::size_t mismatched = 0;
+      groups.for_each([&](std::string_view author, const PriceSummary& summary) {
+        total += summary.count;
+        mismatched += differs(summary, expected.at(std::string(author)));
+      });
+      by_id.for_each([&](std::uint32_t id, const PriceSummary& summary) {
+        mismatched += differs(summary, expected.at(std::string(ids.authors[id])));
+      });
+      CHECK_EQ(total, books.size());
+      CHECK_EQ(mismatched, 0);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,230 @@
+#include "isbn_index.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "book.hpp"
+#include "book_loader.hpp"
+#include "book_snapshot.hpp"
+#include "mapped_file.hpp"
+
+namespace {
+
+constexpr std::size_t SLOTS_OFFSET = 64;              // the header, padded to a cache line
+
+static_assert(sizeof(IsbnIndexHeader) <= SLOTS_OFFSET, "header must fit before the slots");
+
+// Reads the ISBN of the record a slot points at, from either kind of
+// database.
+class IsbnReader {
+ public:
+  IsbnReader(const MappedFile& text, const BookSnapshot* snapshot)
+      : first_(text.data()), last_(text.data() + text.size()), snapshot_(snapshot) {}
+
+  // Whether "offset" can point at a record.
+  bool valid(std::uint64_t offset) const {
+    return snapshot_ != nullptr ? offset < snapshot_->size()
+                                : offset < static_cast<std::uint64_t>(last_ - first_);
+  }
+
+  // The record at "offset", unless it cannot be parsed.
+  std::optional<RawBookRecord> record(std::uint64_t offset) const {
+    if (snapshot_ != nullptr) {
+      return snapshot_->record(offset);
+    }
+    RawBookRecord record;
+    if (parse_book_record(first_ + offset, last_, record) == nullptr) {
+      return std::nullopt;
+    }
+    return record;
+  }
+
+  bool isbn_equals(std::uint64_t offset, std::string_view isbn) const {
+    const std::optional<RawBookRecord> found = record(offset);
+    if (!found) {
+      return false;
+    }
+    return found->escaped ? unescape_book_field(found->isbn) == isbn
+                          : found->isbn == isbn;
+  }
+
+ private:
+  const char* first_;
+  const char* last_;
+  const BookSnapshot* snapshot_;
+};
+
+bool is_snapshot(const MappedFile& file) {
+  return file.size() >= sizeof SnapshotHeader::MAGIC &&
+         std::memcmp(file.data(), SnapshotHeader::MAGIC, sizeof SnapshotHeader::MAGIC) == 0;
+}
+
+std::uint64_t slot_count_for(std::size_t records) {
+  std::uint64_t count = 8;
+  while (count < 2 * static_cast<std::uint64_t>(records)) {
+    count *= 2;
+  }
+  return count;
+}
+
+[[noreturn]] void reject(const std::string& path, const std::string& reason) {
+  throw std::runtime_error(path + " is not a usable ISBN index: " + reason);
+}
+
+}  // namespace
+
+//
+// Writing
+//
+
+std::size_t write_isbn_index(const std::string& database_path,
+                             const std::string& index_path) {
+  MappedFile text(database_path);
+  std::optional<BookSnapshot> snapshot;
+  IsbnIndexHeader header{};
+  std::memcpy(header.magic, IsbnIndexHeader::MAGIC, sizeof header.magic);
+  header.version = IsbnIndexHeader::VERSION;
+  header.byte_order = IsbnIndexHeader::BYTE_ORDER_MARK;
+  header.source_size = text.size();
+
+  // Every record's hash and location, in file order.
+  std::vector<IsbnIndexSlot> records;
+  if (is_snapshot(text)) {
+    header.source = IsbnIndexHeader::SNAPSHOT;
+    snapshot.emplace(database_path);
+    text = MappedFile();
+    records.reserve(snapshot->size());
+    for (std::size_t i = 0; i < snapshot->size(); ++i) {
+      records.push_back({isbn_hash(snapshot->isbn(i)), i});
+    }
+  } else {
+    header.source = IsbnIndexHeader::TEXT;
+    text.advise_sequential();
+    const char* first = text.data();
+    const char* last = first + text.size();
+    RawBookRecord record;
+    for (const char* cursor = first; const char* next = parse_book_record(cursor, last, record);
+         cursor = next) {
+      const std::uint64_t hash = record.escaped ? isbn_hash(unescape_book_field(record.isbn))
+                                                : isbn_hash(record.isbn);
+      records.push_back({hash, static_cast<std::uint64_t>(cursor - first)});
+    }
+  }
+
+  // Later records replace earlier ones with the same ISBN.
+  const IsbnReader reader(text, snapshot ? &*snapshot : nullptr);
+  header.slot_count = slot_count_for(records.size());
+  const std::uint64_t mask = header.slot_count - 1;
+  std::vector<IsbnIndexSlot> slots(header.slot_count, IsbnIndexSlot{0, 0});
+  for (const IsbnIndexSlot& entry : records) {
+    for (std::uint64_t i = entry.hash & mask;; i = (i + 1) & mask) {
+      IsbnIndexSlot& slot = slots[i];
+      if (slot.hash == 0) {
+        slot = entry;
+        ++header.record_count;
+        break;
+      }
+      if (slot.hash == entry.hash) {
+        const std::optional<RawBookRecord> record = reader.record(entry.offset);
+        const std::string isbn = record->escaped ? unescape_book_field(record->isbn)
+                                                 : std::string(record->isbn);
+        if (reader.isbn_equals(slot.offset, isbn)) {
+          slot.offset = entry.offset;
+          break;
+        }
+      }
+    }
+  }
+
+  std::ofstream file(index_path, std::ios::binary | std::ios::trunc);
+  char padded_header[SLOTS_OFFSET] = {};
+  std::memcpy(padded_header, &header, sizeof header);
+  file.write(padded_header, sizeof padded_header);
+  file.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(IsbnIndexSlot));
+  file.flush();
+  if (!file) {
+    throw std::system_error(errno, std::generic_category(), "write " + index_path);
+  }
+  return header.record_count;
+}
+
+//
+// Reading
+//
+
+IsbnIndex::IsbnIndex(const std::string& database_path, const std::string& index_path)
+    : index_(index_path) {
+  IsbnIndexHeader header;
+  if (index_.size() < SLOTS_OFFSET) {
+    reject(index_path, "too short for a header");
+  }
+  std::memcpy(&header, index_.data(), sizeof header);
+  if (std::memcmp(header.magic, IsbnIndexHeader::MAGIC, sizeof header.magic) != 0) {
+    reject(index_path, "bad magic number");
+  }
+  if (header.version != IsbnIndexHeader::VERSION) {
+    reject(index_path, "unsupported version " + std::to_string(header.version));
+  }
+  if (header.byte_order != IsbnIndexHeader::BYTE_ORDER_MARK) {
+    reject(index_path, "written with a different byte order");
+  }
+  if (header.slot_count == 0 || (header.slot_count & (header.slot_count - 1)) != 0 ||
+      header.record_count >= header.slot_count ||
+      header.slot_count > (index_.size() - SLOTS_OFFSET) / sizeof(IsbnIndexSlot) ||
+      index_.size() != SLOTS_OFFSET + header.slot_count * sizeof(IsbnIndexSlot)) {
+    reject(index_path, "slot table out of bounds");
+  }
+
+  if (header.source == IsbnIndexHeader::SNAPSHOT) {
+    snapshot_.emplace(database_path);
+    if (std::filesystem::file_size(database_path) != header.source_size) {
+      reject(index_path, "built from a different version of " + database_path);
+    }
+  } else if (header.source == IsbnIndexHeader::TEXT) {
+    text_ = MappedFile(database_path);
+    if (text_.size() != header.source_size) {
+      reject(index_path, "built from a different version of " + database_path);
+    }
+  } else {
+    reject(index_path, "unknown database kind");
+  }
+
+  record_count_ = header.record_count;
+  slot_mask_ = header.slot_count - 1;
+  slots_ = reinterpret_cast<const IsbnIndexSlot*>(index_.data() + SLOTS_OFFSET);
+}
+
+const IsbnIndexSlot* IsbnIndex::locate(std::string_view isbn) const {
+  const IsbnReader reader(text_, snapshot_ ? &*snapshot_ : nullptr);
+  const std::uint64_t hash = isbn_hash(isbn);
+  // At most every slot is probed, so a damaged table cannot loop forever.
+  std::uint64_t i = hash & slot_mask_;
+  for (std::uint64_t probes = 0; probes <= slot_mask_; ++probes, i = (i + 1) & slot_mask_) {
+    const IsbnIndexSlot& slot = slots_[i];
+    if (slot.hash == 0) {
+      return nullptr;
+    }
+    if (slot.hash == hash && reader.valid(slot.offset) && reader.isbn_equals(slot.offset, isbn)) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+std::optional<Book> IsbnIndex::find(std::string_view isbn) const {
+  const IsbnIndexSlot* slot = locate(isbn);
+  if (slot == nullptr) {
+    return std::nullopt;
+  }
+  const IsbnReader reader(text_, snapshot_ ? &*snapshot_ : nullptr);
+  return to_book(*reader.record(slot->offset));
+}
@@ -0,0 +1,115 @@
+#ifndef _isbn_index_hpp_
+#define _isbn_index_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "book.hpp"
+#include "book_snapshot.hpp"
+#include "mapped_file.hpp"
+
+// A persisted ISBN index: an open-addressing hash table written to a sidecar
+// file next to a text database or a snapshot, so that a lookup maps the file
+// and probes it directly instead of building a std::unordered_map at startup.
+//
+// Layout (native byte order):
+//
+//   IsbnIndexHeader       padded to 64 bytes
+//   slots                 slot_count IsbnIndexSlots, slot_count a power of two
+//
+// A slot holds the 64-bit FNV-1a hash of an ISBN and where its record is: the
+// byte offset of the record in a text database, or the record number in a
+// snapshot. Hash 0 marks an empty slot. The table is at most half full and
+// probed linearly, and a hash match is confirmed by reading the ISBN back out
+// of the database, so hash collisions never return the wrong book.
+//
+// If an ISBN appears more than once in the database, the index points at its
+// last record, as inserting every book into a hash table would.
+
+struct IsbnIndexHeader {
+  static constexpr char MAGIC[8] = {'I', 'S', 'B', 'N', 'I', 'N', 'D', 'X'};
+  static constexpr std::uint32_t VERSION = 1;
+  static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+  // What a slot's offset refers to.
+  enum Source : std::uint32_t { TEXT = 0, SNAPSHOT = 1 };
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint32_t source;
+  std::uint32_t reserved;
+  std::uint64_t source_size;                          // bytes in the indexed database, to catch stale indexes
+  std::uint64_t record_count;                         // distinct ISBNs
+  std::uint64_t slot_count;
+};
+
+struct IsbnIndexSlot {
+  std::uint64_t hash;
+  std::uint64_t offset;
+};
+
+// The hash stored in the index: 64-bit FNV-1a, never 0.
+inline std::uint64_t isbn_hash(std::string_view isbn) {
+  std::uint64_t hash = 0xcbf29ce484222325;
+  for (unsigned char c : isbn) {
+    hash = (hash ^ c) * 0x100000001b3;
+  }
+  return hash != 0 ? hash : 1;
+}
+
+// The index path used when none is given: the database path plus ".idx".
+inline std::string isbn_index_path(const std::string& database_path) {
+  return database_path + ".idx";
+}
+
+// Indexes the text database or snapshot at "database_path" (a snapshot is
+// recognized by its magic number) and writes the index to "index_path".
+// Returns the number of distinct ISBNs indexed. Throws std::system_error if a
+// file cannot be read or written.
+std::size_t write_isbn_index(const std::string& database_path,
+                             const std::string& index_path);
+
+// A database opened together with its index. Opening maps both files and
+// checks the header; nothing is read or built until the first lookup.
+//
+// Usage:
+//
+//   write_isbn_index("database-large.dat", "database-large.dat.idx");    // once
+//
+//   const IsbnIndex index("database-large.dat", "database-large.dat.idx");
+//   std::optional<Book> book = index.find("9780131103627");
+class IsbnIndex {
+ public:
+  // Throws std::system_error if a file cannot be mapped, and
+  // std::runtime_error if the index is not valid or was not built from this
+  // database.
+  IsbnIndex(const std::string& database_path, const std::string& index_path);
+  explicit IsbnIndex(const std::string& database_path)
+      : IsbnIndex(database_path, isbn_index_path(database_path)) {}
+
+  // Distinct ISBNs in the index.
+  std::size_t size() const { return record_count_; }
+  bool empty() const { return record_count_ == 0; }
+
+  // The book with ISBN "isbn", if the database has one.
+  std::optional<Book> find(std::string_view isbn) const;
+
+  bool contains(std::string_view isbn) const { return locate(isbn) != nullptr; }
+
+ private:
+  // The slot of "isbn", or nullptr.
+  const IsbnIndexSlot* locate(std::string_view isbn) const;
+
+  MappedFile index_;
+  MappedFile text_;                                   // the database, when it is text
+  std::optional<BookSnapshot> snapshot_;              // the database, when it is a snapshot
+  std::size_t record_count_ = 0;
+  std::uint64_t slot_mask_ = 0;
+  const IsbnIndexSlot* slots_ = nullptr;
+};
+
+#endif
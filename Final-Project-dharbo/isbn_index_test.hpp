@@ -0,0 +1,100 @@
+#ifndef _isbn_index_test_hpp_
+#define _isbn_index_test_hpp_
+
+#include "isbn_index.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "book.hpp"
+#include "book_snapshot.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("IsbnIndex") {
+  const std::filesystem::path database =
+      std::filesystem::temp_directory_path() / "isbn_index_test.dat";
+  const std::filesystem::path index =
+      std::filesystem::temp_directory_path() / "isbn_index_test.dat.idx";
+  const std::vector<Book> books = {
+      Book("title", "author", "isbn", 123.45),
+      Book("other, title", "other \"author\"", "0123456789012", 543.21),
+      Book("escaped", "isbn", "12\"34", 1.0),
+      Book("newer title", "author", "isbn", 9.99)};        // replaces books[0]
+  auto write_database = [&](const std::vector<Book>& contents) {
+    std::ofstream file(database);
+    for (const Book& book : contents) file << book;
+  };
+
+  SUBCASE("FindsTextRecords") {
+    write_database(books);
+    CHECK_EQ(write_isbn_index(database.string(), index.string()), 3);
+    const IsbnIndex lookup(database.string(), index.string());
+    CHECK_EQ(lookup.size(), 3);
+    CHECK_EQ(lookup.find("isbn"), books[3]);
+    CHECK_EQ(lookup.find("0123456789012"), books[1]);
+    CHECK_EQ(lookup.find("12\"34"), books[2]);
+    CHECK_EQ(lookup.find("missing"), std::nullopt);
+    CHECK_FALSE(lookup.contains(""));
+  }
+
+  SUBCASE("FindsSnapshotRecords") {
+    const std::filesystem::path snapshot =
+        std::filesystem::temp_directory_path() / "isbn_index_test.snap";
+    write_book_snapshot(snapshot.string(), books);
+    CHECK_EQ(write_isbn_index(snapshot.string(), index.string()), 3);
+    const IsbnIndex lookup(snapshot.string(), index.string());
+    CHECK_EQ(lookup.find("isbn"), books[3]);
+    CHECK_EQ(lookup.find("12\"34"), books[2]);
+    CHECK_FALSE(lookup.contains("missing"));
+    std::filesystem::remove(snapshot);
+  }
+
+  SUBCASE("ManyRecords") {
+    std::vector<Book> many;
+    for (std::size_t i = 0; i < 5000; ++i) {
+      many.push_back(Book("title", "author", std::to_string(i * 7919), static_cast<double>(i)));
+    }
+    write_database(many);
+    write_isbn_index(database.string(), index.string());
+    const IsbnIndex lookup(database.string());
+    REQUIRE_EQ(lookup.size(), many.size());
+    for (const Book& book : many) {
+      CHECK_EQ(lookup.find(book.isbn()), book);
+    }
+    CHECK_FALSE(lookup.contains("7918"));
+  }
+
+  SUBCASE("EmptyDatabase") {
+    write_database({});
+    CHECK_EQ(write_isbn_index(database.string(), index.string()), 0);
+    const IsbnIndex lookup(database.string(), index.string());
+    CHECK(lookup.empty());
+    CHECK_FALSE(lookup.contains("isbn"));
+  }
+
+  SUBCASE("RejectsStaleAndDamagedIndexes") {
+    write_database(books);
+    write_isbn_index(database.string(), index.string());
+
+    write_database({books[0]});
+    CHECK_THROWS_AS(IsbnIndex(database.string(), index.string()), std::runtime_error);
+
+    write_isbn_index(database.string(), index.string());
+    std::filesystem::resize_file(index, std::filesystem::file_size(index) - 16);
+    CHECK_THROWS_AS(IsbnIndex(database.string(), index.string()), std::runtime_error);
+
+    CHECK_THROWS_AS(IsbnIndex(database.string(), database.string()), std::runtime_error);
+  }
+
+  std::filesystem::remove(database);
+  std::filesystem::remove(index);
+  CHECK_THROWS_AS(IsbnIndex(database.string(), index.string()), std::system_error);
+}
+
+#endif
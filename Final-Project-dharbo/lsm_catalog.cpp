@@ -0,0 +1,515 @@
+#include "lsm_catalog.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "book.hpp"
+#include "sorted_run.hpp"
+
+namespace {
+
+constexpr const char* MANIFEST = "MANIFEST";
+
+// Memory a memtable entry takes beyond its encoded size: the map node and
+// the strings' headers, roughly.
+constexpr std::size_t MEMTABLE_OVERHEAD = 160;
+
+std::size_t encoded_size(std::string_view isbn, const std::optional<Book>& value) {
+  std::size_t size = 15 + isbn.size();
+  if (value) size += value->title().size() + value->author().size();
+  return size;
+}
+
+RunEntry to_entry(const std::string& isbn, const std::optional<Book>& value) {
+  RunEntry entry;
+  entry.isbn = isbn;
+  entry.tombstone = !value;
+  if (value) {
+    entry.title = value->title();
+    entry.author = value->author();
+    entry.price = value->price();
+  }
+  return entry;
+}
+
+bool is_sorted_by_key(const std::vector<std::shared_ptr<SortedRun>>& level) {
+  return std::is_sorted(level.begin(), level.end(),
+                        [](const auto& a, const auto& b) { return a->smallest() < b->smallest(); });
+}
+
+}  // namespace
+
+//
+// Constructor and Destructor
+//
+
+LsmCatalog::LsmCatalog(const std::string& directory, LsmOptions options)
+    : directory_(directory),
+      options_(options),
+      memtable_(std::make_unique<Memtable>()),
+      compact_pointer_(MAX_LEVELS) {
+  std::filesystem::create_directories(directory_);
+
+  auto version = std::make_shared<Version>();
+  version->levels.resize(MAX_LEVELS);
+  std::set<std::string> live;
+  std::ifstream manifest(std::filesystem::path(directory_) / MANIFEST);
+  std::string word;
+  while (manifest >> word) {
+    if (word == "next") {
+      manifest >> next_run_number_;
+    } else if (word == "run") {
+      std::size_t level = 0;
+      std::uint64_t number = 0;
+      manifest >> level >> number;
+      if (!manifest || level >= MAX_LEVELS) {
+        throw std::runtime_error(directory_ + ": damaged manifest");
+      }
+      version->levels[level].push_back(std::make_shared<SortedRun>(run_path(number), number));
+      live.insert(run_path(number));
+      next_run_number_ = std::max(next_run_number_, number + 1);
+    }
+  }
+  for (std::size_t level = 1; level < MAX_LEVELS; ++level) {
+    if (!is_sorted_by_key(version->levels[level])) {
+      throw std::runtime_error(directory_ + ": damaged manifest");
+    }
+  }
+
+  // Runs written but never installed (a crash mid-compaction) are garbage.
+  for (const auto& file : std::filesystem::directory_iterator(directory_)) {
+    if (file.path().extension() == ".run" && live.count(file.path().string()) == 0) {
+      std::filesystem::remove(file.path());
+    }
+  }
+
+  version_ = std::move(version);
+  background_ = std::thread([this] { background_work(); });
+}
+
+LsmCatalog::~LsmCatalog() noexcept {
+  try {
+    {
+      std::unique_lock lock(mutex_);
+      work_done_.wait(lock, [this] { return !immutable_ || background_error_; });
+      if (!memtable_->empty() && !background_error_) {
+        immutable_ = std::move(memtable_);
+        memtable_ = std::make_unique<Memtable>();
+      }
+      stopping_ = true;
+    }
+    work_ready_.notify_all();
+    background_.join();
+    write_manifest(*version_, next_run_number_);
+  } catch (...) {
+  }
+}
+
+//
+// Modifiers
+//
+
+void LsmCatalog::insert(const Book& book) {
+  constexpr std::size_t LIMIT = std::numeric_limits<std::uint16_t>::max();
+  if (book.isbn().size() > LIMIT || book.title().size() > LIMIT || book.author().size() > LIMIT) {
+    throw std::length_error("book " + book.isbn().substr(0, 32) + " has a field too long for a sorted run");
+  }
+  write(book.isbn(), book);
+}
+
+void LsmCatalog::remove(std::string_view isbn) {
+  write(isbn, std::nullopt);
+}
+
+void LsmCatalog::write(std::string_view isbn, std::optional<Book> value) {
+  const std::size_t size = encoded_size(isbn, value);
+  std::unique_lock lock(mutex_);
+  make_room(lock);
+  bytes_ingested_ += size;
+  memtable_bytes_ += size + MEMTABLE_OVERHEAD;
+  const auto existing = memtable_->find(isbn);
+  if (existing != memtable_->end()) {
+    existing->second = std::move(value);
+  } else {
+    memtable_->emplace(std::string(isbn), std::move(value));
+  }
+}
+
+void LsmCatalog::make_room(std::unique_lock<std::mutex>& lock) {
+  for (;;) {
+    if (background_error_) {
+      std::rethrow_exception(background_error_);
+    }
+    if (memtable_bytes_ < options_.memtable_bytes) {
+      return;
+    }
+    // Wait for the previous memtable to reach the disk, and for compaction to
+    // catch up if level 0 has piled up.
+    if (immutable_ || version_->levels[0].size() >= LEVEL0_STOP_TRIGGER) {
+      work_done_.wait(lock);
+      continue;
+    }
+    immutable_ = std::move(memtable_);
+    memtable_ = std::make_unique<Memtable>();
+    memtable_bytes_ = 0;
+    work_ready_.notify_one();
+    return;
+  }
+}
+
+void LsmCatalog::flush() {
+  std::unique_lock lock(mutex_);
+  work_done_.wait(lock, [this] { return !immutable_ || background_error_; });
+  if (!memtable_->empty() && !background_error_) {
+    immutable_ = std::move(memtable_);
+    memtable_ = std::make_unique<Memtable>();
+    memtable_bytes_ = 0;
+    work_ready_.notify_one();
+  }
+  work_done_.wait(lock, [this] { return !immutable_ || background_error_; });
+  if (background_error_) {
+    std::rethrow_exception(background_error_);
+  }
+}
+
+void LsmCatalog::wait_for_compaction() {
+  std::unique_lock lock(mutex_);
+  work_done_.wait(lock, [this] {
+    return background_error_ || (!immutable_ && !busy_ && pick_compaction() < 0);
+  });
+  if (background_error_) {
+    std::rethrow_exception(background_error_);
+  }
+}
+
+//
+// Queries
+//
+
+std::optional<Book> LsmCatalog::find(std::string_view isbn) const {
+  ++lookups_;
+  std::shared_ptr<const Memtable> immutable;
+  std::shared_ptr<const Version> version;
+  {
+    std::lock_guard lock(mutex_);
+    const auto found = memtable_->find(isbn);
+    if (found != memtable_->end()) {
+      ++memtable_hits_;
+      return found->second;
+    }
+    immutable = immutable_;
+    version = version_;
+  }
+  if (immutable) {
+    const auto found = immutable->find(isbn);
+    if (found != immutable->end()) {
+      ++memtable_hits_;
+      return found->second;
+    }
+  }
+
+  // Newest data first: level 0 newest to oldest, then one run per level.
+  RunEntry entry;
+  std::optional<std::optional<Book>> result;
+  auto probe = [&](const Run& run) {
+    if (!run->overlaps(isbn, isbn)) {
+      return false;
+    }
+    ++runs_probed_;
+    switch (run->find(isbn, entry)) {
+      case SortedRun::Lookup::FILTERED: ++runs_filtered_; return false;
+      case SortedRun::Lookup::ABSENT: return false;
+      case SortedRun::Lookup::REMOVED: result.emplace(std::nullopt); return true;
+      case SortedRun::Lookup::FOUND: result.emplace(entry.book()); return true;
+    }
+    return false;
+  };
+  for (const Run& run : version->levels[0]) {
+    if (probe(run)) return *result;
+  }
+  for (std::size_t level = 1; level < version->levels.size(); ++level) {
+    const auto& runs = version->levels[level];
+    auto after = std::upper_bound(runs.begin(), runs.end(), isbn,
+                                  [](std::string_view key, const Run& run) { return key < run->smallest(); });
+    if (after != runs.begin() && probe(*(after - 1))) return *result;
+  }
+  return std::nullopt;
+}
+
+LsmStatistics LsmCatalog::statistics() const {
+  LsmStatistics statistics;
+  statistics.lookups = lookups_;
+  statistics.memtable_hits = memtable_hits_;
+  statistics.runs_probed = runs_probed_;
+  statistics.runs_filtered = runs_filtered_;
+  std::lock_guard lock(mutex_);
+  statistics.bytes_ingested = bytes_ingested_;
+  statistics.bytes_flushed = bytes_flushed_;
+  statistics.bytes_compacted = bytes_compacted_;
+  statistics.compactions = compactions_;
+  for (const auto& level : version_->levels) {
+    statistics.runs_per_level.push_back(level.size());
+    statistics.bytes_per_level.push_back(level_bytes(level));
+  }
+  return statistics;
+}
+
+//
+// Background Work
+//
+
+void LsmCatalog::background_work() {
+  std::unique_lock lock(mutex_);
+  for (;;) {
+    std::shared_ptr<const Memtable> frozen = immutable_;
+    const bool compact = !frozen && !stopping_ && pick_compaction() >= 0;
+    if (!frozen && !compact) {
+      if (stopping_) {
+        return;
+      }
+      work_ready_.wait(lock);
+      continue;
+    }
+
+    busy_ = true;
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      if (frozen) {
+        flush_immutable(*frozen);
+      } else {
+        compact_once();
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    busy_ = false;
+    work_done_.notify_all();
+    if (error) {
+      // Writers see the error on their next call; nothing more is written.
+      background_error_ = error;
+      return;
+    }
+  }
+}
+
+void LsmCatalog::flush_immutable(const Memtable& memtable) {
+  const std::uint64_t number = next_run_number_++;
+  SortedRunWriter writer(run_path(number), memtable.size());
+  for (const auto& [isbn, value] : memtable) {
+    writer.add(to_entry(isbn, value));
+  }
+  const std::size_t size = writer.finish();
+  auto run = std::make_shared<SortedRun>(run_path(number), number);
+
+  auto version = std::make_shared<Version>(*version_);
+  version->levels[0].insert(version->levels[0].begin(), std::move(run));
+  write_manifest(*version, next_run_number_);
+
+  std::lock_guard lock(mutex_);
+  version_ = std::move(version);
+  immutable_.reset();
+  bytes_flushed_ += size;
+}
+
+int LsmCatalog::pick_compaction() const {
+  const auto& levels = version_->levels;
+  if (levels[0].size() >= LEVEL0_COMPACTION_TRIGGER) {
+    return 0;
+  }
+  for (std::size_t level = 1; level + 1 < levels.size(); ++level) {
+    if (level_bytes(levels[level]) > level_limit(level)) {
+      return static_cast<int>(level);
+    }
+  }
+  return -1;
+}
+
+void LsmCatalog::compact_once() {
+  std::shared_ptr<const Version> current;
+  int picked;
+  {
+    std::lock_guard lock(mutex_);
+    current = version_;
+    picked = pick_compaction();
+  }
+  if (picked < 0) {
+    return;
+  }
+  const std::size_t level = static_cast<std::size_t>(picked);
+  const std::size_t output_level = level + 1;
+
+  // Inputs, newest first: all of level 0, or the run after the compaction
+  // pointer of a deeper level; then the runs of the next level they overlap.
+  std::vector<Run> inputs;
+  const auto& source = current->levels[level];
+  if (level == 0) {
+    inputs = source;
+  } else {
+    auto next = std::find_if(source.begin(), source.end(),
+                             [&](const Run& run) { return run->smallest() > compact_pointer_[level]; });
+    inputs.push_back(next != source.end() ? *next : source.front());
+  }
+  std::string smallest = inputs.front()->smallest();
+  std::string largest = inputs.front()->largest();
+  for (const Run& run : inputs) {
+    smallest = std::min(smallest, run->smallest());
+    largest = std::max(largest, run->largest());
+  }
+  for (const Run& run : current->levels[output_level]) {
+    if (run->overlaps(smallest, largest)) inputs.push_back(run);
+  }
+
+  // A tombstone can go once nothing older than the output could hold its key.
+  bool deepest = true;
+  for (std::size_t deeper = output_level + 1; deeper < current->levels.size(); ++deeper) {
+    deepest = deepest && current->levels[deeper].empty();
+  }
+  std::size_t written = 0;
+  const std::vector<Run> outputs = merge(inputs, deepest, written);
+
+  auto version = std::make_shared<Version>(*current);
+  auto is_input = [&](const Run& run) {
+    return std::find(inputs.begin(), inputs.end(), run) != inputs.end();
+  };
+  for (std::size_t i : {level, output_level}) {
+    auto& runs = version->levels[i];
+    runs.erase(std::remove_if(runs.begin(), runs.end(), is_input), runs.end());
+  }
+  auto& output_runs = version->levels[output_level];
+  output_runs.insert(output_runs.end(), outputs.begin(), outputs.end());
+  std::sort(output_runs.begin(), output_runs.end(),
+            [](const Run& a, const Run& b) { return a->smallest() < b->smallest(); });
+  compact_pointer_[level] = largest;
+  write_manifest(*version, next_run_number_);
+
+  {
+    std::lock_guard lock(mutex_);
+    version_ = std::move(version);
+    bytes_compacted_ += written;
+    ++compactions_;
+  }
+  // Readers holding the old version keep the files open until they finish.
+  for (const Run& run : inputs) run->mark_obsolete();
+}
+
+std::vector<LsmCatalog::Run> LsmCatalog::merge(const std::vector<Run>& inputs,
+                                               bool drop_tombstones, std::size_t& written) {
+  struct Cursor {
+    const char* position;
+    const char* end;
+    RunEntry entry;
+    bool valid;
+
+    void advance() {
+      position = position < end ? decode_run_entry(position, end, entry) : nullptr;
+      valid = position != nullptr;
+    }
+  };
+  std::vector<Cursor> cursors;
+  std::size_t expected = 0;
+  for (const Run& run : inputs) {
+    cursors.push_back(Cursor{run->entries_begin(), run->entries_end(), {}, false});
+    cursors.back().advance();
+    expected += run->entry_count();
+  }
+
+  std::vector<Run> outputs;
+  std::optional<SortedRunWriter> writer;
+  std::uint64_t number = 0;
+  auto finish = [&] {
+    written += writer->finish();
+    outputs.push_back(std::make_shared<SortedRun>(run_path(number), number));
+    writer.reset();
+  };
+
+  for (;;) {
+    // The smallest key; among equal keys the newest input (lowest index) wins.
+    Cursor* winner = nullptr;
+    for (Cursor& cursor : cursors) {
+      if (cursor.valid && (winner == nullptr || cursor.entry.isbn < winner->entry.isbn)) {
+        winner = &cursor;
+      }
+    }
+    if (winner == nullptr) {
+      break;
+    }
+    const RunEntry entry = winner->entry;
+    if (!(drop_tombstones && entry.tombstone)) {
+      if (!writer) {
+        number = next_run_number_++;
+        writer.emplace(run_path(number), expected);
+      }
+      writer->add(entry);
+      if (writer->data_bytes() >= options_.run_bytes) {
+        finish();
+      }
+    }
+    const std::string key(entry.isbn);
+    for (Cursor& cursor : cursors) {
+      if (cursor.valid && cursor.entry.isbn == key) cursor.advance();
+    }
+  }
+  if (writer) {
+    finish();
+  }
+  return outputs;
+}
+
+//
+// Files
+//
+
+std::string LsmCatalog::run_path(std::uint64_t number) const {
+  char name[32];
+  std::snprintf(name, sizeof name, "%06llu.run", static_cast<unsigned long long>(number));
+  return (std::filesystem::path(directory_) / name).string();
+}
+
+void LsmCatalog::write_manifest(const Version& version, std::uint64_t next_number) const {
+  // Written aside and renamed over the old one, so a crash leaves one or the
+  // other.
+  const std::filesystem::path path = std::filesystem::path(directory_) / MANIFEST;
+  const std::filesystem::path temporary = path.string() + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::trunc);
+    file << "next " << next_number << '\n';
+    for (std::size_t level = 0; level < version.levels.size(); ++level) {
+      for (const Run& run : version.levels[level]) {
+        file << "run " << level << ' ' << run->number() << '\n';
+      }
+    }
+    file.flush();
+    if (!file) {
+      throw std::system_error(errno, std::generic_category(), "write " + temporary.string());
+    }
+  }
+  std::filesystem::rename(temporary, path);
+}
+
+std::size_t LsmCatalog::level_bytes(const std::vector<Run>& level) const {
+  std::size_t bytes = 0;
+  for (const Run& run : level) bytes += run->file_size();
+  return bytes;
+}
+
+std::size_t LsmCatalog::level_limit(std::size_t level) const {
+  std::size_t limit = options_.level_base_bytes;
+  for (std::size_t i = 1; i < level; ++i) limit *= LEVEL_SIZE_RATIO;
+  return limit;
+}
@@ -0,0 +1,206 @@
+#ifndef _lsm_catalog_hpp_
+#define _lsm_catalog_hpp_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "book.hpp"
+#include "sorted_run.hpp"
+
+// A log-structured merge tree of Books keyed by ISBN, for write-heavy
+// workloads such as a price feed that updates the same books over and over.
+//
+// Writes go to an in-memory sorted memtable and never touch the disk
+// directly. A full memtable is frozen and a background thread writes it out
+// as an immutable sorted run (sorted_run.hpp) in level 0. The same thread
+// compacts: once level 0 holds LEVEL0_COMPACTION_TRIGGER runs they are
+// merged with the overlapping runs of level 1, and once level i (i >= 1)
+// holds more than level_base_bytes * LEVEL_SIZE_RATIO^(i-1) bytes one of its
+// runs is merged into level i+1. Runs below level 0 never overlap within
+// their level, so a lookup reads at most one run per level; each run's bloom
+// filter skips most of the runs that do not hold the ISBN.
+//
+// Removing a book writes a tombstone, which hides older versions until a
+// compaction into the deepest level drops it.
+//
+// The levels are listed in a MANIFEST file in the directory, so reopening
+// the directory finds every run. The memtable is only written out when it
+// fills, on flush(), and on destruction: a crash loses it.
+//
+// insert, remove, and find are safe to call from many threads.
+//
+// Usage:
+//
+//   LsmCatalog catalog("catalog.lsm");
+//   catalog.insert(book);
+//   catalog.remove(book.isbn());
+//   std::optional<Book> found = catalog.find(book.isbn());
+struct LsmOptions {
+  std::size_t memtable_bytes = 4 << 20;               // freeze the memtable beyond this
+  std::size_t run_bytes = 4 << 20;                    // target size of a compacted run
+  std::size_t level_base_bytes = 16 << 20;            // capacity of level 1
+};
+
+// Counters of what the catalog has done since it was opened.
+struct LsmStatistics {
+  std::size_t lookups = 0;
+  std::size_t memtable_hits = 0;
+  std::size_t runs_probed = 0;                        // runs whose key range held the ISBN
+  std::size_t runs_filtered = 0;                      // of those, ruled out by the bloom filter
+  std::size_t bytes_ingested = 0;                     // encoded size of every write
+  std::size_t bytes_flushed = 0;                      // run bytes written from memtables
+  std::size_t bytes_compacted = 0;                    // run bytes written by compaction
+  std::size_t compactions = 0;
+  std::vector<std::size_t> runs_per_level;
+  std::vector<std::size_t> bytes_per_level;
+
+  // Runs actually read per lookup.
+  double read_amplification() const {
+    return lookups == 0 ? 0.0 : static_cast<double>(runs_probed - runs_filtered) / lookups;
+  }
+
+  // Bytes written to disk per byte written by the caller.
+  double write_amplification() const {
+    return bytes_ingested == 0 ? 0.0
+                               : static_cast<double>(bytes_flushed + bytes_compacted) / bytes_ingested;
+  }
+};
+
+class LsmCatalog {
+ public:
+  static constexpr std::size_t LEVEL0_COMPACTION_TRIGGER = 4;
+  static constexpr std::size_t LEVEL0_STOP_TRIGGER = 12;        // writers wait beyond this
+  static constexpr std::size_t LEVEL_SIZE_RATIO = 10;
+  static constexpr std::size_t MAX_LEVELS = 7;
+
+  // Opens the catalog in "directory", creating it if needed, and starts the
+  // background thread. Throws std::system_error on I/O errors and
+  // std::runtime_error if the manifest names runs that cannot be opened.
+  explicit LsmCatalog(const std::string& directory, LsmOptions options = {});
+
+  LsmCatalog(const LsmCatalog&) = delete;
+  LsmCatalog& operator=(const LsmCatalog&) = delete;
+
+  // Writes the memtable out and stops the background thread.
+  ~LsmCatalog() noexcept;
+
+  //
+  // Modifiers
+  //
+
+  // Inserts "book", replacing any book with the same ISBN. Rethrows any error
+  // the background thread has hit.
+  void insert(const Book& book);
+
+  // Removes the book with ISBN "isbn", if any.
+  void remove(std::string_view isbn);
+
+  // Writes the memtable out as a level 0 run and waits until it is on disk.
+  void flush();
+
+  // Waits until the background thread has nothing left to flush or compact.
+  void wait_for_compaction();
+
+  //
+  // Queries
+  //
+
+  std::optional<Book> find(std::string_view isbn) const;
+
+  LsmStatistics statistics() const;
+
+ private:
+  // A memtable value: a Book, or nothing for a tombstone.
+  using Memtable = std::map<std::string, std::optional<Book>, std::less<>>;
+  using Run = std::shared_ptr<SortedRun>;
+
+  // The runs of every level. Level 0 is newest first; the others are sorted
+  // by key. Replaced as a whole, so readers can hold on to one.
+  struct Version {
+    std::vector<std::vector<Run>> levels;
+  };
+
+  void write(std::string_view isbn, std::optional<Book> value);
+  void make_room(std::unique_lock<std::mutex>& lock);
+  void background_work();
+  void flush_immutable(const Memtable& memtable);
+  int pick_compaction() const;
+  void compact_once();
+  std::vector<Run> merge(const std::vector<Run>& inputs, bool drop_tombstones, std::size_t& written);
+  std::string run_path(std::uint64_t number) const;
+  void write_manifest(const Version& version, std::uint64_t next_number) const;
+  std::size_t level_bytes(const std::vector<Run>& level) const;
+  std::size_t level_limit(std::size_t level) const;
+
+  const std::string directory_;
+  const LsmOptions options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable work_ready_;                // the background thread has work
+  std::condition_variable work_done_;                 // the background thread finished some
+  std::unique_ptr<Memtable> memtable_;
+  std::size_t memtable_bytes_ = 0;
+  std::shared_ptr<const Memtable> immutable_;         // frozen, being flushed
+  std::shared_ptr<const Version> version_;
+  std::uint64_t next_run_number_ = 1;                 // background thread only
+  std::vector<std::string> compact_pointer_;          // per level: where the last compaction ended
+  bool stopping_ = false;
+  bool busy_ = false;
+  std::exception_ptr background_error_;
+
+  mutable std::atomic<std::size_t> lookups_{0};
+  mutable std::atomic<std::size_t> memtable_hits_{0};
+  mutable std::atomic<std::size_t> runs_probed_{0};
+  mutable std::atomic<std::size_t> runs_filtered_{0};
+  std::size_t bytes_ingested_ = 0;
+  std::size_t bytes_flushed_ = 0;
+  std::size_t bytes_compacted_ = 0;
+  std::size_t compactions_ = 0;
+
+  std::thread background_;
+};
+
+//
+// LSM TREE OPERATIONS
+//
+
+struct insert_into_lsm {
+  // Function takes a constant Book as a parameter, inserts that book indexed by
+  // the book's ISBN into an LSM tree, and returns nothing.
+  void operator()(const Book& book) { my_lsm.insert(book); }
+
+  LsmCatalog& my_lsm;
+};
+
+struct remove_from_lsm {
+  // Function takes a constant Book as a parameter, writes a tombstone for the
+  // book's ISBN into an LSM tree, and returns nothing.
+  void operator()(const Book& book) { my_lsm.remove(book.isbn()); }
+
+  LsmCatalog& my_lsm;
+};
+
+struct search_within_lsm {
+  // Function takes no parameters, searches an LSM tree for a book with an ISBN
+  // matching the target ISBN, and returns a copy of that book if such a book is
+  // found, an empty optional otherwise.
+  std::optional<Book> operator()(const Book& unused) {
+    return my_lsm.find(target_isbn);
+  }
+
+  const LsmCatalog& my_lsm;
+  const std::string target_isbn;
+};
+
+#endif
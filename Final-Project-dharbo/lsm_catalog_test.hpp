@@ -0,0 +1,175 @@
+#ifndef _lsm_catalog_test_hpp_
+#define _lsm_catalog_test_hpp_
+
+#include "lsm_catalog.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bloom_filter.hpp"
+#include "book.hpp"
+#include "doctest.hpp"
+#include "sorted_run.hpp"
+
+TEST_CASE("BloomFilter") {
+  BloomFilter filter(10000);
+  for (int i = 0; i < 10000; ++i) filter.add(std::to_string(i));
+  for (int i = 0; i < 10000; ++i) CHECK(filter.may_contain(std::to_string(i)));
+
+  std::size_t false_positives = 0;
+  for (int i = 10000; i < 20000; ++i) false_positives += filter.may_contain(std::to_string(i));
+  CHECK_LT(false_positives, 300);
+  CHECK(BloomFilter::may_contain(filter.bytes().data(), filter.bytes().size(),
+                                 filter.hash_count(), "42"));
+}
+
+TEST_CASE("SortedRun") {
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / "sorted_run_test.run";
+  std::filesystem::remove(path);
+  {
+    SortedRunWriter writer(path.string(), 1000);
+    for (int i = 1000; i < 2000; ++i) {
+      const std::string isbn = std::to_string(i);
+      writer.add(RunEntry{isbn, "title " + isbn, "author", static_cast<double>(i), i % 10 == 0});
+    }
+    CHECK_EQ(writer.entry_count(), 1000);
+    writer.finish();
+  }
+
+  auto run = std::make_unique<SortedRun>(path.string(), 7);
+  CHECK_EQ(run->number(), 7);
+  CHECK_EQ(run->entry_count(), 1000);
+  CHECK_EQ(run->smallest(), "1000");
+  CHECK_EQ(run->largest(), "1999");
+  CHECK(run->overlaps("0", "1000"));
+  CHECK_FALSE(run->overlaps("2", "3"));
+
+  RunEntry entry;
+  REQUIRE_EQ(run->find("1234", entry), SortedRun::Lookup::FOUND);
+  CHECK_EQ(entry.book(), Book("title 1234", "author", "1234", 1234.0));
+  CHECK_EQ(run->find("1230", entry), SortedRun::Lookup::REMOVED);
+  CHECK_EQ(run->find("0999", entry), SortedRun::Lookup::ABSENT);
+  std::size_t missing = 0;
+  for (int i = 0; i < 1000; ++i) {
+    const auto lookup = run->find("1500" + std::to_string(i), entry);
+    CHECK_NE(lookup, SortedRun::Lookup::FOUND);
+    missing += lookup == SortedRun::Lookup::FILTERED;
+  }
+  CHECK_GT(missing, 950);
+
+  std::size_t visited = 0;
+  run->for_each([&](const RunEntry& each) { visited += !each.tombstone; });
+  CHECK_EQ(visited, 900);
+
+  run->mark_obsolete();
+  run.reset();
+  CHECK_FALSE(std::filesystem::exists(path));
+}
+
+TEST_CASE("LsmCatalog") {
+  const std::filesystem::path directory = std::filesystem::temp_directory_path() / "lsm_catalog_test";
+  std::filesystem::remove_all(directory);
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book = Book("other-title", "other-author", "other-isbn", 543.21);
+
+  // Small enough that the tests below flush and compact through several levels.
+  LsmOptions options;
+  options.memtable_bytes = 16 << 10;
+  options.run_bytes = 16 << 10;
+  options.level_base_bytes = 64 << 10;
+
+  SUBCASE("InsertFindRemove") {
+    LsmCatalog catalog(directory.string(), options);
+    insert_into_lsm{catalog}(book);
+    insert_into_lsm{catalog}(other_book);
+    CHECK_EQ(search_within_lsm{catalog, book.isbn()}(Book{}), book);
+
+    catalog.flush();
+    insert_into_lsm{catalog}(Book(book).price(1.0));
+    CHECK_EQ(catalog.find(book.isbn())->price(), 1.0);
+    catalog.flush();
+    CHECK_EQ(catalog.find(book.isbn())->price(), 1.0);
+
+    remove_from_lsm{catalog}(book);
+    CHECK_EQ(search_within_lsm{catalog, book.isbn()}(Book{}), std::nullopt);
+    catalog.flush();
+    CHECK_EQ(catalog.find(book.isbn()), std::nullopt);
+    CHECK_EQ(catalog.find(other_book.isbn()), other_book);
+    CHECK_EQ(catalog.statistics().runs_per_level[0], 3);
+  }
+
+  SUBCASE("MatchesStdMapThroughCompaction") {
+    std::map<std::string, Book> expected;
+    std::default_random_engine random(38);
+    {
+      LsmCatalog catalog(directory.string(), options);
+      for (std::size_t i = 0; i < 60000; ++i) {
+        const std::string isbn = std::to_string(random() % 8000);
+        if (random() % 5 == 0) {
+          catalog.remove(isbn);
+          expected.erase(isbn);
+        } else {
+          const Book next("title " + isbn, "author", isbn, static_cast<double>(i));
+          catalog.insert(next);
+          expected[isbn] = next;
+        }
+      }
+      catalog.wait_for_compaction();
+      const LsmStatistics statistics = catalog.statistics();
+      CHECK_GT(statistics.compactions, 0);
+      CHECK_GT(statistics.runs_per_level[1] + statistics.runs_per_level[2], 0);
+      CHECK_LT(statistics.runs_per_level[0], LsmCatalog::LEVEL0_COMPACTION_TRIGGER);
+      CHECK_GT(statistics.write_amplification(), 0.0);
+
+      for (std::size_t i = 0; i < 8000; ++i) {
+        const std::string isbn = std::to_string(i);
+        const auto found = expected.find(isbn);
+        CHECK_EQ(catalog.find(isbn), found == expected.end() ? std::nullopt : std::optional(found->second));
+      }
+      CHECK_LT(catalog.statistics().read_amplification(), 2.0);
+    }
+
+    // Reopened from the manifest; nothing was lost with the memtable.
+    LsmCatalog catalog(directory.string(), options);
+    for (std::size_t i = 0; i < 8000; ++i) {
+      const std::string isbn = std::to_string(i);
+      const auto found = expected.find(isbn);
+      CHECK_EQ(catalog.find(isbn), found == expected.end() ? std::nullopt : std::optional(found->second));
+    }
+  }
+
+  SUBCASE("ConcurrentWritersAndReaders") {
+    LsmCatalog catalog(directory.string(), options);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&catalog, t] {
+        for (int i = 0; i < 5000; ++i) {
+          const std::string isbn = std::to_string(t) + "-" + std::to_string(i);
+          catalog.insert(Book("title", "author", isbn, i));
+          catalog.find(std::to_string(t) + "-" + std::to_string(i / 2));
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    for (int t = 0; t < 4; ++t) {
+      CHECK_EQ(catalog.find(std::to_string(t) + "-4999")->price(), 4999.0);
+    }
+  }
+
+  SUBCASE("RejectsBadInput") {
+    LsmCatalog catalog(directory.string(), options);
+    CHECK_THROWS_AS(catalog.insert(Book(std::string(70000, 't'), "", "1")), std::length_error);
+    CHECK_EQ(catalog.find("1"), std::nullopt);
+  }
+
+  std::filesystem::remove_all(directory);
+}
+
+#endif
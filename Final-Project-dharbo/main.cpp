@@ -2,4 +2,28 @@
 
 #include "doctest.hpp"
 
-#include "operations_test.hpp"
\ No newline at end of file
+#include "operations_test.hpp"
+#include "concurrent_hash_map_test.hpp"
+#include "concurrent_queue_test.hpp"
+#include "skip_list_test.hpp"
+#include "rcu_catalog_test.hpp"
+#include "thread_pool_test.hpp"
+#include "book_loader_test.hpp"
+#include "structural_scanner_test.hpp"
+#include "book_snapshot_test.hpp"
+#include "book_view_test.hpp"
+#include "isbn_index_test.hpp"
+#include "btree_catalog_test.hpp"
+#include "lsm_catalog_test.hpp"
+#include "wal_test.hpp"
+#include "compressed_catalog_test.hpp"
+#include "external_sort_test.hpp"
+#include "shared_catalog_test.hpp"
+#include "secondary_index_test.hpp"
+#include "range_scan_test.hpp"
+#include "price_index_test.hpp"
+#include "text_index_test.hpp"
+#include "trigram_index_test.hpp"
+#include "completion_trie_test.hpp"
+#include "query_engine_test.hpp"
+#include "group_by_test.hpp"
@@ -0,0 +1,91 @@
+#include "mapped_file.hpp"
+
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//
+// Constructors, Assignments, and Destructor
+//
+
+MappedFile::MappedFile(const std::string& path)
+    : MappedFile(::open(path.c_str(), O_RDONLY), path) {}
+
+MappedFile MappedFile::shared_memory(const std::string& name) {
+  return MappedFile(::shm_open(name.c_str(), O_RDONLY, 0), name);
+}
+
+MappedFile::MappedFile(int fd, const std::string& path) {
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "open " + path);
+  }
+
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    const int error = errno;
+    ::close(fd);
+    throw std::system_error(error, std::generic_category(), "stat " + path);
+  }
+
+  // mmap rejects zero-length mappings; an empty file is simply empty.
+  size_ = static_cast<std::size_t>(status.st_size);
+  if (size_ != 0) {
+    void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+      const int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), "mmap " + path);
+    }
+    data_ = static_cast<const char*>(mapping);
+  }
+
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    MappedFile discarded(std::move(*this));
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() noexcept {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+//
+// Accessors
+//
+
+void MappedFile::advise_sequential() const {
+  if (data_ != nullptr) {
+    ::madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+  }
+}
+
+//
+// Page Cache
+//
+
+void drop_cached_pages(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+}
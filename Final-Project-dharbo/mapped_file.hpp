@@ -0,0 +1,58 @@
+#ifndef _mapped_file_hpp_
+#define _mapped_file_hpp_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// A read-only memory mapping of a whole file. The bytes are paged in by the
+// operating system on first touch, so "opening" a file costs nothing more
+// than a system call regardless of its size.
+//
+// POSIX only (mmap, shm_open). Throws std::system_error if the file cannot be opened or
+// mapped.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string& path);
+
+  // Maps the POSIX shared memory object "name" (e.g. "/books") rather than a
+  // file.
+  static MappedFile shared_memory(const std::string& name);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  ~MappedFile() noexcept;
+
+  //
+  // Accessors
+  //
+
+  const char* data() const { return data_; }
+  std::size_t size() const { return size_; }
+  std::string_view view() const { return {data_, size_}; }
+  bool empty() const { return size_ == 0; }
+
+  // Tells the kernel the file is about to be read front to back, so it can
+  // read ahead aggressively.
+  void advise_sequential() const;
+
+ private:
+  // Maps the open descriptor "fd", which it closes, described as "path" in
+  // errors.
+  MappedFile(int fd, const std::string& path);
+
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Asks the kernel to drop the cached pages of the file at "path", so that the
+// next read comes from the disk. Dirty pages are not written back first, and
+// the request is only advice: some pages may stay cached. Does nothing if the
+// file cannot be opened.
+void drop_cached_pages(const std::string& path);
+
+#endif
@@ -1,24 +1,36 @@
 #ifndef _operations_hpp_
 #define _operations_hpp_
 
+#include <algorithm>
+#include <cstddef>
 #include <forward_list>
+#include <iterator>
 #include <list>
 #include <map>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "book.hpp"
+#include "book_view.hpp"
+
+// Every functor is a template over the record type its container holds: Book
+// by default, or BookView for containers of non-owning views. The record type
+// is deduced from the container, so "insert_at_back_of_vector{v}" works for a
+// std::vector of either. The BST and hash table are keyed by the record's ISBN
+// type (see isbn_key_t).
 
 //
 // INSERT OPERATIONS
 //
 
+template <class Record = Book>
 struct insert_at_back_of_vector {
   // Function takes a constant Book as a parameter, inserts that book at the
   // back of a vector, and returns nothing.
-  void operator()(const Book& book) {
+  void operator()(const Record& book) {
 
     // Write the lines of code to insert "book" at the back of "my_vector".
 
@@ -26,26 +38,32 @@ struct insert_at_back_of_vector {
     my_vector.push_back(book);
   }
 
-  std::vector<Book>& my_vector;
+  std::vector<Record>& my_vector;
 };
+template <class Record>
+insert_at_back_of_vector(std::vector<Record>&) -> insert_at_back_of_vector<Record>;
 
+template <class Record = Book>
 struct insert_at_back_of_dll {
   // Function takes a constant Book as a parameter, inserts that book at the
   // back of a doubly linked list, and returns nothing.
-  void operator()(const Book& book) {
+  void operator()(const Record& book) {
     // Write the lines of code to insert "book" at the back of "my_dll".
 
     // Add the book to the back of the DLL.
     my_dll.push_back(book);
   }
 
-  std::list<Book>& my_dll;
+  std::list<Record>& my_dll;
 };
+template <class Record>
+insert_at_back_of_dll(std::list<Record>&) -> insert_at_back_of_dll<Record>;
 
+template <class Record = Book>
 struct insert_at_back_of_sll {
   // Function takes a constant Book as a parameter, inserts that book at the
   // back of a singly linked list, and returns nothing.
-  void operator()(const Book& book) {
+  void operator()(const Record& book) {
     // Write the lines of code to insert "book" at the back of "my_sll". Since
     // the SLL has no size() function and no tail pointer, you must walk the
     // list looking for the last node.
@@ -53,7 +71,7 @@ struct insert_at_back_of_sll {
     // HINT:  Do not attempt to insert after "my_sll.end()".
 
     // Create iterator for forward list.
-    std::forward_list<Book>::iterator iter = my_sll.before_begin();
+    typename std::forward_list<Record>::iterator iter = my_sll.before_begin();
     // Traverse the SLL, advancing the iterator by one position at a time.
     for (auto& node : my_sll) {
       ++iter;
@@ -62,52 +80,64 @@ struct insert_at_back_of_sll {
     my_sll.insert_after(iter, book);
   }
 
-  std::forward_list<Book>& my_sll;
+  std::forward_list<Record>& my_sll;
 };
+template <class Record>
+insert_at_back_of_sll(std::forward_list<Record>&) -> insert_at_back_of_sll<Record>;
 
+template <class Record = Book>
 struct insert_at_front_of_vector {
   // Function takes a constant Book as a parameter, inserts that book at the
   // front of a vector, and returns nothing.
-  void operator()(const Book& book) {
+  void operator()(const Record& book) {
     // Write the lines of code to insert "book" at the front of "my_vector".
 
     // Insert the book at the front of the vector using insert().
     my_vector.insert(my_vector.begin(), book);
   }
 
-  std::vector<Book>& my_vector;
+  std::vector<Record>& my_vector;
 };
+template <class Record>
+insert_at_front_of_vector(std::vector<Record>&) -> insert_at_front_of_vector<Record>;
 
+template <class Record = Book>
 struct insert_at_front_of_dll {
   // Function takes a constant Book as a parameter, inserts that book at the
   // front of a doubly linked list, and returns nothing.
-  void operator()(const Book& book) {
+  void operator()(const Record& book) {
     // Write the lines of code to insert "book" at the front of "my_dll".
 
     // Insert the book to the front of the DLL using push_front().
     my_dll.push_front(book);
   }
 
-  std::list<Book>& my_dll;
+  std::list<Record>& my_dll;
 };
+template <class Record>
+insert_at_front_of_dll(std::list<Record>&) -> insert_at_front_of_dll<Record>;
 
-struct insert_at_front_of_sll{
+template <class Record = Book>
+struct insert_at_front_of_sll {
   // Function takes a constant Book as a parameter, inserts that book at the
   // front of a singly linked list, and returns nothing.
-  void operator()(const Book& book) {
+  void operator()(const Record& book) {
     // Write the lines of code to insert "book" at the front of "my_sll"
 
     // Insert the book at the front of the SLL using push_front().
     my_sll.push_front(book);
   }
 
-  std::forward_list<Book>& my_sll;
+  std::forward_list<Record>& my_sll;
 };
+template <class Record>
+insert_at_front_of_sll(std::forward_list<Record>&) -> insert_at_front_of_sll<Record>;
 
+template <class Record = Book>
 struct insert_into_bst {
   // Function takes a constant Book as a parameter, inserts that book indexed by
   // the book's ISBN into a binary search tree, and returns nothing.
-  void operator()(const Book& book) {
+  void operator()(const Record& book) {
     // Write the lines of code to insert the key (book's ISBN) and value
     // ("book") pair into "my_bst".
 
@@ -115,13 +145,16 @@ struct insert_into_bst {
     my_bst[book.isbn()] = book;
   }
 
-  std::map<std::string, Book>& my_bst;
+  std::map<isbn_key_t<Record>, Record>& my_bst;
 };
+template <class Key, class Record>
+insert_into_bst(std::map<Key, Record>&) -> insert_into_bst<Record>;
 
+template <class Record = Book>
 struct insert_into_hash_table {
   // Function takes a constant Book as a parameter, inserts that book indexed by
   // the book's ISBN into a hash table, and returns nothing.
-  void operator()(const Book& book) {
+  void operator()(const Record& book) {
     // Write the lines of code to insert the key (book's ISBN) and value
     // ("book") pair into "my_hash_table".
 
@@ -129,17 +162,20 @@ struct insert_into_hash_table {
     my_hash_table[book.isbn()] = book;
   }
 
-  std::unordered_map<std::string, Book>& my_hash_table;
+  std::unordered_map<isbn_key_t<Record>, Record>& my_hash_table;
 };
+template <class Key, class Record>
+insert_into_hash_table(std::unordered_map<Key, Record>&) -> insert_into_hash_table<Record>;
 
 //
 // REMOVE OPERATIONS
 //
 
+template <class Record = Book>
 struct remove_from_back_of_vector {
   // Function takes no parameters, removes the book at the back of a vector, and
   // returns nothing.
-  void operator()(const Book& unused) {
+  void operator()(const Record& unused) {
     // Write the lines of code to remove the book at the back of "my_vector".
     //
     // Remember, attempting to remove an element from an empty data structure is
@@ -153,13 +189,16 @@ struct remove_from_back_of_vector {
     my_vector.pop_back();
   }
 
-  std::vector<Book>& my_vector;
+  std::vector<Record>& my_vector;
 };
+template <class Record>
+remove_from_back_of_vector(std::vector<Record>&) -> remove_from_back_of_vector<Record>;
 
+template <class Record = Book>
 struct remove_from_back_of_dll {
   // Function takes no parameters, removes the book at the back of a doubly
   // linked list, and returns nothing.
-  void operator()(const Book& unused) {
+  void operator()(const Record& unused) {
     // Write the lines of code to remove the book at the back of "my_dll".
     //
     // Remember, attempting to remove an element from an empty data structure is
@@ -173,13 +212,16 @@ struct remove_from_back_of_dll {
     my_dll.pop_back();
   }
 
-  std::list<Book>& my_dll;
+  std::list<Record>& my_dll;
 };
+template <class Record>
+remove_from_back_of_dll(std::list<Record>&) -> remove_from_back_of_dll<Record>;
 
+template <class Record = Book>
 struct remove_from_back_of_sll {
   // Function takes no parameters, removes the book at the back of a singly
   // linked list, and returns nothing.
-  void operator()(const Book& unused) {
+  void operator()(const Record& unused) {
     // Write the lines of code to remove the book at the back of "my_sll".
     //
     // Remember, attempting to remove an element from an empty data structure is
@@ -204,8 +246,8 @@ struct remove_from_back_of_sll {
       throw std::out_of_range("Cannot remove from empty data structure.");
     }
     // Set predecessor and current iterators.
-    std::forward_list<Book>::iterator predecessor = my_sll.before_begin();
-    std::forward_list<Book>::iterator current = my_sll.begin();
+    typename std::forward_list<Record>::iterator predecessor = my_sll.before_begin();
+    typename std::forward_list<Record>::iterator current = my_sll.begin();
     // Advance current iterator by 1 position.
     std::advance(current, 1);
     // While current is not out of the SLL, advance current and predecessor by 1.
@@ -217,13 +259,16 @@ struct remove_from_back_of_sll {
     my_sll.erase_after(predecessor);
   }
 
-  std::forward_list<Book>& my_sll;
+  std::forward_list<Record>& my_sll;
 };
+template <class Record>
+remove_from_back_of_sll(std::forward_list<Record>&) -> remove_from_back_of_sll<Record>;
 
+template <class Record = Book>
 struct remove_from_front_of_vector {
   // Function takes no parameters, removes the book at the front of a vector,
   // and returns nothing.
-  void operator()(const Book& unused) {
+  void operator()(const Record& unused) {
     // Write the lines of code to remove the book at the front of "my_vector".
     //
     // Remember, attempting to remove an element from an empty data structure is
@@ -237,13 +282,16 @@ struct remove_from_front_of_vector {
     my_vector.erase(my_vector.begin());
   }
 
-  std::vector<Book>& my_vector;
+  std::vector<Record>& my_vector;
 };
+template <class Record>
+remove_from_front_of_vector(std::vector<Record>&) -> remove_from_front_of_vector<Record>;
 
+template <class Record = Book>
 struct remove_from_front_of_dll {
   // Function takes no parameters, removes the book at the front of a doubly
   // linked list, and returns nothing.
-  void operator()(const Book& unused) {
+  void operator()(const Record& unused) {
     // Write the lines of code to remove the book at the front of "my_dll".
     //
     // Remember, attempting to remove an element from an empty data structure is
@@ -257,13 +305,16 @@ struct remove_from_front_of_dll {
     my_dll.pop_front();
   }
 
-  std::list<Book>& my_dll;
+  std::list<Record>& my_dll;
 };
+template <class Record>
+remove_from_front_of_dll(std::list<Record>&) -> remove_from_front_of_dll<Record>;
 
+template <class Record = Book>
 struct remove_from_front_of_sll {
   // Function takes no parameters, removes the book at the front of a singly
   // linked list, and returns nothing.
-  void operator()(const Book& unused) {
+  void operator()(const Record& unused) {
     // Write the lines of code to remove the book at the front of "my_sll".
     //
     // Remember, attempting to remove an element from an empty data structure is
@@ -277,38 +328,44 @@ struct remove_from_front_of_sll {
     my_sll.pop_front();
   }
 
-  std::forward_list<Book>& my_sll;
+  std::forward_list<Record>& my_sll;
 };
+template <class Record>
+remove_from_front_of_sll(std::forward_list<Record>&) -> remove_from_front_of_sll<Record>;
 
+template <class Record = Book>
 struct remove_from_bst {
   // Function takes a constant Book as a parameter, finds and removes from the
   // binary search tree the book with a matching ISBN (if any), and returns
   // nothing. If no Book matches the ISBN, the method does nothing.
-  void operator()(const Book& book) {
+  void operator()(const Record& book) {
     // Write the lines of code to remove the book from "my_bst" that has an ISBN
     // matching "book".
 
     // Find an iterator to a pair with book.isbn() as its key.
-    std::map<std::string, Book>::iterator iter = my_bst.find(book.isbn());
+    typename std::map<isbn_key_t<Record>, Record>::iterator iter = my_bst.find(book.isbn());
     // If the iterator is not past the end, remove that pair.
     if (iter != my_bst.end()) {
       my_bst.erase(iter);
     }
   }
 
-  std::map<std::string, Book>& my_bst;
+  std::map<isbn_key_t<Record>, Record>& my_bst;
 };
+template <class Key, class Record>
+remove_from_bst(std::map<Key, Record>&) -> remove_from_bst<Record>;
 
+template <class Record = Book>
 struct remove_from_hash_table {
   // Function takes a constant Book as a parameter, finds and removes from the
   // hash table the book with a matching ISBN (if any), and returns nothing. If 
   // no Book matches the ISBN, the method does nothing.
-  void operator()(const Book& book) {
+  void operator()(const Record& book) {
     // Write the lines of code to remove the book from "my_hash_table" that has
     // an ISBN matching "book".
 
     // Find an iterator to a pair with book.isbn() as its key.
-    std::unordered_map<std::string, Book>::iterator iter = 
+    typename std::unordered_map<isbn_key_t<Record>, Record>::iterator iter = 
                                         my_hash_table.find(book.isbn());
     // If the iterator is not past the end, remove that pair.
     if (iter != my_hash_table.end()) {
@@ -316,18 +373,259 @@ struct remove_from_hash_table {
     }
   }
 
-  std::unordered_map<std::string, Book>& my_hash_table;
+  std::unordered_map<isbn_key_t<Record>, Record>& my_hash_table;
+};
+template <class Key, class Record>
+remove_from_hash_table(std::unordered_map<Key, Record>&) -> remove_from_hash_table<Record>;
+
+//
+// BULK OPERATIONS
+//
+// Each bulk functor takes a range of Books [first, last) and does the work of
+// calling the matching single-Book functor once per Book, but lets the
+// container do it in one pass: one allocation, one rehash, one walk of a list.
+//
+
+template <class Record = Book>
+struct bulk_insert_at_back_of_vector {
+  // Function takes a range of Books, appends them in order at the back of a
+  // vector, and returns nothing.
+  template <class Iter>
+  void operator()(Iter first, Iter last) {
+    // Grow the vector at most once. Keep the growth geometric so that many
+    // small batches in a row don't each reallocate.
+    const std::size_t needed = my_vector.size() + std::distance(first, last);
+    if (needed > my_vector.capacity()) {
+      my_vector.reserve(std::max(needed, 2 * my_vector.capacity()));
+    }
+    // Append the whole range in one call.
+    my_vector.insert(my_vector.end(), first, last);
+  }
+
+  std::vector<Record>& my_vector;
+};
+template <class Record>
+bulk_insert_at_back_of_vector(std::vector<Record>&) -> bulk_insert_at_back_of_vector<Record>;
+
+template <class Record = Book>
+struct bulk_insert_at_back_of_dll {
+  // Function takes a range of Books, appends them in order at the back of a
+  // doubly linked list, and returns nothing.
+  template <class Iter>
+  void operator()(Iter first, Iter last) {
+    // Build the new nodes off to the side, then link them all in with a
+    // single constant-time splice.
+    std::list<Record> batch(first, last);
+    my_dll.splice(my_dll.end(), batch);
+  }
+
+  std::list<Record>& my_dll;
+};
+template <class Record>
+bulk_insert_at_back_of_dll(std::list<Record>&) -> bulk_insert_at_back_of_dll<Record>;
+
+template <class Record = Book>
+struct bulk_insert_at_back_of_sll {
+  // Function takes a range of Books, appends them in order at the back of a
+  // singly linked list, and returns nothing.
+  template <class Iter>
+  void operator()(Iter first, Iter last) {
+    // Walk to the last node once for the whole batch instead of once per book.
+    typename std::forward_list<Record>::iterator tail = my_sll.before_begin();
+    for (auto next = my_sll.begin(); next != my_sll.end(); ++next) {
+      tail = next;
+    }
+    my_sll.insert_after(tail, first, last);
+  }
+
+  std::forward_list<Record>& my_sll;
+};
+template <class Record>
+bulk_insert_at_back_of_sll(std::forward_list<Record>&) -> bulk_insert_at_back_of_sll<Record>;
+
+template <class Record = Book>
+struct bulk_insert_into_bst {
+  // Function takes a range of Books, inserts each one indexed by its ISBN into
+  // a binary search tree, and returns nothing. Books later in the range replace
+  // earlier ones with the same ISBN.
+  template <class Iter>
+  void operator()(Iter first, Iter last) {
+    // Put the batch in key order (a stable sort keeps later duplicates after
+    // earlier ones) unless it already is.
+    std::vector<const Record*> batch;
+    batch.reserve(std::distance(first, last));
+    for (; first != last; ++first) {
+      batch.push_back(&*first);
+    }
+    auto by_isbn = [](const Record* lhs, const Record* rhs) {
+      return lhs->isbn() < rhs->isbn();
+    };
+    if (!std::is_sorted(batch.begin(), batch.end(), by_isbn)) {
+      std::stable_sort(batch.begin(), batch.end(), by_isbn);
+    }
+
+    // Each key belongs right after the previous one, so hint that position.
+    // A correct hint makes each insertion amortized constant time instead of
+    // a full descent from the root.
+    typename std::map<isbn_key_t<Record>, Record>::iterator hint = my_bst.end();
+    for (const Record* book : batch) {
+      hint = std::next(my_bst.insert_or_assign(hint, book->isbn(), *book));
+    }
+  }
+
+  std::map<isbn_key_t<Record>, Record>& my_bst;
+};
+template <class Key, class Record>
+bulk_insert_into_bst(std::map<Key, Record>&) -> bulk_insert_into_bst<Record>;
+
+template <class Record = Book>
+struct bulk_insert_into_hash_table {
+  // Function takes a range of Books, inserts each one indexed by its ISBN into
+  // a hash table, and returns nothing.
+  template <class Iter>
+  void operator()(Iter first, Iter last) {
+    // Rehash at most once for the whole batch, keeping the growth geometric.
+    const std::size_t needed =
+        my_hash_table.size() + std::distance(first, last);
+    if (needed > my_hash_table.bucket_count() * my_hash_table.max_load_factor()) {
+      my_hash_table.reserve(std::max(needed, 2 * my_hash_table.size()));
+    }
+    for (; first != last; ++first) {
+      my_hash_table.insert_or_assign(first->isbn(), *first);
+    }
+  }
+
+  std::unordered_map<isbn_key_t<Record>, Record>& my_hash_table;
+};
+template <class Key, class Record>
+bulk_insert_into_hash_table(std::unordered_map<Key, Record>&) -> bulk_insert_into_hash_table<Record>;
+
+template <class Record = Book>
+struct bulk_remove_from_back_of_vector {
+  // Function takes a range of Books, removes that many books from the back of
+  // a vector, and returns nothing. Like remove_from_back_of_vector, the books
+  // themselves are unused; only the size of the range matters.
+  template <class Iter>
+  void operator()(Iter first, Iter last) {
+    const std::size_t count = std::distance(first, last);
+    // If the vector holds fewer books than requested, throw exception.
+    if (count > my_vector.size()) {
+      throw std::out_of_range("Cannot remove from empty data structure.");
+    }
+    // Destroy the tail in one call.
+    my_vector.erase(my_vector.end() - count, my_vector.end());
+  }
+
+  std::vector<Record>& my_vector;
+};
+template <class Record>
+bulk_remove_from_back_of_vector(std::vector<Record>&) -> bulk_remove_from_back_of_vector<Record>;
+
+template <class Record = Book>
+struct bulk_remove_from_front_of_dll {
+  // Function takes a range of Books, removes that many books from the front of
+  // a doubly linked list, and returns nothing. The books themselves are unused.
+  template <class Iter>
+  void operator()(Iter first, Iter last) {
+    const std::size_t count = std::distance(first, last);
+    // If the DLL holds fewer books than requested, throw exception.
+    if (count > my_dll.size()) {
+      throw std::out_of_range("Cannot remove from empty data structure.");
+    }
+    // Unlink the whole run of nodes in one call.
+    my_dll.erase(my_dll.begin(), std::next(my_dll.begin(), count));
+  }
+
+  std::list<Record>& my_dll;
+};
+template <class Record>
+bulk_remove_from_front_of_dll(std::list<Record>&) -> bulk_remove_from_front_of_dll<Record>;
+
+template <class Record = Book>
+struct bulk_remove_from_front_of_sll {
+  // Function takes a range of Books, removes that many books from the front of
+  // a singly linked list, and returns nothing. The books themselves are unused.
+  template <class Iter>
+  void operator()(Iter first, Iter last) {
+    // Find the end of the run to remove, checking the list is long enough.
+    typename std::forward_list<Record>::iterator end = my_sll.begin();
+    for (; first != last; ++first, ++end) {
+      // If the SLL holds fewer books than requested, throw exception.
+      if (end == my_sll.end()) {
+        throw std::out_of_range("Cannot remove from empty data structure.");
+      }
+    }
+    // Unlink the whole run of nodes in one call.
+    my_sll.erase_after(my_sll.before_begin(), end);
+  }
+
+  std::forward_list<Record>& my_sll;
+};
+template <class Record>
+bulk_remove_from_front_of_sll(std::forward_list<Record>&) -> bulk_remove_from_front_of_sll<Record>;
+
+template <class Record = Book>
+struct bulk_remove_from_bst {
+  // Function takes a range of Books, removes from a binary search tree every
+  // book with a matching ISBN (if any), and returns nothing.
+  template <class Iter>
+  void operator()(Iter first, Iter last) {
+    // Visit the keys in order so that each one can be found by stepping
+    // forward from where the previous one was.
+    std::vector<isbn_key_t<Record>> keys;
+    keys.reserve(std::distance(first, last));
+    for (; first != last; ++first) {
+      keys.push_back(first->isbn());
+    }
+    std::sort(keys.begin(), keys.end());
+
+    typename std::map<isbn_key_t<Record>, Record>::iterator iter = my_bst.begin();
+    for (const auto& key : keys) {
+      // Step forward a few nodes before falling back to a fresh descent.
+      for (int steps = 0;
+           iter != my_bst.end() && iter->first < key && steps < 8; ++steps) {
+        ++iter;
+      }
+      if (iter != my_bst.end() && iter->first < key) {
+        iter = my_bst.lower_bound(key);
+      }
+      if (iter != my_bst.end() && iter->first == key) {
+        iter = my_bst.erase(iter);
+      }
+    }
+  }
+
+  std::map<isbn_key_t<Record>, Record>& my_bst;
+};
+template <class Key, class Record>
+bulk_remove_from_bst(std::map<Key, Record>&) -> bulk_remove_from_bst<Record>;
+
+template <class Record = Book>
+struct bulk_remove_from_hash_table {
+  // Function takes a range of Books, removes from a hash table every book with
+  // a matching ISBN (if any), and returns nothing.
+  template <class Iter>
+  void operator()(Iter first, Iter last) {
+    for (; first != last; ++first) {
+      my_hash_table.erase(first->isbn());
+    }
+  }
+
+  std::unordered_map<isbn_key_t<Record>, Record>& my_hash_table;
 };
+template <class Key, class Record>
+bulk_remove_from_hash_table(std::unordered_map<Key, Record>&) -> bulk_remove_from_hash_table<Record>;
 
 //
 // SEARCH OPERATIONS
 //
 
+template <class Record = Book>
 struct search_within_vector {
   // Function takes no parameters, searches a vector for a book with an ISBN
   // matching the target ISBN, and returns a pointer to that found book if such
   // a book is found, nullptr otherwise.
-  Book* operator()(const Book& unused) {
+  Record* operator()(const Record& unused) {
     // Write the lines of code to search for the Book within "my_vector" with an
     // ISBN matching "target_isbn". Return a pointer to that book immediately
     // upon finding it, or a null pointer when you know the book is not in the
@@ -343,15 +641,18 @@ struct search_within_vector {
     return nullptr;
   }
 
-  std::vector<Book>& my_vector;
+  std::vector<Record>& my_vector;
   const std::string target_isbn;
 };
+template <class Record>
+search_within_vector(std::vector<Record>&, const std::string&) -> search_within_vector<Record>;
 
+template <class Record = Book>
 struct search_within_dll {
   // Function takes no parameters, searches a doubly linked list for a book with
   // an ISBN matching the target ISBN, and returns a pointer to that found book
   // if such a book is found, nullptr otherwise.
-  Book* operator()(const Book& unused) {
+  Record* operator()(const Record& unused) {
     // Write the lines of code to search for the Book within "my_dll" with an
     // ISBN matching "target_isbn". Return a pointer to that book immediately
     // upon finding it, or a null pointer when you know the book is not in the
@@ -367,15 +668,18 @@ struct search_within_dll {
     return nullptr;
   }
 
-  std::list<Book>& my_dll;
+  std::list<Record>& my_dll;
   const std::string target_isbn;
 };
+template <class Record>
+search_within_dll(std::list<Record>&, const std::string&) -> search_within_dll<Record>;
 
+template <class Record = Book>
 struct search_within_sll {
   // Function takes no parameters, searches a singly linked list for a book with
   // an ISBN matching the target ISBN, and returns a pointer to that found book
   // if such a book is found, nullptr otherwise.
-  Book* operator()(const Book& unused) {
+  Record* operator()(const Record& unused) {
     // Write the lines of code to search for the Book within "my_sll" with an
     // ISBN matching "target_isbn". Return a pointer to that book immediately
     // upon finding it, or a null pointer when you know the book is not in the
@@ -391,15 +695,18 @@ struct search_within_sll {
     return nullptr;
   }
 
-  std::forward_list<Book>& my_sll;
+  std::forward_list<Record>& my_sll;
   const std::string target_isbn;
 };
+template <class Record>
+search_within_sll(std::forward_list<Record>&, const std::string&) -> search_within_sll<Record>;
 
+template <class Record = Book>
 struct search_within_bst {
   // Function takes no parameters, searches a binary search tree for a book with
   // an ISBN matching the target ISBN, and returns a pointer to that found book
   // if such a book is found, nullptr otherwise.
-  Book* operator()(const Book& unused) {
+  Record* operator()(const Record& unused) {
     // Write the lines of code to search for the Book within "my_bst" with an
     // ISBN matching "target_isbn". Return a pointer to that book immediately
     // upon finding it, or a null pointer when you know the book is not in the
@@ -416,15 +723,18 @@ struct search_within_bst {
     return nullptr;
   }
 
-  std::map<std::string, Book>& my_bst;
+  std::map<isbn_key_t<Record>, Record>& my_bst;
   const std::string target_isbn;
 };
+template <class Key, class Record>
+search_within_bst(std::map<Key, Record>&, const std::string&) -> search_within_bst<Record>;
 
+template <class Record = Book>
 struct search_within_hash_table {
   // Function takes no parameters, searches a hash table for a book with an ISBN
   // matching the target ISBN, and returns a pointer to that found book if such
   // a book is found, nullptr otherwise.
-  Book* operator()(const Book& unused) {
+  Record* operator()(const Record& unused) {
     // Write the lines of code to search for the Book within "my_hash_table"
     // with an ISBN matching "target_isbn". Return a pointer to that book
     // immediately upon finding it, or a null pointer when you know the book is
@@ -441,8 +751,10 @@ struct search_within_hash_table {
     return nullptr;
   }
 
-  std::unordered_map<std::string, Book>& my_hash_table;
+  std::unordered_map<isbn_key_t<Record>, Record>& my_hash_table;
   const std::string target_isbn;
 };
+template <class Key, class Record>
+search_within_hash_table(std::unordered_map<Key, Record>&, const std::string&) -> search_within_hash_table<Record>;
 
 #endif
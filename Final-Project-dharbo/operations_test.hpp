@@ -351,6 +351,147 @@ TEST_CASE("RemoveFromHashTable") {
   }
 }
 
+//
+// BULK TESTS
+//
+
+TEST_CASE("BulkInsertAtBackOfVector") {
+  std::vector<Book> vec = std::vector<Book>();
+  const std::vector<Book> batch = {book, other_book};
+
+  vec.push_back(unused_book);
+  bulk_insert_at_back_of_vector{vec}(batch.begin(), batch.end());
+  CHECK_EQ(vec, std::vector<Book>{unused_book, book, other_book});
+}
+
+TEST_CASE("BulkInsertAtBackOfDll") {
+  std::list<Book> dll = std::list<Book>();
+  const std::vector<Book> batch = {book, other_book};
+
+  dll.push_back(unused_book);
+  bulk_insert_at_back_of_dll{dll}(batch.begin(), batch.end());
+  CHECK_EQ(dll, std::list<Book>{unused_book, book, other_book});
+}
+
+TEST_CASE("BulkInsertAtBackOfSll") {
+  std::forward_list<Book> sll = std::forward_list<Book>();
+  const std::vector<Book> batch = {book, other_book};
+
+  SUBCASE("EmptySll") {
+    bulk_insert_at_back_of_sll{sll}(batch.begin(), batch.end());
+    CHECK_EQ(sll, std::forward_list<Book>{book, other_book});
+  }
+
+  SUBCASE("NonEmptySll") {
+    sll.push_front(unused_book);
+    bulk_insert_at_back_of_sll{sll}(batch.begin(), batch.end());
+    CHECK_EQ(sll, std::forward_list<Book>{unused_book, book, other_book});
+  }
+}
+
+TEST_CASE("BulkInsertIntoBst") {
+  std::map<std::string, Book> bst = std::map<std::string, Book>();
+  const Book replacement = Book(book).price(1.0);
+  const std::vector<Book> batch = {other_book, book, unused_book, replacement};
+
+  bulk_insert_into_bst{bst}(batch.begin(), batch.end());
+  CHECK_EQ(bst.size(), 3);
+  CHECK_EQ(bst[book.isbn()], replacement);
+  CHECK_EQ(bst[other_book.isbn()], other_book);
+  CHECK_EQ(bst[unused_book.isbn()], unused_book);
+}
+
+TEST_CASE("BulkInsertIntoHashTable") {
+  std::unordered_map<std::string, Book> hash_table =
+      std::unordered_map<std::string, Book>();
+  const std::vector<Book> batch = {book, other_book};
+
+  hash_table[unused_book.isbn()] = unused_book;
+  bulk_insert_into_hash_table{hash_table}(batch.begin(), batch.end());
+  CHECK_EQ(hash_table.size(), 3);
+  CHECK_EQ(hash_table[book.isbn()], book);
+  CHECK_EQ(hash_table[other_book.isbn()], other_book);
+}
+
+TEST_CASE("BulkRemoveFromBackOfVector") {
+  std::vector<Book> vec = {other_book, book, book};
+  const std::vector<Book> batch = {unused_book, unused_book};
+
+  SUBCASE("EnoughBooks") {
+    bulk_remove_from_back_of_vector{vec}(batch.begin(), batch.end());
+    CHECK_EQ(vec, std::vector<Book>{other_book});
+  }
+
+  SUBCASE("TooFewBooks") {
+    vec.pop_back();
+    vec.pop_back();
+    CHECK_THROWS_AS(
+        bulk_remove_from_back_of_vector{vec}(batch.begin(), batch.end()),
+        std::out_of_range);
+  }
+}
+
+TEST_CASE("BulkRemoveFromFrontOfDll") {
+  std::list<Book> dll = {book, book, other_book};
+  const std::vector<Book> batch = {unused_book, unused_book};
+
+  SUBCASE("EnoughBooks") {
+    bulk_remove_from_front_of_dll{dll}(batch.begin(), batch.end());
+    CHECK_EQ(dll, std::list<Book>{other_book});
+  }
+
+  SUBCASE("TooFewBooks") {
+    dll.pop_back();
+    dll.pop_back();
+    CHECK_THROWS_AS(
+        bulk_remove_from_front_of_dll{dll}(batch.begin(), batch.end()),
+        std::out_of_range);
+  }
+}
+
+TEST_CASE("BulkRemoveFromFrontOfSll") {
+  std::forward_list<Book> sll = {book, book, other_book};
+  const std::vector<Book> batch = {unused_book, unused_book};
+
+  SUBCASE("EnoughBooks") {
+    bulk_remove_from_front_of_sll{sll}(batch.begin(), batch.end());
+    CHECK_EQ(sll, std::forward_list<Book>{other_book});
+  }
+
+  SUBCASE("TooFewBooks") {
+    sll.pop_front();
+    sll.pop_front();
+    CHECK_THROWS_AS(
+        bulk_remove_from_front_of_sll{sll}(batch.begin(), batch.end()),
+        std::out_of_range);
+  }
+}
+
+TEST_CASE("BulkRemoveFromBst") {
+  std::map<std::string, Book> bst = std::map<std::string, Book>();
+  const std::vector<Book> batch = {other_book, book, unused_book};
+
+  bst[book.isbn()] = book;
+  bst[other_book.isbn()] = other_book;
+  bst["zzz"] = unused_book;
+  bulk_remove_from_bst{bst}(batch.begin(), batch.end());
+  CHECK_EQ(bst.size(), 1);
+  CHECK_EQ(bst.count("zzz"), 1);
+}
+
+TEST_CASE("BulkRemoveFromHashTable") {
+  std::unordered_map<std::string, Book> hash_table =
+      std::unordered_map<std::string, Book>();
+  const std::vector<Book> batch = {other_book, book, unused_book};
+
+  hash_table[book.isbn()] = book;
+  hash_table[other_book.isbn()] = other_book;
+  hash_table["zzz"] = unused_book;
+  bulk_remove_from_hash_table{hash_table}(batch.begin(), batch.end());
+  CHECK_EQ(hash_table.size(), 1);
+  CHECK_EQ(hash_table.count("zzz"), 1);
+}
+
 //
 // SEARCH TESTS
 //
@@ -0,0 +1,176 @@
+#include "price_index.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+struct PriceIndex::Node {
+  Node(double price, std::string_view isbn, std::uint64_t priority)
+      : price(price), isbn(isbn), priority(priority), sum(price) {}
+
+  double price;
+  std::string isbn;
+  std::uint64_t priority;                             // greater than every priority below it
+  std::size_t count = 1;                              // of the subtree rooted here
+  double sum;
+  std::unique_ptr<Node> left;
+  std::unique_ptr<Node> right;
+};
+
+namespace {
+
+using NodePtr = std::unique_ptr<PriceIndex::Node>;
+
+std::size_t count_of(const NodePtr& node) { return node ? node->count : 0; }
+double sum_of(const NodePtr& node) { return node ? node->sum : 0.0; }
+
+// Recomputes a node's subtree count and sum from its children's. Recomputing
+// rather than adjusting keeps the sums from drifting over many updates.
+void update(PriceIndex::Node& node) {
+  node.count = 1 + count_of(node.left) + count_of(node.right);
+  node.sum = sum_of(node.left) + node.price + sum_of(node.right);
+}
+
+// Whether the entry (price, isbn) orders before "node".
+bool before(double price, std::string_view isbn, const PriceIndex::Node& node) {
+  return price < node.price || (price == node.price && isbn < node.isbn);
+}
+
+// Splits "node" into the entries ordered before (price, isbn) and the rest.
+std::pair<NodePtr, NodePtr> split(NodePtr node, double price, std::string_view isbn) {
+  if (!node) {
+    return {nullptr, nullptr};
+  }
+  if (before(price, isbn, *node)) {
+    auto [left, right] = split(std::move(node->left), price, isbn);
+    node->left = std::move(right);
+    update(*node);
+    return {std::move(left), std::move(node)};
+  }
+  auto [left, right] = split(std::move(node->right), price, isbn);
+  node->right = std::move(left);
+  update(*node);
+  return {std::move(node), std::move(right)};
+}
+
+// Joins two treaps, every entry of "left" ordered before every entry of
+// "right".
+NodePtr merge(NodePtr left, NodePtr right) {
+  if (!left) return right;
+  if (!right) return left;
+  if (left->priority > right->priority) {
+    left->right = merge(std::move(left->right), std::move(right));
+    update(*left);
+    return left;
+  }
+  right->left = merge(std::move(left), std::move(right->left));
+  update(*right);
+  return right;
+}
+
+// Removes the entry (price, isbn) from the subtree at "node".
+bool erase(NodePtr& node, double price, std::string_view isbn) {
+  if (!node) {
+    return false;
+  }
+  if (price == node->price && isbn == node->isbn) {
+    node = merge(std::move(node->left), std::move(node->right));
+    return true;
+  }
+  const bool erased = before(price, isbn, *node) ? erase(node->left, price, isbn)
+                                                 : erase(node->right, price, isbn);
+  if (erased) {
+    update(*node);
+  }
+  return erased;
+}
+
+std::size_t height_of(const NodePtr& node) {
+  return node ? 1 + std::max(height_of(node->left), height_of(node->right)) : 0;
+}
+
+void add(PriceSummary& summary, std::size_t count, double sum) {
+  summary.count += count;
+  summary.sum += sum;
+}
+
+}  // namespace
+
+//
+// Constructors, Assignments, and Destructor
+//
+
+PriceIndex::PriceIndex() : priorities_(0x5eed) {}
+PriceIndex::~PriceIndex() noexcept = default;
+PriceIndex::PriceIndex(PriceIndex&&) noexcept = default;
+PriceIndex& PriceIndex::operator=(PriceIndex&&) noexcept = default;
+
+//
+// Modifiers
+//
+
+void PriceIndex::insert(double price, std::string_view isbn) {
+  auto [left, right] = split(std::move(root_), price, isbn);
+  auto node = std::make_unique<Node>(price, isbn, priorities_());
+  root_ = merge(merge(std::move(left), std::move(node)), std::move(right));
+}
+
+bool PriceIndex::remove(double price, std::string_view isbn) {
+  return erase(root_, price, isbn);
+}
+
+void PriceIndex::clear() {
+  root_.reset();
+}
+
+//
+// Queries
+//
+
+PriceSummary PriceIndex::summarize(double low, double high) const {
+  PriceSummary summary;
+
+  // The highest node in the range; every other node in it is below.
+  const Node* split_node = root_.get();
+  while (split_node != nullptr && (split_node->price < low || split_node->price > high)) {
+    split_node = split_node->price < low ? split_node->right.get() : split_node->left.get();
+  }
+  if (split_node == nullptr) {
+    return summary;
+  }
+  add(summary, 1, split_node->price);
+
+  // Down the left subtree toward "low": a node in the range brings its right
+  // subtree, which is in the range too.
+  for (const Node* node = split_node->left.get(); node != nullptr;) {
+    if (node->price >= low) {
+      add(summary, 1 + count_of(node->right), node->price + sum_of(node->right));
+      node = node->left.get();
+    } else {
+      node = node->right.get();
+    }
+  }
+
+  // Likewise down the right subtree toward "high".
+  for (const Node* node = split_node->right.get(); node != nullptr;) {
+    if (node->price <= high) {
+      add(summary, 1 + count_of(node->left), node->price + sum_of(node->left));
+      node = node->right.get();
+    } else {
+      node = node->left.get();
+    }
+  }
+  return summary;
+}
+
+PriceSummary PriceIndex::total() const {
+  return PriceSummary{count_of(root_), sum_of(root_)};
+}
+
+std::size_t PriceIndex::height() const {
+  return height_of(root_);
+}
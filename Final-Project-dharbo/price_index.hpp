@@ -0,0 +1,144 @@
+#ifndef _price_index_hpp_
+#define _price_index_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "book.hpp"
+
+// The number of books in a price range and the sum of their prices.
+struct PriceSummary {
+  std::size_t count = 0;
+  double sum = 0.0;
+
+  // The mean price, or 0 for no books.
+  double average() const { return count > 0 ? sum / count : 0.0; }
+};
+
+// An index of books by price that answers "how many books, and at what
+// average price, cost between $10 and $20" in O(log n), where a scan of the
+// books is O(n).
+//
+// The index is a treap, a binary search tree kept balanced by random
+// priorities, ordered by (price, ISBN). Each node is augmented with the count
+// and price sum of its subtree, so a range query adds up whole subtrees along
+// the two paths to the range's ends instead of visiting the books between
+// them. Inserts and removes are expected O(log n) and update the sums on the
+// way.
+//
+// The index keeps each book's price and ISBN, not the book; a catalog that
+// changes a price removes the book with its old price and inserts it with the
+// new one.
+//
+// Usage:
+//
+//   PriceIndex index;
+//   for (const Book& book : books) index.insert(book);
+//   PriceSummary summary = index.summarize(10.0, 20.0);
+//   std::cout << summary.count << " books, average $" << summary.average() << '\n';
+class PriceIndex {
+ public:
+  PriceIndex();
+  ~PriceIndex() noexcept;
+
+  PriceIndex(const PriceIndex&) = delete;
+  PriceIndex& operator=(const PriceIndex&) = delete;
+  PriceIndex(PriceIndex&&) noexcept;
+  PriceIndex& operator=(PriceIndex&&) noexcept;
+
+  //
+  // Modifiers
+  //
+
+  // Adds "book" at its price. A book added twice is counted twice.
+  void insert(const Book& book) { insert(book.price(), book.isbn()); }
+  void insert(double price, std::string_view isbn);
+
+  // Removes one entry for "book" at its price. Returns false if there is none.
+  bool remove(const Book& book) { return remove(book.price(), book.isbn()); }
+  bool remove(double price, std::string_view isbn);
+
+  void clear();
+
+  //
+  // Queries
+  //
+
+  // The books priced from "low" through "high", both inclusive.
+  PriceSummary summarize(double low, double high) const;
+
+  // Every book in the index.
+  PriceSummary total() const;
+
+  std::size_t size() const { return total().count; }
+  bool empty() const { return root_ == nullptr; }
+
+  // Levels from the root to the deepest leaf, for checking the balance.
+  std::size_t height() const;
+
+  // A tree node, defined in price_index.cpp.
+  struct Node;
+
+ private:
+  std::unique_ptr<Node> root_;
+  std::mt19937_64 priorities_;
+};
+
+//
+// PRICE INDEX OPERATIONS
+//
+
+struct insert_into_price_index {
+  // Function takes a constant Book as a parameter, adds that book at its price
+  // to a price index, and returns nothing.
+  void operator()(const Book& book) { my_index.insert(book); }
+
+  PriceIndex& my_index;
+};
+
+struct remove_from_price_index {
+  // Function takes a constant Book as a parameter, removes that book at its
+  // price from a price index (if present), and returns nothing.
+  void operator()(const Book& book) { my_index.remove(book); }
+
+  PriceIndex& my_index;
+};
+
+struct summarize_price_range_of_price_index {
+  // Function takes no parameters, counts and sums the prices of the books in a
+  // price index priced within the target range, and returns the summary.
+  PriceSummary operator()(const Book& unused) { return my_index.summarize(low, high); }
+
+  const PriceIndex& my_index;
+  const double low;
+  const double high;
+};
+
+template <class Record = Book>
+struct summarize_price_range_of_vector {
+  // Function takes no parameters, scans a vector for the books priced within
+  // the target range, and returns their count and the sum of their prices.
+  PriceSummary operator()(const Record& unused) {
+    PriceSummary summary;
+    for (const Record& book : my_vector) {
+      if (book.price() >= low && book.price() <= high) {
+        ++summary.count;
+        summary.sum += book.price();
+      }
+    }
+    return summary;
+  }
+
+  const std::vector<Record>& my_vector;
+  const double low;
+  const double high;
+};
+template <class Record>
+summarize_price_range_of_vector(const std::vector<Record>&, double, double) -> summarize_price_range_of_vector<Record>;
+
+#endif
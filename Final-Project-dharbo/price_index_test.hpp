@@ -0,0 +1,91 @@
+#ifndef _price_index_test_hpp_
+#define _price_index_test_hpp_
+
+#include "price_index.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("PriceIndex") {
+  PriceIndex index;
+  const Book unused;
+
+  SUBCASE("Empty") {
+    CHECK(index.empty());
+    CHECK_EQ(index.summarize(0.0, 100.0).count, 0);
+    CHECK_EQ(index.summarize(0.0, 100.0).average(), 0.0);
+    CHECK_FALSE(index.remove(Book("title", "author", "isbn", 1.0)));
+  }
+
+  SUBCASE("SummarizesInclusiveRanges") {
+    for (double price : {5.0, 10.0, 12.5, 20.0, 20.0, 25.0}) {
+      insert_into_price_index{index}(Book("title", "author", std::to_string(price), price));
+    }
+    index.insert(20.0, "another");
+    CHECK_EQ(index.size(), 7);
+    const PriceSummary summary = summarize_price_range_of_price_index{index, 10.0, 20.0}(unused);
+    CHECK_EQ(summary.count, 5);
+    CHECK_EQ(summary.sum, doctest::Approx(82.5));
+    CHECK_EQ(summary.average(), doctest::Approx(16.5));
+    CHECK_EQ(index.summarize(20.0, 20.0).count, 3);
+    CHECK_EQ(index.summarize(20.5, 24.0).count, 0);
+    CHECK_EQ(index.summarize(30.0, 10.0).count, 0);
+    CHECK_EQ(index.total().sum, doctest::Approx(112.5));
+
+    CHECK(index.remove(20.0, "another"));
+    CHECK_FALSE(index.remove(20.0, "another"));
+    CHECK_FALSE(index.remove(21.0, "20.000000"));
+    remove_from_price_index{index}(Book("title", "author", "10.000000", 10.0));
+    CHECK_EQ(index.summarize(10.0, 20.0).count, 3);
+  }
+
+  SUBCASE("MatchesAScanUnderUpdates") {
+    std::default_random_engine random(45);
+    std::uniform_int_distribution<int> cents(0, 10000);
+    std::vector<Book> books;
+    for (std::size_t i = 0; i < 4000; ++i) {
+      books.push_back(Book("title", "author", std::to_string(i), cents(random) / 100.0));
+      index.insert(books.back());
+    }
+    // Remove every third book, then reprice every fifth.
+    std::vector<Book> kept;
+    for (std::size_t i = 0; i < books.size(); ++i) {
+      if (i % 3 == 0) {
+        CHECK(index.remove(books[i]));
+        continue;
+      }
+      if (i % 5 == 0) {
+        index.remove(books[i]);
+        books[i].price(cents(random) / 100.0);
+        index.insert(books[i]);
+      }
+      kept.push_back(books[i]);
+    }
+    CHECK_EQ(index.size(), kept.size());
+    CHECK_LT(index.height(), 50);
+
+    for (std::size_t i = 0; i < 200; ++i) {
+      double low = cents(random) / 100.0, high = cents(random) / 100.0;
+      if (low > high) std::swap(low, high);
+      const PriceSummary expected = summarize_price_range_of_vector{kept, low, high}(unused);
+      const PriceSummary found = index.summarize(low, high);
+      CHECK_EQ(found.count, expected.count);
+      CHECK_EQ(found.sum, doctest::Approx(expected.sum));
+    }
+  }
+
+  SUBCASE("Clear") {
+    index.insert(1.0, "isbn");
+    index.clear();
+    CHECK(index.empty());
+    CHECK_EQ(index.total().count, 0);
+  }
+}
+
+#endif
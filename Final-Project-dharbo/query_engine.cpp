@@ -0,0 +1,528 @@
+#include "query_engine.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "range_scan.hpp"
+
+namespace {
+
+// Guesses for the conditions no statistic covers.
+constexpr double STARTS_WITH_SELECTIVITY = 0.01;
+constexpr double BETWEEN_SELECTIVITY = 0.1;
+constexpr double CONTAINS_SELECTIVITY = 0.05;
+
+// The cost model, in units of one book scanned in place and tested. Books
+// reached through an index are each a pointer away, and likely a cache miss.
+constexpr double SCAN_ROW = 1.0;
+constexpr double HASH_PROBE = 2.0;
+constexpr double TREE_LEVEL = 1.0;                    // per level of a descent
+constexpr double FETCH_ROW = 2.0;                     // follow an index entry to its book
+constexpr double FILTER_ROW = 0.5;                    // test a book already fetched
+constexpr double UNION_ROW = 1.0;                     // check a book against those returned
+
+std::string_view field_of(const Book& book, QueryField field) {
+  switch (field) {
+    case QueryField::Isbn: return book.isbn();
+    case QueryField::Title: return book.title();
+    default: return book.author();
+  }
+}
+
+const char* name_of(QueryField field) {
+  switch (field) {
+    case QueryField::Isbn: return "isbn";
+    case QueryField::Title: return "title";
+    case QueryField::Author: return "author";
+    default: return "price";
+  }
+}
+
+Predicate comparison(Predicate::Kind kind, QueryField field, std::string_view text) {
+  if (field == QueryField::Price) {
+    throw std::invalid_argument("Prices are compared with Predicate::price_between().");
+  }
+  Predicate predicate;
+  predicate.kind = kind;
+  predicate.field = field;
+  predicate.text = std::string(text);
+  return predicate;
+}
+
+Predicate join(Predicate::Kind kind, Predicate lhs, Predicate rhs) {
+  Predicate joined;
+  joined.kind = kind;
+  for (Predicate* operand : {&lhs, &rhs}) {
+    if (operand->kind == kind) {
+      for (Predicate& inner : operand->operands) joined.operands.push_back(std::move(inner));
+    } else {
+      joined.operands.push_back(std::move(*operand));
+    }
+  }
+  return joined;
+}
+
+// The ISBNs a comparison of them selects, or none if it is not a range.
+std::optional<IsbnRange> isbn_range_of(const Predicate& predicate) {
+  if (predicate.field != QueryField::Isbn) return std::nullopt;
+  switch (predicate.kind) {
+    case Predicate::Kind::Between: return IsbnRange{predicate.text, predicate.last};
+    case Predicate::Kind::StartsWith: return IsbnRange::with_prefix(predicate.text);
+    default: return std::nullopt;
+  }
+}
+
+// The fraction of the books below "value" by an equi-depth histogram's
+// "bounds", with "within(first, last, value)" the fraction of a bucket
+// below it.
+template <class Value, class Within>
+double fraction_below(const std::vector<Value>& bounds, const Value& value, Within within) {
+  if (bounds.empty() || value <= bounds.front()) return 0.0;
+  if (value > bounds.back()) return 1.0;
+  const std::size_t i = std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+  return (i - 1 + within(bounds[i - 1], bounds[i], value)) / (bounds.size() - 1);
+}
+
+double price_fraction_below(const std::vector<double>& bounds, double price) {
+  return fraction_below(bounds, price,
+                        [](double first, double last, double value) { return (value - first) / (last - first); });
+}
+
+// Where "text" falls among strings of the bytes ["low", "high"] as a
+// number in [0, 1): its bytes past the "shared" prefix read as digits in
+// base high - low + 1. Like PostgreSQL's planner, this spreads ISBNs over
+// the ten digits rather than over all 256 byte values.
+double string_position(const std::string& text, std::size_t shared, unsigned char low, unsigned char high) {
+  const double base = high - low + 1.0;
+  double position = 0.0;
+  double scale = 1.0;
+  for (std::size_t i = shared; i < text.size() && i < shared + 8; ++i) {
+    scale /= base;
+    position += (std::clamp(static_cast<unsigned char>(text[i]), low, high) - low) * scale;
+  }
+  return position;
+}
+
+double isbn_fraction_below(const std::vector<std::string>& bounds, const std::string& isbn) {
+  return fraction_below(bounds, isbn, [](const std::string& first, const std::string& last, const std::string& value) {
+    const std::size_t shared = std::mismatch(first.begin(), first.end(), last.begin(), last.end()).first - first.begin();
+    unsigned char low = 0xFF;
+    unsigned char high = 0;
+    for (const std::string* text : {&first, &last, &value}) {
+      for (std::size_t i = shared; i < text->size(); ++i) {
+        low = std::min(low, static_cast<unsigned char>((*text)[i]));
+        high = std::max(high, static_cast<unsigned char>((*text)[i]));
+      }
+    }
+    if (low > high) return 0.5;
+    const double start = string_position(first, shared, low, high);
+    const double end = string_position(last, shared, low, high);
+    return end > start ? std::clamp((string_position(value, shared, low, high) - start) / (end - start), 0.0, 1.0)
+                       : 0.5;
+  });
+}
+
+// Equi-depth bounds of "values", sorted.
+template <class Value>
+std::vector<Value> histogram_bounds(const std::vector<Value>& values) {
+  std::vector<Value> bounds;
+  if (values.empty()) return bounds;
+  for (std::size_t i = 0; i <= TableStatistics::HISTOGRAM_BUCKETS; ++i) {
+    bounds.push_back(values[i * (values.size() - 1) / TableStatistics::HISTOGRAM_BUCKETS]);
+  }
+  return bounds;
+}
+
+//
+// Cursors
+//
+
+// Every book, or those matching a predicate, in storage order.
+class ScanCursor : public BookCursor {
+ public:
+  ScanCursor(const std::vector<Book>& books, const Predicate& predicate)
+      : next_(books.data()), end_(books.data() + books.size()), predicate_(predicate) {}
+
+  const Book* next() override {
+    while (next_ != end_) {
+      const Book* book = next_++;
+      if (predicate_.matches(*book)) return book;
+    }
+    return nullptr;
+  }
+
+ private:
+  const Book* next_;
+  const Book* end_;
+  const Predicate& predicate_;
+};
+
+// The books of an index's entries in [first, last).
+template <class Iterator>
+class IndexCursor : public BookCursor {
+ public:
+  IndexCursor(Iterator first, Iterator last) : next_(first), last_(last) {}
+
+  const Book* next() override { return next_ != last_ ? (next_++)->second : nullptr; }
+
+ private:
+  Iterator next_;
+  Iterator last_;
+};
+
+template <class Iterator>
+std::unique_ptr<BookCursor> make_index_cursor(Iterator first, Iterator last) {
+  return std::make_unique<IndexCursor<Iterator>>(first, last);
+}
+
+// The books of each input in turn, each once.
+class UnionCursor : public BookCursor {
+ public:
+  explicit UnionCursor(std::vector<std::unique_ptr<BookCursor>> inputs) : inputs_(std::move(inputs)) {}
+
+  const Book* next() override {
+    for (; current_ < inputs_.size(); ++current_) {
+      while (const Book* book = inputs_[current_]->next()) {
+        if (returned_.insert(book).second) return book;
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  std::vector<std::unique_ptr<BookCursor>> inputs_;
+  std::size_t current_ = 0;
+  std::unordered_set<const Book*> returned_;
+};
+
+// The books of the input that match a predicate.
+class FilterCursor : public BookCursor {
+ public:
+  FilterCursor(std::unique_ptr<BookCursor> input, const Predicate& predicate)
+      : input_(std::move(input)), predicate_(predicate) {}
+
+  const Book* next() override {
+    while (const Book* book = input_->next()) {
+      if (predicate_.matches(*book)) return book;
+    }
+    return nullptr;
+  }
+
+ private:
+  std::unique_ptr<BookCursor> input_;
+  const Predicate& predicate_;
+};
+
+void explain(const QueryPlan& plan, std::size_t depth, std::ostringstream& out) {
+  out << std::string(2 * depth, ' ') << QueryPlan::name(plan.op);
+  if (plan.op != QueryPlan::Operator::Union) out << ' ' << plan.predicate.to_string();
+  out << std::fixed << std::setprecision(1) << "  (rows " << plan.rows << ", cost " << plan.cost << ")\n";
+  for (const QueryPlan& input : plan.inputs) explain(input, depth + 1, out);
+}
+
+}  // namespace
+
+//
+// Predicate
+//
+
+Predicate Predicate::equals(QueryField field, std::string_view text) {
+  return comparison(Kind::Equals, field, text);
+}
+
+Predicate Predicate::between(QueryField field, std::string_view first, std::optional<std::string> last) {
+  Predicate predicate = comparison(Kind::Between, field, first);
+  predicate.last = std::move(last);
+  return predicate;
+}
+
+Predicate Predicate::starts_with(QueryField field, std::string_view prefix) {
+  return comparison(Kind::StartsWith, field, prefix);
+}
+
+Predicate Predicate::contains(QueryField field, std::string_view text) {
+  return comparison(Kind::Contains, field, text);
+}
+
+Predicate Predicate::price_between(double low, double high) {
+  Predicate predicate;
+  predicate.kind = Kind::PriceBetween;
+  predicate.field = QueryField::Price;
+  predicate.low = low;
+  predicate.high = high;
+  return predicate;
+}
+
+bool Predicate::matches(const Book& book) const {
+  switch (kind) {
+    case Kind::Equals: return field_of(book, field) == text;
+    case Kind::Between: {
+      const std::string_view value = field_of(book, field);
+      return value >= text && (!last || value < *last);
+    }
+    case Kind::StartsWith: return field_of(book, field).substr(0, text.size()) == text;
+    case Kind::Contains: return field_of(book, field).find(text) != std::string_view::npos;
+    case Kind::PriceBetween: return book.price() >= low && book.price() <= high;
+    case Kind::And:
+      return std::all_of(operands.begin(), operands.end(), [&](const Predicate& p) { return p.matches(book); });
+    default:
+      return std::any_of(operands.begin(), operands.end(), [&](const Predicate& p) { return p.matches(book); });
+  }
+}
+
+std::string Predicate::to_string() const {
+  std::ostringstream out;
+  switch (kind) {
+    case Kind::Equals: out << name_of(field) << " = " << std::quoted(text); break;
+    case Kind::Between:
+      out << name_of(field) << " in [" << std::quoted(text) << ", ";
+      if (last) out << std::quoted(*last) << ')';
+      else out << "...)";
+      break;
+    case Kind::StartsWith: out << name_of(field) << " starts with " << std::quoted(text); break;
+    case Kind::Contains: out << name_of(field) << " contains " << std::quoted(text); break;
+    case Kind::PriceBetween: out << "price in [" << low << ", " << high << ']'; break;
+    default:
+      if (operands.empty()) {
+        out << (kind == Kind::And ? "TRUE" : "FALSE");
+        break;
+      }
+      out << '(';
+      for (std::size_t i = 0; i < operands.size(); ++i) {
+        out << (i > 0 ? (kind == Kind::And ? " AND " : " OR ") : "") << operands[i].to_string();
+      }
+      out << ')';
+      break;
+  }
+  return out.str();
+}
+
+Predicate operator&&(Predicate lhs, Predicate rhs) {
+  return join(Predicate::Kind::And, std::move(lhs), std::move(rhs));
+}
+
+Predicate operator||(Predicate lhs, Predicate rhs) {
+  return join(Predicate::Kind::Or, std::move(lhs), std::move(rhs));
+}
+
+//
+// Statistics and Plans
+//
+
+double TableStatistics::selectivity(const Predicate& predicate) const {
+  if (rows == 0) return 0.0;
+  using Kind = Predicate::Kind;
+  switch (predicate.kind) {
+    case Kind::Equals:
+      if (predicate.field == QueryField::Isbn) return 1.0 / rows;
+      return 1.0 / std::max<std::size_t>(predicate.field == QueryField::Title ? distinct_titles : distinct_authors, 1);
+    case Kind::Between:
+    case Kind::StartsWith: {
+      const std::optional<IsbnRange> range = isbn_range_of(predicate);
+      if (!range) return predicate.kind == Kind::Between ? BETWEEN_SELECTIVITY : STARTS_WITH_SELECTIVITY;
+      const double below_last = range->last ? isbn_fraction_below(isbn_bounds, *range->last) : 1.0;
+      return std::max(below_last - isbn_fraction_below(isbn_bounds, range->first), 0.0);
+    }
+    case Kind::Contains: return CONTAINS_SELECTIVITY;
+    case Kind::PriceBetween:
+      if (predicate.low > predicate.high) return 0.0;
+      if (predicate.low == predicate.high) return 1.0 / std::max<std::size_t>(distinct_prices, 1);
+      return std::max(price_fraction_below(price_bounds, std::nextafter(predicate.high, HUGE_VAL)) -
+                          price_fraction_below(price_bounds, predicate.low),
+                      0.0);
+    case Kind::And: {
+      double selected = 1.0;
+      for (const Predicate& operand : predicate.operands) selected *= selectivity(operand);
+      return selected;
+    }
+    default: {
+      double missed = 1.0;
+      for (const Predicate& operand : predicate.operands) missed *= 1.0 - selectivity(operand);
+      return 1.0 - missed;
+    }
+  }
+}
+
+const char* QueryPlan::name(Operator op) {
+  static const char* const names[] = {"Full scan",     "ISBN hash lookup", "ISBN range", "Price range",
+                                      "Author lookup", "Title lookup",     "Union",      "Filter"};
+  return names[static_cast<int>(op)];
+}
+
+std::string QueryPlan::explain() const {
+  std::ostringstream out;
+  ::explain(*this, 0, out);
+  return out.str();
+}
+
+//
+// Constructors
+//
+
+BookTable::BookTable(const std::vector<Book>& books) {
+  std::unordered_map<std::string_view, std::size_t> positions;
+  books_.reserve(books.size());
+  for (const Book& book : books) {
+    auto [position, inserted] = positions.try_emplace(book.isbn(), books_.size());
+    if (inserted) {
+      books_.push_back(book);
+    } else {
+      books_[position->second] = book;
+    }
+  }
+
+  std::vector<std::string> isbns;
+  std::vector<double> prices;
+  std::unordered_set<std::string_view> titles;
+  std::unordered_set<std::string_view> authors;
+  for (const Book& book : books_) {
+    by_isbn_.emplace(book.isbn(), &book);
+    isbn_order_.emplace(book.isbn(), &book);
+    price_order_.emplace(book.price(), &book);
+    by_author_.emplace(book.author(), &book);
+    by_title_.emplace(book.title(), &book);
+    isbns.push_back(book.isbn());
+    prices.push_back(book.price());
+    titles.insert(book.title());
+    authors.insert(book.author());
+  }
+  std::sort(isbns.begin(), isbns.end());
+  std::sort(prices.begin(), prices.end());
+
+  statistics_.rows = books_.size();
+  statistics_.distinct_titles = titles.size();
+  statistics_.distinct_authors = authors.size();
+  statistics_.isbn_bounds = histogram_bounds(isbns);
+  statistics_.price_bounds = histogram_bounds(prices);
+  statistics_.distinct_prices = std::unique(prices.begin(), prices.end()) - prices.begin();
+}
+
+//
+// Queries
+//
+
+std::optional<BookTable::Path> BookTable::index_path(const Predicate& predicate) const {
+  using Kind = Predicate::Kind;
+  using Operator = QueryPlan::Operator;
+  const double rows = statistics_.selectivity(predicate) * statistics_.rows;
+  const double descent = TREE_LEVEL * std::log2(statistics_.rows + 1.0);
+  auto leaf = [&](Operator op, double probe) {
+    return Path{QueryPlan{op, predicate, {}, rows, probe + rows * FETCH_ROW}, true};
+  };
+
+  switch (predicate.kind) {
+    case Kind::Equals:
+      // The ISBN's ordered index could answer too, but its descent costs
+      // more than a hash probe.
+      if (predicate.field == QueryField::Isbn) return leaf(Operator::IsbnHashLookup, HASH_PROBE);
+      return leaf(predicate.field == QueryField::Author ? Operator::AuthorLookup : Operator::TitleLookup, HASH_PROBE);
+    case Kind::Between:
+    case Kind::StartsWith:
+      if (predicate.field == QueryField::Isbn) return leaf(Operator::IsbnRange, descent);
+      return std::nullopt;
+    case Kind::PriceBetween: return leaf(Operator::PriceRange, descent);
+    case Kind::And: {
+      // Walk the cheapest operand's path and filter its books by the rest.
+      std::optional<Path> best;
+      for (const Predicate& operand : predicate.operands) {
+        std::optional<Path> path = index_path(operand);
+        if (path && (!best || path->plan.cost < best->plan.cost)) best = std::move(path);
+      }
+      if (best && predicate.operands.size() > 1) best->exact = false;
+      return best;
+    }
+    case Kind::Or: {
+      // Every operand needs a path, or some of its books could be missed.
+      if (predicate.operands.empty()) return std::nullopt;
+      Path path{QueryPlan{Operator::Union, predicate, {}, rows, 0.0}, true};
+      double returned = 0.0;
+      for (const Predicate& operand : predicate.operands) {
+        std::optional<Path> input = index_path(operand);
+        if (!input) return std::nullopt;
+        if (!input->exact) {
+          const double filtered = statistics_.selectivity(operand) * statistics_.rows;
+          const double cost = input->plan.cost + input->plan.rows * FILTER_ROW;
+          input->plan = QueryPlan{Operator::Filter, operand, {std::move(input->plan)}, filtered, cost};
+        }
+        returned += input->plan.rows;
+        path.plan.cost += input->plan.cost;
+        path.plan.inputs.push_back(std::move(input->plan));
+      }
+      path.plan.cost += returned * UNION_ROW;
+      return path;
+    }
+    default: return std::nullopt;
+  }
+}
+
+QueryPlan BookTable::plan(const Predicate& predicate, PlanMode mode) const {
+  const double rows = statistics_.selectivity(predicate) * statistics_.rows;
+  QueryPlan scan{QueryPlan::Operator::FullScan, predicate, {}, rows, statistics_.rows * SCAN_ROW};
+  if (mode == PlanMode::FullScan) {
+    return scan;
+  }
+  std::optional<Path> path = index_path(predicate);
+  if (!path) {
+    return scan;
+  }
+  if (!path->exact) {
+    const double cost = path->plan.cost + path->plan.rows * FILTER_ROW;
+    path->plan = QueryPlan{QueryPlan::Operator::Filter, predicate, {std::move(path->plan)}, rows, cost};
+  }
+  return path->plan.cost < scan.cost ? std::move(path->plan) : scan;
+}
+
+std::unique_ptr<BookCursor> BookTable::open(const QueryPlan& plan) const {
+  using Operator = QueryPlan::Operator;
+  const Predicate& predicate = plan.predicate;
+  switch (plan.op) {
+    case Operator::FullScan: return std::make_unique<ScanCursor>(books_, predicate);
+    case Operator::IsbnHashLookup: {
+      auto found = by_isbn_.find(predicate.text);
+      return make_index_cursor(found, found == by_isbn_.end() ? found : std::next(found));
+    }
+    case Operator::IsbnRange: {
+      const IsbnRange range = *isbn_range_of(predicate);
+      auto first = isbn_order_.lower_bound(range.first);
+      if (range.last && *range.last <= range.first) return make_index_cursor(first, first);
+      return make_index_cursor(first, range.last ? isbn_order_.lower_bound(*range.last) : isbn_order_.end());
+    }
+    case Operator::PriceRange: {
+      if (predicate.low > predicate.high) return make_index_cursor(price_order_.end(), price_order_.end());
+      return make_index_cursor(price_order_.lower_bound(predicate.low), price_order_.upper_bound(predicate.high));
+    }
+    case Operator::AuthorLookup: {
+      auto [first, last] = by_author_.equal_range(predicate.text);
+      return make_index_cursor(first, last);
+    }
+    case Operator::TitleLookup: {
+      auto [first, last] = by_title_.equal_range(predicate.text);
+      return make_index_cursor(first, last);
+    }
+    case Operator::Union: {
+      std::vector<std::unique_ptr<BookCursor>> inputs;
+      for (const QueryPlan& input : plan.inputs) inputs.push_back(open(input));
+      return std::make_unique<UnionCursor>(std::move(inputs));
+    }
+    default: return std::make_unique<FilterCursor>(open(plan.inputs.front()), predicate);
+  }
+}
+
+std::vector<const Book*> BookTable::select(const Predicate& predicate, PlanMode mode) const {
+  const QueryPlan chosen = plan(predicate, mode);
+  std::vector<const Book*> found;
+  std::unique_ptr<BookCursor> cursor = open(chosen);
+  while (const Book* book = cursor->next()) found.push_back(book);
+  return found;
+}
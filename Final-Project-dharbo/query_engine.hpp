@@ -0,0 +1,200 @@
+#ifndef _query_engine_hpp_
+#define _query_engine_hpp_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "book.hpp"
+
+// A small query engine over a catalog of books: conditions on ISBN, title,
+// author, and price combined with AND and OR, answered through whichever
+// access path the statistics say is cheapest.
+//
+// A BookTable holds the books and an index for each way to find them:
+//
+//   - a hash table by ISBN, for ISBN equality;
+//   - an ordered tree by ISBN, for ISBN ranges and prefixes;
+//   - an ordered tree by price, for price ranges;
+//   - hashed secondary indexes by author and by title, for equality.
+//
+// Planning estimates how many books each condition selects from statistics
+// gathered when the table is built: the row count, the distinct authors and
+// titles, and equi-depth histograms of ISBNs and prices, with conditions
+// taken as independent. Each access path is costed in units of one book
+// scanned, from the books it is expected to fetch, and the plan is the
+// cheapest of a full scan and the index paths:
+//
+//   - a condition an index answers becomes a lookup or range walk;
+//   - an AND uses the cheapest path among its operands and filters the rest;
+//   - an OR whose every operand has a path takes the union of their books.
+//
+// A plan runs as a pipeline of pull-based cursors (the "Volcano" model):
+// each cursor's next() pulls from its inputs just enough to return one more
+// book, so a plan streams its results without materializing them in
+// between.
+//
+// The table is built once and not modified; the books are deduplicated by
+// ISBN, the last one winning.
+//
+// Usage:
+//
+//   BookTable table(books);
+//   Predicate query = Predicate::equals(QueryField::Author, "Geoffrey Hull") && Predicate::price_between(10, 20);
+//   std::cout << table.plan(query).explain();
+//   for (const Book* book : table.select(query)) std::cout << *book << '\n';
+
+// A field of a book a condition tests.
+enum class QueryField { Isbn, Title, Author, Price };
+
+// A condition on a book: a comparison of one field, or an AND or OR of
+// conditions.
+struct Predicate {
+  enum class Kind { Equals, Between, StartsWith, Contains, PriceBetween, And, Or };
+
+  Kind kind = Kind::And;
+  QueryField field = QueryField::Isbn;
+  std::string text;                                   // compared with, or the first of a Between
+  std::optional<std::string> last;                    // a Between's exclusive end, or none
+  double low = 0.0;                                   // a PriceBetween's inclusive bounds
+  double high = 0.0;
+  std::vector<Predicate> operands;                    // of an And or Or
+
+  // Comparisons of the ISBN, title, or author, byte for byte: equal to
+  // "text", in ["first", "last") (from "first" on without "last"), starting
+  // with "prefix", or containing "text". Throws std::invalid_argument for
+  // the price, which is compared with price_between().
+  static Predicate equals(QueryField field, std::string_view text);
+  static Predicate between(QueryField field, std::string_view first, std::optional<std::string> last);
+  static Predicate starts_with(QueryField field, std::string_view prefix);
+  static Predicate contains(QueryField field, std::string_view text);
+
+  // Prices from "low" through "high", both inclusive.
+  static Predicate price_between(double low, double high);
+
+  bool matches(const Book& book) const;
+
+  // The condition as text, such as (author = "Lillian Too" AND price in [10, 20]).
+  std::string to_string() const;
+};
+
+// Conditions joined with AND or OR; joining an AND to an AND (or an OR to an
+// OR) flattens them.
+Predicate operator&&(Predicate lhs, Predicate rhs);
+Predicate operator||(Predicate lhs, Predicate rhs);
+
+// What the planner knows about a table.
+struct TableStatistics {
+  static constexpr std::size_t HISTOGRAM_BUCKETS = 64;
+
+  std::size_t rows = 0;
+  std::size_t distinct_titles = 0;
+  std::size_t distinct_authors = 0;
+  std::size_t distinct_prices = 0;
+
+  // Equi-depth histograms: HISTOGRAM_BUCKETS + 1 bounds, each bucket holding
+  // about as many books as the next, or none for an empty table.
+  std::vector<std::string> isbn_bounds;
+  std::vector<double> price_bounds;
+
+  // The estimated fraction of the books matching "predicate".
+  double selectivity(const Predicate& predicate) const;
+};
+
+// A step of a query plan, with the steps it pulls from. Lookups and range
+// walks return exactly the books of their predicate; a Filter returns the
+// books of its input that match its predicate.
+struct QueryPlan {
+  enum class Operator { FullScan, IsbnHashLookup, IsbnRange, PriceRange, AuthorLookup, TitleLookup, Union, Filter };
+
+  Operator op = Operator::FullScan;
+  Predicate predicate;
+  std::vector<QueryPlan> inputs;
+  double rows = 0.0;                                  // estimated books returned
+  double cost = 0.0;                                  // estimated, in books scanned, with the inputs'
+
+  // The plan as indented lines, one per step.
+  std::string explain() const;
+
+  // An operator's name, such as "ISBN range".
+  static const char* name(Operator op);
+};
+
+// A pull-based iterator over the books a plan step returns.
+class BookCursor {
+ public:
+  virtual ~BookCursor() = default;
+
+  // The next book, or null once there are no more.
+  virtual const Book* next() = 0;
+};
+
+// How to plan: by cost, or by scanning every book whatever the indexes.
+enum class PlanMode { CostBased, FullScan };
+
+class BookTable {
+ public:
+  explicit BookTable(const std::vector<Book>& books);
+
+  // The indexes point into the books, so a table does not copy.
+  BookTable(const BookTable&) = delete;
+  BookTable& operator=(const BookTable&) = delete;
+  BookTable(BookTable&&) = default;
+  BookTable& operator=(BookTable&&) = default;
+
+  //
+  // Queries
+  //
+
+  QueryPlan plan(const Predicate& predicate, PlanMode mode = PlanMode::CostBased) const;
+
+  // A cursor over the books "plan" returns. The plan must outlive it.
+  std::unique_ptr<BookCursor> open(const QueryPlan& plan) const;
+
+  // The books matching "predicate", in the order its plan returns them.
+  std::vector<const Book*> select(const Predicate& predicate, PlanMode mode = PlanMode::CostBased) const;
+
+  const TableStatistics& statistics() const { return statistics_; }
+
+  std::size_t size() const { return books_.size(); }
+  bool empty() const { return books_.empty(); }
+
+ private:
+  // The cheapest index path to a superset of the books matching
+  // "predicate", and whether it returns exactly them, or none.
+  struct Path {
+    QueryPlan plan;
+    bool exact;
+  };
+  std::optional<Path> index_path(const Predicate& predicate) const;
+
+  std::vector<Book> books_;
+  std::unordered_map<std::string_view, const Book*> by_isbn_;
+  std::map<std::string_view, const Book*> isbn_order_;
+  std::multimap<double, const Book*> price_order_;
+  std::unordered_multimap<std::string_view, const Book*> by_author_;
+  std::unordered_multimap<std::string_view, const Book*> by_title_;
+  TableStatistics statistics_;
+};
+
+//
+// QUERY ENGINE OPERATIONS
+//
+
+struct select_from_book_table {
+  // Function takes no parameters, plans the target query over a book table
+  // (or scans every book, when forced to), runs the plan, and returns the
+  // matching books.
+  std::vector<const Book*> operator()(const Book& unused) { return my_table.select(target_query, mode); }
+
+  const BookTable& my_table;
+  const Predicate target_query;
+  const PlanMode mode;
+};
+
+#endif
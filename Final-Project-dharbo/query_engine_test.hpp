@@ -0,0 +1,147 @@
+#ifndef _query_engine_test_hpp_
+#define _query_engine_test_hpp_
+
+#include "query_engine.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("Predicate") {
+  const Book book("Malta language question", "Geoffrey Hull", "9990943087", 62.06);
+  CHECK(Predicate::equals(QueryField::Author, "Geoffrey Hull").matches(book));
+  CHECK_FALSE(Predicate::equals(QueryField::Author, "Geoffrey").matches(book));
+  CHECK(Predicate::starts_with(QueryField::Isbn, "999").matches(book));
+  CHECK(Predicate::between(QueryField::Isbn, "999", "9991").matches(book));
+  CHECK_FALSE(Predicate::between(QueryField::Isbn, "999", "9990943087").matches(book));
+  CHECK(Predicate::between(QueryField::Title, "M", std::nullopt).matches(book));
+  CHECK(Predicate::contains(QueryField::Title, "language").matches(book));
+  CHECK(Predicate::price_between(62.06, 62.06).matches(book));
+  CHECK_FALSE(Predicate::price_between(0, 62).matches(book));
+  CHECK_THROWS_AS(Predicate::equals(QueryField::Price, "62.06"), std::invalid_argument);
+
+  const Predicate query = (Predicate::equals(QueryField::Author, "Geoffrey Hull") && Predicate::price_between(60, 70)) &&
+                          (Predicate::contains(QueryField::Title, "x") || Predicate::starts_with(QueryField::Title, "Malta"));
+  CHECK_EQ(query.operands.size(), 3);
+  CHECK(query.matches(book));
+  CHECK_EQ(query.to_string(),
+           "(author = \"Geoffrey Hull\" AND price in [60, 70] AND (title contains \"x\" OR title starts with \"Malta\"))");
+}
+
+TEST_CASE("BookTable") {
+  // 4000 books by 361 authors, a tenth of them by the first, with prices
+  // from $0 to $100 and ISBNs from 9780000000 up.
+  std::default_random_engine random(49);
+  std::uniform_int_distribution<int> cents(0, 10000);
+  std::vector<Book> books;
+  for (std::size_t i = 0; i < 4000; ++i) {
+    const std::size_t author = i % 10 == 0 ? 0 : i % 400;
+    books.emplace_back("Title " + std::to_string(i % 1000), "Author " + std::to_string(author),
+                       std::to_string(9780000000 + i * 7), cents(random) / 100.0);
+  }
+  books.push_back(Book("Replaced", "Author 1", books[5].isbn(), 1.0));
+  const BookTable table(books);
+  const Book unused;
+
+  auto sorted = [](std::vector<const Book*> found) {
+    std::sort(found.begin(), found.end());
+    return found;
+  };
+  auto op = [&](const Predicate& query) { return table.plan(query).op; };
+  using Operator = QueryPlan::Operator;
+
+  SUBCASE("Statistics") {
+    const TableStatistics& statistics = table.statistics();
+    CHECK_EQ(table.size(), 4000);
+    CHECK_EQ(statistics.rows, 4000);
+    CHECK_EQ(statistics.distinct_authors, 361);
+    CHECK_EQ(statistics.distinct_titles, 1001);
+    CHECK_EQ(statistics.isbn_bounds.size(), TableStatistics::HISTOGRAM_BUCKETS + 1);
+    CHECK_EQ(statistics.selectivity(Predicate::price_between(0, 50)), doctest::Approx(0.5).epsilon(0.05));
+    CHECK_EQ(statistics.selectivity(Predicate::price_between(90, 80)), 0.0);
+    CHECK_EQ(statistics.selectivity(Predicate::equals(QueryField::Isbn, "9780000000")), 1.0 / 4000);
+    // ISBNs 9780000000 to 9780009999 are 1429 of the books.
+    CHECK_EQ(statistics.selectivity(Predicate::starts_with(QueryField::Isbn, "978000")),
+             doctest::Approx(1429.0 / 4000).epsilon(0.05));
+    CHECK_LT(statistics.selectivity(Predicate::starts_with(QueryField::Isbn, "9780001")), 0.05);
+  }
+
+  SUBCASE("ChoosesAnAccessPath") {
+    CHECK_EQ(op(Predicate::equals(QueryField::Isbn, "9780000007")), Operator::IsbnHashLookup);
+    CHECK_EQ(op(Predicate::starts_with(QueryField::Isbn, "97800001")), Operator::IsbnRange);
+    CHECK_EQ(op(Predicate::price_between(10, 10.5)), Operator::PriceRange);
+    CHECK_EQ(op(Predicate::price_between(0, 90)), Operator::FullScan);
+    CHECK_EQ(op(Predicate::equals(QueryField::Title, "Title 7")), Operator::TitleLookup);
+    CHECK_EQ(op(Predicate::contains(QueryField::Title, "7")), Operator::FullScan);
+
+    const QueryPlan filtered =
+        table.plan(Predicate::price_between(0, 90) && Predicate::equals(QueryField::Author, "Author 7"));
+    CHECK_EQ(filtered.op, Operator::Filter);
+    REQUIRE_EQ(filtered.inputs.size(), 1);
+    CHECK_EQ(filtered.inputs[0].op, Operator::AuthorLookup);
+
+    const QueryPlan either = table.plan(Predicate::equals(QueryField::Author, "Author 7") ||
+                                        (Predicate::equals(QueryField::Title, "Title 8") && Predicate::price_between(0, 5)));
+    CHECK_EQ(either.op, Operator::Union);
+    REQUIRE_EQ(either.inputs.size(), 2);
+    CHECK_EQ(either.inputs[1].op, Operator::Filter);
+    CHECK_EQ(either.explain().substr(0, 6), "Union ");
+
+    CHECK_EQ(op(Predicate::equals(QueryField::Author, "Author 7") || Predicate::contains(QueryField::Title, "7")),
+             Operator::FullScan);
+    CHECK_EQ(table.plan(Predicate::equals(QueryField::Isbn, "9780000007"), PlanMode::FullScan).op, Operator::FullScan);
+  }
+
+  SUBCASE("DeduplicatesByIsbn") {
+    const std::vector<const Book*> found = table.select(Predicate::equals(QueryField::Isbn, books[5].isbn()));
+    REQUIRE_EQ(found.size(), 1);
+    CHECK_EQ(found[0]->title(), "Replaced");
+  }
+
+  SUBCASE("Streams") {
+    const QueryPlan plan = table.plan(Predicate::price_between(0, 100));
+    std::unique_ptr<BookCursor> cursor = table.open(plan);
+    CHECK_NE(cursor->next(), nullptr);
+    CHECK_NE(cursor->next(), nullptr);
+  }
+
+  SUBCASE("MatchesAFullScan") {
+    std::uniform_int_distribution<std::size_t> pick(0, books.size() - 1);
+    auto condition = [&](std::size_t kind) {
+      const Book& book = books[pick(random)];
+      switch (kind % 6) {
+        case 0: return Predicate::equals(QueryField::Isbn, book.isbn());
+        case 1: return Predicate::starts_with(QueryField::Isbn, book.isbn().substr(0, 7 + kind % 3));
+        case 2: return Predicate::equals(QueryField::Author, book.author());
+        case 3: return Predicate::equals(QueryField::Title, book.title());
+        case 4: return Predicate::price_between(book.price(), book.price() + kind % 20);
+        default: return Predicate::contains(QueryField::Title, book.title().substr(6));
+      }
+    };
+    for (std::size_t i = 0; i < 300; ++i) {
+      Predicate query = condition(i);
+      if (i % 3 == 1) query = std::move(query) && condition(i / 3);
+      if (i % 3 == 2) query = std::move(query) || condition(i / 3);
+      if (i % 7 == 0) query = std::move(query) || (condition(i / 7) && condition(i / 5));
+
+      std::vector<const Book*> expected;
+      for (const Book& book : books) {
+        if (query.matches(book)) expected.push_back(&book);
+      }
+      const std::vector<const Book*> planned = select_from_book_table{table, query, PlanMode::CostBased}(unused);
+      const std::vector<const Book*> scanned = table.select(query, PlanMode::FullScan);
+      CHECK_EQ(sorted(planned), sorted(scanned));
+      // The replaced book's match is its replacement's.
+      CHECK_LE(planned.size(), expected.size());
+      CHECK_GE(planned.size() + 1, expected.size());
+    }
+  }
+}
+
+#endif
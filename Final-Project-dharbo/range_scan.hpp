@@ -0,0 +1,154 @@
+#ifndef _range_scan_hpp_
+#define _range_scan_hpp_
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "book.hpp"
+#include "book_view.hpp"
+#include "btree_catalog.hpp"
+#include "skip_list.hpp"
+
+// ISBN range and prefix scans over the ordered containers: the BST
+// (std::map), a vector sorted by ISBN, the skip list, and the on-disk B+tree.
+// Each finds the first ISBN in the range in O(log n) and then walks forward
+// in ISBN order, so a scan costs a descent plus the books it returns, where
+// the hash table and the unsorted containers would have to visit every book.
+//
+// A prefix is a range: the books whose ISBN starts with "97801" are those in
+// ["97801", "97802").
+//
+// Usage:
+//
+//   for_each_in_isbn_range(bst, IsbnRange::with_prefix("97801"),
+//                          [](const Book& book) { ... });
+
+// The ISBNs in [first, last), or every ISBN from "first" on when "last" is
+// empty.
+struct IsbnRange {
+  std::string first;
+  std::optional<std::string> last;
+
+  // The ISBNs that start with "prefix".
+  static IsbnRange with_prefix(std::string_view prefix) {
+    // The least string greater than every string starting with "prefix":
+    // drop trailing 0xFF bytes, then increment the last byte. A prefix with
+    // no such successor (empty, or all 0xFF) bounds nothing.
+    std::string successor(prefix);
+    while (!successor.empty() && static_cast<unsigned char>(successor.back()) == 0xFF) {
+      successor.pop_back();
+    }
+    if (successor.empty()) {
+      return IsbnRange{std::string(prefix), std::nullopt};
+    }
+    successor.back() = static_cast<char>(static_cast<unsigned char>(successor.back()) + 1);
+    return IsbnRange{std::string(prefix), std::move(successor)};
+  }
+
+  // Whether an ISBN at or after "first" is still in the range.
+  bool before_last(std::string_view isbn) const { return !last || isbn < *last; }
+
+  bool contains(std::string_view isbn) const { return isbn >= first && before_last(isbn); }
+};
+
+//
+// Scans: each calls "visit(book)" for every book in "range", in ISBN order,
+// and returns the number of books visited.
+//
+
+template <class Key, class Record, class Visit>
+std::size_t for_each_in_isbn_range(const std::map<Key, Record>& bst, const IsbnRange& range, Visit visit) {
+  std::size_t count = 0;
+  for (auto iter = bst.lower_bound(range.first);
+       iter != bst.end() && range.before_last(iter->first); ++iter, ++count) {
+    visit(iter->second);
+  }
+  return count;
+}
+
+// "sorted" must be in ISBN order, as sort_by_isbn() leaves it.
+template <class Record, class Visit>
+std::size_t for_each_in_isbn_range(const std::vector<Record>& sorted, const IsbnRange& range, Visit visit) {
+  auto iter = std::lower_bound(sorted.begin(), sorted.end(), range.first,
+                               [](const Record& book, const std::string& isbn) { return book.isbn() < isbn; });
+  std::size_t count = 0;
+  for (; iter != sorted.end() && range.before_last(iter->isbn()); ++iter, ++count) {
+    visit(*iter);
+  }
+  return count;
+}
+
+template <class Key, class Record, class Visit>
+std::size_t for_each_in_isbn_range(const SkipList<Key, Record>& skip_list, const IsbnRange& range, Visit visit) {
+  std::size_t count = 0;
+  auto visitor = [&](const Key&, const Record& book) {
+    visit(book);
+    ++count;
+  };
+  if (range.last) {
+    skip_list.for_each_in_range(Key(range.first), Key(*range.last), visitor);
+  } else {
+    skip_list.for_each_from(Key(range.first), visitor);
+  }
+  return count;
+}
+
+template <class Visit>
+std::size_t for_each_in_isbn_range(const BTreeCatalog& btree, const IsbnRange& range, Visit visit) {
+  std::size_t count = 0;
+  auto visitor = [&](const Book& book) {
+    visit(book);
+    ++count;
+  };
+  if (range.last) {
+    btree.for_each_in_range(range.first, *range.last, visitor);
+  } else {
+    btree.for_each_from(range.first, visitor);
+  }
+  return count;
+}
+
+// Sorts "books" into the order for_each_in_isbn_range() expects of a vector.
+// Books with equal ISBNs keep their relative order.
+template <class Record>
+void sort_by_isbn(std::vector<Record>& books) {
+  std::stable_sort(books.begin(), books.end(),
+                   [](const Record& lhs, const Record& rhs) { return lhs.isbn() < rhs.isbn(); });
+}
+
+//
+// RANGE SCAN OPERATIONS
+//
+
+template <class Container>
+struct scan_isbn_range {
+  // Function takes no parameters, visits every book in an ordered container
+  // with an ISBN in the target range, and returns the number of books visited.
+  std::size_t operator()(const Book& unused) {
+    return for_each_in_isbn_range(my_container, target_range, [](const auto&) {});
+  }
+
+  const Container& my_container;
+  const IsbnRange target_range;
+};
+
+template <class Container>
+struct scan_isbn_prefix {
+  // Function takes no parameters, visits every book in an ordered container
+  // whose ISBN starts with the target prefix, and returns the number of books
+  // visited.
+  std::size_t operator()(const Book& unused) {
+    return for_each_in_isbn_range(my_container, IsbnRange::with_prefix(target_prefix), [](const auto&) {});
+  }
+
+  const Container& my_container;
+  const std::string target_prefix;
+};
+
+#endif
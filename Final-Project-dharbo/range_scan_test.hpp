@@ -0,0 +1,104 @@
+#ifndef _range_scan_test_hpp_
+#define _range_scan_test_hpp_
+
+#include "range_scan.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "btree_catalog.hpp"
+#include "doctest.hpp"
+#include "skip_list.hpp"
+
+TEST_CASE("IsbnRange") {
+  const IsbnRange range = IsbnRange::with_prefix("97801");
+  CHECK_EQ(range.first, "97801");
+  CHECK_EQ(range.last, "97802");
+  CHECK(range.contains("97801"));
+  CHECK(range.contains("9780131103627"));
+  CHECK_FALSE(range.contains("9780"));
+  CHECK_FALSE(range.contains("97802"));
+
+  CHECK_EQ(IsbnRange::with_prefix("19").last, "1:");
+  CHECK_EQ(IsbnRange::with_prefix("a\xff\xff").last, "b");
+  CHECK_EQ(IsbnRange::with_prefix("").last, std::nullopt);
+  CHECK_EQ(IsbnRange::with_prefix("\xff").last, std::nullopt);
+  CHECK(IsbnRange::with_prefix("").contains("anything"));
+}
+
+TEST_CASE("IsbnRangeScans") {
+  // Books with random 6-digit ISBNs, so prefixes and ranges catch a few each.
+  std::default_random_engine random(131);
+  std::uniform_int_distribution<int> digit(0, 9);
+  std::map<std::string, Book> bst;
+  for (std::size_t i = 0; i < 2000; ++i) {
+    std::string isbn;
+    for (int d = 0; d < 6; ++d) isbn += static_cast<char>('0' + digit(random));
+    bst.insert_or_assign(isbn, Book("title", "author", isbn, static_cast<double>(i)));
+  }
+
+  std::vector<Book> sorted;
+  BookSkipList skip_list;
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / "range_scan_test.btree";
+  std::filesystem::remove(path);
+  BTreeCatalog btree(path.string());
+  for (const auto& [isbn, book] : bst) sorted.push_back(book);
+  std::shuffle(sorted.begin(), sorted.end(), random);
+  for (const Book& book : sorted) {
+    skip_list.insert_or_assign(book.isbn(), book);
+    btree.insert(book);
+  }
+  sort_by_isbn(sorted);
+
+  // Every container visits what filtering every book would, in ISBN order.
+  auto check = [&](const IsbnRange& range) {
+    std::vector<std::string> expected;
+    for (const auto& [isbn, book] : bst) {
+      if (range.contains(isbn)) expected.push_back(isbn);
+    }
+    auto scan = [&](const auto& container) {
+      std::vector<std::string> visited;
+      const std::size_t count =
+          for_each_in_isbn_range(container, range, [&](const Book& book) { visited.push_back(book.isbn()); });
+      CHECK_EQ(count, visited.size());
+      return visited;
+    };
+    CHECK_EQ(scan(bst), expected);
+    CHECK_EQ(scan(sorted), expected);
+    CHECK_EQ(scan(skip_list), expected);
+    CHECK_EQ(scan(btree), expected);
+  };
+
+  SUBCASE("Prefixes") {
+    for (const char* prefix : {"", "0", "5", "99", "123", "4567", "000000", "9999999", "x"}) {
+      check(IsbnRange::with_prefix(prefix));
+    }
+  }
+
+  SUBCASE("Ranges") {
+    check(IsbnRange{"2", std::string("3")});
+    check(IsbnRange{"250000", std::string("250500")});
+    check(IsbnRange{"5", std::nullopt});
+    check(IsbnRange{"", std::string("")});
+    check(IsbnRange{"7", std::string("6")});
+  }
+
+  SUBCASE("Functors") {
+    const Book unused;
+    const std::size_t expected = for_each_in_isbn_range(bst, IsbnRange::with_prefix("1"), [](const Book&) {});
+    CHECK_GT(expected, 0);
+    CHECK_EQ(scan_isbn_prefix<std::map<std::string, Book>>{bst, "1"}(unused), expected);
+    CHECK_EQ(scan_isbn_prefix<BTreeCatalog>{btree, "1"}(unused), expected);
+    CHECK_EQ(scan_isbn_range<std::vector<Book>>{sorted, IsbnRange::with_prefix("1")}(unused), expected);
+    CHECK_EQ(scan_isbn_range<BookSkipList>{skip_list, IsbnRange{"1", std::string("2")}}(unused), expected);
+  }
+
+  std::filesystem::remove(path);
+}
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef _rcu_catalog_hpp_
+#define _rcu_catalog_hpp_
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "book.hpp"
+#include "epoch_reclamation.hpp"
+
+// A read-copy-update catalog for read-mostly traffic.
+//
+// Readers see an immutable hash index through a single atomic pointer. A
+// lookup pins the catalog's EpochDomain, which only writes the reader's own
+// per-thread record, then loads the pointer and searches; readers never touch
+// a shared lock or a cache line that writers also write.
+//
+// Writers do not modify the published index. Inserts and removes are queued,
+// and publish() copies the current index, applies the queued changes, and
+// swaps the pointer. The old index is retired and freed once no reader can
+// still be using it. Copying costs O(n) per publish, so writes are batched:
+// with a batch size of B, each write pays about n / B of a copy.
+class RcuCatalog {
+ public:
+  using Index = std::unordered_map<std::string, Book>;
+
+  // A reader's view of one published version. The version stays valid, and
+  // unchanged, for as long as the snapshot is alive.
+  class Snapshot {
+   public:
+    const Index& index() const { return *index_; }
+
+    const Book* find(const std::string& isbn) const {
+      auto iter = index_->find(isbn);
+      return iter == index_->end() ? nullptr : &iter->second;
+    }
+
+   private:
+    friend class RcuCatalog;
+    Snapshot(EpochDomain::Guard guard, const Index* index)
+        : guard_(std::move(guard)), index_(index) {}
+
+    EpochDomain::Guard guard_;
+    const Index* index_;
+  };
+
+  // Publishes automatically once "batch_size" changes are queued. A batch size
+  // of 0 leaves publishing entirely to explicit publish() calls.
+  explicit RcuCatalog(std::size_t batch_size = 256)
+      : batch_size_(batch_size), index_(new Index) {}
+
+  RcuCatalog(const RcuCatalog&) = delete;
+  RcuCatalog& operator=(const RcuCatalog&) = delete;
+
+  ~RcuCatalog() { delete index_.load(); }
+
+  //
+  // Readers
+  //
+
+  Snapshot snapshot() const {
+    EpochDomain::Guard guard = domain_.pin();
+    return Snapshot(std::move(guard), index_.load(std::memory_order_acquire));
+  }
+
+  // Returns a copy of the book with a matching ISBN in the latest published
+  // version, or an empty optional.
+  std::optional<Book> find(const std::string& isbn) const {
+    EpochDomain::Guard guard = domain_.pin();
+    const Index& index = *index_.load(std::memory_order_acquire);
+    auto iter = index.find(isbn);
+    if (iter == index.end()) {
+      return std::nullopt;
+    }
+    return iter->second;
+  }
+
+  // Calls "visitor" with the matching book without copying it. Returns false
+  // if the ISBN is not in the latest published version.
+  template <class Visitor>
+  bool visit(const std::string& isbn, Visitor visitor) const {
+    EpochDomain::Guard guard = domain_.pin();
+    const Index& index = *index_.load(std::memory_order_acquire);
+    auto iter = index.find(isbn);
+    if (iter == index.end()) {
+      return false;
+    }
+    visitor(iter->second);
+    return true;
+  }
+
+  // Number of books in the latest published version.
+  std::size_t size() const {
+    EpochDomain::Guard guard = domain_.pin();
+    return index_.load(std::memory_order_acquire)->size();
+  }
+
+  //
+  // Writers
+  //
+
+  // Queues "book" to be inserted, replacing any book with the same ISBN.
+  void insert(const Book& book) {
+    std::lock_guard lock(writer_mutex_);
+    pending_.push_back({book, false});
+    publish_if_full();
+  }
+
+  // Queues the book with a matching ISBN to be removed.
+  void remove(const std::string& isbn) {
+    std::lock_guard lock(writer_mutex_);
+    pending_.push_back({Book().isbn(isbn), true});
+    publish_if_full();
+  }
+
+  // Makes every queued change visible to readers as one new version.
+  void publish() {
+    std::lock_guard lock(writer_mutex_);
+    publish_locked();
+  }
+
+  // Number of changes queued but not yet visible to readers.
+  std::size_t pending() const {
+    std::lock_guard lock(writer_mutex_);
+    return pending_.size();
+  }
+
+ private:
+  struct Change {
+    Book book;
+    bool remove;
+  };
+
+  void publish_if_full() {
+    if (batch_size_ != 0 && pending_.size() >= batch_size_) {
+      publish_locked();
+    }
+  }
+
+  void publish_locked() {
+    if (pending_.empty()) {
+      return;
+    }
+    const Index* current = index_.load(std::memory_order_relaxed);
+    Index* next = new Index(*current);
+    for (Change& change : pending_) {
+      if (change.remove) {
+        next->erase(change.book.isbn());
+      } else {
+        (*next)[change.book.isbn()] = std::move(change.book);
+      }
+    }
+    pending_.clear();
+
+    index_.store(next, std::memory_order_release);
+    domain_.retire(const_cast<Index*>(current));
+    // Old versions are large; try to free them now rather than waiting for the
+    // domain's usual retirement threshold.
+    domain_.collect();
+  }
+
+  const std::size_t batch_size_;
+  std::atomic<const Index*> index_;
+  mutable EpochDomain domain_;
+
+  mutable std::mutex writer_mutex_;
+  std::vector<Change> pending_;
+};
+
+//
+// RCU CATALOG OPERATIONS
+//
+
+struct insert_into_rcu_catalog {
+  // Function takes a constant Book as a parameter, queues that book to be
+  // inserted into an RCU catalog, and returns nothing. The book becomes
+  // visible to readers at the next publish.
+  void operator()(const Book& book) {
+    my_catalog.insert(book);
+  }
+
+  RcuCatalog& my_catalog;
+};
+
+struct remove_from_rcu_catalog {
+  // Function takes a constant Book as a parameter, queues the book with a
+  // matching ISBN (if any) to be removed from an RCU catalog, and returns
+  // nothing.
+  void operator()(const Book& book) {
+    my_catalog.remove(book.isbn());
+  }
+
+  RcuCatalog& my_catalog;
+};
+
+struct search_within_rcu_catalog {
+  // Function takes no parameters, searches the latest published version of an
+  // RCU catalog for a book with an ISBN matching the target ISBN, and returns a
+  // copy of that book if such a book is found, an empty optional otherwise.
+  std::optional<Book> operator()(const Book& unused) {
+    return my_catalog.find(target_isbn);
+  }
+
+  const RcuCatalog& my_catalog;
+  const std::string target_isbn;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef _rcu_catalog_test_hpp_
+#define _rcu_catalog_test_hpp_
+
+#include "rcu_catalog.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("RcuCatalogBatchesWrites") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+  RcuCatalog catalog(2);
+
+  SUBCASE("InvisibleUntilPublished") {
+    insert_into_rcu_catalog{catalog}(book);
+    CHECK_EQ(catalog.pending(), 1);
+    CHECK_EQ(search_within_rcu_catalog{catalog, book.isbn()}(book),
+             std::nullopt);
+    catalog.publish();
+    CHECK_EQ(catalog.pending(), 0);
+    CHECK_EQ(search_within_rcu_catalog{catalog, book.isbn()}(book), book);
+  }
+
+  SUBCASE("PublishesFullBatch") {
+    insert_into_rcu_catalog{catalog}(book);
+    insert_into_rcu_catalog{catalog}(other_book);
+    CHECK_EQ(catalog.pending(), 0);
+    CHECK_EQ(catalog.size(), 2);
+  }
+
+  SUBCASE("RemoveAppliesInOrder") {
+    insert_into_rcu_catalog{catalog}(book);
+    remove_from_rcu_catalog{catalog}(book);
+    CHECK_EQ(catalog.size(), 0);
+    CHECK_EQ(catalog.find(book.isbn()), std::nullopt);
+  }
+}
+
+TEST_CASE("RcuCatalogSnapshotIsStable") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  RcuCatalog catalog(0);
+  catalog.insert(book);
+  catalog.publish();
+
+  RcuCatalog::Snapshot snapshot = catalog.snapshot();
+  catalog.remove(book.isbn());
+  catalog.publish();
+
+  REQUIRE_NE(snapshot.find(book.isbn()), nullptr);
+  CHECK_EQ(*snapshot.find(book.isbn()), book);
+  CHECK_EQ(catalog.find(book.isbn()), std::nullopt);
+}
+
+TEST_CASE("RcuCatalogReadersDuringWrites") {
+  constexpr std::size_t READERS = 3;
+  constexpr std::size_t WRITES = 2000;
+  RcuCatalog catalog(16);
+  std::atomic<bool> done{false};
+  std::atomic<bool> went_backwards{false};
+
+  std::vector<std::thread> readers;
+  for (std::size_t r = 0; r < READERS; ++r) {
+    readers.emplace_back([&] {
+      // Once a reader sees a book, every later version must still have it.
+      std::size_t highest_seen = 0;
+      while (!done.load()) {
+        RcuCatalog::Snapshot snapshot = catalog.snapshot();
+        if (snapshot.index().size() < highest_seen) {
+          went_backwards.store(true);
+        }
+        highest_seen = snapshot.index().size();
+      }
+    });
+  }
+  for (std::size_t i = 0; i < WRITES; ++i) {
+    const std::string isbn = std::to_string(i);
+    catalog.insert(Book("title", "author", isbn, 1.0));
+  }
+  catalog.publish();
+  done.store(true);
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  CHECK_FALSE(went_backwards.load());
+  CHECK_EQ(catalog.size(), WRITES);
+}
+
+#endif
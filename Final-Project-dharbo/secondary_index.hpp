@@ -0,0 +1,209 @@
+#ifndef _secondary_index_hpp_
+#define _secondary_index_hpp_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "book.hpp"
+#include "book_view.hpp"
+
+// An ISBN-keyed container with secondary indexes on author and title, kept in
+// sync on every insert and remove, so that a lookup by author or title costs
+// a hash probe or a tree descent rather than a scan of every book.
+//
+// The primary container is one of operations.hpp's: a std::map (BST) or a
+// std::unordered_map (hash table) of records by ISBN. Neither moves a record
+// once inserted, so each index maps a string_view of the record's own author
+// or title to a pointer to the record, and costs one node per book with no
+// copies of any string. The indexes are multimaps, hashed
+// (std::unordered_multimap) or ordered (std::multimap), since many books
+// share an author and some share a title.
+//
+// Removing a book, or replacing it with a book of the same ISBN, erases its
+// entries from both indexes, which walks the books that share its author. The
+// catalog is not safe to modify from several threads at once.
+//
+// Usage:
+//
+//   HashIndexedCatalog<> catalog;
+//   catalog.insert(book);
+//   std::vector<const Book*> books = catalog.find_by_author("Tolkien, J. R. R.");
+template <class Primary, template <class...> class Multimap = std::unordered_multimap>
+class IndexedCatalog {
+ public:
+  using Record = typename Primary::mapped_type;
+  using Key = typename Primary::key_type;
+  using Index = Multimap<std::string_view, const Record*>;
+
+  IndexedCatalog() = default;
+
+  // The indexes point into the primary container, so a copy's would point
+  // into the original's.
+  IndexedCatalog(const IndexedCatalog&) = delete;
+  IndexedCatalog& operator=(const IndexedCatalog&) = delete;
+
+  //
+  // Modifiers
+  //
+
+  // Inserts "book", replacing any book with the same ISBN.
+  void insert(const Record& book) {
+    auto [iter, inserted] = primary_.try_emplace(book.isbn(), book);
+    if (!inserted) {
+      unindex(iter->second);
+      iter->second = book;
+    }
+    index(iter->second);
+  }
+
+  // Removes the book with ISBN "isbn". Returns false if there is none.
+  bool remove(const Key& isbn) {
+    auto iter = primary_.find(isbn);
+    if (iter == primary_.end()) {
+      return false;
+    }
+    unindex(iter->second);
+    primary_.erase(iter);
+    return true;
+  }
+
+  void clear() {
+    by_author_.clear();
+    by_title_.clear();
+    primary_.clear();
+  }
+
+  //
+  // Queries
+  //
+
+  const Record* find(const Key& isbn) const {
+    auto iter = primary_.find(isbn);
+    return iter != primary_.end() ? &iter->second : nullptr;
+  }
+
+  // Every book by "author" or titled "title": in insertion order for the
+  // ordered indexes, in no particular order for the hashed ones.
+  std::vector<const Record*> find_by_author(std::string_view author) const {
+    return lookup(by_author_, author);
+  }
+  std::vector<const Record*> find_by_title(std::string_view title) const {
+    return lookup(by_title_, title);
+  }
+
+  std::size_t count_by_author(std::string_view author) const { return by_author_.count(author); }
+  std::size_t count_by_title(std::string_view title) const { return by_title_.count(title); }
+
+  std::size_t size() const { return primary_.size(); }
+  bool empty() const { return primary_.empty(); }
+
+  const Primary& primary() const { return primary_; }
+  const Index& author_index() const { return by_author_; }
+  const Index& title_index() const { return by_title_; }
+
+ private:
+  void index(const Record& book) {
+    by_author_.emplace(std::string_view(book.author()), &book);
+    by_title_.emplace(std::string_view(book.title()), &book);
+  }
+
+  void unindex(const Record& book) {
+    erase(by_author_, book.author(), &book);
+    erase(by_title_, book.title(), &book);
+  }
+
+  static void erase(Index& index, std::string_view key, const Record* book) {
+    auto [first, last] = index.equal_range(key);
+    for (; first != last; ++first) {
+      if (first->second == book) {
+        index.erase(first);
+        return;
+      }
+    }
+  }
+
+  static std::vector<const Record*> lookup(const Index& index, std::string_view key) {
+    std::vector<const Record*> found;
+    auto [first, last] = index.equal_range(key);
+    for (; first != last; ++first) {
+      found.push_back(first->second);
+    }
+    return found;
+  }
+
+  Primary primary_;
+  Index by_author_;
+  Index by_title_;
+};
+
+// A hash table of records by ISBN with hashed author and title indexes.
+template <class Record = Book>
+using HashIndexedCatalog = IndexedCatalog<std::unordered_map<isbn_key_t<Record>, Record>, std::unordered_multimap>;
+
+// A binary search tree of records by ISBN with ordered author and title
+// indexes.
+template <class Record = Book>
+using OrderedIndexedCatalog = IndexedCatalog<std::map<isbn_key_t<Record>, Record>, std::multimap>;
+
+//
+// INDEXED CATALOG OPERATIONS
+//
+
+template <class Catalog>
+struct insert_into_indexed_catalog {
+  // Function takes a constant Book as a parameter, inserts that book indexed by
+  // the book's ISBN, author, and title into an indexed catalog, and returns
+  // nothing.
+  void operator()(const typename Catalog::Record& book) { my_catalog.insert(book); }
+
+  Catalog& my_catalog;
+};
+
+template <class Catalog>
+struct remove_from_indexed_catalog {
+  // Function takes a constant Book as a parameter, finds and removes from the
+  // indexed catalog and its indexes the book with a matching ISBN (if any), and
+  // returns nothing.
+  void operator()(const typename Catalog::Record& book) { my_catalog.remove(book.isbn()); }
+
+  Catalog& my_catalog;
+};
+
+template <class Catalog>
+struct search_within_indexed_catalog_by_author {
+  // Function takes no parameters, looks up the target author in an indexed
+  // catalog's author index, and returns pointers to every book by that author.
+  std::vector<const typename Catalog::Record*> operator()(const typename Catalog::Record& unused) {
+    return my_catalog.find_by_author(target_author);
+  }
+
+  const Catalog& my_catalog;
+  const std::string target_author;
+};
+
+template <class Record = Book>
+struct search_within_vector_by_author {
+  // Function takes no parameters, scans a vector for books whose author matches
+  // the target author, and returns pointers to every such book.
+  std::vector<const Record*> operator()(const Record& unused) {
+    std::vector<const Record*> found;
+    for (const Record& book : my_vector) {
+      if (book.author() == target_author) {
+        found.push_back(&book);
+      }
+    }
+    return found;
+  }
+
+  const std::vector<Record>& my_vector;
+  const std::string target_author;
+};
+template <class Record>
+search_within_vector_by_author(const std::vector<Record>&, const std::string&) -> search_within_vector_by_author<Record>;
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef _secondary_index_test_hpp_
+#define _secondary_index_test_hpp_
+
+#include "secondary_index.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "book_view.hpp"
+#include "doctest.hpp"
+
+namespace secondary_index_test {
+
+// The ISBNs of "books", sorted, so that hashed and ordered indexes compare
+// alike.
+template <class Record>
+std::vector<std::string> isbns(const std::vector<const Record*>& books) {
+  std::vector<std::string> found;
+  for (const Record* book : books) found.emplace_back(book->isbn());
+  std::sort(found.begin(), found.end());
+  return found;
+}
+
+}  // namespace secondary_index_test
+
+TEST_CASE_TEMPLATE("IndexedCatalog", Catalog, HashIndexedCatalog<Book>, OrderedIndexedCatalog<Book>,
+                   HashIndexedCatalog<BookView>) {
+  using Record = typename Catalog::Record;
+  using secondary_index_test::isbns;
+  using Isbns = std::vector<std::string>;
+
+  const std::vector<Book> books = {
+      Book("Dune", "Herbert, Frank", "1", 9.99),
+      Book("Dune Messiah", "Herbert, Frank", "2", 8.99),
+      Book("Dune", "Lynch, David", "3", 19.99),
+      Book("Emma", "Austen, Jane", "4", 4.99)};
+  const Book retitled("Children of Dune", "Herbert, Frank", "2", 7.99);
+  Catalog catalog;
+  for (const Book& book : books) insert_into_indexed_catalog<Catalog>{catalog}(Record(book));
+
+  SUBCASE("FindsByEveryKey") {
+    CHECK_EQ(catalog.size(), 4);
+    REQUIRE_NE(catalog.find("3"), nullptr);
+    CHECK_EQ(catalog.find("3")->author(), "Lynch, David");
+    CHECK_EQ(isbns(catalog.find_by_author("Herbert, Frank")), Isbns{"1", "2"});
+    CHECK_EQ(isbns(catalog.find_by_title("Dune")), Isbns{"1", "3"});
+    CHECK_EQ(catalog.count_by_author("Austen, Jane"), 1);
+    CHECK(catalog.find_by_author("Nobody").empty());
+    CHECK_EQ(catalog.author_index().size(), 4);
+  }
+
+  SUBCASE("RemoveUpdatesIndexes") {
+    remove_from_indexed_catalog<Catalog>{catalog}(Record(books[0]));
+    CHECK_FALSE(catalog.remove("1"));
+    CHECK_EQ(catalog.find("1"), nullptr);
+    CHECK_EQ(isbns(catalog.find_by_author("Herbert, Frank")), Isbns{"2"});
+    CHECK_EQ(isbns(catalog.find_by_title("Dune")), Isbns{"3"});
+    CHECK_EQ(catalog.author_index().size(), 3);
+    CHECK_EQ(catalog.title_index().size(), 3);
+  }
+
+  SUBCASE("ReplacingABookReindexesIt") {
+    catalog.insert(Record(retitled));
+    CHECK_EQ(catalog.size(), 4);
+    CHECK(catalog.find_by_title("Dune Messiah").empty());
+    CHECK_EQ(isbns(catalog.find_by_title("Children of Dune")), Isbns{"2"});
+    CHECK_EQ(isbns(catalog.find_by_author("Herbert, Frank")), Isbns{"1", "2"});
+    CHECK_EQ(catalog.title_index().size(), 4);
+  }
+
+  SUBCASE("MatchesALinearScan") {
+    std::vector<Record> records(books.begin(), books.end());
+    for (const Book& book : books) {
+      const std::string author = book.author();
+      CHECK_EQ(isbns(search_within_indexed_catalog_by_author<Catalog>{catalog, author}(records[0])),
+               isbns(search_within_vector_by_author{records, author}(records[0])));
+    }
+  }
+
+  SUBCASE("Clear") {
+    catalog.clear();
+    CHECK(catalog.empty());
+    CHECK(catalog.find_by_author("Herbert, Frank").empty());
+  }
+}
+
+#endif
@@ -0,0 +1,278 @@
+#include "shared_catalog.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "book.hpp"
+#include "book_view.hpp"
+#include "isbn_index.hpp"
+#include "mapped_file.hpp"
+
+namespace {
+
+constexpr std::uint64_t ALIGNMENT = 64;               // every section starts on a cache line
+
+static_assert(sizeof(SharedCatalogHeader) <= ALIGNMENT, "header must fit before the slots");
+static_assert(sizeof(SharedCatalogRecord) == 32, "records must pack two to a cache line");
+
+std::uint64_t align(std::uint64_t offset) {
+  return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+std::uint64_t slot_count_for(std::size_t records) {
+  std::uint64_t count = 8;
+  while (count < 2 * static_cast<std::uint64_t>(records)) {
+    count *= 2;
+  }
+  return count;
+}
+
+std::uint32_t field_length(const std::string& field) {
+  if (field.size() > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error("shared catalog field of " + std::to_string(field.size()) + " bytes");
+  }
+  return static_cast<std::uint32_t>(field.size());
+}
+
+// Where each section of the image of "books" goes, and which books it holds.
+struct Layout {
+  std::vector<std::size_t> chosen;                    // the last book of each ISBN, in publishing order
+  SharedCatalogHeader header{};
+  std::uint64_t image_size = 0;
+};
+
+Layout plan(const std::vector<Book>& books) {
+  Layout layout;
+  std::unordered_map<std::string_view, std::size_t> last;
+  last.reserve(books.size());
+  for (std::size_t i = 0; i < books.size(); ++i) {
+    last.insert_or_assign(std::string_view(books[i].isbn()), i);
+  }
+
+  std::uint64_t heap_size = 0;
+  layout.chosen.reserve(last.size());
+  for (std::size_t i = 0; i < books.size(); ++i) {
+    const Book& book = books[i];
+    if (last.at(book.isbn()) != i) continue;
+    layout.chosen.push_back(i);
+    heap_size += std::uint64_t{field_length(book.isbn())} + field_length(book.title()) + field_length(book.author());
+  }
+
+  SharedCatalogHeader& header = layout.header;
+  std::memcpy(header.magic, SharedCatalogHeader::MAGIC, sizeof header.magic);
+  header.version = SharedCatalogHeader::VERSION;
+  header.byte_order = SharedCatalogHeader::BYTE_ORDER_MARK;
+  header.count = layout.chosen.size();
+  header.slot_count = slot_count_for(layout.chosen.size());
+  header.slots = ALIGNMENT;
+  header.records = align(header.slots + header.slot_count * sizeof(SharedCatalogSlot));
+  header.heap = align(header.records + header.count * sizeof(SharedCatalogRecord));
+  header.heap_size = heap_size;
+  layout.image_size = align(header.heap + heap_size);
+  return layout;
+}
+
+// Fills "image", of layout.image_size zeroed bytes, with the catalog.
+// The magic number goes in last, so a reader that maps the image early sees
+// no catalog rather than part of one.
+void fill(char* image, const Layout& layout, const std::vector<Book>& books) {
+  const SharedCatalogHeader& header = layout.header;
+  auto* slots = reinterpret_cast<SharedCatalogSlot*>(image + header.slots);
+  auto* records = reinterpret_cast<SharedCatalogRecord*>(image + header.records);
+  char* heap = image + header.heap;
+
+  const std::uint64_t mask = header.slot_count - 1;
+  std::uint64_t offset = 0;
+  for (std::uint64_t number = 0; number < layout.chosen.size(); ++number) {
+    const Book& book = books[layout.chosen[number]];
+    SharedCatalogRecord& record = records[number];
+    record.offset = offset;
+    record.isbn_length = field_length(book.isbn());
+    record.title_length = field_length(book.title());
+    record.author_length = field_length(book.author());
+    record.price = book.price();
+    for (const std::string* field : {&book.isbn(), &book.title(), &book.author()}) {
+      std::memcpy(heap + offset, field->data(), field->size());
+      offset += field->size();
+    }
+
+    // ISBNs are distinct by now, so the first empty slot is the one.
+    const std::uint64_t hash = isbn_hash(book.isbn());
+    std::uint64_t i = hash & mask;
+    while (slots[i].hash != 0) i = (i + 1) & mask;
+    slots[i] = {hash, number};
+  }
+
+  SharedCatalogHeader written = header;
+  std::memset(written.magic, 0, sizeof written.magic);
+  std::memcpy(image, &written, sizeof written);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  std::memcpy(image, header.magic, sizeof header.magic);
+}
+
+// Sizes the open, empty object "fd" for "layout", the plan() of "books",
+// writes the catalog through a shared mapping, and closes "fd".
+std::size_t write_image(int fd, const std::string& description, const Layout& layout,
+                        const std::vector<Book>& books) {
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "open " + description);
+  }
+  auto fail = [fd, &description](const char* operation) {
+    const int error = errno;
+    ::close(fd);
+    throw std::system_error(error, std::generic_category(), operation + (" " + description));
+  };
+
+  const std::uint64_t size = layout.image_size;
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) fail("truncate");
+  void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) fail("mmap");
+  fill(static_cast<char*>(mapping), layout, books);
+  ::munmap(mapping, size);
+  ::close(fd);
+  return layout.chosen.size();
+}
+
+[[noreturn]] void reject(const std::string& description, const std::string& reason) {
+  throw std::runtime_error(description + " is not a usable shared catalog: " + reason);
+}
+
+// Whether "count" items of "size" bytes starting at "offset" end by "limit".
+bool fits(std::uint64_t offset, std::uint64_t count, std::uint64_t size, std::uint64_t limit) {
+  return offset <= limit && offset % ALIGNMENT == 0 && count <= (limit - offset) / size;
+}
+
+}  // namespace
+
+//
+// Publishing
+//
+
+std::size_t publish_shared_catalog(const std::string& name, const std::vector<Book>& books) {
+  // Planned first: plan() throws for a catalog too large to lay out, and
+  // nothing has been created yet to clean up.
+  const Layout layout = plan(books);
+
+  // A new object rather than the old one truncated, which would pull the
+  // pages out from under the processes mapping it. One left half written
+  // is removed again.
+  remove_shared_catalog(name);
+  const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  try {
+    return write_image(fd, name, layout, books);
+  } catch (...) {
+    if (fd >= 0) remove_shared_catalog(name);
+    throw;
+  }
+}
+
+void remove_shared_catalog(const std::string& name) {
+  ::shm_unlink(name.c_str());
+}
+
+std::size_t write_shared_catalog(const std::string& path, const std::vector<Book>& books) {
+  const Layout layout = plan(books);
+  const std::string temporary = path + ".tmp";
+  const int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  std::size_t count = 0;
+  try {
+    count = write_image(fd, temporary, layout, books);
+  } catch (...) {
+    if (fd >= 0) std::remove(temporary.c_str());
+    throw;
+  }
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    const int error = errno;
+    std::remove(temporary.c_str());
+    throw std::system_error(error, std::generic_category(), "rename " + temporary);
+  }
+  return count;
+}
+
+//
+// Attaching
+//
+
+SharedCatalog::SharedCatalog(MappedFile image, const std::string& description)
+    : image_(std::move(image)), description_(description) {
+  SharedCatalogHeader header;
+  if (image_.size() < ALIGNMENT) {
+    reject(description, "too short for a header");
+  }
+  std::memcpy(&header, image_.data(), sizeof header);
+  if (std::memcmp(header.magic, SharedCatalogHeader::MAGIC, sizeof header.magic) != 0) {
+    reject(description, "bad magic number");
+  }
+  if (header.version != SharedCatalogHeader::VERSION) {
+    reject(description, "unsupported version " + std::to_string(header.version));
+  }
+  if (header.byte_order != SharedCatalogHeader::BYTE_ORDER_MARK) {
+    reject(description, "written with a different byte order");
+  }
+  if (header.slot_count == 0 || (header.slot_count & (header.slot_count - 1)) != 0 ||
+      header.count >= header.slot_count ||
+      !fits(header.slots, header.slot_count, sizeof(SharedCatalogSlot), header.records) ||
+      !fits(header.records, header.count, sizeof(SharedCatalogRecord), header.heap) ||
+      !fits(header.heap, header.heap_size, 1, image_.size())) {
+    reject(description, "sections out of bounds");
+  }
+
+  count_ = header.count;
+  slot_mask_ = header.slot_count - 1;
+  slots_ = reinterpret_cast<const SharedCatalogSlot*>(image_.data() + header.slots);
+  records_ = reinterpret_cast<const SharedCatalogRecord*>(image_.data() + header.records);
+  heap_ = image_.data() + header.heap;
+  heap_size_ = header.heap_size;
+}
+
+//
+// Queries
+//
+
+BookView SharedCatalog::record(std::size_t index) const {
+  const SharedCatalogRecord& record = records_[index];
+  const std::uint64_t length =
+      std::uint64_t{record.isbn_length} + record.title_length + record.author_length;
+  if (record.offset > heap_size_ || length > heap_size_ - record.offset) {
+    reject(description_, "record " + std::to_string(index) + " out of bounds");
+  }
+  const char* isbn = heap_ + record.offset;
+  const char* title = isbn + record.isbn_length;
+  const char* author = title + record.title_length;
+  return BookView({title, record.title_length}, {author, record.author_length},
+                  {isbn, record.isbn_length}, record.price);
+}
+
+std::optional<BookView> SharedCatalog::view(std::string_view isbn) const {
+  const std::uint64_t hash = isbn_hash(isbn);
+  // At most every slot is probed, so a damaged table cannot loop forever.
+  std::uint64_t i = hash & slot_mask_;
+  for (std::uint64_t probes = 0; probes <= slot_mask_; ++probes, i = (i + 1) & slot_mask_) {
+    const SharedCatalogSlot& slot = slots_[i];
+    if (slot.hash == 0) {
+      return std::nullopt;
+    }
+    if (slot.hash == hash && slot.record < count_) {
+      const BookView found = record(slot.record);
+      if (found.isbn() == isbn) {
+        return found;
+      }
+    }
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,160 @@
+#ifndef _shared_catalog_hpp_
+#define _shared_catalog_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "book.hpp"
+#include "book_view.hpp"
+#include "mapped_file.hpp"
+
+// A read-only catalog laid out so that many processes can map one copy of it,
+// in a POSIX shared memory object or a file, instead of each building its own
+// hash table from the text database.
+//
+// Everything in the image refers to everything else by offset from the image
+// start, never by pointer, so it reads the same at whatever address each
+// process maps it. Attaching maps the image and checks its header; no record
+// is read, and no memory is allocated, until the first lookup, and the pages
+// a lookup touches are shared by every process that has the image mapped.
+//
+// Layout (native byte order, every section starting on a 64-byte boundary):
+//
+//   SharedCatalogHeader
+//   slots       slot_count SharedCatalogSlots, slot_count a power of two
+//   records     count SharedCatalogRecords
+//   heap        each record's ISBN, title, and author back to back
+//
+// A slot holds the 64-bit FNV-1a hash of an ISBN (isbn_hash()) and the number
+// of its record; hash 0 marks an empty slot. The table is at most half full
+// and probed linearly, and a hash match is confirmed against the ISBN in the
+// heap.
+//
+// Usage:
+//
+//   publish_shared_catalog("/books", load_books_mapped("database-large.dat"));   // once per box
+//
+//   const SharedCatalog catalog = SharedCatalog::attach("/books");              // in each worker
+//   std::optional<BookView> book = catalog.view("9780131103627");
+
+struct SharedCatalogHeader {
+  static constexpr char MAGIC[8] = {'B', 'O', 'O', 'K', 'S', 'H', 'R', 'D'};
+  static constexpr std::uint32_t VERSION = 1;
+  static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint64_t count;                                // distinct ISBNs
+  std::uint64_t slot_count;
+  std::uint64_t slots;                                // offsets of each section from the image start
+  std::uint64_t records;
+  std::uint64_t heap;
+  std::uint64_t heap_size;
+};
+
+struct SharedCatalogSlot {
+  std::uint64_t hash;
+  std::uint64_t record;
+};
+
+struct SharedCatalogRecord {
+  std::uint64_t offset;                               // of the ISBN in the heap; the title and author follow
+  std::uint32_t isbn_length;
+  std::uint32_t title_length;
+  std::uint32_t author_length;
+  std::uint32_t reserved;
+  double price;
+};
+
+// Writes a catalog of "books" to the POSIX shared memory object "name" (e.g.
+// "/books"), replacing any object of that name. Processes attached to the
+// object it replaces keep their mapping of it; processes that attach during
+// the call may fail to. If an ISBN appears more than once, the last book with
+// it wins, as inserting every book into a hash table would. Returns the
+// number of distinct ISBNs. Throws std::system_error if the object cannot be
+// created, and std::length_error if a field is longer than 4 GiB.
+std::size_t publish_shared_catalog(const std::string& name, const std::vector<Book>& books);
+
+// Removes the shared memory object "name". Attached processes keep their
+// mapping. Does nothing if there is no such object.
+void remove_shared_catalog(const std::string& name);
+
+// As publish_shared_catalog(), but to the file at "path", which is written
+// beside it and renamed into place.
+std::size_t write_shared_catalog(const std::string& path, const std::vector<Book>& books);
+
+// A read-only mapping of a catalog image.
+class SharedCatalog {
+ public:
+  // Maps the shared memory object "name". Throws std::system_error if it
+  // cannot be mapped, and std::runtime_error if it is not a valid catalog.
+  static SharedCatalog attach(const std::string& name) {
+    return SharedCatalog(MappedFile::shared_memory(name), name);
+  }
+
+  // Maps the catalog file at "path", with the same errors as attach().
+  explicit SharedCatalog(const std::string& path) : SharedCatalog(MappedFile(path), path) {}
+
+  std::size_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+
+  // Bytes in the image, shared by every process that maps it.
+  std::size_t image_bytes() const { return image_.size(); }
+
+  //
+  // Queries
+  //
+
+  // The book with ISBN "isbn" as a view of the image, valid while the catalog
+  // is attached.
+  std::optional<BookView> view(std::string_view isbn) const;
+
+  // An owning copy of the book with ISBN "isbn".
+  std::optional<Book> find(std::string_view isbn) const {
+    const std::optional<BookView> found = view(isbn);
+    if (!found) {
+      return std::nullopt;
+    }
+    return found->to_book();
+  }
+
+  bool contains(std::string_view isbn) const { return view(isbn).has_value(); }
+
+  // Record "index" in [0, size()), in the order the books were published.
+  BookView record(std::size_t index) const;
+
+ private:
+  SharedCatalog(MappedFile image, const std::string& description);
+
+  MappedFile image_;
+  std::string description_;                           // for errors about damaged records
+  std::size_t count_ = 0;
+  std::uint64_t slot_mask_ = 0;
+  const SharedCatalogSlot* slots_ = nullptr;
+  const SharedCatalogRecord* records_ = nullptr;
+  const char* heap_ = nullptr;
+  std::uint64_t heap_size_ = 0;
+};
+
+//
+// SHARED CATALOG OPERATIONS
+//
+
+struct search_within_shared_catalog {
+  // Function takes no parameters, searches a shared catalog for a book with an
+  // ISBN matching the target ISBN, and returns a copy of that book if such a
+  // book is found, an empty optional otherwise.
+  std::optional<Book> operator()(const Book& unused) {
+    return my_catalog.find(target_isbn);
+  }
+
+  const SharedCatalog& my_catalog;
+  const std::string target_isbn;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef _shared_catalog_test_hpp_
+#define _shared_catalog_test_hpp_
+
+#include "shared_catalog.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "book.hpp"
+#include "book_view.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("SharedCatalog") {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "shared_catalog_test.cat";
+  const std::string name = "/shared_catalog_test." + std::to_string(::getpid());
+  const std::vector<Book> books = {
+      Book("title", "author", "isbn", 123.45),
+      Book("other, title", "other \"author\"", "0123456789012", 543.21),
+      Book("", "", "empty fields", 1.0),
+      Book("newer title", "author", "isbn", 9.99)};        // replaces books[0]
+
+  SUBCASE("FindsBooksInAFile") {
+    CHECK_EQ(write_shared_catalog(path.string(), books), 3);
+    const SharedCatalog catalog(path.string());
+    CHECK_EQ(catalog.size(), 3);
+    CHECK_EQ(catalog.find("isbn"), books[3]);
+    CHECK_EQ(catalog.find("0123456789012"), books[1]);
+    CHECK_EQ(catalog.find("empty fields"), books[2]);
+    CHECK_EQ(catalog.find("missing"), std::nullopt);
+    CHECK_FALSE(catalog.contains(""));
+    CHECK_EQ(catalog.view("isbn")->title(), "newer title");
+
+    // Records keep the order the books were published in.
+    CHECK_EQ(catalog.record(0), BookView(books[1]));
+    CHECK_EQ(catalog.record(2), BookView(books[3]));
+    CHECK_EQ(search_within_shared_catalog{catalog, "0123456789012"}(Book()), books[1]);
+  }
+
+  SUBCASE("ManyBooks") {
+    std::vector<Book> many;
+    for (std::size_t i = 0; i < 5000; ++i) {
+      many.push_back(Book("title " + std::to_string(i), "author", std::to_string(i * 7919),
+                          static_cast<double>(i)));
+    }
+    write_shared_catalog(path.string(), many);
+    const SharedCatalog catalog(path.string());
+    REQUIRE_EQ(catalog.size(), many.size());
+    for (const Book& book : many) {
+      CHECK_EQ(catalog.find(book.isbn()), book);
+    }
+    CHECK_FALSE(catalog.contains("7918"));
+  }
+
+  SUBCASE("SharedMemory") {
+    CHECK_EQ(publish_shared_catalog(name, books), 3);
+
+    // Two mappings of one image, at different addresses, read the same.
+    const SharedCatalog first = SharedCatalog::attach(name);
+    const SharedCatalog second = SharedCatalog::attach(name);
+    CHECK_NE(first.view("isbn")->isbn().data(), second.view("isbn")->isbn().data());
+    CHECK_EQ(first.find("isbn"), books[3]);
+    CHECK_EQ(second.find("isbn"), books[3]);
+
+    // Another process attaches the same object.
+    const pid_t child = ::fork();
+    REQUIRE(child >= 0);
+    if (child == 0) {
+      const bool found = SharedCatalog::attach(name).find("0123456789012") == books[1];
+      ::_exit(found ? 0 : 1);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    CHECK(WIFEXITED(status));
+    CHECK_EQ(WEXITSTATUS(status), 0);
+
+    // Republishing leaves attached processes with the old image.
+    publish_shared_catalog(name, {Book("replacement", "author", "isbn", 1.0)});
+    CHECK_EQ(first.find("0123456789012"), books[1]);
+    CHECK_EQ(SharedCatalog::attach(name).size(), 1);
+
+    remove_shared_catalog(name);
+    CHECK_THROWS_AS(SharedCatalog::attach(name), std::system_error);
+    CHECK_EQ(first.find("isbn"), books[3]);
+  }
+
+  SUBCASE("Empty") {
+    CHECK_EQ(write_shared_catalog(path.string(), {}), 0);
+    const SharedCatalog catalog(path.string());
+    CHECK(catalog.empty());
+    CHECK_FALSE(catalog.contains("isbn"));
+  }
+
+  SUBCASE("RejectsDamagedImages") {
+    write_shared_catalog(path.string(), books);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 64);
+    CHECK_THROWS_AS(SharedCatalog(path.string()), std::runtime_error);
+
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      for (const Book& book : books) file << book;
+    }
+    CHECK_THROWS_AS(SharedCatalog(path.string()), std::runtime_error);
+  }
+
+  std::filesystem::remove(path);
+  remove_shared_catalog(name);
+  CHECK_THROWS_AS(SharedCatalog(path.string()), std::system_error);
+}
+
+#endif
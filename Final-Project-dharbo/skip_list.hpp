@@ -0,0 +1,390 @@
+#ifndef _skip_list_hpp_
+#define _skip_list_hpp_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "book.hpp"
+#include "book_view.hpp"
+#include "epoch_reclamation.hpp"
+
+// An ordered map that many threads may insert into, erase from, search, and
+// iterate over at the same time without locks. Each node sits in a randomly
+// chosen number of sorted linked lists ("levels"); searches start in the
+// sparsest level and drop down, giving expected O(log n) operations like a
+// balanced tree.
+//
+// Erasing a node first marks its outgoing links (the low bit of each next
+// pointer) so no thread can link anything after it, then unlinks it. Any
+// search that walks over a marked node helps unlink it. Unlinked nodes and
+// replaced values are retired through an EpochDomain.
+//
+// Values are copied out rather than returned by pointer, since a pointer into
+// the list may be reclaimed once the caller's operation ends.
+template <class Key, class Value, class Compare = std::less<Key>>
+class SkipList {
+ public:
+  static constexpr int MAX_LEVEL = 24;
+
+  SkipList() : head_(new Node(Key{}, nullptr, MAX_LEVEL - 1)) {}
+
+  SkipList(const SkipList&) = delete;
+  SkipList& operator=(const SkipList&) = delete;
+
+  ~SkipList() {
+    Node* node = head_;
+    while (node != nullptr) {
+      Node* next = pointer(node->next[0].load());
+      delete node;
+      node = next;
+    }
+  }
+
+  // Inserts "value" under "key", replacing any existing value. Returns true if
+  // the key was not already present.
+  bool insert_or_assign(const Key& key, const Value& value) {
+    EpochDomain::Guard guard = domain_.pin();
+    Node* preds[MAX_LEVEL];
+    Node* succs[MAX_LEVEL];
+    const int top_level = random_level();
+
+    for (;;) {
+      if (locate(key, preds, succs)) {
+        // Replace the value in place. The old value may still be read by a
+        // concurrent search, so it is retired rather than deleted.
+        Node* existing = succs[0];
+        if (is_marked(existing->next[0].load(std::memory_order_acquire))) {
+          continue;                                   // being erased; retry
+        }
+        Value* old_value = existing->value.exchange(
+            new Value(value), std::memory_order_acq_rel);
+        domain_.retire(old_value);
+        return false;
+      }
+
+      Node* node = new Node(key, new Value(value), top_level);
+      for (int level = 0; level <= top_level; ++level) {
+        node->next[level].store(tag(succs[level]), std::memory_order_relaxed);
+      }
+      // Linking the bottom level is what makes the key present.
+      Link expected = tag(succs[0]);
+      if (!preds[0]->next[0].compare_exchange_strong(
+              expected, tag(node), std::memory_order_release,
+              std::memory_order_relaxed)) {
+        delete node;                                  // never published
+        continue;
+      }
+      size_.fetch_add(1, std::memory_order_relaxed);
+      link_upper_levels(node, key, preds, succs);
+      return true;
+    }
+  }
+
+  // Removes the value stored under "key", if any. Returns true if this call
+  // removed it.
+  bool erase(const Key& key) {
+    EpochDomain::Guard guard = domain_.pin();
+    Node* preds[MAX_LEVEL];
+    Node* succs[MAX_LEVEL];
+    if (!locate(key, preds, succs)) {
+      return false;
+    }
+    Node* node = succs[0];
+
+    // Mark the upper levels top-down; whoever marks the bottom level owns the
+    // removal.
+    for (int level = node->top_level; level > 0; --level) {
+      Link link = node->next[level].load(std::memory_order_acquire);
+      while (!is_marked(link) &&
+             !node->next[level].compare_exchange_weak(
+                 link, link | 1, std::memory_order_acq_rel)) {
+      }
+    }
+    Link link = node->next[0].load(std::memory_order_acquire);
+    for (;;) {
+      if (is_marked(link)) {
+        return false;                                 // lost to another erase
+      }
+      if (node->next[0].compare_exchange_weak(link, link | 1,
+                                              std::memory_order_acq_rel)) {
+        break;
+      }
+    }
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    locate(key, preds, succs);                        // unlink every level
+    release(node);
+    return true;
+  }
+
+  // Returns a copy of the value stored under "key", or an empty optional.
+  std::optional<Value> find(const Key& key) const {
+    EpochDomain::Guard guard = domain_.pin();
+    Node* node = lower_bound(key);
+    if (node == nullptr || less_(key, node->key)) {
+      return std::nullopt;
+    }
+    return *node->value.load(std::memory_order_acquire);
+  }
+
+  bool contains(const Key& key) const {
+    EpochDomain::Guard guard = domain_.pin();
+    Node* node = lower_bound(key);
+    return node != nullptr && !less_(key, node->key);
+  }
+
+  // Calls "visitor(key, value)" in key order for every entry with
+  // first <= key < last. The scan is weakly consistent: it sees every entry
+  // present for the whole scan, and may or may not see entries inserted or
+  // erased while it runs. The visitor must not call back into this list.
+  template <class Visitor>
+  void for_each_in_range(const Key& first, const Key& last,
+                         Visitor visitor) const {
+    EpochDomain::Guard guard = domain_.pin();
+    for (Node* node = lower_bound(first);
+         node != nullptr && less_(node->key, last);
+         node = next_unmarked(node)) {
+      visitor(node->key, *node->value.load(std::memory_order_acquire));
+    }
+  }
+
+  // Calls "visitor(key, value)" in key order for every entry with
+  // first <= key, with the same consistency as for_each_in_range().
+  template <class Visitor>
+  void for_each_from(const Key& first, Visitor visitor) const {
+    EpochDomain::Guard guard = domain_.pin();
+    for (Node* node = lower_bound(first); node != nullptr; node = next_unmarked(node)) {
+      visitor(node->key, *node->value.load(std::memory_order_acquire));
+    }
+  }
+
+  // Calls "visitor(key, value)" for every entry in key order.
+  template <class Visitor>
+  void for_each(Visitor visitor) const {
+    EpochDomain::Guard guard = domain_.pin();
+    for (Node* node = next_unmarked(head_); node != nullptr;
+         node = next_unmarked(node)) {
+      visitor(node->key, *node->value.load(std::memory_order_acquire));
+    }
+  }
+
+  // Returns the number of entries. Exact only when no writers are running.
+  std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  bool empty() const { return size() == 0; }
+
+ private:
+  // A next pointer whose low bit marks the node that owns it as erased.
+  using Link = std::uintptr_t;
+
+  struct Node {
+    Node(const Key& key, Value* value, int top_level)
+        : key(key), value(value), top_level(top_level),
+          next(new std::atomic<Link>[top_level + 1]) {
+      for (int level = 0; level <= top_level; ++level) {
+        next[level].store(0, std::memory_order_relaxed);
+      }
+    }
+    ~Node() {
+      delete value.load(std::memory_order_relaxed);
+      delete[] next;
+    }
+
+    const Key key;
+    std::atomic<Value*> value;
+    const int top_level;
+    std::atomic<Link>* const next;
+
+    // A published node is released once by the inserting thread when it has
+    // finished linking it, and once by the thread that erases it. The second
+    // release retires the node, so it is never freed while its inserter could
+    // still link it into an upper level.
+    std::atomic<int> owners{2};
+  };
+
+  static Node* pointer(Link link) {
+    return reinterpret_cast<Node*>(link & ~Link{1});
+  }
+  static Link tag(Node* node) { return reinterpret_cast<Link>(node); }
+  static bool is_marked(Link link) { return (link & 1) != 0; }
+
+  static int random_level() {
+    thread_local std::uint64_t state =
+        0x9E3779B97F4A7C15ull ^ reinterpret_cast<std::uintptr_t>(&state);
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    // Each extra level with probability 1/2.
+    int level = 0;
+    for (std::uint64_t bits = state; (bits & 1) != 0 && level < MAX_LEVEL - 1;
+         bits >>= 1) {
+      ++level;
+    }
+    return level;
+  }
+
+  void release(Node* node) {
+    if (node->owners.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      domain_.retire(node);
+    }
+  }
+
+  // Fills "preds" and "succs" with the last node before "key" and the first
+  // node at or after "key" on every level, unlinking any marked node passed on
+  // the way. Returns true if succs[0] holds "key".
+  bool locate(const Key& key, Node** preds, Node** succs) const {
+  retry:
+    Node* pred = head_;
+    for (int level = MAX_LEVEL - 1; level >= 0; --level) {
+      Node* curr = pointer(pred->next[level].load(std::memory_order_acquire));
+      while (curr != nullptr) {
+        Link succ = curr->next[level].load(std::memory_order_acquire);
+        while (is_marked(succ)) {
+          Link expected = tag(curr);
+          if (!pred->next[level].compare_exchange_strong(
+                  expected, succ & ~Link{1}, std::memory_order_acq_rel)) {
+            goto retry;
+          }
+          curr = pointer(succ);
+          if (curr == nullptr) {
+            break;
+          }
+          succ = curr->next[level].load(std::memory_order_acquire);
+        }
+        if (curr == nullptr || !less_(curr->key, key)) {
+          break;
+        }
+        pred = curr;
+        curr = pointer(succ);
+      }
+      preds[level] = pred;
+      succs[level] = curr;
+    }
+    return succs[0] != nullptr && !less_(key, succs[0]->key);
+  }
+
+  // Links a node already present on the bottom level into its upper levels.
+  // Stops early if the node is erased meanwhile, and makes sure an erased node
+  // does not stay reachable through a level this thread linked late.
+  void link_upper_levels(Node* node, const Key& key, Node** preds,
+                         Node** succs) {
+    for (int level = 1; level <= node->top_level; ++level) {
+      for (;;) {
+        Link link = node->next[level].load(std::memory_order_acquire);
+        if (is_marked(link)) {
+          goto done;
+        }
+        if (pointer(link) != succs[level] &&
+            !node->next[level].compare_exchange_strong(
+                link, tag(succs[level]), std::memory_order_acq_rel)) {
+          continue;
+        }
+        Link expected = tag(succs[level]);
+        if (preds[level]->next[level].compare_exchange_strong(
+                expected, tag(node), std::memory_order_release,
+                std::memory_order_relaxed)) {
+          break;
+        }
+        locate(key, preds, succs);
+        if (succs[0] != node) {
+          goto done;                                  // erased meanwhile
+        }
+      }
+    }
+  done:
+    if (is_marked(node->next[0].load(std::memory_order_acquire))) {
+      locate(key, preds, succs);
+    }
+    release(node);
+  }
+
+  // Returns the first unmarked node whose key is not less than "key".
+  Node* lower_bound(const Key& key) const {
+    Node* pred = head_;
+    Node* curr = nullptr;
+    for (int level = MAX_LEVEL - 1; level >= 0; --level) {
+      curr = pointer(pred->next[level].load(std::memory_order_acquire));
+      while (curr != nullptr) {
+        Link succ = curr->next[level].load(std::memory_order_acquire);
+        if (!is_marked(succ) && !less_(curr->key, key)) {
+          break;
+        }
+        if (!is_marked(succ)) {
+          pred = curr;
+        }
+        curr = pointer(succ);
+      }
+    }
+    return curr;
+  }
+
+  // Returns the next node after "node" on the bottom level that is not erased.
+  static Node* next_unmarked(Node* node) {
+    Node* curr = pointer(node->next[0].load(std::memory_order_acquire));
+    while (curr != nullptr &&
+           is_marked(curr->next[0].load(std::memory_order_acquire))) {
+      curr = pointer(curr->next[0].load(std::memory_order_acquire));
+    }
+    return curr;
+  }
+
+  Node* const head_;
+  std::atomic<std::size_t> size_{0};
+  Compare less_;
+  mutable EpochDomain domain_;
+};
+
+using BookSkipList = SkipList<std::string, Book>;
+
+//
+// SKIP LIST OPERATIONS
+//
+
+template <class Record = Book>
+struct insert_into_skip_list {
+  // Function takes a constant Book as a parameter, inserts that book indexed by
+  // the book's ISBN into a skip list, and returns nothing. Safe to call from
+  // many threads at once.
+  void operator()(const Record& book) {
+    my_skip_list.insert_or_assign(book.isbn(), book);
+  }
+
+  SkipList<isbn_key_t<Record>, Record>& my_skip_list;
+};
+template <class Key, class Record>
+insert_into_skip_list(SkipList<Key, Record>&) -> insert_into_skip_list<Record>;
+
+template <class Record = Book>
+struct remove_from_skip_list {
+  // Function takes a constant Book as a parameter, finds and removes from the
+  // skip list the book with a matching ISBN (if any), and returns nothing. If
+  // no Book matches the ISBN, the method does nothing.
+  void operator()(const Record& book) {
+    my_skip_list.erase(book.isbn());
+  }
+
+  SkipList<isbn_key_t<Record>, Record>& my_skip_list;
+};
+template <class Key, class Record>
+remove_from_skip_list(SkipList<Key, Record>&) -> remove_from_skip_list<Record>;
+
+template <class Record = Book>
+struct search_within_skip_list {
+  // Function takes no parameters, searches a skip list for a book with an ISBN
+  // matching the target ISBN, and returns a copy of that book if such a book is
+  // found, an empty optional otherwise.
+  std::optional<Record> operator()(const Record& unused) {
+    return my_skip_list.find(target_isbn);
+  }
+
+  const SkipList<isbn_key_t<Record>, Record>& my_skip_list;
+  const std::string target_isbn;
+};
+template <class Key, class Record>
+search_within_skip_list(const SkipList<Key, Record>&, const std::string&) -> search_within_skip_list<Record>;
+
+#endif
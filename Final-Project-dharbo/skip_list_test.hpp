@@ -0,0 +1,129 @@
+#ifndef _skip_list_test_hpp_
+#define _skip_list_test_hpp_
+
+#include "skip_list.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("InsertIntoSkipList") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+  BookSkipList skip_list;
+
+  SUBCASE("EmptySkipList") {
+    insert_into_skip_list{skip_list}(book);
+    CHECK_EQ(skip_list.size(), 1);
+    CHECK_EQ(skip_list.find(book.isbn()), book);
+  }
+
+  SUBCASE("ReplacesExisting") {
+    insert_into_skip_list{skip_list}(other_book);
+    insert_into_skip_list{skip_list}(book);
+    insert_into_skip_list{skip_list}(Book(book).price(1.0));
+    CHECK_EQ(skip_list.size(), 2);
+    CHECK_EQ(skip_list.find(book.isbn())->price(), 1.0);
+    CHECK_EQ(skip_list.find(other_book.isbn()), other_book);
+  }
+}
+
+TEST_CASE("RemoveFromSkipList") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+  BookSkipList skip_list;
+
+  SUBCASE("EmptySkipList") {
+    remove_from_skip_list{skip_list}(book);
+    CHECK_EQ(skip_list.size(), 0);
+  }
+
+  SUBCASE("NonEmptySkipList") {
+    skip_list.insert_or_assign(book.isbn(), book);
+    skip_list.insert_or_assign(other_book.isbn(), other_book);
+    remove_from_skip_list{skip_list}(book);
+    CHECK_EQ(skip_list.size(), 1);
+    CHECK_FALSE(skip_list.contains(book.isbn()));
+    CHECK_EQ(skip_list.find(other_book.isbn()), other_book);
+  }
+}
+
+TEST_CASE("SearchWithinSkipList") {
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book =
+      Book("other-title", "other-author", "other-isbn", 543.21);
+  BookSkipList skip_list;
+  skip_list.insert_or_assign(other_book.isbn(), other_book);
+
+  SUBCASE("ItemNotFound") {
+    CHECK_EQ(search_within_skip_list{skip_list, book.isbn()}(book),
+             std::nullopt);
+  }
+
+  SUBCASE("ItemFound") {
+    skip_list.insert_or_assign(book.isbn(), book);
+    CHECK_EQ(search_within_skip_list{skip_list, book.isbn()}(book), book);
+  }
+}
+
+TEST_CASE("SkipListOrderedRange") {
+  SkipList<int, int> skip_list;
+  for (int key : {5, 1, 9, 3, 7}) skip_list.insert_or_assign(key, key * 10);
+
+  std::vector<int> keys;
+  skip_list.for_each_in_range(3, 9, [&](int key, int value) {
+    CHECK_EQ(value, key * 10);
+    keys.push_back(key);
+  });
+  CHECK_EQ(keys, std::vector<int>{3, 5, 7});
+
+  keys.clear();
+  skip_list.erase(5);
+  skip_list.for_each([&](int key, int) { keys.push_back(key); });
+  CHECK_EQ(keys, std::vector<int>{1, 3, 7, 9});
+}
+
+TEST_CASE("SkipListManyThreads") {
+  constexpr int THREADS = 4;
+  constexpr int KEYS_PER_THREAD = 1000;
+  SkipList<int, int> skip_list;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&skip_list, t] {
+      for (int i = 0; i < KEYS_PER_THREAD; ++i) {
+        // Interleave the threads' keys so they contend on neighbouring nodes.
+        const int key = i * THREADS + t;
+        skip_list.insert_or_assign(key, key);
+        skip_list.find(key - 1);
+        if (key % 2 == 0) {
+          skip_list.erase(key);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  CHECK_EQ(skip_list.size(), THREADS * KEYS_PER_THREAD / 2);
+  int previous = -1;
+  std::size_t count = 0;
+  skip_list.for_each([&](int key, int value) {
+    CHECK_EQ(key % 2, 1);
+    CHECK_EQ(key, value);
+    CHECK_LT(previous, key);
+    previous = key;
+    ++count;
+  });
+  CHECK_EQ(count, skip_list.size());
+}
+
+#endif
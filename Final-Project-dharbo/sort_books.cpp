@@ -0,0 +1,50 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "external_sort.hpp"
+
+// Sorts a text database or snapshot of any size by ISBN into a text database,
+// keeping only the last record of each ISBN, within a fixed memory budget.
+//
+// Usage:  sort_books <input> <output> [memory budget in MiB] [--keep-duplicates]
+//
+// Run files go to the system's temporary directory unless TMPDIR says
+// otherwise; point it at a disk with room for about twice the input.
+int main(int argc, char* argv[]) {
+  ExternalSortOptions options;
+  std::string arguments[3];
+  int count = 0;
+  for (int i = 1; i < argc; ++i) {
+    const std::string argument = argv[i];
+    if (argument == "--keep-duplicates") {
+      options.deduplicate = false;
+    } else if (count < 3) {
+      arguments[count++] = argument;
+    } else {
+      count = 0;
+      break;
+    }
+  }
+  if (count < 2) {
+    std::cerr << "Usage: " << argv[0] << " <input> <output> [memory budget in MiB] [--keep-duplicates]\n";
+    return EXIT_FAILURE;
+  }
+
+  try {
+    if (count == 3) options.memory_budget = std::stoul(arguments[2]) << 20;
+    const ExternalSortStatistics statistics = external_sort_books(arguments[0], arguments[1], options);
+    std::clog << "Sorted " << statistics.records_read << " records (" << statistics.bytes_read
+              << " bytes) into " << statistics.records_written << ", dropping " << statistics.duplicates_dropped
+              << " duplicates\n"
+              << "  " << statistics.runs << " runs, " << statistics.merge_passes << " merge passes, "
+              << statistics.bytes_spilled << " bytes spilled\n"
+              << "  " << statistics.seconds << " seconds: "
+              << statistics.bytes_read / statistics.seconds / (1 << 20) << " MiB/s, "
+              << statistics.records_read / statistics.seconds << " records/s\n";
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,197 @@
+#include "sorted_run.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "bloom_filter.hpp"
+#include "mapped_file.hpp"
+
+namespace {
+
+constexpr std::size_t ENTRY_HEADER = 15;              // kind, three lengths, price
+
+template <class T>
+T load(const char* at) {
+  T value;
+  std::memcpy(&value, at, sizeof value);
+  return value;
+}
+
+template <class T>
+void append(std::string& out, T value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof value);
+}
+
+[[noreturn]] void reject(const std::string& path, const std::string& reason) {
+  throw std::runtime_error(path + " is not a usable sorted run: " + reason);
+}
+
+}  // namespace
+
+//
+// Entries
+//
+
+void append_run_entry(std::string& out, const RunEntry& entry) {
+  out.push_back(entry.tombstone ? 0 : 1);
+  append<std::uint16_t>(out, static_cast<std::uint16_t>(entry.isbn.size()));
+  append<std::uint16_t>(out, static_cast<std::uint16_t>(entry.title.size()));
+  append<std::uint16_t>(out, static_cast<std::uint16_t>(entry.author.size()));
+  append<double>(out, entry.price);
+  out.append(entry.isbn).append(entry.title).append(entry.author);
+}
+
+const char* decode_run_entry(const char* cursor, const char* end, RunEntry& entry) {
+  if (end - cursor < static_cast<std::ptrdiff_t>(ENTRY_HEADER)) {
+    return nullptr;
+  }
+  const std::size_t isbn_size = load<std::uint16_t>(cursor + 1);
+  const std::size_t title_size = load<std::uint16_t>(cursor + 3);
+  const std::size_t author_size = load<std::uint16_t>(cursor + 5);
+  const char* strings = cursor + ENTRY_HEADER;
+  if (static_cast<std::size_t>(end - strings) < isbn_size + title_size + author_size) {
+    return nullptr;
+  }
+  entry.tombstone = *cursor == 0;
+  entry.price = load<double>(cursor + 7);
+  entry.isbn = std::string_view(strings, isbn_size);
+  entry.title = std::string_view(strings + isbn_size, title_size);
+  entry.author = std::string_view(strings + isbn_size + title_size, author_size);
+  return strings + isbn_size + title_size + author_size;
+}
+
+//
+// Writing
+//
+
+SortedRunWriter::SortedRunWriter(std::string path, std::size_t expected_entries)
+    : path_(std::move(path)) {
+  keys_.reserve(expected_entries);
+}
+
+void SortedRunWriter::add(const RunEntry& entry) {
+  if (entry_count_ % INDEX_INTERVAL == 0) {
+    append<std::uint64_t>(index_, data_.size());
+    append<std::uint16_t>(index_, static_cast<std::uint16_t>(entry.isbn.size()));
+    index_.append(entry.isbn);
+  }
+  append_run_entry(data_, entry);
+  keys_.emplace_back(entry.isbn);
+  ++entry_count_;
+}
+
+std::size_t SortedRunWriter::finish() {
+  BloomFilter bloom(keys_.size());
+  for (const std::string& key : keys_) bloom.add(key);
+
+  RunFooter footer{};
+  footer.entry_count = entry_count_;
+  footer.index_offset = data_.size();
+  footer.bloom_offset = footer.index_offset + index_.size();
+  footer.bloom_hashes = bloom.hash_count();
+  footer.footer_offset = footer.bloom_offset + bloom.bytes().size();
+  std::memcpy(footer.magic, RunFooter::MAGIC, sizeof footer.magic);
+
+  std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+  file.write(data_.data(), data_.size());
+  file.write(index_.data(), index_.size());
+  file.write(reinterpret_cast<const char*>(bloom.bytes().data()), bloom.bytes().size());
+  file.write(reinterpret_cast<const char*>(&footer), sizeof footer);
+  file.flush();
+  if (!file) {
+    throw std::system_error(errno, std::generic_category(), "write " + path_);
+  }
+  return footer.footer_offset + sizeof footer;
+}
+
+//
+// Reading
+//
+
+SortedRun::SortedRun(std::string path, std::uint64_t number)
+    : path_(std::move(path)), number_(number), file_(path_) {
+  RunFooter footer;
+  if (file_.size() < sizeof footer) {
+    reject(path_, "too short for a footer");
+  }
+  std::memcpy(&footer, file_.data() + file_.size() - sizeof footer, sizeof footer);
+  if (std::memcmp(footer.magic, RunFooter::MAGIC, sizeof footer.magic) != 0) {
+    reject(path_, "bad magic number");
+  }
+  if (footer.footer_offset != file_.size() - sizeof footer ||
+      footer.bloom_offset > footer.footer_offset || footer.index_offset > footer.bloom_offset) {
+    reject(path_, "sections out of bounds");
+  }
+
+  entry_count_ = footer.entry_count;
+  index_offset_ = footer.index_offset;
+  bloom_ = reinterpret_cast<const unsigned char*>(file_.data() + footer.bloom_offset);
+  bloom_bytes_ = footer.footer_offset - footer.bloom_offset;
+  bloom_hashes_ = footer.bloom_hashes;
+
+  const char* cursor = file_.data() + footer.index_offset;
+  const char* end = file_.data() + footer.bloom_offset;
+  while (cursor < end) {
+    if (end - cursor < 10) reject(path_, "damaged index");
+    const std::uint64_t offset = load<std::uint64_t>(cursor);
+    const std::size_t size = load<std::uint16_t>(cursor + 8);
+    if (static_cast<std::size_t>(end - cursor - 10) < size || offset >= index_offset_) {
+      reject(path_, "damaged index");
+    }
+    index_.emplace_back(std::string(cursor + 10, size), offset);
+    cursor += 10 + size;
+  }
+
+  if (!index_.empty()) {
+    smallest_ = index_.front().first;
+    RunEntry entry;
+    const char* data_end = file_.data() + index_offset_;
+    for (const char* at = file_.data() + index_.back().second; at < data_end;) {
+      at = decode_run_entry(at, data_end, entry);
+      if (at == nullptr) reject(path_, "damaged entry");
+      largest_ = std::string(entry.isbn);
+    }
+  }
+}
+
+SortedRun::~SortedRun() noexcept {
+  if (obsolete_) {
+    std::remove(path_.c_str());
+  }
+}
+
+SortedRun::Lookup SortedRun::find(std::string_view isbn, RunEntry& entry) const {
+  if (index_.empty() || isbn < smallest_ || largest_ < isbn) {
+    return Lookup::ABSENT;
+  }
+  if (!BloomFilter::may_contain(bloom_, bloom_bytes_, bloom_hashes_, isbn)) {
+    return Lookup::FILTERED;
+  }
+
+  // The last index key not greater than "isbn" starts the block to scan.
+  std::size_t low = 0, high = index_.size();
+  while (high - low > 1) {
+    const std::size_t middle = (low + high) / 2;
+    if (isbn < index_[middle].first) high = middle; else low = middle;
+  }
+  const char* cursor = file_.data() + index_[low].second;
+  const char* end = file_.data() + index_offset_;
+  for (std::size_t i = 0; i < SortedRunWriter::INDEX_INTERVAL && cursor < end; ++i) {
+    cursor = decode_run_entry(cursor, end, entry);
+    if (cursor == nullptr || isbn < entry.isbn) {
+      break;
+    }
+    if (entry.isbn == isbn) {
+      return entry.tombstone ? Lookup::REMOVED : Lookup::FOUND;
+    }
+  }
+  return Lookup::ABSENT;
+}
@@ -0,0 +1,161 @@
+#ifndef _sorted_run_hpp_
+#define _sorted_run_hpp_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "book.hpp"
+#include "mapped_file.hpp"
+
+// An immutable file of Book entries sorted by ISBN: one level of the LSM
+// catalog (lsm_catalog.hpp) is made of these. An entry is either a Book or a
+// tombstone recording that the ISBN was removed.
+//
+// Layout (native byte order):
+//
+//   entries       kind (1 byte: 0 tombstone, 1 book), isbn, title, and author
+//                 lengths (2 bytes each), price (8 bytes), then the strings
+//   sparse index  every INDEX_INTERVAL-th entry: offset (8 bytes), key length
+//                 (2 bytes), key
+//   bloom filter  the BloomFilter bits of every ISBN
+//   footer        RunFooter
+//
+// Opening a run maps it and reads its index; a lookup then tests the bloom
+// filter, binary searches the index, and scans at most INDEX_INTERVAL
+// entries.
+
+// One entry, viewing the bytes of a run (or of whatever it was decoded from).
+struct RunEntry {
+  std::string_view isbn;
+  std::string_view title;
+  std::string_view author;
+  double price = 0.0;
+  bool tombstone = false;
+
+  Book book() const {
+    return Book(std::string(title), std::string(author), std::string(isbn), price);
+  }
+};
+
+// Appends the encoding of "entry" to "out".
+void append_run_entry(std::string& out, const RunEntry& entry);
+
+// Decodes the entry at "cursor" and returns the position after it, or
+// nullptr if the bytes up to "end" do not hold a whole entry.
+const char* decode_run_entry(const char* cursor, const char* end, RunEntry& entry);
+
+struct RunFooter {
+  static constexpr char MAGIC[8] = {'B', 'O', 'O', 'K', 'R', 'U', 'N', '1'};
+
+  std::uint64_t entry_count;
+  std::uint64_t index_offset;
+  std::uint64_t bloom_offset;
+  std::uint64_t bloom_hashes;
+  std::uint64_t footer_offset;
+  char magic[8];
+};
+
+// Writes a run from entries handed over in strictly increasing ISBN order.
+//
+//   SortedRunWriter writer("000001.run", expected_entries);
+//   writer.add(entry);  ...
+//   writer.finish();
+class SortedRunWriter {
+ public:
+  static constexpr std::size_t INDEX_INTERVAL = 16;
+
+  // Throws std::system_error if the file cannot be created.
+  SortedRunWriter(std::string path, std::size_t expected_entries);
+
+  void add(const RunEntry& entry);
+
+  // Bytes of entries added so far.
+  std::size_t data_bytes() const { return data_.size(); }
+  std::size_t entry_count() const { return entry_count_; }
+
+  // Writes the file. Returns its size. Throws std::system_error if it cannot
+  // be written.
+  std::size_t finish();
+
+ private:
+  std::string path_;
+  std::string data_;
+  std::string index_;
+  std::vector<std::string> keys_;
+  std::size_t entry_count_ = 0;
+};
+
+// An open run. The file is removed when the last reference to a run marked
+// obsolete goes away, so a reader can keep using a run that compaction has
+// already replaced.
+class SortedRun {
+ public:
+  // Throws std::system_error if the file cannot be mapped, and
+  // std::runtime_error if it is not a run.
+  SortedRun(std::string path, std::uint64_t number);
+
+  SortedRun(const SortedRun&) = delete;
+  SortedRun& operator=(const SortedRun&) = delete;
+
+  ~SortedRun() noexcept;
+
+  // The result of looking an ISBN up in one run.
+  enum class Lookup { ABSENT, FILTERED, FOUND, REMOVED };
+
+  // Looks "isbn" up. FILTERED means the bloom filter ruled it out without
+  // reading any entry; "entry" is set when FOUND or REMOVED.
+  Lookup find(std::string_view isbn, RunEntry& entry) const;
+
+  // Calls "visit(entry)" for every entry in order.
+  template <class Visitor>
+  void for_each(Visitor visit) const {
+    RunEntry entry;
+    const char* end = file_.data() + index_offset_;
+    for (const char* cursor = file_.data(); cursor != nullptr && cursor < end;) {
+      cursor = decode_run_entry(cursor, end, entry);
+      if (cursor != nullptr) {
+        visit(static_cast<const RunEntry&>(entry));
+      }
+    }
+  }
+
+  // The encoded entries, for reading them in order with decode_run_entry().
+  const char* entries_begin() const { return file_.data(); }
+  const char* entries_end() const { return file_.data() + index_offset_; }
+
+  std::uint64_t number() const { return number_; }
+  const std::string& path() const { return path_; }
+  std::size_t entry_count() const { return entry_count_; }
+  std::size_t file_size() const { return file_.size(); }
+  const std::string& smallest() const { return smallest_; }
+  const std::string& largest() const { return largest_; }
+
+  bool overlaps(std::string_view smallest, std::string_view largest) const {
+    return !(largest_ < smallest || largest < smallest_);
+  }
+
+  // Removes the file once no one uses the run any more.
+  void mark_obsolete() { obsolete_ = true; }
+
+ private:
+  std::string path_;
+  std::uint64_t number_;
+  MappedFile file_;
+  std::size_t entry_count_ = 0;
+  std::size_t index_offset_ = 0;
+  std::vector<std::pair<std::string, std::uint64_t>> index_;
+  const unsigned char* bloom_ = nullptr;
+  std::size_t bloom_bytes_ = 0;
+  std::size_t bloom_hashes_ = 0;
+  std::string smallest_;
+  std::string largest_;
+  std::atomic<bool> obsolete_{false};
+};
+
+#endif
@@ -0,0 +1,26 @@
+#include "structural_scanner.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "book.hpp"
+#include "book_loader.hpp"
+#include "mapped_file.hpp"
+
+std::vector<Book> parse_books_simd(std::string_view text) {
+  std::vector<Book> books;
+  books.reserve(text.size() / 64 + 1);
+  for_each_book_record_indexed(text.data(), text.data() + text.size(),
+                               [&](const RawBookRecord& record) {
+                                 books.push_back(to_book(record));
+                               });
+  books.shrink_to_fit();
+  return books;
+}
+
+std::vector<Book> load_books_simd(const std::string& path) {
+  MappedFile file(path);
+  file.advise_sequential();
+  return parse_books_simd(file.view());
+}
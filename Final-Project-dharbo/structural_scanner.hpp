@@ -0,0 +1,334 @@
+#ifndef _structural_scanner_hpp_
+#define _structural_scanner_hpp_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "book.hpp"
+#include "book_loader.hpp"
+
+// A two-stage parser for the text database format, in the style of simdjson.
+//
+// Stage 1 classifies the input 64 bytes at a time. Each block becomes four
+// bitmasks, one bit per byte: where the quotes, backslashes, commas, and
+// newlines are. Backslash escapes are resolved with a little bit arithmetic,
+// and a prefix XOR over the unescaped quotes gives a mask of the bytes inside
+// quoted fields, so that commas and newlines inside a title do not count. The
+// surviving positions, the "structural index", are appended to a vector.
+//
+// Stage 2 walks that index instead of the bytes: a quoted field ends at the
+// next quote in the index, and a delimiter is the next comma, so the field
+// contents are never looked at one byte at a time.
+//
+// Every position taken from the index is checked against what the scalar
+// parser in book_loader.hpp expects to find there; where they disagree (for
+// example an unquoted field that contains a quote, which throws the prefix XOR
+// off), stage 2 parses that field with the scalar code instead. The result is
+// therefore always the same as parse_books().
+//
+// The block classifier uses AVX2 or SSE2 when the compiler targets them
+// (-mavx2, -march=native, or any x86-64 for SSE2) and a plain loop otherwise.
+
+// One 64-byte block of input, classified.
+struct StructuralMasks {
+  std::uint64_t quote = 0;
+  std::uint64_t backslash = 0;
+  std::uint64_t comma = 0;
+  std::uint64_t newline = 0;
+};
+
+//
+// Stage 1: Classification
+//
+
+constexpr std::size_t STRUCTURAL_BLOCK_SIZE = 64;
+
+inline StructuralMasks classify_block_scalar(const char* block) {
+  StructuralMasks masks;
+  for (std::size_t i = 0; i < STRUCTURAL_BLOCK_SIZE; ++i) {
+    const std::uint64_t bit = std::uint64_t{1} << i;
+    switch (block[i]) {
+      case '"':  masks.quote |= bit; break;
+      case '\\': masks.backslash |= bit; break;
+      case ',':  masks.comma |= bit; break;
+      case '\n': masks.newline |= bit; break;
+      default: break;
+    }
+  }
+  return masks;
+}
+
+#if defined(__AVX2__)
+
+inline StructuralMasks classify_block(const char* block) {
+  const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+  const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+  auto match = [&](char c) {
+    const __m256i target = _mm256_set1_epi8(c);
+    const std::uint32_t lo = _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, target));
+    const std::uint32_t hi = _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, target));
+    return std::uint64_t{lo} | (std::uint64_t{hi} << 32);
+  };
+  return {match('"'), match('\\'), match(','), match('\n')};
+}
+
+constexpr const char* STRUCTURAL_BACKEND = "avx2";
+
+#elif defined(__SSE2__)
+
+inline StructuralMasks classify_block(const char* block) {
+  __m128i lanes[4];
+  for (int i = 0; i < 4; ++i) {
+    lanes[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+  }
+  auto match = [&](char c) {
+    const __m128i target = _mm_set1_epi8(c);
+    std::uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+      const std::uint32_t bits = _mm_movemask_epi8(_mm_cmpeq_epi8(lanes[i], target));
+      mask |= std::uint64_t{bits} << (16 * i);
+    }
+    return mask;
+  };
+  return {match('"'), match('\\'), match(','), match('\n')};
+}
+
+constexpr const char* STRUCTURAL_BACKEND = "sse2";
+
+#else
+
+inline StructuralMasks classify_block(const char* block) {
+  return classify_block_scalar(block);
+}
+
+constexpr const char* STRUCTURAL_BACKEND = "scalar";
+
+#endif
+
+// Returns a mask whose bit i is the XOR of bits 0..i of "bits". Applied to the
+// quote mask, it sets every bit from an opening quote up to (not including)
+// the matching closing quote.
+inline std::uint64_t prefix_xor(std::uint64_t bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+// Builds the structural index of consecutive pieces of one input, carrying
+// the escape and in-quote state from each piece to the next.
+//
+// An index entry is the offset, from the start of the piece, of an unescaped
+// quote, of a backslash that escapes the next byte, or of a comma or newline
+// outside quotes.
+class StructuralIndexer {
+ public:
+  // Classifies [begin, end) and replaces "index" with its entries. "begin"
+  // must be where the previous call's piece ended, or the start of the input.
+  template <bool Vectorized = true>
+  void build(const char* begin, const char* end,
+             std::vector<std::uint32_t>& index) {
+    index.clear();
+    const std::size_t size = end - begin;
+    std::size_t offset = 0;
+    for (; offset + STRUCTURAL_BLOCK_SIZE <= size;
+         offset += STRUCTURAL_BLOCK_SIZE) {
+      append(classify<Vectorized>(begin + offset), offset, index);
+    }
+    if (offset < size) {
+      // Pad the last partial block with spaces, which are never structural.
+      char block[STRUCTURAL_BLOCK_SIZE];
+      std::memset(block, ' ', sizeof block);
+      std::memcpy(block, begin + offset, size - offset);
+      append(classify<Vectorized>(block), offset, index);
+    }
+  }
+
+ private:
+  template <bool Vectorized>
+  static StructuralMasks classify(const char* block) {
+    return Vectorized ? classify_block(block) : classify_block_scalar(block);
+  }
+
+  void append(const StructuralMasks& masks, std::size_t offset,
+              std::vector<std::uint32_t>& index) {
+    // A backslash escapes the byte after it unless it is itself escaped.
+    // Backslashes are rare, so they are resolved one at a time.
+    std::uint64_t escaped = escape_carry_;
+    std::uint64_t escapers = 0;
+    escape_carry_ = 0;
+    for (std::uint64_t pending = masks.backslash & ~escaped; pending != 0;) {
+      const std::uint64_t bit = pending & -pending;
+      escapers |= bit;
+      if (bit >> 63) {
+        escape_carry_ = 1;
+      }
+      escaped |= bit << 1;
+      pending &= ~(bit | (bit << 1));
+    }
+
+    const std::uint64_t quotes = masks.quote & ~escaped;
+    const std::uint64_t inside = prefix_xor(quotes) ^ quote_carry_;
+    quote_carry_ = (inside >> 63) ? ~std::uint64_t{0} : 0;
+
+    std::uint64_t structural =
+        quotes | escapers | ((masks.comma | masks.newline) & ~inside);
+    while (structural != 0) {
+      index.push_back(static_cast<std::uint32_t>(offset + count_trailing_zeros(structural)));
+      structural &= structural - 1;
+    }
+  }
+
+  static int count_trailing_zeros(std::uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int count = 0;
+    for (; (bits & 1) == 0; bits >>= 1) ++count;
+    return count;
+#endif
+  }
+
+  std::uint64_t escape_carry_ = 0;                    // bit 0 set if the next piece starts escaped
+  std::uint64_t quote_carry_ = 0;                     // all ones if the next piece starts inside quotes
+};
+
+//
+// Stage 2: Records
+//
+
+// Calls "visitor(record)" for every record in [begin, end), like
+// for_each_book_record(), but finds field and delimiter positions through a
+// structural index built "window" bytes at a time. Returns the position where
+// parsing stopped.
+template <class Visitor>
+const char* for_each_book_record_indexed(const char* begin, const char* end,
+                                         Visitor visitor,
+                                         std::size_t window = 1 << 20);
+
+// Parses every record in "text" into Books with the two-stage scanner.
+std::vector<Book> parse_books_simd(std::string_view text);
+
+// Memory-maps the database file at "path" and parses it with the two-stage
+// scanner. Throws std::system_error if the file cannot be mapped.
+std::vector<Book> load_books_simd(const std::string& path);
+
+//
+// Implementation
+//
+
+namespace structural_detail {
+
+// The structural index of one window of the input, and a cursor into it.
+// Entries past the end of the window are simply missing; the parser then
+// falls back to scanning bytes.
+struct IndexedWindow {
+  const char* base = nullptr;
+  std::vector<std::uint32_t> entries;
+  std::size_t next = 0;
+
+  // Moves the cursor to the first entry at or after "position" and returns
+  // it, or nullptr if the window has none.
+  const char* seek(const char* position) {
+    while (next < entries.size() && base + entries[next] < position) {
+      ++next;
+    }
+    return next < entries.size() ? base + entries[next] : nullptr;
+  }
+};
+
+inline bool all_book_space(const char* first, const char* last) {
+  return skip_book_space(first, last) == last;
+}
+
+inline const char* parse_field(const char* cursor, const char* end,
+                               IndexedWindow& window, std::string_view& field,
+                               bool& escaped) {
+  cursor = skip_book_space(cursor, end);
+  if (cursor == end || *cursor != '"' || window.seek(cursor) != cursor) {
+    return parse_book_field(cursor, end, field, escaped);
+  }
+  // The opening quote is in the index, so it is not escaped. Its closing
+  // quote is the next quote entry; escaping backslashes may come between.
+  ++window.next;
+  bool field_escaped = false;
+  for (; window.next < window.entries.size(); ++window.next) {
+    const char* entry = window.base + window.entries[window.next];
+    if (*entry == '\\') {
+      field_escaped = true;
+    } else if (*entry == '"') {
+      ++window.next;
+      field = std::string_view(cursor + 1, entry - cursor - 1);
+      escaped |= field_escaped;
+      return entry + 1;
+    }
+  }
+  return parse_book_field(cursor, end, field, escaped);
+}
+
+inline const char* parse_delimiter(const char* cursor, const char* end,
+                                   IndexedWindow& window) {
+  const char* comma = window.seek(cursor);
+  if (comma != nullptr && *comma == ',' && all_book_space(cursor, comma)) {
+    ++window.next;
+    return comma + 1;
+  }
+  return parse_book_delimiter(cursor, end);
+}
+
+inline const char* parse_record(const char* cursor, const char* end,
+                                IndexedWindow& window, RawBookRecord& record) {
+  record.escaped = false;
+  if ((cursor = parse_field(cursor, end, window, record.isbn, record.escaped)) &&
+      (cursor = parse_delimiter(cursor, end, window)) &&
+      (cursor = parse_field(cursor, end, window, record.title, record.escaped)) &&
+      (cursor = parse_delimiter(cursor, end, window)) &&
+      (cursor = parse_field(cursor, end, window, record.author, record.escaped)) &&
+      (cursor = parse_delimiter(cursor, end, window))) {
+    return parse_book_price(cursor, end, record.price);
+  }
+  return nullptr;
+}
+
+}  // namespace structural_detail
+
+template <class Visitor>
+const char* for_each_book_record_indexed(const char* begin, const char* end,
+                                         Visitor visitor, std::size_t window) {
+  StructuralIndexer indexer;
+  structural_detail::IndexedWindow indexed;
+  RawBookRecord record;
+  const char* cursor = begin;
+  for (const char* first = begin; first < end; first += window) {
+    // Offsets are 32 bits, so windows stay well under 4 GB.
+    const char* last = first + std::min<std::size_t>(window, end - first);
+    indexed.base = first;
+    indexed.next = 0;
+    indexer.build(first, last, indexed.entries);
+
+    // Records that start in this window; the last may run into the next one.
+    while (cursor < last) {
+      const char* next = structural_detail::parse_record(cursor, end, indexed, record);
+      if (next == nullptr) {
+        return cursor;
+      }
+      visitor(static_cast<const RawBookRecord&>(record));
+      cursor = next;
+    }
+  }
+  return cursor;
+}
+
+#endif
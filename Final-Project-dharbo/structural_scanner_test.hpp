@@ -0,0 +1,108 @@
+#ifndef _structural_scanner_test_hpp_
+#define _structural_scanner_test_hpp_
+
+#include "structural_scanner.hpp"
+
+#include <cstdint>
+#include <iomanip>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "book_loader.hpp"
+#include "doctest.hpp"
+
+// Returns "count" characters drawn mostly from the ones the scanner treats as
+// structural.
+inline std::string random_book_field(std::mt19937& random, std::size_t count) {
+  static const char alphabet[] = "\"\\,\n\t abcXYZ019.";
+  std::uniform_int_distribution<std::size_t> pick(0, sizeof alphabet - 2);
+  std::string field;
+  for (std::size_t i = 0; i < count; ++i) field.push_back(alphabet[pick(random)]);
+  return field;
+}
+
+// Writes a database text made of well-formed records with awkward contents,
+// some unquoted fields, irregular spacing, and, occasionally, a truncated or
+// corrupted tail.
+inline std::string random_database_text(std::mt19937& random) {
+  std::uniform_int_distribution<std::size_t> length(0, 40);
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::ostringstream stream;
+  auto space = [&] {
+    if (percent(random) < 20) stream << (percent(random) < 50 ? " \t " : "\n");
+  };
+  const int records = percent(random);
+  for (int i = 0; i < records; ++i) {
+    for (int field = 0; field < 3; ++field) {
+      space();
+      if (percent(random) < 5) {
+        stream << "word" << i << (percent(random) < 50 ? "\"q" : "\\") << ' ';
+      } else {
+        stream << std::quoted(random_book_field(random, length(random)));
+      }
+      space();
+      stream << ',';
+    }
+    space();
+    stream << percent(random) << '.' << percent(random) << '\n';
+  }
+  std::string text = stream.str();
+  if (!text.empty() && percent(random) < 10) {
+    text.resize(std::uniform_int_distribution<std::size_t>(0, text.size())(random));
+  }
+  return text;
+}
+
+TEST_CASE("StructuralMasks") {
+  SUBCASE("VectorizedMatchesScalar") {
+    std::mt19937 random(131);
+    for (int trial = 0; trial < 200; ++trial) {
+      const std::string block = random_book_field(random, STRUCTURAL_BLOCK_SIZE);
+      const StructuralMasks expected = classify_block_scalar(block.data());
+      const StructuralMasks actual = classify_block(block.data());
+      CHECK_EQ(actual.quote, expected.quote);
+      CHECK_EQ(actual.backslash, expected.backslash);
+      CHECK_EQ(actual.comma, expected.comma);
+      CHECK_EQ(actual.newline, expected.newline);
+    }
+  }
+
+  SUBCASE("PrefixXorMarksQuotedBytes") {
+    CHECK_EQ(prefix_xor(0b0000), 0b0000);
+    CHECK_EQ(prefix_xor(0b1001), 0b0111);
+    CHECK_EQ(prefix_xor(0b0001), ~std::uint64_t{0});
+  }
+
+  SUBCASE("IndexSkipsQuotedAndEscapedBytes") {
+    const std::string text = "\"a,b\\\"\\\\\", c\n";
+    std::vector<std::uint32_t> index;
+    StructuralIndexer().build(text.data(), text.data() + text.size(), index);
+    // Opening quote, both escaping backslashes, closing quote, comma, newline.
+    CHECK_EQ(index, std::vector<std::uint32_t>{0, 4, 6, 8, 9, 12});
+  }
+}
+
+TEST_CASE("ParseBooksSimdMatchesExtractionOperator") {
+  std::mt19937 random(33);
+  for (int trial = 0; trial < 500; ++trial) {
+    const std::string text = random_database_text(random);
+    std::istringstream stream(text);
+    const std::vector<Book> expected{std::istream_iterator<Book>(stream),
+                                     std::istream_iterator<Book>()};
+    CHECK_EQ(parse_books_simd(text), expected);
+
+    // Tiny windows put records, fields, and escapes across window edges.
+    std::vector<Book> windowed;
+    for_each_book_record_indexed(
+        text.data(), text.data() + text.size(),
+        [&](const RawBookRecord& record) { windowed.push_back(to_book(record)); },
+        STRUCTURAL_BLOCK_SIZE);
+    CHECK_EQ(windowed, expected);
+  }
+}
+
+#endif
@@ -0,0 +1,224 @@
+#include "text_index.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+void put_varint(std::vector<std::uint8_t>& out, std::uint32_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<std::uint8_t>(value));
+}
+
+const std::uint8_t* get_varint(const std::uint8_t* in, std::uint32_t& value) {
+  value = 0;
+  for (int shift = 0;; shift += 7) {
+    const std::uint8_t byte = *in++;
+    value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+    if (byte < 0x80) {
+      return in;
+    }
+  }
+}
+
+}  // namespace
+
+//
+// Posting lists
+//
+
+void TextIndex::PostingList::append(DocId doc) {
+  tail.push_back(doc);
+  if (tail.size() < BLOCK_SIZE) {
+    return;
+  }
+  blocks.push_back(Block{tail.front(), tail.back(), static_cast<std::uint32_t>(gaps.size())});
+  for (std::size_t i = 1; i < tail.size(); ++i) {
+    put_varint(gaps, tail[i] - tail[i - 1]);
+  }
+  tail.clear();
+}
+
+std::size_t TextIndex::PostingList::decode(std::size_t block, DocId* out) const {
+  const std::uint8_t* in = gaps.data() + blocks[block].offset;
+  DocId doc = blocks[block].first;
+  out[0] = doc;
+  for (std::size_t i = 1; i < BLOCK_SIZE; ++i) {
+    std::uint32_t gap;
+    in = get_varint(in, gap);
+    doc += gap;
+    out[i] = doc;
+  }
+  return BLOCK_SIZE;
+}
+
+void TextIndex::PostingList::decode_all(std::vector<DocId>& out) const {
+  const std::size_t start = out.size();
+  out.resize(start + size());
+  for (std::size_t block = 0; block < blocks.size(); ++block) {
+    decode(block, out.data() + start + block * BLOCK_SIZE);
+  }
+  std::copy(tail.begin(), tail.end(), out.begin() + start + blocks.size() * BLOCK_SIZE);
+}
+
+//
+// Modifiers
+//
+
+TextIndex::DocId TextIndex::add(std::string_view isbn, std::string_view title, std::string_view author) {
+  remove(isbn);
+  const DocId doc = static_cast<DocId>(documents_.size());
+  const auto key = ids_.emplace(std::string(isbn), doc).first;
+  documents_.push_back(&key->first);
+
+  std::vector<std::string> words = text_tokens(title);
+  for (std::string& word : text_tokens(author)) words.push_back(std::move(word));
+  std::sort(words.begin(), words.end());
+  words.erase(std::unique(words.begin(), words.end()), words.end());
+  for (const std::string& word : words) {
+    terms_[word].append(doc);
+  }
+  return doc;
+}
+
+bool TextIndex::remove(std::string_view isbn) {
+  const auto found = ids_.find(std::string(isbn));
+  if (found == ids_.end()) {
+    return false;
+  }
+  documents_[found->second] = nullptr;
+  ids_.erase(found);
+  ++removed_;
+
+  // Rewriting costs about as much as the postings of the books still
+  // indexed, so waiting until as many have been removed keeps removal
+  // amortized O(words per book).
+  if (removed_ >= BLOCK_SIZE && removed_ > ids_.size()) {
+    compact();
+  }
+  return true;
+}
+
+void TextIndex::compact() {
+  std::vector<DocId> docs;
+  for (auto term = terms_.begin(); term != terms_.end();) {
+    docs.clear();
+    term->second.decode_all(docs);
+    PostingList rewritten;
+    for (DocId doc : docs) {
+      if (documents_[doc] != nullptr) rewritten.append(doc);
+    }
+    if (rewritten.size() == 0) {
+      term = terms_.erase(term);
+    } else {
+      term->second = std::move(rewritten);
+      ++term;
+    }
+  }
+  removed_ = 0;
+}
+
+void TextIndex::clear() {
+  terms_.clear();
+  ids_.clear();
+  documents_.clear();
+  removed_ = 0;
+}
+
+//
+// Queries
+//
+
+template <bool Vectorized>
+void TextIndex::intersect(const std::vector<DocId>& candidates, const PostingList& list, std::vector<DocId>& out) {
+  auto intersect_range = [&](const DocId* a, std::size_t a_size, const DocId* b, std::size_t b_size) {
+    if constexpr (Vectorized) {
+      intersect_postings(a, a_size, b, b_size, out);
+    } else {
+      intersect_postings_scalar(a, a_size, b, b_size, out);
+    }
+  };
+
+  DocId decoded[BLOCK_SIZE];
+  auto candidate = candidates.begin();
+  auto block = list.blocks.begin();
+  while (candidate != candidates.end()) {
+    // The first block that can hold the next candidate.
+    block = std::lower_bound(block, list.blocks.end(), *candidate,
+                             [](const Block& b, DocId doc) { return b.last < doc; });
+    if (block == list.blocks.end()) {
+      break;
+    }
+    const auto end = std::upper_bound(candidate, candidates.end(), block->last);
+    if (end != candidate && *(end - 1) >= block->first) {
+      const std::size_t count = list.decode(block - list.blocks.begin(), decoded);
+      intersect_range(&*candidate, end - candidate, decoded, count);
+    }
+    candidate = end;
+    ++block;
+  }
+  if (candidate != candidates.end() && !list.tail.empty()) {
+    intersect_range(&*candidate, candidates.end() - candidate, list.tail.data(), list.tail.size());
+  }
+}
+
+template <bool Vectorized>
+std::vector<TextIndex::DocId> TextIndex::search(std::string_view query) const {
+  std::vector<const PostingList*> lists;
+  for (const std::string& word : text_tokens(query)) {
+    const auto found = terms_.find(word);
+    if (found == terms_.end()) {
+      return {};
+    }
+    lists.push_back(&found->second);
+  }
+  if (lists.empty()) {
+    return {};
+  }
+  std::sort(lists.begin(), lists.end(),
+            [](const PostingList* lhs, const PostingList* rhs) { return lhs->size() < rhs->size(); });
+
+  std::vector<DocId> matches;
+  lists.front()->decode_all(matches);
+  std::vector<DocId> next;
+  for (std::size_t i = 1; i < lists.size() && !matches.empty(); ++i) {
+    next.clear();
+    intersect<Vectorized>(matches, *lists[i], next);
+    matches.swap(next);
+  }
+  if (removed_ > 0) {
+    matches.erase(std::remove_if(matches.begin(), matches.end(),
+                                 [&](DocId doc) { return documents_[doc] == nullptr; }),
+                  matches.end());
+  }
+  return matches;
+}
+
+template std::vector<TextIndex::DocId> TextIndex::search<true>(std::string_view) const;
+template std::vector<TextIndex::DocId> TextIndex::search<false>(std::string_view) const;
+
+std::size_t TextIndex::postings() const {
+  std::size_t count = 0;
+  for (const auto& [word, list] : terms_) count += list.size();
+  return count;
+}
+
+std::size_t TextIndex::postings(const std::string& word) const {
+  const auto found = terms_.find(word);
+  return found == terms_.end() ? 0 : found->second.size();
+}
+
+std::size_t TextIndex::posting_bytes() const {
+  std::size_t bytes = 0;
+  for (const auto& [word, list] : terms_) {
+    bytes += list.gaps.size() + list.blocks.size() * sizeof(Block) + list.tail.size() * sizeof(DocId);
+  }
+  return bytes;
+}
@@ -0,0 +1,281 @@
+#ifndef _text_index_hpp_
+#define _text_index_hpp_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "book.hpp"
+
+// An inverted index of the words in books' titles and authors, for keyword
+// searches such as "genocide" or "bahamas history" that would otherwise scan
+// every book.
+//
+// Each book gets a document number, in the order books are added, and each
+// word a posting list of the numbers of the books that use it. A posting list
+// is kept in blocks of 128 numbers: a block stores its first and last number
+// uncompressed and the gaps between the rest as varints, most of which fit in
+// one or two bytes, and the newest numbers wait in an uncompressed tail until
+// they fill a block. Numbers only grow, so adding a book appends to the tails
+// of its words' lists.
+//
+// A query matches the books with every one of its words. Its lists are
+// intersected shortest first: the shortest is decoded whole, and each longer
+// one skips, by their last numbers, the blocks that cannot hold a remaining
+// match, then intersects the rest with SSE2 four numbers against four at a
+// time (on any x86-64; a plain merge elsewhere).
+//
+// Removing a book only forgets its document number, so searches stop
+// returning it; its postings stay in the lists until compact() rewrites
+// them, which happens by itself once removed books outnumber the rest.
+//
+// Words are runs of ASCII letters and digits, lowercased, and of bytes of
+// UTF-8 sequences, which are kept as they are.
+//
+// Usage:
+//
+//   TextIndex index;
+//   for (const Book& book : books) index.add(book);
+//   for (TextIndex::DocId doc : index.search("nuclear physics")) std::cout << index.isbn(doc) << '\n';
+
+// Calls "visit(word)" for each word of "text", in order, lowercased.
+template <class Visit>
+void for_each_text_token(std::string_view text, Visit visit) {
+  std::string word;
+  for (char c : text) {
+    const unsigned char byte = static_cast<unsigned char>(c);
+    if ((byte >= 'a' && byte <= 'z') || (byte >= '0' && byte <= '9') || byte >= 0x80) {
+      word += c;
+    } else if (byte >= 'A' && byte <= 'Z') {
+      word += static_cast<char>(byte - 'A' + 'a');
+    } else if (!word.empty()) {
+      visit(word);
+      word.clear();
+    }
+  }
+  if (!word.empty()) {
+    visit(word);
+  }
+}
+
+// The distinct words of "text", sorted.
+inline std::vector<std::string> text_tokens(std::string_view text) {
+  std::vector<std::string> words;
+  for_each_text_token(text, [&](const std::string& word) { words.push_back(word); });
+  std::sort(words.begin(), words.end());
+  words.erase(std::unique(words.begin(), words.end()), words.end());
+  return words;
+}
+
+//
+// Posting list intersection
+//
+
+// Appends to "out" the numbers in both "a" and "b", which are sorted and
+// without duplicates.
+inline void intersect_postings_scalar(const std::uint32_t* a, std::size_t a_size,
+                                      const std::uint32_t* b, std::size_t b_size,
+                                      std::vector<std::uint32_t>& out) {
+  std::size_t i = 0, j = 0;
+  while (i < a_size && j < b_size) {
+    if (a[i] < b[j]) {
+      ++i;
+    } else if (b[j] < a[i]) {
+      ++j;
+    } else {
+      out.push_back(a[i]);
+      ++i;
+      ++j;
+    }
+  }
+}
+
+#if defined(__SSE2__)
+
+// Compares four numbers of "a" with each rotation of four of "b": a lane of
+// "a" that equals any lane of "b" is a match. Whichever block ends lower
+// cannot match anything further along the other, so it is the one to advance.
+inline void intersect_postings(const std::uint32_t* a, std::size_t a_size,
+                               const std::uint32_t* b, std::size_t b_size,
+                               std::vector<std::uint32_t>& out) {
+  std::size_t i = 0, j = 0;
+  while (i + 4 <= a_size && j + 4 <= b_size) {
+    const __m128i a_lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i b_lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+    __m128i equal = _mm_cmpeq_epi32(a_lanes, b_lanes);
+    equal = _mm_or_si128(equal, _mm_cmpeq_epi32(a_lanes, _mm_shuffle_epi32(b_lanes, _MM_SHUFFLE(0, 3, 2, 1))));
+    equal = _mm_or_si128(equal, _mm_cmpeq_epi32(a_lanes, _mm_shuffle_epi32(b_lanes, _MM_SHUFFLE(1, 0, 3, 2))));
+    equal = _mm_or_si128(equal, _mm_cmpeq_epi32(a_lanes, _mm_shuffle_epi32(b_lanes, _MM_SHUFFLE(2, 1, 0, 3))));
+    for (int matches = _mm_movemask_ps(_mm_castsi128_ps(equal)); matches != 0; matches &= matches - 1) {
+      out.push_back(a[i + __builtin_ctz(matches)]);
+    }
+    const std::uint32_t a_last = a[i + 3];
+    const std::uint32_t b_last = b[j + 3];
+    if (a_last <= b_last) i += 4;
+    if (b_last <= a_last) j += 4;
+  }
+  intersect_postings_scalar(a + i, a_size - i, b + j, b_size - j, out);
+}
+
+constexpr const char* TEXT_INDEX_BACKEND = "sse2";
+
+#else
+
+inline void intersect_postings(const std::uint32_t* a, std::size_t a_size,
+                               const std::uint32_t* b, std::size_t b_size,
+                               std::vector<std::uint32_t>& out) {
+  intersect_postings_scalar(a, a_size, b, b_size, out);
+}
+
+constexpr const char* TEXT_INDEX_BACKEND = "scalar";
+
+#endif
+
+class TextIndex {
+ public:
+  // A book's document number.
+  using DocId = std::uint32_t;
+
+  // Numbers per compressed block of a posting list.
+  static constexpr std::size_t BLOCK_SIZE = 128;
+
+  TextIndex() = default;
+
+  // The document numbers point into the ISBN map, so an index does not copy.
+  TextIndex(const TextIndex&) = delete;
+  TextIndex& operator=(const TextIndex&) = delete;
+  TextIndex(TextIndex&&) = default;
+  TextIndex& operator=(TextIndex&&) = default;
+
+  //
+  // Modifiers
+  //
+
+  // Indexes the words of a book's title and author under a new document
+  // number, and returns it. A book whose ISBN is already indexed replaces it.
+  template <class Record>
+  DocId add(const Record& book) { return add(book.isbn(), book.title(), book.author()); }
+  DocId add(std::string_view isbn, std::string_view title, std::string_view author);
+
+  // Removes the book with "isbn" from search results. Returns false if there
+  // is none.
+  bool remove(std::string_view isbn);
+
+  // Rewrites every posting list without the removed books.
+  void compact();
+
+  void clear();
+
+  //
+  // Queries
+  //
+
+  // The books whose titles and authors, together, contain every word of
+  // "query", in document number order. A query with no words matches nothing.
+  // Vectorized = false intersects with the plain merge, for comparison.
+  template <bool Vectorized = true>
+  std::vector<DocId> search(std::string_view query) const;
+
+  // The ISBN of a book returned by search().
+  const std::string& isbn(DocId doc) const { return *documents_[doc]; }
+
+  bool contains(std::string_view isbn) const { return ids_.count(std::string(isbn)) > 0; }
+
+  // Books indexed and not removed.
+  std::size_t size() const { return ids_.size(); }
+  bool empty() const { return ids_.empty(); }
+
+  // Distinct words, and the postings in their lists, including those of
+  // removed books that are not yet compacted away.
+  std::size_t terms() const { return terms_.size(); }
+  std::size_t postings() const;
+
+  // Entries in the posting list of "word" (already lowercased).
+  std::size_t postings(const std::string& word) const;
+
+  // Bytes the posting lists take, compressed blocks, block headers, and
+  // tails, against the 4 bytes per posting of an array of numbers.
+  std::size_t posting_bytes() const;
+
+ private:
+  // The first and last numbers of a block, and where its gaps start.
+  struct Block {
+    DocId first;
+    DocId last;
+    std::uint32_t offset;
+  };
+
+  struct PostingList {
+    std::vector<std::uint8_t> gaps;
+    std::vector<Block> blocks;
+    std::vector<DocId> tail;                          // fewer than BLOCK_SIZE, after every block
+
+    std::size_t size() const { return blocks.size() * BLOCK_SIZE + tail.size(); }
+    void append(DocId doc);
+    std::size_t decode(std::size_t block, DocId* out) const;
+    void decode_all(std::vector<DocId>& out) const;
+  };
+
+  // Intersects "candidates" with "list", skipping the blocks past which no
+  // candidate falls, into "out".
+  template <bool Vectorized>
+  static void intersect(const std::vector<DocId>& candidates, const PostingList& list, std::vector<DocId>& out);
+
+  std::unordered_map<std::string, PostingList> terms_;
+  std::unordered_map<std::string, DocId> ids_;
+  std::vector<const std::string*> documents_;         // the ISBN key of each number, or null once removed
+  std::size_t removed_ = 0;                           // removed numbers still in the lists
+};
+
+//
+// TEXT INDEX OPERATIONS
+//
+
+struct search_within_text_index {
+  // Function takes no parameters, finds the books in a text index with every
+  // word of the target query, and returns their document numbers.
+  std::vector<TextIndex::DocId> operator()(const Book& unused) { return my_index.search(target_query); }
+
+  const TextIndex& my_index;
+  const std::string target_query;
+};
+
+template <class Record = Book>
+struct search_within_vector_by_words {
+  // Function takes no parameters, scans a vector for the books with every
+  // word of the target query in their titles and authors, and returns them.
+  std::vector<const Record*> operator()(const Record& unused) {
+    const std::vector<std::string> query = text_tokens(target_query);
+    std::vector<const Record*> found;
+    if (query.empty()) {
+      return found;
+    }
+    std::vector<std::string> words;
+    for (const Record& book : my_vector) {
+      words.clear();
+      auto collect = [&](const std::string& word) { words.push_back(word); };
+      for_each_text_token(book.title(), collect);
+      for_each_text_token(book.author(), collect);
+      std::sort(words.begin(), words.end());
+      if (std::includes(words.begin(), words.end(), query.begin(), query.end())) {
+        found.push_back(&book);
+      }
+    }
+    return found;
+  }
+
+  const std::vector<Record>& my_vector;
+  const std::string target_query;
+};
+template <class Record>
+search_within_vector_by_words(const std::vector<Record>&, std::string) -> search_within_vector_by_words<Record>;
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef _text_index_test_hpp_
+#define _text_index_test_hpp_
+
+#include "text_index.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("TextTokens") {
+  CHECK_EQ(text_tokens("Malta language question (1st edition)"),
+           std::vector<std::string>{"1st", "edition", "language", "malta", "question"});
+  CHECK_EQ(text_tokens("Hindu berkiblat ke India? INDIA!"),
+           std::vector<std::string>{"berkiblat", "hindu", "india", "ke"});
+  CHECK_EQ(text_tokens("Kvæði"), std::vector<std::string>{"kvæði"});
+  CHECK(text_tokens(" -- ").empty());
+}
+
+TEST_CASE("IntersectPostings") {
+  std::default_random_engine random(46);
+  for (std::uint32_t density : {2, 5, 50}) {
+    std::vector<std::uint32_t> a, b;
+    std::uniform_int_distribution<std::uint32_t> pick(0, density - 1);
+    for (std::uint32_t doc = 0; doc < 5000; ++doc) {
+      if (pick(random) == 0) a.push_back(doc);
+      if (pick(random) == 0) b.push_back(doc);
+    }
+    std::vector<std::uint32_t> expected, vectorized;
+    intersect_postings_scalar(a.data(), a.size(), b.data(), b.size(), expected);
+    intersect_postings(a.data(), a.size(), b.data(), b.size(), vectorized);
+    CHECK_EQ(vectorized, expected);
+    vectorized.clear();
+    intersect_postings(b.data(), b.size(), a.data(), a.size(), vectorized);
+    CHECK_EQ(vectorized, expected);
+  }
+}
+
+TEST_CASE("TextIndex") {
+  // Titles from a small vocabulary, so common words span many blocks.
+  const std::vector<std::string> vocabulary = {"history", "of", "the", "bahamas", "genocide", "nuclear",
+                                               "physics", "collected", "poems", "Kvæði", "ÉTUDES", "2nd"};
+  std::default_random_engine random(461);
+  std::uniform_int_distribution<std::size_t> word(0, vocabulary.size() - 1);
+  std::uniform_int_distribution<std::size_t> length(1, 5);
+  std::vector<Book> books;
+  TextIndex index;
+  for (std::size_t i = 0; i < 3000; ++i) {
+    std::string title;
+    for (std::size_t n = length(random); n > 0; --n) title += vocabulary[word(random)] + ' ';
+    books.emplace_back(title, i % 7 == 0 ? "Hull, Geoffrey" : "Too, Lillian", std::to_string(i), 1.0);
+    index.add(books.back());
+  }
+
+  // The index finds what a scan of the remaining books finds.
+  auto check = [&](const std::string& query) {
+    std::vector<std::string> expected;
+    for (const Book* book : search_within_vector_by_words{books, query}(books[0])) expected.push_back(book->isbn());
+    std::vector<std::string> found, scalar;
+    for (TextIndex::DocId doc : index.search(query)) found.push_back(index.isbn(doc));
+    for (TextIndex::DocId doc : index.search<false>(query)) scalar.push_back(index.isbn(doc));
+    std::sort(expected.begin(), expected.end());
+    std::sort(found.begin(), found.end());
+    std::sort(scalar.begin(), scalar.end());
+    CHECK_EQ(found, expected);
+    CHECK_EQ(scalar, expected);
+  };
+  const std::vector<std::string> queries = {"history", "the bahamas", "nuclear physics of", "hull poems",
+                                            "KVÆÐI", "ÉTUDES 2nd the", "lillian history genocide", "missing",
+                                            "the missing", ""};
+
+  SUBCASE("Search") {
+    CHECK_EQ(index.size(), 3000);
+    CHECK_GT(index.postings("the"), 4 * TextIndex::BLOCK_SIZE);
+    CHECK_LT(index.posting_bytes(), index.postings() * sizeof(TextIndex::DocId) / 2);
+    for (const std::string& query : queries) check(query);
+    CHECK_EQ(search_within_text_index{index, "hull"}(books[0]).size(), 3000 / 7 + 1);
+  }
+
+  SUBCASE("RemoveAndReplace") {
+    // Remove every third book and retitle every fifth.
+    std::vector<Book> remaining;
+    for (std::size_t i = 0; i < books.size(); ++i) {
+      if (i % 3 == 0) {
+        CHECK(index.remove(books[i].isbn()));
+      } else if (i % 5 == 0) {
+        remaining.emplace_back("Bahamas genocide", books[i].author(), books[i].isbn(), 1.0);
+        index.add(remaining.back());
+      } else {
+        remaining.push_back(books[i]);
+      }
+    }
+    CHECK_FALSE(index.remove("0"));
+    CHECK_FALSE(index.contains("3"));
+    books = remaining;
+    CHECK_EQ(index.size(), books.size());
+    for (const std::string& query : queries) check(query);
+
+    const std::size_t before = index.postings();
+    index.compact();
+    CHECK_LT(index.postings(), before);
+    for (const std::string& query : queries) check(query);
+  }
+
+  SUBCASE("RemovingMostBooksCompacts") {
+    for (std::size_t i = 0; i < 2000; ++i) index.remove(books[i].isbn());
+    books.erase(books.begin(), books.begin() + 2000);
+    CHECK_LT(index.postings(), 2000 * 5);
+    for (const std::string& query : queries) check(query);
+  }
+
+  SUBCASE("Clear") {
+    index.clear();
+    CHECK(index.empty());
+    CHECK_EQ(index.terms(), 0);
+    CHECK(index.search("history").empty());
+  }
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef _thread_pool_hpp_
+#define _thread_pool_hpp_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A fixed set of worker threads that run submitted tasks in FIFO order.
+//
+// Usage:
+//
+//   ThreadPool pool(4);
+//   std::future<int> answer = pool.submit([] { return 6 * 7; });
+//   answer.get();                                   // 42
+//
+// The destructor finishes every task already submitted, then joins the
+// workers.
+class ThreadPool {
+ public:
+  // Starts "thread_count" workers, or one per hardware thread when 0.
+  explicit ThreadPool(std::size_t thread_count = 0) {
+    if (thread_count == 0) {
+      thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+      workers_.emplace_back([this] { work(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    ready_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  // Queues "task" to run on a worker and returns a future for its result. An
+  // exception thrown by the task is rethrown from the future's get().
+  template <class Task>
+  std::future<std::invoke_result_t<Task>> submit(Task task) {
+    using Result = std::invoke_result_t<Task>;
+    // std::function needs a copyable target, so the move-only packaged_task is
+    // shared instead.
+    auto packaged =
+        std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    std::future<Result> result = packaged->get_future();
+    {
+      std::lock_guard lock(mutex_);
+      tasks_.emplace([packaged] { (*packaged)(); });
+    }
+    ready_.notify_one();
+    return result;
+  }
+
+  std::size_t size() const { return workers_.size(); }
+
+ private:
+  void work() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock lock(mutex_);
+        ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;                                     // stopping and drained
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::queue<std::function<void()>> tasks_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef _thread_pool_test_hpp_
+#define _thread_pool_test_hpp_
+
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+#include "doctest.hpp"
+
+TEST_CASE("ThreadPool") {
+  SUBCASE("ReturnsResultsThroughFutures") {
+    ThreadPool pool(3);
+    CHECK_EQ(pool.size(), 3);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i) {
+      results.push_back(pool.submit([i] { return i * i; }));
+    }
+    for (int i = 0; i < 100; ++i) {
+      CHECK_EQ(results[i].get(), i * i);
+    }
+  }
+
+  SUBCASE("FinishesQueuedTasksOnDestruction") {
+    std::atomic<int> finished{0};
+    {
+      ThreadPool pool(2);
+      for (int i = 0; i < 50; ++i) {
+        pool.submit([&finished] { ++finished; });
+      }
+    }
+    CHECK_EQ(finished.load(), 50);
+  }
+}
+
+#endif
@@ -0,0 +1,382 @@
+#include "trigram_index.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "text_index.hpp"
+
+namespace {
+
+constexpr char32_t REPLACEMENT = 0xFFFD;
+
+// Decodes the code point at "cursor", advancing past it.
+char32_t decode_utf8(const unsigned char*& cursor, const unsigned char* end) {
+  const unsigned char lead = *cursor++;
+  if (lead < 0x80) {
+    return lead;
+  }
+  std::size_t length;
+  char32_t code;
+  if (lead >= 0xF0 && lead < 0xF5) {
+    length = 3;
+    code = lead & 0x07;
+  } else if (lead >= 0xE0 && lead < 0xF0) {
+    length = 2;
+    code = lead & 0x0F;
+  } else if (lead >= 0xC2 && lead < 0xE0) {
+    length = 1;
+    code = lead & 0x1F;
+  } else {
+    return REPLACEMENT;
+  }
+  if (static_cast<std::size_t>(end - cursor) < length) {
+    cursor = end;
+    return REPLACEMENT;
+  }
+  for (std::size_t i = 0; i < length; ++i) {
+    if ((cursor[i] & 0xC0) != 0x80) {
+      cursor += i;
+      return REPLACEMENT;
+    }
+    code = (code << 6) | (cursor[i] & 0x3F);
+  }
+  cursor += length;
+  return code;
+}
+
+// The unaccented lowercase letter of each code point of Latin Extended-A,
+// U+0100 to U+017F; '*' marks the ligatures, which fold to two letters.
+constexpr std::string_view LATIN_EXTENDED_A =
+    "aaaaaaccccccccddddeeeeeeeeeegggggggghhhhiii"
+    "iiiiiii**jjkkkllllllllllnnnnnnnnnoooooo**rr"
+    "rrrrssssssssttttttuuuuuuuuuuuuwwyyyzzzzzzs";
+
+// The unaccented lowercase letter of each code point of U+00C0 to U+00FF;
+// '*' marks the ligatures and ' ' the multiplication and division signs.
+constexpr std::string_view LATIN_1 =
+    "aaaaaa*ceeeeiiii" "dnooooo ouuuuy**" "aaaaaa*ceeeeiiii" "dnooooo ouuuuy*y";
+
+// Appends the normalized form of "code" to "out", which folds to nothing,
+// to a separator (' '), or to one or more code points.
+void fold(char32_t code, std::u32string& out) {
+  auto separate = [&] {
+    if (!out.empty() && out.back() != U' ') out += U' ';
+  };
+  if (code < 0x80) {
+    if (code >= 'A' && code <= 'Z') {
+      out += static_cast<char32_t>(code - 'A' + 'a');
+    } else if ((code >= 'a' && code <= 'z') || (code >= '0' && code <= '9')) {
+      out += code;
+    } else {
+      separate();
+    }
+    return;
+  }
+  if (code < 0xC0 || (code >= 0x2000 && code < 0x2070) || (code >= 0x3000 && code < 0x3040)) {
+    separate();                                       // Latin-1 symbols, general and CJK punctuation
+    return;
+  }
+  if ((code >= 0x0300 && code < 0x0370) || (code >= 0x02B0 && code < 0x0300) ||
+      (code >= 0x1AB0 && code < 0x1B00) || (code >= 0x1DC0 && code < 0x1E00) ||
+      (code >= 0x20D0 && code < 0x2100) || (code >= 0xFE20 && code < 0xFE30)) {
+    return;                                           // combining marks and modifier letters
+  }
+  if (code < 0x0180) {                                // Latin-1 letters and Latin Extended-A
+    const char letter = code < 0x0100 ? LATIN_1[code - 0xC0] : LATIN_EXTENDED_A[code - 0x0100];
+    if (letter == ' ') {
+      separate();
+    } else if (letter != '*') {
+      out += static_cast<char32_t>(letter);
+    } else {
+      switch (code) {
+        case 0xC6: case 0xE6: out += U"ae"; break;
+        case 0xDE: case 0xFE: out += U"th"; break;
+        case 0xDF: out += U"ss"; break;
+        case 0x132: case 0x133: out += U"ij"; break;
+        default: out += U"oe"; break;        // U+0152, U+0153
+      }
+    }
+    return;
+  }
+  if (code >= 0x0391 && code <= 0x03A9) {
+    out += static_cast<char32_t>(code + 0x20);        // Greek capitals
+  } else if (code >= 0x0410 && code <= 0x042F) {
+    out += static_cast<char32_t>(code + 0x20);        // Cyrillic capitals
+  } else if (code >= 0x0400 && code <= 0x040F) {
+    out += static_cast<char32_t>(code + 0x50);
+  } else {
+    out += code;
+  }
+}
+
+// The key of the trigram at "text[i]" of "field": three 21-bit code points
+// and the field in the top bit.
+std::uint64_t trigram_key(const std::u32string& text, std::size_t i, TextField field) {
+  return (std::uint64_t{field == TextField::Author} << 63) | (std::uint64_t{text[i]} << 42) |
+         (std::uint64_t{text[i + 1]} << 21) | std::uint64_t{text[i + 2]};
+}
+
+// The distinct trigram keys of "text".
+std::vector<std::uint64_t> trigram_keys(const std::u32string& text, TextField field) {
+  std::vector<std::uint64_t> keys;
+  for (std::size_t i = 0; i + 3 <= text.size(); ++i) keys.push_back(trigram_key(text, i, field));
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  return keys;
+}
+
+}  // namespace
+
+//
+// Normalization and Distance
+//
+
+std::u32string normalize_text(std::string_view utf8) {
+  std::u32string normalized;
+  normalized.reserve(utf8.size());
+  const unsigned char* cursor = reinterpret_cast<const unsigned char*>(utf8.data());
+  const unsigned char* end = cursor + utf8.size();
+  while (cursor < end) {
+    fold(decode_utf8(cursor, end), normalized);
+  }
+  if (!normalized.empty() && normalized.back() == U' ') {
+    normalized.pop_back();
+  }
+  return normalized;
+}
+
+std::string to_utf8(std::u32string_view text) {
+  std::string utf8;
+  for (char32_t code : text) {
+    if (code < 0x80) {
+      utf8 += static_cast<char>(code);
+    } else if (code < 0x800) {
+      utf8 += static_cast<char>(0xC0 | (code >> 6));
+      utf8 += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+      utf8 += static_cast<char>(0xE0 | (code >> 12));
+      utf8 += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      utf8 += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+      utf8 += static_cast<char>(0xF0 | (code >> 18));
+      utf8 += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+      utf8 += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      utf8 += static_cast<char>(0x80 | (code & 0x3F));
+    }
+  }
+  return utf8;
+}
+
+// Sellers' algorithm: the edit distance table of "pattern" against "text",
+// one column per text position, where a match may start anywhere because
+// the top row is always 0.
+std::size_t substring_edit_distance(std::u32string_view pattern, std::u32string_view text) {
+  std::vector<std::size_t> column(pattern.size() + 1);
+  for (std::size_t i = 0; i <= pattern.size(); ++i) column[i] = i;
+  std::size_t best = pattern.size();
+  for (char32_t code : text) {
+    std::size_t diagonal = 0;
+    for (std::size_t i = 1; i <= pattern.size(); ++i) {
+      const std::size_t above = column[i];
+      column[i] = std::min({diagonal + (pattern[i - 1] != code), above + 1, column[i - 1] + 1});
+      diagonal = above;
+    }
+    best = std::min(best, column.back());
+  }
+  return best;
+}
+
+//
+// Modifiers
+//
+
+TrigramIndex::DocId TrigramIndex::add(std::string_view isbn, std::string_view title, std::string_view author) {
+  remove(isbn);
+  const DocId doc = static_cast<DocId>(documents_.size());
+  const auto key = ids_.emplace(std::string(isbn), doc).first;
+  documents_.push_back(Document{&key->first, normalize_text(title), normalize_text(author)});
+
+  for (TextField field : {TextField::Title, TextField::Author}) {
+    for (std::uint64_t trigram : trigram_keys(documents_.back().text(field), field)) {
+      postings_[trigram].push_back(doc);
+    }
+  }
+  return doc;
+}
+
+bool TrigramIndex::remove(std::string_view isbn) {
+  const auto found = ids_.find(std::string(isbn));
+  if (found == ids_.end()) {
+    return false;
+  }
+  Document& document = documents_[found->second];
+  document.isbn = nullptr;
+  document.title.clear();
+  document.title.shrink_to_fit();
+  document.author.clear();
+  document.author.shrink_to_fit();
+  ids_.erase(found);
+  ++removed_;
+
+  // As in TextIndex, rewriting waits until it costs no more than the
+  // removals did.
+  if (removed_ >= 128 && removed_ > ids_.size()) {
+    compact();
+  }
+  return true;
+}
+
+void TrigramIndex::compact() {
+  for (auto list = postings_.begin(); list != postings_.end();) {
+    std::vector<DocId>& docs = list->second;
+    docs.erase(std::remove_if(docs.begin(), docs.end(),
+                              [&](DocId doc) { return documents_[doc].isbn == nullptr; }),
+               docs.end());
+    if (docs.empty()) {
+      list = postings_.erase(list);
+    } else {
+      docs.shrink_to_fit();
+      ++list;
+    }
+  }
+  removed_ = 0;
+}
+
+void TrigramIndex::clear() {
+  postings_.clear();
+  ids_.clear();
+  documents_.clear();
+  removed_ = 0;
+}
+
+//
+// Queries
+//
+
+std::vector<TrigramIndex::DocId> TrigramIndex::every_document() const {
+  std::vector<DocId> docs;
+  docs.reserve(ids_.size());
+  for (DocId doc = 0; doc < documents_.size(); ++doc) {
+    if (documents_[doc].isbn != nullptr) docs.push_back(doc);
+  }
+  return docs;
+}
+
+std::vector<TrigramIndex::DocId> TrigramIndex::substring_candidates(const std::u32string& query,
+                                                                    TextField field) const {
+  std::vector<const std::vector<DocId>*> lists;
+  for (std::uint64_t trigram : trigram_keys(query, field)) {
+    const auto found = postings_.find(trigram);
+    if (found == postings_.end()) {
+      return {};
+    }
+    lists.push_back(&found->second);
+  }
+  std::sort(lists.begin(), lists.end(), [](const auto* lhs, const auto* rhs) { return lhs->size() < rhs->size(); });
+
+  std::vector<DocId> candidates = *lists.front();
+  std::vector<DocId> next;
+  for (std::size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+    next.clear();
+    intersect_postings(candidates.data(), candidates.size(), lists[i]->data(), lists[i]->size(), next);
+    candidates.swap(next);
+  }
+  return candidates;
+}
+
+std::vector<TrigramIndex::DocId> TrigramIndex::fuzzy_candidates(const std::u32string& query, std::size_t max_edits,
+                                                                TextField field) const {
+  // Every query position whose trigram a book has counts once for it: each
+  // distinct trigram's list, weighted by how often the query repeats it.
+  const std::size_t needed = query.size() - 2 - 3 * max_edits;
+  std::vector<std::uint64_t> positions;
+  for (std::size_t i = 0; i + 3 <= query.size(); ++i) positions.push_back(trigram_key(query, i, field));
+  std::sort(positions.begin(), positions.end());
+  static const std::vector<DocId> none;
+  std::vector<std::pair<const std::vector<DocId>*, std::size_t>> lists;
+  for (auto position = positions.begin(); position != positions.end();) {
+    const auto next = std::upper_bound(position, positions.end(), *position);
+    const auto found = postings_.find(*position);
+    lists.emplace_back(found == postings_.end() ? &none : &found->second, next - position);
+    position = next;
+  }
+  std::sort(lists.begin(), lists.end(), [](const auto& lhs, const auto& rhs) { return lhs.first->size() < rhs.first->size(); });
+
+  // A book short of "needed" on the longest lists must be on one of the
+  // others, so only those are merged, and the longest are probed per book.
+  // Trigrams common to most titles (of "edition", say) are never walked.
+  std::size_t long_weight = 0;
+  std::size_t short_lists = lists.size();
+  while (short_lists > 0 && long_weight + lists[short_lists - 1].second < needed) {
+    long_weight += lists[--short_lists].second;
+  }
+
+  std::vector<DocId> hits;
+  for (std::size_t i = 0; i < short_lists; ++i) {
+    for (std::size_t repeat = 0; repeat < lists[i].second; ++repeat) {
+      hits.insert(hits.end(), lists[i].first->begin(), lists[i].first->end());
+    }
+  }
+  std::sort(hits.begin(), hits.end());
+
+  std::vector<DocId> candidates;
+  for (auto hit = hits.begin(); hit != hits.end();) {
+    const auto next = std::upper_bound(hit, hits.end(), *hit);
+    std::size_t count = next - hit;
+    for (std::size_t i = short_lists; i < lists.size() && count < needed; ++i) {
+      if (std::binary_search(lists[i].first->begin(), lists[i].first->end(), *hit)) count += lists[i].second;
+    }
+    if (count >= needed) candidates.push_back(*hit);
+    hit = next;
+  }
+  return candidates;
+}
+
+template <bool Filtered>
+TrigramSearch TrigramIndex::find_substring(std::string_view query, TextField field) const {
+  const std::u32string normalized = normalize_text(query);
+  const std::vector<DocId> candidates =
+      Filtered && normalized.size() >= 3 ? substring_candidates(normalized, field) : every_document();
+
+  TrigramSearch search;
+  for (DocId doc : candidates) {
+    const Document& document = documents_[doc];
+    if (document.isbn == nullptr) continue;
+    ++search.candidates;
+    if (document.text(field).find(normalized) != std::u32string::npos) search.matches.push_back(doc);
+  }
+  return search;
+}
+
+template <bool Filtered>
+TrigramSearch TrigramIndex::find_fuzzy(std::string_view query, std::size_t max_edits, TextField field) const {
+  const std::u32string normalized = normalize_text(query);
+  const bool filterable = normalized.size() > 2 + 3 * max_edits;
+  const std::vector<DocId> candidates =
+      Filtered && filterable ? fuzzy_candidates(normalized, max_edits, field) : every_document();
+
+  TrigramSearch search;
+  for (DocId doc : candidates) {
+    const Document& document = documents_[doc];
+    if (document.isbn == nullptr) continue;
+    ++search.candidates;
+    if (substring_edit_distance(normalized, document.text(field)) <= max_edits) search.matches.push_back(doc);
+  }
+  return search;
+}
+
+template TrigramSearch TrigramIndex::find_substring<true>(std::string_view, TextField) const;
+template TrigramSearch TrigramIndex::find_substring<false>(std::string_view, TextField) const;
+template TrigramSearch TrigramIndex::find_fuzzy<true>(std::string_view, std::size_t, TextField) const;
+template TrigramSearch TrigramIndex::find_fuzzy<false>(std::string_view, std::size_t, TextField) const;
+
+std::size_t TrigramIndex::postings() const {
+  std::size_t count = 0;
+  for (const auto& [trigram, docs] : postings_) count += docs.size();
+  return count;
+}
@@ -0,0 +1,199 @@
+#ifndef _trigram_index_hpp_
+#define _trigram_index_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "book.hpp"
+
+// A trigram index of books' titles and authors, for substring searches and
+// for fuzzy searches that tolerate a few typing mistakes, such as
+// "oganesyan" for "Oganesi͡an".
+//
+// Both fields are first normalized (normalize_text()): the UTF-8 is decoded,
+// letters are lowercased and Latin letters lose their accents, combining
+// marks and modifier letters are dropped, and every run of punctuation and
+// spaces becomes one space. Each field's normalized text is then cut into
+// its trigrams, every run of three code points, and each trigram keeps a
+// sorted list of the books whose field contains it.
+//
+// A search first filters, then verifies:
+//
+//   - Substring: a book containing the query contains every trigram of it,
+//     so the candidates are the intersection of the query's trigram lists.
+//   - Fuzzy, within k edits of some substring of the field: each edit
+//     touches at most 3 of the query's m - 2 trigrams, so a match still has
+//     at least m - 2 - 3k of them (the q-gram lemma), and the candidates are
+//     the books reaching that count.
+//
+// Each candidate is then checked against its normalized text. A query too
+// short to have trigrams, or a fuzzy query whose bound drops to zero, has no
+// filter, and every book is a candidate.
+//
+// Removing a book drops it from results at once; its postings are rewritten
+// away by compact(), which runs by itself once removed books outnumber the
+// rest.
+//
+// Usage:
+//
+//   TrigramIndex index;
+//   for (const Book& book : books) index.add(book);
+//   TrigramSearch found = index.find_fuzzy("oganesyan", 1, TextField::Author);
+//   for (TrigramIndex::DocId doc : found.matches) std::cout << index.isbn(doc) << '\n';
+
+// The field of a book a search looks in.
+enum class TextField { Title, Author };
+
+// The text "utf8" normalized for searching, as code points. Invalid UTF-8
+// bytes become U+FFFD.
+std::u32string normalize_text(std::string_view utf8);
+
+// Encodes code points as UTF-8.
+std::string to_utf8(std::u32string_view text);
+
+// The fewest insertions, deletions, and substitutions that turn "pattern"
+// into some substring of "text".
+std::size_t substring_edit_distance(std::u32string_view pattern, std::u32string_view text);
+
+// What a search found: the matching books in document number order, and how
+// many books it verified to find them.
+struct TrigramSearch {
+  std::vector<std::uint32_t> matches;
+  std::size_t candidates = 0;
+};
+
+class TrigramIndex {
+ public:
+  // A book's document number.
+  using DocId = std::uint32_t;
+
+  TrigramIndex() = default;
+
+  // The documents point into the ISBN map, so an index does not copy.
+  TrigramIndex(const TrigramIndex&) = delete;
+  TrigramIndex& operator=(const TrigramIndex&) = delete;
+  TrigramIndex(TrigramIndex&&) = default;
+  TrigramIndex& operator=(TrigramIndex&&) = default;
+
+  //
+  // Modifiers
+  //
+
+  // Indexes a book's title and author under a new document number, and
+  // returns it. A book whose ISBN is already indexed replaces it.
+  template <class Record>
+  DocId add(const Record& book) { return add(book.isbn(), book.title(), book.author()); }
+  DocId add(std::string_view isbn, std::string_view title, std::string_view author);
+
+  // Removes the book with "isbn" from search results. Returns false if there
+  // is none.
+  bool remove(std::string_view isbn);
+
+  // Rewrites every posting list without the removed books.
+  void compact();
+
+  void clear();
+
+  //
+  // Queries
+  //
+
+  // The books whose "field" contains "query", once both are normalized.
+  // Filtered = false verifies every book instead, for comparison.
+  template <bool Filtered = true>
+  TrigramSearch find_substring(std::string_view query, TextField field) const;
+
+  // The books with a substring of "field" within "max_edits" edits of
+  // "query", once both are normalized.
+  template <bool Filtered = true>
+  TrigramSearch find_fuzzy(std::string_view query, std::size_t max_edits, TextField field) const;
+
+  // The ISBN of a book returned by a search.
+  const std::string& isbn(DocId doc) const { return *documents_[doc].isbn; }
+
+  bool contains(std::string_view isbn) const { return ids_.count(std::string(isbn)) > 0; }
+
+  // Books indexed and not removed.
+  std::size_t size() const { return ids_.size(); }
+  bool empty() const { return ids_.empty(); }
+
+  // Distinct trigrams of both fields, and the postings in their lists,
+  // including those of removed books that are not yet compacted away.
+  std::size_t trigrams() const { return postings_.size(); }
+  std::size_t postings() const;
+
+ private:
+  // A book's ISBN key, or null once removed, and its normalized fields.
+  struct Document {
+    const std::string* isbn;
+    std::u32string title;
+    std::u32string author;
+
+    const std::u32string& text(TextField field) const { return field == TextField::Title ? title : author; }
+  };
+
+  // The books that could hold a query, by its trigrams.
+  std::vector<DocId> substring_candidates(const std::u32string& query, TextField field) const;
+  std::vector<DocId> fuzzy_candidates(const std::u32string& query, std::size_t max_edits, TextField field) const;
+
+  // Every book not removed.
+  std::vector<DocId> every_document() const;
+
+  std::unordered_map<std::uint64_t, std::vector<DocId>> postings_;  // by field and trigram
+  std::unordered_map<std::string, DocId> ids_;
+  std::vector<Document> documents_;
+  std::size_t removed_ = 0;                           // removed numbers still in the lists
+};
+
+//
+// TRIGRAM INDEX OPERATIONS
+//
+
+struct search_within_trigram_index_by_substring {
+  // Function takes no parameters, finds the books in a trigram index whose
+  // target field contains the target query, and returns what it found.
+  TrigramSearch operator()(const Book& unused) { return my_index.find_substring(target_query, target_field); }
+
+  const TrigramIndex& my_index;
+  const std::string target_query;
+  const TextField target_field;
+};
+
+struct search_within_trigram_index_by_fuzzy_match {
+  // Function takes no parameters, finds the books in a trigram index whose
+  // target field has a substring within the allowed edits of the target
+  // query, and returns what it found.
+  TrigramSearch operator()(const Book& unused) {
+    return my_index.find_fuzzy(target_query, max_edits, target_field);
+  }
+
+  const TrigramIndex& my_index;
+  const std::string target_query;
+  const std::size_t max_edits;
+  const TextField target_field;
+};
+
+template <class Record = Book>
+struct search_within_vector_by_title_substring {
+  // Function takes no parameters, scans a vector for the books whose titles
+  // contain the target text byte for byte, and returns them.
+  std::vector<const Record*> operator()(const Record& unused) {
+    std::vector<const Record*> found;
+    for (const Record& book : my_vector) {
+      if (book.title().find(target_text) != std::string::npos) found.push_back(&book);
+    }
+    return found;
+  }
+
+  const std::vector<Record>& my_vector;
+  const std::string target_text;
+};
+template <class Record>
+search_within_vector_by_title_substring(const std::vector<Record>&, std::string)
+    -> search_within_vector_by_title_substring<Record>;
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef _trigram_index_test_hpp_
+#define _trigram_index_test_hpp_
+
+#include "trigram_index.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+
+TEST_CASE("NormalizeText") {
+  CHECK_EQ(to_utf8(normalize_text("Malta language question (1st edition)")), "malta language question 1st edition");
+  CHECK_EQ(to_utf8(normalize_text("  Żveli aġtʻkʻmis -- ")), "zveli agtkmis");
+  CHECK_EQ(to_utf8(normalize_text("Oganesi͡an, R.")), "oganesian r");
+  CHECK_EQ(to_utf8(normalize_text("Ólafur Jóhann Sigurðsson")), "olafur johann sigurdsson");
+  CHECK_EQ(to_utf8(normalize_text("Æsir STRAẞE Œuvres")), "aesir straẞe oeuvres");
+  CHECK_EQ(to_utf8(normalize_text("ДОСТОЕВСКИЙ Ёлка")), "достоевский ёлка");
+  CHECK_EQ(normalize_text("a\xff" "b"), U"a�b");
+  CHECK_EQ(normalize_text("\xe2\x82"), U"�");
+  CHECK(normalize_text("?!").empty());
+}
+
+TEST_CASE("SubstringEditDistance") {
+  CHECK_EQ(substring_edit_distance(U"oganesyan", U"r oganesian"), 1);
+  CHECK_EQ(substring_edit_distance(U"oganesian", U"r oganesian"), 0);
+  CHECK_EQ(substring_edit_distance(U"ogansian", U"oganesian"), 1);
+  CHECK_EQ(substring_edit_distance(U"xyz", U"abc"), 3);
+  CHECK_EQ(substring_edit_distance(U"abc", U""), 3);
+  CHECK_EQ(substring_edit_distance(U"", U"abc"), 0);
+}
+
+TEST_CASE("TrigramIndex") {
+  std::vector<Book> books = {
+      Book("Nuclear collective dynamics", "Oganesi͡an, R. A.", "1", 83.98),
+      Book("Kvæði", "Ólafur Jóhann Sigurðsson", "2", 100.87),
+      Book("Creating Prosperity Through Creative Visualisation", "Lillian Too", "3", 21.03),
+      Book("Malta language question", "Geoffrey Hull", "4", 62.06),
+      Book("Hindu berkiblat ke India?", "I Gusti Ketut Widana", "5", 21.90)};
+  // Random titles over a few letters, so that trigrams repeat and fuzzy
+  // candidates include near misses.
+  std::default_random_engine random(47);
+  std::uniform_int_distribution<int> letter('a', 'e');
+  std::uniform_int_distribution<std::size_t> length(3, 30);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    std::string title;
+    for (std::size_t n = length(random); n > 0; --n) title += static_cast<char>(n % 6 == 0 ? ' ' : letter(random));
+    books.emplace_back(title, "Author " + std::to_string(i % 37), "x" + std::to_string(i), 1.0);
+  }
+  TrigramIndex index;
+  for (const Book& book : books) index.add(book);
+
+  auto isbns = [&](const TrigramSearch& search) {
+    std::vector<std::string> found;
+    for (TrigramIndex::DocId doc : search.matches) found.push_back(index.isbn(doc));
+    std::sort(found.begin(), found.end());
+    return found;
+  };
+
+  // Filtering never loses a match that verifying every book finds.
+  auto check = [&](const std::string& query, std::size_t max_edits, TextField field) {
+    const TrigramSearch substring = index.find_substring(query, field);
+    CHECK_EQ(isbns(substring), isbns(index.find_substring<false>(query, field)));
+    const TrigramSearch fuzzy = index.find_fuzzy(query, max_edits, field);
+    const TrigramSearch every = index.find_fuzzy<false>(query, max_edits, field);
+    CHECK_EQ(isbns(fuzzy), isbns(every));
+    CHECK_LE(fuzzy.candidates, every.candidates);
+  };
+
+  SUBCASE("Substring") {
+    CHECK_EQ(isbns(index.find_substring("OGANESIAN", TextField::Author)), std::vector<std::string>{"1"});
+    CHECK_EQ(isbns(index.find_substring("sigurds", TextField::Author)), std::vector<std::string>{"2"});
+    CHECK_EQ(isbns(index.find_substring("kvaedi", TextField::Title)), std::vector<std::string>{"2"});
+    CHECK_EQ(isbns(index.find_substring("creati", TextField::Title)), std::vector<std::string>{"3"});
+    CHECK(index.find_substring("creati", TextField::Author).matches.empty());
+    CHECK(index.find_substring("zzz", TextField::Title).matches.empty());
+    CHECK_EQ(index.find_substring("Visualisation", TextField::Title).candidates, 1);
+    CHECK_EQ(index.find_substring("a", TextField::Title).candidates, books.size());
+  }
+
+  SUBCASE("Fuzzy") {
+    const TrigramSearch found = index.find_fuzzy("Oganesyan", 1, TextField::Author);
+    CHECK_EQ(isbns(found), std::vector<std::string>{"1"});
+    CHECK_LT(found.candidates, 5);
+    CHECK(index.find_fuzzy("Oganesyan", 0, TextField::Author).matches.empty());
+    CHECK_EQ(isbns(index.find_fuzzy("Geofrey Hul", 2, TextField::Author)), std::vector<std::string>{"4"});
+    CHECK_EQ(isbns(search_within_trigram_index_by_fuzzy_match{index, "prosparity", 1, TextField::Title}(books[0])),
+             std::vector<std::string>{"3"});
+  }
+
+  SUBCASE("MatchesVerifyingEveryBook") {
+    std::uniform_int_distribution<std::size_t> pick(0, books.size() - 1);
+    for (std::size_t i = 0; i < 50; ++i) {
+      const std::string& title = books[pick(random)].title();
+      const std::size_t start = std::min<std::size_t>(i % 5, title.size());
+      const std::string query = title.substr(start, 4 + i % 9);
+      check(query, i % 3, TextField::Title);
+    }
+    check("author 1", 1, TextField::Author);
+    check("ab", 1, TextField::Title);
+  }
+
+  SUBCASE("RemoveAndCompact") {
+    CHECK(index.remove("1"));
+    CHECK_FALSE(index.remove("1"));
+    CHECK(index.find_fuzzy("Oganesyan", 1, TextField::Author).matches.empty());
+    index.add(Book("Nuclear collective dynamics", "Oganesyan, R. A.", "1", 83.98));
+    CHECK_EQ(isbns(index.find_substring("oganesyan", TextField::Author)), std::vector<std::string>{"1"});
+
+    for (std::size_t i = 0; i < 900; ++i) index.remove("x" + std::to_string(i));
+    CHECK_EQ(index.size(), 105);
+    CHECK_LT(index.postings(), 105 * 60);
+    check("abc", 1, TextField::Title);
+    CHECK_EQ(isbns(index.find_substring("oganesyan", TextField::Author)), std::vector<std::string>{"1"});
+  }
+
+  SUBCASE("Clear") {
+    index.clear();
+    CHECK(index.empty());
+    CHECK_EQ(index.trigrams(), 0);
+    CHECK(index.find_substring("a", TextField::Title).matches.empty());
+  }
+}
+
+#endif
@@ -0,0 +1,313 @@
+#include "wal.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t FRAME_HEADER = 8;               // length, checksum
+constexpr std::size_t PAYLOAD_HEADER = 15;            // kind, price, three lengths
+
+std::uint32_t crc32(const char* data, std::size_t size) {
+  static const std::array<std::uint32_t, 256> table = [] {
+    std::array<std::uint32_t, 256> entries{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t value = i;
+      for (int bit = 0; bit < 8; ++bit) value = (value >> 1) ^ (0xEDB88320u & (0u - (value & 1)));
+      entries[i] = value;
+    }
+    return entries;
+  }();
+  std::uint32_t crc = 0xFFFFFFFFu;
+  for (std::size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+template <class T>
+T load(const char* at) {
+  T value;
+  std::memcpy(&value, at, sizeof value);
+  return value;
+}
+
+template <class T>
+void append(std::string& out, T value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof value);
+}
+
+void append_frame(std::string& out, const WalRecord& record) {
+  const Book& book = record.book;
+  if (book.isbn().size() > WriteAheadLog::MAX_FIELD_SIZE ||
+      book.title().size() > WriteAheadLog::MAX_FIELD_SIZE ||
+      book.author().size() > WriteAheadLog::MAX_FIELD_SIZE) {
+    throw std::length_error("book " + book.isbn().substr(0, 32) + " has a field too long for the log");
+  }
+  const std::size_t start = out.size();
+  append<std::uint32_t>(out, 0);
+  append<std::uint32_t>(out, 0);
+  out.push_back(static_cast<char>(record.kind));
+  append<double>(out, book.price());
+  append<std::uint16_t>(out, static_cast<std::uint16_t>(book.isbn().size()));
+  append<std::uint16_t>(out, static_cast<std::uint16_t>(book.title().size()));
+  append<std::uint16_t>(out, static_cast<std::uint16_t>(book.author().size()));
+  out.append(book.isbn()).append(book.title()).append(book.author());
+
+  const std::uint32_t length = static_cast<std::uint32_t>(out.size() - start - FRAME_HEADER);
+  const std::uint32_t checksum = crc32(out.data() + start + FRAME_HEADER, length);
+  std::memcpy(&out[start], &length, sizeof length);
+  std::memcpy(&out[start + 4], &checksum, sizeof checksum);
+}
+
+// Decodes the frame at "cursor". Returns the position after it, or nullptr
+// if the bytes up to "end" do not hold a whole, intact frame.
+const char* decode_frame(const char* cursor, const char* end, WalRecord& record) {
+  if (end - cursor < static_cast<std::ptrdiff_t>(FRAME_HEADER + PAYLOAD_HEADER)) {
+    return nullptr;
+  }
+  const std::size_t length = load<std::uint32_t>(cursor);
+  const char* payload = cursor + FRAME_HEADER;
+  if (length < PAYLOAD_HEADER || static_cast<std::size_t>(end - payload) < length ||
+      crc32(payload, length) != load<std::uint32_t>(cursor + 4)) {
+    return nullptr;
+  }
+  const auto kind = static_cast<WalRecord::Kind>(payload[0]);
+  const std::size_t isbn_size = load<std::uint16_t>(payload + 9);
+  const std::size_t title_size = load<std::uint16_t>(payload + 11);
+  const std::size_t author_size = load<std::uint16_t>(payload + 13);
+  if (PAYLOAD_HEADER + isbn_size + title_size + author_size != length ||
+      (kind != WalRecord::Kind::INSERT && kind != WalRecord::Kind::REMOVE &&
+       kind != WalRecord::Kind::PRICE_UPDATE)) {
+    return nullptr;
+  }
+  const char* strings = payload + PAYLOAD_HEADER;
+  record.kind = kind;
+  record.book = Book(std::string(strings + isbn_size, title_size),
+                     std::string(strings + isbn_size + title_size, author_size),
+                     std::string(strings, isbn_size), load<double>(payload + 1));
+  return payload + length;
+}
+
+std::string read_file(int fd, const std::string& path) {
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    throw std::system_error(errno, std::generic_category(), "stat " + path);
+  }
+  std::string contents(static_cast<std::size_t>(status.st_size), '\0');
+  std::size_t done = 0;
+  while (done < contents.size()) {
+    const ssize_t count = ::pread(fd, &contents[done], contents.size() - done, done);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      throw std::system_error(errno, std::generic_category(), "read " + path);
+    }
+    if (count == 0) break;
+    done += count;
+  }
+  contents.resize(done);
+  return contents;
+}
+
+}  // namespace
+
+//
+// Constructor and Destructor
+//
+
+WriteAheadLog::WriteAheadLog(const std::string& path, WalOptions options)
+    : path_(path), options_(options) {
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "open " + path);
+  }
+  try {
+    // Keep every intact frame; whatever follows the first bad one was never
+    // acknowledged to a writer.
+    const std::string contents = read_file(fd_, path_);
+    WalRecord record;
+    const char* cursor = contents.data();
+    const char* end = contents.data() + contents.size();
+    while (const char* next = decode_frame(cursor, end, record)) cursor = next;
+    offset_ = cursor - contents.data();
+    discarded_bytes_ = contents.size() - offset_;
+    if (discarded_bytes_ > 0 && ::ftruncate(fd_, static_cast<off_t>(offset_)) != 0) {
+      throw std::system_error(errno, std::generic_category(), "truncate " + path_);
+    }
+  } catch (...) {
+    ::close(fd_);
+    throw;
+  }
+}
+
+WriteAheadLog::~WriteAheadLog() noexcept {
+  try {
+    std::unique_lock lock(mutex_);
+    committed_.wait(lock, [this] { return !committing_; });
+    if (!pending_.empty() && !error_) {
+      committing_ = true;
+      commit_group(lock);
+    }
+  } catch (...) {
+  }
+  ::close(fd_);
+}
+
+//
+// Writing
+//
+
+std::uint64_t WriteAheadLog::enqueue(const WalRecord& record) {
+  std::string frame;
+  append_frame(frame, record);
+  std::lock_guard lock(mutex_);
+  pending_ += frame;
+  ++pending_records_;
+  if (options_.max_group_records > 0 && pending_records_ >= options_.max_group_records) {
+    queued_.notify_one();
+  }
+  return ++enqueued_;
+}
+
+void WriteAheadLog::append_batch(const std::vector<WalRecord>& records) {
+  std::string frames;
+  for (const WalRecord& record : records) append_frame(frames, record);
+  std::uint64_t sequence;
+  {
+    std::lock_guard lock(mutex_);
+    pending_ += frames;
+    pending_records_ += records.size();
+    enqueued_ += records.size();
+    sequence = enqueued_;
+  }
+  wait_durable(sequence);
+}
+
+void WriteAheadLog::wait_durable(std::uint64_t sequence) {
+  std::unique_lock lock(mutex_);
+  while (durable_ < sequence) {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    if (committing_) {
+      committed_.wait(lock);
+      continue;
+    }
+
+    // Lead the next group. Waiting out the sync interval lets more writers
+    // join it.
+    committing_ = true;
+    if (options_.sync_interval.count() > 0) {
+      queued_.wait_until(lock, last_sync_ + options_.sync_interval, [this] {
+        return options_.max_group_records > 0 && pending_records_ >= options_.max_group_records;
+      });
+    }
+    commit_group(lock);
+  }
+}
+
+// Writes out everything queued. Called with "committing_" set by the caller.
+void WriteAheadLog::commit_group(std::unique_lock<std::mutex>& lock) {
+  std::string group;
+  group.swap(pending_);
+  pending_records_ = 0;
+  const std::uint64_t last = enqueued_;
+  const std::size_t offset = offset_;
+  lock.unlock();
+
+  std::exception_ptr error;
+  try {
+    std::size_t done = 0;
+    while (done < group.size()) {
+      const ssize_t count = ::pwrite(fd_, group.data() + done, group.size() - done,
+                                     static_cast<off_t>(offset + done));
+      if (count < 0) {
+        if (errno == EINTR) continue;
+        throw std::system_error(errno, std::generic_category(), "write " + path_);
+      }
+      done += count;
+    }
+    if (options_.sync && ::fdatasync(fd_) != 0) {
+      throw std::system_error(errno, std::generic_category(), "sync " + path_);
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  lock.lock();
+  committing_ = false;
+  last_sync_ = std::chrono::steady_clock::now();
+  if (error) {
+    error_ = error;
+  } else {
+    offset_ += group.size();
+    durable_ = last;
+    ++groups_;
+    syncs_ += options_.sync;
+  }
+  committed_.notify_all();
+}
+
+void WriteAheadLog::reset() {
+  std::lock_guard lock(mutex_);
+  if (::ftruncate(fd_, 0) != 0 || (options_.sync && ::fdatasync(fd_) != 0)) {
+    throw std::system_error(errno, std::generic_category(), "truncate " + path_);
+  }
+  offset_ = 0;
+}
+
+//
+// Reading
+//
+
+std::size_t WriteAheadLog::replay(const std::function<void(const WalRecord&)>& visit) const {
+  std::size_t limit;
+  {
+    std::lock_guard lock(mutex_);
+    limit = offset_;
+  }
+  std::string contents = read_file(fd_, path_);
+  contents.resize(std::min(contents.size(), limit));
+
+  std::size_t count = 0;
+  WalRecord record;
+  const char* end = contents.data() + contents.size();
+  for (const char* cursor = contents.data(); cursor < end; ++count) {
+    cursor = decode_frame(cursor, end, record);
+    if (cursor == nullptr) {
+      throw std::runtime_error(path_ + " changed while it was being replayed");
+    }
+    visit(static_cast<const WalRecord&>(record));
+  }
+  return count;
+}
+
+//
+// Statistics
+//
+
+std::size_t WriteAheadLog::size_bytes() const {
+  std::lock_guard lock(mutex_);
+  return offset_;
+}
+
+std::size_t WriteAheadLog::groups() const {
+  std::lock_guard lock(mutex_);
+  return groups_;
+}
+
+std::size_t WriteAheadLog::syncs() const {
+  std::lock_guard lock(mutex_);
+  return syncs_;
+}
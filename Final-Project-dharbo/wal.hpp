@@ -0,0 +1,144 @@
+#ifndef _wal_hpp_
+#define _wal_hpp_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "book.hpp"
+
+// A write-ahead log of catalog mutations, appended to a single file.
+//
+// Each record is framed as
+//
+//   length   (4 bytes)  payload bytes
+//   checksum (4 bytes)  CRC-32 of the payload
+//   payload             kind (1 byte), price (8 bytes), isbn, title, and
+//                       author lengths (2 bytes each), then the strings
+//
+// in native byte order. Opening a log checks every frame and cuts off a torn
+// or damaged tail, so replay() sees exactly the records whose group commit
+// finished before a crash.
+//
+// Group commit: append() hands its record to whoever is committing. The first
+// writer to find no commit in progress becomes the leader: it takes every
+// record queued so far, writes them with one write and one fdatasync, and
+// wakes the writers whose records went out. Writers that arrive meanwhile
+// queue behind it and are committed together by the next leader, so N
+// concurrent writers share roughly one fsync instead of paying N.
+// WalOptions::sync_interval makes a leader hold its group open until that
+// long after the previous sync, trading latency for larger groups.
+//
+// Usage:
+//
+//   WriteAheadLog log("catalog.wal");
+//   log.replay([&](const WalRecord& record) { apply(record); });
+//   log.append(WalRecord::insert(book));             // durable on return
+struct WalRecord {
+  enum class Kind : std::uint8_t { INSERT = 1, REMOVE = 2, PRICE_UPDATE = 3 };
+
+  Kind kind = Kind::INSERT;
+  Book book;                          // REMOVE uses only the ISBN, PRICE_UPDATE the ISBN and price
+
+  static WalRecord insert(const Book& book) { return WalRecord{Kind::INSERT, book}; }
+  static WalRecord remove(std::string_view isbn) {
+    return WalRecord{Kind::REMOVE, Book("", "", std::string(isbn))};
+  }
+  static WalRecord price_update(std::string_view isbn, double price) {
+    return WalRecord{Kind::PRICE_UPDATE, Book("", "", std::string(isbn), price)};
+  }
+
+  bool operator==(const WalRecord& other) const { return kind == other.kind && book == other.book; }
+};
+
+struct WalOptions {
+  bool sync = true;                                   // fdatasync each group; false leaves it to the OS
+  std::chrono::microseconds sync_interval{0};         // least time between one sync and the next
+  std::size_t max_group_records = 0;                  // commit early once this many wait; 0 is no limit
+};
+
+class WriteAheadLog {
+ public:
+  // Record fields are limited to 65535 bytes each.
+  static constexpr std::size_t MAX_FIELD_SIZE = 0xFFFF;
+
+  // Opens "path", creating an empty log if there is none, and cuts off any
+  // torn tail. Throws std::system_error on I/O errors.
+  explicit WriteAheadLog(const std::string& path, WalOptions options = {});
+
+  WriteAheadLog(const WriteAheadLog&) = delete;
+  WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+  // Commits anything still queued.
+  ~WriteAheadLog() noexcept;
+
+  //
+  // Writing
+  //
+
+  // Appends "record" and returns once it is committed. Throws
+  // std::length_error if a field is too long, and std::system_error if the
+  // commit fails; after a failed commit every later append throws too.
+  void append(const WalRecord& record) { wait_durable(enqueue(record)); }
+
+  // Appends every record of "records" and returns once all are committed.
+  void append_batch(const std::vector<WalRecord>& records);
+
+  // The two halves of append(): queues "record" and returns its sequence
+  // number, then waits for every record up to "sequence" to be committed.
+  // Records are logged in the order they are queued.
+  std::uint64_t enqueue(const WalRecord& record);
+  void wait_durable(std::uint64_t sequence);
+
+  // Empties the log, once what it recorded is saved elsewhere. No appends
+  // may be in progress.
+  void reset();
+
+  //
+  // Reading
+  //
+
+  // Calls "visit(record)" for every committed record in order. Returns the
+  // number of records.
+  std::size_t replay(const std::function<void(const WalRecord&)>& visit) const;
+
+  //
+  // Statistics
+  //
+
+  std::size_t size_bytes() const;
+  std::size_t discarded_bytes() const { return discarded_bytes_; }   // torn tail cut off on open
+  std::size_t groups() const;
+  std::size_t syncs() const;
+
+ private:
+  void commit_group(std::unique_lock<std::mutex>& lock);
+
+  const std::string path_;
+  const WalOptions options_;
+  int fd_ = -1;
+  std::size_t discarded_bytes_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable queued_;                    // a record was queued
+  std::condition_variable committed_;                 // a group commit finished
+  std::string pending_;                               // frames queued for the next group
+  std::size_t pending_records_ = 0;
+  std::uint64_t enqueued_ = 0;                        // sequence of the last queued record
+  std::uint64_t durable_ = 0;                         // sequence of the last committed record
+  bool committing_ = false;
+  std::exception_ptr error_;
+  std::size_t offset_ = 0;
+  std::chrono::steady_clock::time_point last_sync_;
+  std::size_t groups_ = 0;
+  std::size_t syncs_ = 0;
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef _wal_test_hpp_
+#define _wal_test_hpp_
+
+#include "wal.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book.hpp"
+#include "doctest.hpp"
+#include "durable_catalog.hpp"
+
+TEST_CASE("WriteAheadLog") {
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / "wal_test.wal";
+  std::filesystem::remove(path);
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const std::vector<WalRecord> records = {WalRecord::insert(book), WalRecord::price_update("isbn", 1.0),
+                                          WalRecord::remove("isbn"), WalRecord::insert(Book())};
+
+  auto replayed = [&] {
+    std::vector<WalRecord> seen;
+    WriteAheadLog log(path.string());
+    const std::size_t count = log.replay([&](const WalRecord& record) { seen.push_back(record); });
+    CHECK_EQ(count, seen.size());
+    return seen;
+  };
+
+  SUBCASE("AppendReplay") {
+    {
+      WriteAheadLog log(path.string());
+      for (const WalRecord& record : records) log.append(record);
+      CHECK_EQ(log.groups(), records.size());
+      CHECK_EQ(log.syncs(), records.size());
+    }
+    CHECK_EQ(replayed(), records);
+    {
+      WriteAheadLog log(path.string());
+      log.append_batch(records);
+      CHECK_EQ(log.groups(), 1);
+    }
+    CHECK_EQ(replayed().size(), 2 * records.size());
+  }
+
+  SUBCASE("TornTailIsCutOff") {
+    {
+      WriteAheadLog log(path.string());
+      log.append_batch(records);
+    }
+    const std::size_t intact = std::filesystem::file_size(path);
+    {
+      // Half of a fifth record, as if the machine died mid-write.
+      std::ofstream file(path, std::ios::binary | std::ios::app);
+      file << std::string(20, '\x07');
+    }
+    {
+      WriteAheadLog log(path.string());
+      CHECK_EQ(log.discarded_bytes(), 20);
+      CHECK_EQ(log.size_bytes(), intact);
+      log.append(WalRecord::remove("other"));
+    }
+    std::vector<WalRecord> seen = replayed();
+    REQUIRE_EQ(seen.size(), records.size() + 1);
+    CHECK_EQ(seen.back(), WalRecord::remove("other"));
+
+    {
+      // A damaged byte in the second record loses it and everything after.
+      std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(60);
+      file.put('\x7f');
+    }
+    CHECK_EQ(replayed().size(), 1);
+  }
+
+  SUBCASE("GroupCommit") {
+    WalOptions options;
+    options.sync_interval = std::chrono::milliseconds(2);
+    {
+      WriteAheadLog log(path.string(), options);
+      std::vector<std::thread> writers;
+      for (int t = 0; t < 8; ++t) {
+        writers.emplace_back([&log, t] {
+          for (int i = 0; i < 50; ++i) {
+            log.append(WalRecord::price_update(std::to_string(t), i));
+          }
+        });
+      }
+      for (auto& writer : writers) writer.join();
+      CHECK_LT(log.groups(), 400);
+    }
+
+    // Each writer's records are in its own order.
+    std::vector<int> last(8, -1);
+    std::size_t count = 0;
+    for (const WalRecord& record : replayed()) {
+      const int writer = std::stoi(record.book.isbn());
+      CHECK_EQ(record.book.price(), last[writer] + 1);
+      last[writer] = static_cast<int>(record.book.price());
+      ++count;
+    }
+    CHECK_EQ(count, 400);
+  }
+
+  SUBCASE("Reset") {
+    WriteAheadLog log(path.string());
+    log.append_batch(records);
+    log.reset();
+    CHECK_EQ(log.size_bytes(), 0);
+    log.append(records[0]);
+    CHECK_EQ(log.replay([](const WalRecord&) {}), 1);
+  }
+
+  SUBCASE("RejectsBadInput") {
+    WriteAheadLog log(path.string());
+    CHECK_THROWS_AS(log.append(WalRecord::insert(Book(std::string(70000, 't'), "", "1"))),
+                    std::length_error);
+    CHECK_EQ(log.size_bytes(), 0);
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("DurableCatalog") {
+  const std::filesystem::path path = std::filesystem::temp_directory_path() / "durable_catalog_test.wal";
+  std::filesystem::remove(path);
+  const Book book = Book("title", "author", "isbn", 123.45);
+  const Book other_book = Book("other-title", "other-author", "other-isbn", 543.21);
+
+  {
+    DurableCatalog catalog(path.string());
+    insert_into_durable_catalog{catalog}(book);
+    insert_into_durable_catalog{catalog}(other_book);
+    CHECK(catalog.update_price(book.isbn(), 1.0));
+    CHECK_FALSE(catalog.update_price("missing", 1.0));
+    remove_from_durable_catalog{catalog}(other_book);
+    CHECK_FALSE(catalog.remove(other_book.isbn()));
+    CHECK_EQ(catalog.log().groups(), 4);
+  }
+
+  DurableCatalog catalog(path.string());
+  CHECK_EQ(catalog.size(), 1);
+  CHECK_EQ(search_within_durable_catalog{catalog, book.isbn()}(Book{}), Book(book).price(1.0));
+  CHECK_EQ(search_within_durable_catalog{catalog, other_book.isbn()}(Book{}), std::nullopt);
+
+  std::filesystem::remove(path);
+}
+
+#endif